@@ -0,0 +1,51 @@
+﻿#include "EntityDrawer.h"
+
+/// <summary>
+/// コンストラクタ
+/// 使う色を先に登録しておく
+/// </summary>
+EntityDrawer::EntityDrawer() {
+
+	segmentColorIndex_ = palette_.Register(0xffffffff);
+	pointColorIndex_ = palette_.Register(0xff4040ff);
+}
+
+/// <summary>
+/// 線分と、点から最近接点への線を詰めたスクリーン座標の線にする関数
+/// 描画は更新より重いので、先頭からmaxDrawCount個ずつだけ描く
+/// </summary>
+/// <param name="state"></param>
+/// <param name="maxDrawCount"></param>
+/// <param name="viewProjectionViewportMatrix"></param>
+/// <param name="outLines"></param>
+void EntityDrawer::BuildLines(const EntityState& state, uint32_t maxDrawCount, const Matrix4x4& viewProjectionViewportMatrix, std::vector<PackedLine>& outLines) {
+
+	uint32_t segmentCount = (std::min)(static_cast<uint32_t>(state.segments.Size()), maxDrawCount);
+	uint32_t pointCount = (std::min)(static_cast<uint32_t>(state.pointPositions.Size()), maxDrawCount);
+
+	outLines.clear();
+
+	// 線分の始点と終点
+	worldStarts_.Resize(segmentCount);
+	worldEnds_.Resize(segmentCount);
+	for (uint32_t i = 0; i < segmentCount; ++i) {
+
+		Segement segment = state.segments.Get(i);
+		worldStarts_.Set(i, segment.origin);
+		worldEnds_.Set(i, segment.origin + segment.diff);
+	}
+
+	// まとめて座標変換して詰める
+	PackLinesBatch(worldStarts_, worldEnds_, viewProjectionViewportMatrix, segmentColorIndex_, outLines);
+
+	// 点と最近接点
+	worldStarts_.Resize(pointCount);
+	worldEnds_.Resize(pointCount);
+	for (uint32_t i = 0; i < pointCount; ++i) {
+
+		worldStarts_.Set(i, state.pointPositions.Get(i));
+		worldEnds_.Set(i, state.closestPoints.Get(i));
+	}
+
+	PackLinesBatch(worldStarts_, worldEnds_, viewProjectionViewportMatrix, pointColorIndex_, outLines);
+}
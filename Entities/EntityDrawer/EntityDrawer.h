@@ -0,0 +1,44 @@
+﻿#pragma once
+#include "MyMath.h"
+#include "MyMathBatch.h"
+#include "PackedLine.h"
+#include "EntityStore.h"
+
+/// <summary>
+/// エンティティの描画クラス
+/// 線分と、点から最近接点への線を詰めたスクリーン座標の線にする
+/// シミュレーション側のスレッドから呼べるように、Noviceは使わない
+/// 色の一覧はコンストラクタで作った後は変えないので、描画側のスレッドから読んでよい
+/// </summary>
+class EntityDrawer {
+private:
+	/// <summary>
+	/// メンバ変数
+	/// </summary>
+
+	// 線の端点(フレームをまたいで使い回す)
+	Vec3fSoA worldStarts_;
+	Vec3fSoA worldEnds_;
+
+	LinePalette palette_;
+	uint16_t segmentColorIndex_ = 0;
+	uint16_t pointColorIndex_ = 0;
+
+public:
+	/// <summary>
+	/// メンバ関数
+	/// </summary>
+
+	// コンストラクタ
+	EntityDrawer();
+	// デストラクタ
+	~EntityDrawer() {}
+
+	void BuildLines(const EntityState& state, uint32_t maxDrawCount, const Matrix4x4& viewProjectionViewportMatrix, std::vector<PackedLine>& outLines);
+
+	/// <summary>
+	/// ゲッター
+	/// </summary>
+	/// <returns></returns>
+	const LinePalette& GetPalette() const { return palette_; }
+};
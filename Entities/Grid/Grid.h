@@ -1,15 +1,30 @@
 ﻿#pragma once
 #include "MyMath.h"
+#include "MyMathBatch.h"
+#include "LineBatcher.h"
+#include "WorldLines.h"
+#include "MeshTables.h"
+#include "Derived.h"
 
 /// <summary>
 /// グリッド線クラス
+/// 分割数か幅が変わるとバージョンが進む
 /// </summary>
-class Grid {
+class Grid : public VersionSource {
 private:
 	/// <summary>
 	/// メンバ変数
 	/// </summary>
 
+	// 分割数と半分の幅(線の端点と色はMeshTablesの表を使う)
+	uint32_t subdivision_ = kDefaultGridSubdivision;
+	float halfWidth_ = kDefaultGridHalfWidth;
+
+	uint64_t version_ = 1;
+
+	// 線の端点のスクリーン座標(フレームをまたいで使い回す)
+	Vec3fSoA screenPositions_;
+
 public:
 	/// <summary>
 	/// メンバ関数
@@ -18,7 +33,31 @@ public:
 	// コンストラクタ
 	Grid() {};
 	// デストラクタ
-	~Grid() {}
+	~Grid() override {}
 
-	void DrawGrid(const Matrix4x4& viewMatrix, const Matrix4x4& projectionMatrix, const Matrix4x4& viewportMatrix);
+	void DrawGrid(const Matrix4x4& viewProjectionViewportMatrix, LineBatcher& lineBatcher);
+	// 座標変換せずにワールド座標の線として足す(複数の視点で描く時)
+	void AddWorldLines(WorldLines& outLines) const;
+
+	/// <summary>
+	/// ゲッター
+	/// </summary>
+	/// <returns></returns>
+	uint64_t GetVersion() const override { return version_; }
+
+	/// <summary>
+	/// セッター
+	/// </summary>
+	void SetSubdivision(uint32_t subdivision) {
+		if (subdivision != subdivision_) {
+			subdivision_ = subdivision;
+			++version_;
+		}
+	}
+	void SetHalfWidth(float halfWidth) {
+		if (halfWidth != halfWidth_) {
+			halfWidth_ = halfWidth;
+			++version_;
+		}
+	}
 };
\ No newline at end of file
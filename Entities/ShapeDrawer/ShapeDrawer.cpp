@@ -0,0 +1,145 @@
+﻿#include "ShapeDrawer.h"
+#include <cmath>
+
+/// <summary>
+/// ワールド座標の線を溜める
+/// </summary>
+/// <param name="start"></param>
+/// <param name="end"></param>
+/// <param name="color"></param>
+void ShapeDrawer::AddWorldLine(const Vec3f& start, const Vec3f& end, uint32_t color) {
+
+	if (worldPositions_.Size() < (lineCount_ + 1) * 2) {
+		worldPositions_.Resize((lineCount_ + 1) * 2);
+		colors_.resize(lineCount_ + 1);
+	}
+
+	worldPositions_.Set(lineCount_ * 2, start);
+	worldPositions_.Set(lineCount_ * 2 + 1, end);
+	colors_[lineCount_] = color;
+
+	++lineCount_;
+}
+
+/// <summary>
+/// 8つの角を結ぶ12本の辺を溜める
+/// 番号のビットが1つだけ違う角同士が辺でつながっている
+/// </summary>
+/// <param name="corners"></param>
+/// <param name="color"></param>
+void ShapeDrawer::AddBoxEdges(const Vec3f (&corners)[8], uint32_t color) {
+
+	for (uint32_t corner = 0; corner < 8; ++corner) {
+		for (uint32_t axisBit = 1; axisBit < 8; axisBit <<= 1) {
+
+			// 各辺を1回だけ、ビットが0の側から足す
+			if ((corner & axisBit) == 0) {
+				AddWorldLine(corners[corner], corners[corner | axisBit], color);
+			}
+		}
+	}
+}
+
+/// <summary>
+/// AABBの辺を溜める
+/// </summary>
+/// <param name="aabb"></param>
+/// <param name="color"></param>
+void ShapeDrawer::AddAABB(const AABB& aabb, uint32_t color) {
+
+	Vec3f corners[8];
+	for (uint32_t corner = 0; corner < 8; ++corner) {
+		corners[corner] = {
+			(corner & 1) ? aabb.max.x : aabb.min.x,
+			(corner & 2) ? aabb.max.y : aabb.min.y,
+			(corner & 4) ? aabb.max.z : aabb.min.z };
+	}
+
+	AddBoxEdges(corners, color);
+}
+
+/// <summary>
+/// OBBの辺を溜める
+/// </summary>
+/// <param name="obb"></param>
+/// <param name="color"></param>
+void ShapeDrawer::AddOBB(const OBB& obb, uint32_t color) {
+
+	Vec3f axes[3] = {
+		obb.orientations[0] * obb.size.x,
+		obb.orientations[1] * obb.size.y,
+		obb.orientations[2] * obb.size.z };
+
+	Vec3f corners[8];
+	for (uint32_t corner = 0; corner < 8; ++corner) {
+		corners[corner] = obb.center +
+			((corner & 1) ? axes[0] : axes[0] * -1.0f) +
+			((corner & 2) ? axes[1] : axes[1] * -1.0f) +
+			((corner & 4) ? axes[2] : axes[2] * -1.0f);
+	}
+
+	AddBoxEdges(corners, color);
+}
+
+/// <summary>
+/// 平面を原点に一番近い点を中心にした正方形で溜める
+/// </summary>
+/// <param name="plane"></param>
+/// <param name="halfSize">正方形の一辺の半分</param>
+/// <param name="color"></param>
+void ShapeDrawer::AddPlane(const Plane& plane, float halfSize, uint32_t color) {
+
+	Vec3f center = plane.normal * plane.distance;
+
+	// 法線に垂直な2方向
+	Vec3f helper = std::abs(plane.normal.y) < 0.9f ? Vec3f(0.0f, 1.0f, 0.0f) : Vec3f(1.0f, 0.0f, 0.0f);
+	Vec3f perpendicular1 = Normalize(Cross(plane.normal, helper)) * halfSize;
+	Vec3f perpendicular2 = Cross(plane.normal, perpendicular1);
+
+	Vec3f corners[4] = {
+		center + perpendicular1 + perpendicular2,
+		center - perpendicular1 + perpendicular2,
+		center - perpendicular1 - perpendicular2,
+		center + perpendicular1 - perpendicular2 };
+
+	for (int i = 0; i < 4; ++i) {
+		AddWorldLine(corners[i], corners[(i + 1) % 4], color);
+	}
+
+	AddWorldLine(center, center + plane.normal * (halfSize * 0.5f), color);
+}
+
+/// <summary>
+/// 溜めた線をまとめて座標変換して描画し、空にする
+/// </summary>
+/// <param name="viewProjectionViewportMatrix"></param>
+/// <param name="lineBatcher"></param>
+void ShapeDrawer::Draw(const Matrix4x4& viewProjectionViewportMatrix, LineBatcher& lineBatcher) {
+
+	if (lineCount_ == 0) {
+		return;
+	}
+
+	// 使っていない末尾は変換しない
+	worldPositions_.Resize(lineCount_ * 2);
+	TransformBatch(worldPositions_, viewProjectionViewportMatrix, screenPositions_);
+
+	for (size_t lineIndex = 0; lineIndex < lineCount_; ++lineIndex) {
+		lineBatcher.AddLine(screenPositions_.Get(lineIndex * 2), screenPositions_.Get(lineIndex * 2 + 1), colors_[lineIndex]);
+	}
+
+	lineCount_ = 0;
+}
+
+/// <summary>
+/// 溜めた線をワールド座標の線として足し、空にする
+/// </summary>
+/// <param name="outLines"></param>
+void ShapeDrawer::MoveWorldLines(WorldLines& outLines) {
+
+	for (size_t lineIndex = 0; lineIndex < lineCount_; ++lineIndex) {
+		outLines.Add(worldPositions_.Get(lineIndex * 2), worldPositions_.Get(lineIndex * 2 + 1), colors_[lineIndex]);
+	}
+
+	lineCount_ = 0;
+}
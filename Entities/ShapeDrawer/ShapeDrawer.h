@@ -0,0 +1,53 @@
+﻿#pragma once
+#include "MyMath.h"
+#include "MyMathBatch.h"
+#include "LineBatcher.h"
+#include "WorldLines.h"
+
+/// <summary>
+/// 形状のワイヤーフレーム描画クラス
+/// AABB、OBB、平面の辺をワールド座標で溜めておき、Drawでまとめて座標変換して線にする
+/// </summary>
+class ShapeDrawer {
+private:
+	/// <summary>
+	/// メンバ変数
+	/// </summary>
+
+	// 線の端点(2つで1本、フレームをまたいで使い回す)
+	Vec3fSoA worldPositions_;
+	Vec3fSoA screenPositions_;
+
+	// 線ごとの色
+	std::vector<uint32_t> colors_;
+
+	// 溜めている線の数
+	size_t lineCount_ = 0;
+
+	// ワールド座標の線を溜める
+	void AddWorldLine(const Vec3f& start, const Vec3f& end, uint32_t color);
+	// 8つの角を結ぶ12本の辺を溜める(角の番号のビットが軸ごとの正負)
+	void AddBoxEdges(const Vec3f (&corners)[8], uint32_t color);
+
+public:
+	/// <summary>
+	/// メンバ関数
+	/// </summary>
+
+	// コンストラクタ
+	ShapeDrawer() {}
+	// デストラクタ
+	~ShapeDrawer() {}
+
+	// AABBの辺を溜める
+	void AddAABB(const AABB& aabb, uint32_t color);
+	// OBBの辺を溜める
+	void AddOBB(const OBB& obb, uint32_t color);
+	// 平面を原点に一番近い点を中心にした正方形で溜める、法線も描く
+	void AddPlane(const Plane& plane, float halfSize, uint32_t color);
+
+	// 溜めた線をまとめて座標変換して描画し、空にする
+	void Draw(const Matrix4x4& viewProjectionViewportMatrix, LineBatcher& lineBatcher);
+	// 溜めた線を座標変換せずにワールド座標の線として足し、空にする(複数の視点で描く時)
+	void MoveWorldLines(WorldLines& outLines);
+};
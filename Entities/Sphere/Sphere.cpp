@@ -1,97 +1,151 @@
 ﻿#include "Sphere.h"
+#include "Counters.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+	/// <summary>
+	/// 球が画面の外に完全に出ているか
+	/// 球の中の点の同次座標は中心の値から半径 x 行列の列の長さ以上は変わらないので、
+	/// xとwの範囲の組み合わせでスクリーン座標の範囲を保守的に求める
+	/// </summary>
+	/// <param name="center"></param>
+	/// <param name="radius"></param>
+	/// <param name="matrix">ビュー x 射影 x ビューポート行列</param>
+	/// <param name="width"></param>
+	/// <param name="height"></param>
+	/// <returns></returns>
+	bool IsSphereOffScreen(const Vec3f& center, float radius, const Matrix4x4& matrix, float width, float height) {
+
+		// 同次座標の1列分の値と、球の中での変化の上限
+		auto column = [&](int j, float& value, float& extent) {
+			value = center.x * matrix.m[0][j] + center.y * matrix.m[1][j] + center.z * matrix.m[2][j] + matrix.m[3][j];
+			extent = radius * std::sqrt(matrix.m[0][j] * matrix.m[0][j] + matrix.m[1][j] * matrix.m[1][j] + matrix.m[2][j] * matrix.m[2][j]);
+			};
+
+		float w = 0.0f;
+		float wExtent = 0.0f;
+		column(3, w, wExtent);
+
+		// 全てカメラの後ろなら描かない、カメラをまたぐ時は判定できないので描く
+		if (w + wExtent <= 0.0f) {
+			return true;
+		}
+		if (w - wExtent <= 0.0f) {
+			return false;
+		}
+
+		const float limits[2] = { width, height };
+		for (int j = 0; j < 2; ++j) {
+
+			float value = 0.0f;
+			float extent = 0.0f;
+			column(j, value, extent);
+
+			// wが正の範囲では、割った値の最大最小は範囲の端の組み合わせのどれか
+			float candidates[4] = {
+				(value - extent) / (w - wExtent), (value - extent) / (w + wExtent),
+				(value + extent) / (w - wExtent), (value + extent) / (w + wExtent) };
+			float minValue = (std::min)((std::min)(candidates[0], candidates[1]), (std::min)(candidates[2], candidates[3]));
+			float maxValue = (std::max)((std::max)(candidates[0], candidates[1]), (std::max)(candidates[2], candidates[3]));
+
+			if (maxValue < 0.0f || minValue > limits[j]) {
+				return true;
+			}
+		}
+
+		return false;
+	}
+}
 
 /// <summary>
-/// 球を描画する関数
+/// 半径の操作
+/// 中心は描画の度に渡す点で上書きされるので、ここでは半径だけを操作する
 /// </summary>
-void Sphere::DrawSphere(
-	const Vec3f& point, uint32_t color, const Matrix4x4& viewMatrix, const Matrix4x4& projectionMatrix, const Matrix4x4& viewportMatrix) {
+void Sphere::DrawImGui() {
 
 	ImGui::Begin("Sphere");
 
-	ImGui::SliderFloat3("translate", &center.localPos_.x, -10.0f, 10.0f);
-	ImGui::SliderFloat("radius", &radius_, 0.0f, 10.0f);
+	if (ImGui::SliderFloat("radius", &radius_, 0.0f, 10.0f)) {
+		++version_;
+	}
 
 	ImGui::End();
+}
 
-	center.localPos_ = point;
-
-	// 分割数
-	const uint32_t kSubdivision = 12;
-	// 緯度分割1つ文の角度
-	const float kLatEvery = Pi() / kSubdivision;
-	// 経度分割1つ分の角度
-	const float kLonEvery = 2.0f * Pi() / kSubdivision;
-
-	// 緯度方向に分割 -π/2 ~ π/2
-	for (uint32_t latIndex = 0; latIndex < kSubdivision; ++latIndex) {
-
-		// 現在の緯度
-		float lat = -Pi() / 2.0f + kLatEvery * latIndex;
-
-		// 経度の方向に分割 0 ~ 2π
-		for (uint32_t lonIndex = 0; lonIndex < kSubdivision; ++lonIndex) {
-
-			// 現在の経度
-			float lon = lonIndex * kLonEvery;
-
-			// world座標系でのa、b、cを求める
-			a.localPos_ =
-			{ radius_ * std::cos(lat) * std::cos(lon),radius_ * std::sin(lat),radius_ * std::cos(lat) * std::sin(lon) };
-
-			a.localPos_ += center.localPos_;
-
-			b.localPos_ =
-			{ radius_ * std::cos(lat + kLatEvery) * std::cos(lon),radius_ * std::sin(lat + kLatEvery),radius_ * std::cos(lat + kLatEvery) * std::sin(lon) };
-
-			b.localPos_ += center.localPos_;
-
-			c.localPos_ =
-			{ radius_ * std::cos(lat) * std::cos(lon + kLonEvery),radius_ * std::sin(lat),radius_ * std::cos(lat) * std::sin(lon + kLonEvery) };
-
-			c.localPos_ += center.localPos_;
-
-			/****************************************************************************************************************************/
-			// a地点の変換
-			a.worldMatrix_ =
-				MakeAffineMatrix({ 1.0f,1.0f,1.0f }, { 0.0f,0.0f,0.0f }, a.localPos_);
-			ndcPosA_ =
-				Transform(a.localPos_, Multiply(viewMatrix, projectionMatrix));
-			a.screenPos_ =
-				Transform(ndcPosA_, viewportMatrix);
-
-			/****************************************************************************************************************************/
-			// b地点の変換
-			b.worldMatrix_ =
-				MakeAffineMatrix({ 1.0f,1.0f,1.0f }, { 0.0f,0.0f,0.0f }, b.localPos_);
-			ndcPosB_ =
-				Transform(b.localPos_, Multiply(viewMatrix, projectionMatrix));
-			b.screenPos_ =
-				Transform(ndcPosB_, viewportMatrix);
-
-			/****************************************************************************************************************************/
-			// c地点の変換
-			c.worldMatrix_ =
-				MakeAffineMatrix({ 1.0f,1.0f,1.0f }, { 0.0f,0.0f,0.0f }, c.localPos_);
-			ndcPosC_ =
-				Transform(c.localPos_, Multiply(viewMatrix, projectionMatrix));
-			c.screenPos_ =
-				Transform(ndcPosC_, viewportMatrix);
-
-			/****************************************************************************************************************************/
-			// ab、bcで描画
-			// ab
-			Novice::DrawLine(
-				static_cast<int>(a.screenPos_.x), static_cast<int>(a.screenPos_.y),
-				static_cast<int>(b.screenPos_.x), static_cast<int>(b.screenPos_.y),
-				color
-			);
-
-			// bc
-			Novice::DrawLine(
-				static_cast<int>(a.screenPos_.x), static_cast<int>(a.screenPos_.y),
-				static_cast<int>(c.screenPos_.x), static_cast<int>(c.screenPos_.y),
-				color
-			);
-		}
+/// <summary>
+/// 単位球の頂点を半径倍して中心へ動かす、三角関数は表を作る時にしか使わない
+/// </summary>
+void Sphere::BuildWorldPositions() {
+
+	const SphereTable& table = GetSphereTable(subdivision_);
+	const size_t kVertexCount = table.unitPositions.Size();
+	worldPositions_.Resize(kVertexCount);
+	for (size_t index = 0; index < kVertexCount; ++index) {
+		worldPositions_.x[index] = table.unitPositions.x[index] * radius_ + center_.x;
+		worldPositions_.y[index] = table.unitPositions.y[index] * radius_ + center_.y;
+		worldPositions_.z[index] = table.unitPositions.z[index] * radius_ + center_.z;
+	}
+}
+
+/// <summary>
+/// 球を描画する関数
+/// </summary>
+void Sphere::DrawSphere(const Vec3f& point, uint32_t color, const Matrix4x4& viewProjectionViewportMatrix, LineBatcher& lineBatcher) {
+
+	center_ = point;
+
+	// 画面外の球は頂点を作らない
+	if (IsSphereOffScreen(center_, radius_, viewProjectionViewportMatrix,
+		static_cast<float>(lineBatcher.GetWidth()), static_cast<float>(lineBatcher.GetHeight()))) {
+		AddCounter(Counter::kSpheresCulled);
+		return;
+	}
+
+	BuildWorldPositions();
+
+	/****************************************************************************************************************************/
+	// まとめて座標変換
+
+	TransformBatch(worldPositions_, viewProjectionViewportMatrix, screenPositions_);
+
+	/****************************************************************************************************************************/
+	// ab、acで描画
+
+	for (uint32_t index = 0; index < worldPositions_.Size(); index += 3) {
+
+		Vec3f a = screenPositions_.Get(index);
+
+		// ab
+		lineBatcher.AddLine(a, screenPositions_.Get(index + 1), color);
+
+		// ac
+		lineBatcher.AddLine(a, screenPositions_.Get(index + 2), color);
+	}
+}
+
+/// <summary>
+/// 球をワールド座標の線として足す関数
+/// 画面外かどうかは視点ごとに違うので、ここでは間引かない
+/// </summary>
+/// <param name="point"></param>
+/// <param name="color"></param>
+/// <param name="outLines"></param>
+void Sphere::AddWorldLines(const Vec3f& point, uint32_t color, WorldLines& outLines) {
+
+	center_ = point;
+
+	BuildWorldPositions();
+
+	for (uint32_t index = 0; index < worldPositions_.Size(); index += 3) {
+
+		Vec3f a = worldPositions_.Get(index);
+
+		// ab
+		outLines.Add(a, worldPositions_.Get(index + 1), color);
+
+		// ac
+		outLines.Add(a, worldPositions_.Get(index + 2), color);
 	}
-}
\ No newline at end of file
+}
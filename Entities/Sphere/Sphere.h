@@ -1,10 +1,16 @@
 ﻿#pragma once
 #include "MyMath.h"
+#include "MyMathBatch.h"
+#include "LineBatcher.h"
+#include "WorldLines.h"
+#include "MeshTables.h"
+#include "Derived.h"
 
 /// <summary>
 /// グリッド球クラス
+/// 半径か分割数が変わるとバージョンが進む(中心は描画の度に渡すので含まない)
 /// </summary>
-class Sphere {
+class Sphere : public VersionSource {
 private:
 	/// <summary>
 	/// メンバ変数
@@ -13,23 +19,20 @@ private:
 	// 半径
 	float radius_{};
 
-	/// <summary>
-	/// 各点の構造体
-	/// </summary>
-	struct Point {
+	// 球の中心
+	Vec3f center_{};
 
-		Matrix4x4 worldMatrix_;
-		Matrix4x4 worldViewProjectionMatrix_;
+	// 頂点(フレームをまたいで使い回す)
+	Vec3fSoA worldPositions_;
+	Vec3fSoA screenPositions_;
 
-		Vec3f localPos_;
-		Vec3f screenPos_;
-	};
+	// 分割数(単位球の頂点はMeshTablesの表を使う)
+	uint32_t subdivision_ = kDefaultSphereSubdivision;
 
-	Point a{}, b{}, c{}, center{};
+	uint64_t version_ = 1;
 
-	Vec3f ndcPosA_{};
-	Vec3f ndcPosB_{};
-	Vec3f ndcPosC_{};
+	// 単位球の頂点を半径倍して中心へ動かす
+	void BuildWorldPositions();
 
 public:
 	/// <summary>
@@ -43,11 +46,34 @@ public:
 		radius_ = 0.01f;
 
 		// 球の中心
-		center.localPos_ = { 0.0f,0.0f,0.0f };
+		center_ = { 0.0f,0.0f,0.0f };
 	}
 	// デストラクタ
-	~Sphere() {}
+	~Sphere() override {}
+
+	// 半径の操作、1フレームに1回呼ぶ
+	void DrawImGui();
 
 	// 球を描画する関数
-	void DrawSphere(const Vec3f& point, uint32_t color, const Matrix4x4& viewMatrix, const Matrix4x4& projectionMatrix, const Matrix4x4& viewportMatrix);
-};
\ No newline at end of file
+	void DrawSphere(const Vec3f& point, uint32_t color, const Matrix4x4& viewProjectionViewportMatrix, LineBatcher& lineBatcher);
+	// 座標変換せずにワールド座標の線として足す関数(複数の視点で描く時)
+	void AddWorldLines(const Vec3f& point, uint32_t color, WorldLines& outLines);
+
+	/// <summary>
+	/// ゲッター
+	/// </summary>
+	/// <returns></returns>
+	float GetRadius() const { return radius_; }
+	uint32_t GetSubdivision() const { return subdivision_; }
+	uint64_t GetVersion() const override { return version_; }
+
+	/// <summary>
+	/// セッター
+	/// </summary>
+	void SetSubdivision(uint32_t subdivision) {
+		if (subdivision != subdivision_) {
+			subdivision_ = subdivision;
+			++version_;
+		}
+	}
+};
@@ -0,0 +1,56 @@
+﻿#include "Benchmark.h"
+#include <chrono>
+#include <ImGui.h>
+
+/// <summary>
+/// 計測する処理の登録
+/// </summary>
+/// <param name="name"></param>
+/// <param name="iterations">繰り返し回数</param>
+/// <param name="opsPerIteration">1回の呼び出しで処理する数</param>
+/// <param name="function"></param>
+void Benchmark::Add(const std::string& name, uint32_t iterations, uint64_t opsPerIteration, Function function) {
+
+	cases_.push_back({ name, iterations, opsPerIteration, std::move(function) });
+}
+
+/// <summary>
+/// 全ての計測
+/// </summary>
+void Benchmark::RunAll() {
+
+	results_.clear();
+
+	for (const Case& benchmarkCase : cases_) {
+
+		// 暖機運転
+		benchmarkCase.function(1);
+
+		auto start = std::chrono::steady_clock::now();
+		benchmarkCase.function(benchmarkCase.iterations);
+		auto end = std::chrono::steady_clock::now();
+
+		double ns = std::chrono::duration<double, std::nano>(end - start).count();
+		double ops = static_cast<double>(benchmarkCase.iterations) * static_cast<double>(benchmarkCase.opsPerIteration);
+
+		results_.push_back({ benchmarkCase.name, ns / ops, ops / (ns * 1.0e-9) });
+	}
+}
+
+/// <summary>
+/// 結果をImGuiで描画
+/// </summary>
+void Benchmark::DrawImGui() {
+
+	ImGui::Begin("Benchmark");
+
+	if (ImGui::Button("run")) {
+		RunAll();
+	}
+
+	for (const Result& result : results_) {
+		ImGui::Text("%-40s %10.2f ns/op %14.0f op/s", result.name.c_str(), result.nsPerOp, result.opsPerSec);
+	}
+
+	ImGui::End();
+}
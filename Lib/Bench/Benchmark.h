@@ -0,0 +1,86 @@
+﻿#pragma once
+#include <stdint.h>
+#include <functional>
+#include <string>
+#include <vector>
+
+/// <summary>
+/// 簡易ベンチマーククラス
+/// 登録した処理をImGuiのボタンから実行し、1回あたりの時間を表示する
+/// </summary>
+class Benchmark {
+public:
+	/// <summary>
+	/// 型定義
+	/// </summary>
+
+	// 引数は繰り返し回数
+	using Function = std::function<void(uint32_t)>;
+
+	/// <summary>
+	/// 計測結果
+	/// </summary>
+	struct Result {
+
+		std::string name;
+		double nsPerOp;   // 1回あたりの時間(ns)
+		double opsPerSec; // 1秒あたりの回数
+	};
+
+private:
+	/// <summary>
+	/// メンバ変数
+	/// </summary>
+
+	struct Case {
+
+		std::string name;
+		uint32_t iterations;
+		uint64_t opsPerIteration;
+		Function function;
+	};
+
+	std::vector<Case> cases_;
+	std::vector<Result> results_;
+
+public:
+	/// <summary>
+	/// メンバ関数
+	/// </summary>
+
+	// コンストラクタ
+	Benchmark() {}
+	// デストラクタ
+	~Benchmark() {}
+
+	// 計測する処理の登録
+	void Add(const std::string& name, uint32_t iterations, uint64_t opsPerIteration, Function function);
+	// 全ての計測
+	void RunAll();
+	// 結果をImGuiで描画
+	void DrawImGui();
+
+	/// <summary>
+	/// ゲッター
+	/// </summary>
+	/// <returns></returns>
+	const std::vector<Result>& GetResults() const { return results_; }
+
+	/// <summary>
+	/// 最適化で計算が消されないように値を使用済みにする
+	/// </summary>
+	template<typename T>
+	static void Consume(const T& value) {
+
+		const volatile unsigned char* bytes = reinterpret_cast<const volatile unsigned char*>(&value);
+		unsigned char hash = 0;
+		for (size_t i = 0; i < sizeof(T); ++i) {
+			hash ^= bytes[i];
+		}
+		sink_ = hash;
+	}
+
+private:
+	// Consumeの書き込み先
+	inline static volatile unsigned char sink_ = 0;
+};
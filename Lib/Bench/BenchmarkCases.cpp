@@ -0,0 +1,986 @@
+﻿#include "BenchmarkCases.h"
+#include "MyMath.h"
+#include "MyMathBatch.h"
+#include "MathDispatch.h"
+#include "Picker.h"
+#include "SoftRasterizer.h"
+#include "EntityStore.h"
+#include "Polyline.h"
+#include "Spline.h"
+#include "SortAndSweep.h"
+#include "PackedLine.h"
+#include "RenderQueue.h"
+#include "Camera.h"
+#include "MultiViewRenderer.h"
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <random>
+#include <string>
+
+namespace {
+
+	/// <summary>
+	/// テンプレート化する前のfloat版4x4行列の積(比較用)
+	/// </summary>
+	Matrix4x4 MultiplyBaseline(const Matrix4x4& m1, const Matrix4x4& m2) {
+
+		Matrix4x4 matrix;
+		for (int i = 0; i < 4; i++) {
+			for (int j = 0; j < 4; j++) {
+				matrix.m[i][j] = 0;
+				for (int k = 0; k < 4; ++k) {
+					matrix.m[i][j] += m1.m[i][k] * m2.m[k][j];
+				}
+			}
+		}
+		return matrix;
+	}
+
+	/// <summary>
+	/// ブロードフェーズのベンチマーク用の、少しずつ動く球の群れ
+	/// 球の数によらず1つの球が重なる数が同じくらいになるよう、箱の大きさを球の数の立方根に比例させる
+	/// </summary>
+	struct MovingSpheres {
+
+		SphereSoA spheres;
+		Vec3fSoA velocities;
+		float halfExtent;
+
+		MovingSpheres(uint32_t count, uint32_t seed) {
+
+			halfExtent = std::cbrt(static_cast<float>(count)) * 1.5f;
+
+			std::mt19937 random(seed);
+			std::uniform_real_distribution<float> position(-halfExtent, halfExtent);
+			std::uniform_real_distribution<float> velocity(-0.02f, 0.02f);
+			std::uniform_real_distribution<float> radius(0.2f, 0.6f);
+
+			spheres.Resize(count);
+			velocities.Resize(count);
+			for (uint32_t i = 0; i < count; ++i) {
+				spheres.Set(i, { { position(random), position(random), position(random) }, radius(random) });
+				velocities.Set(i, { velocity(random), velocity(random), velocity(random) });
+			}
+		}
+
+		// 1フレーム進める、箱の壁で跳ね返る
+		void Step() {
+
+			std::vector<float>* positions[3] = { &spheres.center.x, &spheres.center.y, &spheres.center.z };
+			std::vector<float>* speeds[3] = { &velocities.x, &velocities.y, &velocities.z };
+
+			for (int axis = 0; axis < 3; ++axis) {
+
+				std::vector<float>& position = *positions[axis];
+				std::vector<float>& speed = *speeds[axis];
+
+				for (size_t i = 0; i < position.size(); ++i) {
+					position[i] += speed[i];
+					if (std::abs(position[i]) > halfExtent) {
+						speed[i] = -speed[i];
+					}
+				}
+			}
+		}
+	};
+
+	/// <summary>
+	/// テンプレート化する前のfloat版座標変換(比較用)
+	/// </summary>
+	Vec3f TransformBaseline(const Vec3f& vector, const Matrix4x4& matrix) {
+
+		Vec3f result;
+		result.x = vector.x * matrix.m[0][0] + vector.y * matrix.m[1][0] + vector.z * matrix.m[2][0] + matrix.m[3][0];
+		result.y = vector.x * matrix.m[0][1] + vector.y * matrix.m[1][1] + vector.z * matrix.m[2][1] + matrix.m[3][1];
+		result.z = vector.x * matrix.m[0][2] + vector.y * matrix.m[1][2] + vector.z * matrix.m[2][2] + matrix.m[3][2];
+		float w = vector.x * matrix.m[0][3] + vector.y * matrix.m[1][3] + vector.z * matrix.m[2][3] + matrix.m[3][3];
+
+		if (w != 0.0f) {
+			result.x /= w;
+			result.y /= w;
+			result.z /= w;
+		}
+
+		return result;
+	}
+}
+
+/// <summary>
+/// 数学関数のベンチマークの登録
+/// </summary>
+/// <param name="benchmark"></param>
+void AddMathBenchmarks(Benchmark& benchmark) {
+
+	const uint32_t kIterations = 1000000;
+
+	const Matrix4x4 matrixF = MakeAffineMatrix({ 1.0f,2.0f,3.0f }, { 0.1f,0.2f,0.3f }, { 4.0f,5.0f,6.0f });
+	const Matrix4x4d matrixD = ToMatrix4x4d(matrixF);
+	// 前の結果に続けて掛ける積と座標変換は、値が発散しない(infやNaNにならない)ように回転だけの行列を使う
+	const Matrix4x4 rotateF = MakeAffineMatrix({ 1.0f,1.0f,1.0f }, { 0.1f,0.2f,0.3f }, { 0.0f,0.0f,0.0f });
+	const Matrix4x4d rotateD = ToMatrix4x4d(rotateF);
+
+	/*========================================================================================================================*/
+	// 4x4行列の積
+
+	benchmark.Add("Multiply float (baseline)", kIterations, 1, [rotateF](uint32_t iterations) {
+		Matrix4x4 result = rotateF;
+		for (uint32_t i = 0; i < iterations; ++i) {
+			result = MultiplyBaseline(result, rotateF);
+		}
+		Benchmark::Consume(result);
+		});
+
+	benchmark.Add("Multiply float", kIterations, 1, [rotateF](uint32_t iterations) {
+		Matrix4x4 result = rotateF;
+		for (uint32_t i = 0; i < iterations; ++i) {
+			result = Multiply(result, rotateF);
+		}
+		Benchmark::Consume(result);
+		});
+
+	benchmark.Add("Multiply Matrix4x4A", kIterations, 1, [rotateF](uint32_t iterations) {
+		Matrix4x4A matrix(rotateF);
+		Matrix4x4A result = matrix;
+		for (uint32_t i = 0; i < iterations; ++i) {
+			result *= matrix;
+		}
+		Benchmark::Consume(result);
+		});
+
+	benchmark.Add("Multiply double", kIterations, 1, [rotateD](uint32_t iterations) {
+		Matrix4x4d result = rotateD;
+		for (uint32_t i = 0; i < iterations; ++i) {
+			result = Multiply(result, rotateD);
+		}
+		Benchmark::Consume(result);
+		});
+
+	/*========================================================================================================================*/
+	// アフィン変換
+
+	benchmark.Add("MakeAffineMatrix float (baseline)", kIterations, 1, [](uint32_t iterations) {
+		Matrix4x4 result = {};
+		for (uint32_t i = 0; i < iterations; ++i) {
+			float angle = static_cast<float>(i) * 1.0e-3f;
+			result = MathT::MakeAffineMatrix<Matrix4x4>({ 1.0f,2.0f,3.0f }, { angle,0.2f,0.3f }, { 4.0f,5.0f,6.0f });
+		}
+		Benchmark::Consume(result);
+		});
+
+	benchmark.Add("MakeAffineMatrix float", kIterations, 1, [](uint32_t iterations) {
+		Matrix4x4 result = {};
+		for (uint32_t i = 0; i < iterations; ++i) {
+			float angle = static_cast<float>(i) * 1.0e-3f;
+			result = MakeAffineMatrix({ 1.0f,2.0f,3.0f }, { angle,0.2f,0.3f }, { 4.0f,5.0f,6.0f });
+		}
+		Benchmark::Consume(result);
+		});
+
+	// 多数の物体のワールド行列
+	const uint32_t kObjectCount = 10000;
+	Vec3fSoA scales;
+	Vec3fSoA rotates;
+	Vec3fSoA translates;
+	scales.Resize(kObjectCount);
+	rotates.Resize(kObjectCount);
+	translates.Resize(kObjectCount);
+	std::mt19937 random(7);
+	std::uniform_real_distribution<float> distribution(-3.0f, 3.0f);
+	for (uint32_t i = 0; i < kObjectCount; ++i) {
+		scales.Set(i, { distribution(random), distribution(random), distribution(random) });
+		rotates.Set(i, { distribution(random), distribution(random), distribution(random) });
+		translates.Set(i, { distribution(random), distribution(random), distribution(random) });
+	}
+
+	benchmark.Add("MakeAffineMatrix 10k", 100, kObjectCount, [scales, rotates, translates](uint32_t iterations) {
+		std::vector<Matrix4x4> matrices(scales.Size());
+		for (uint32_t i = 0; i < iterations; ++i) {
+			for (size_t j = 0; j < matrices.size(); ++j) {
+				matrices[j] = MakeAffineMatrix(scales.Get(j), rotates.Get(j), translates.Get(j));
+			}
+		}
+		Benchmark::Consume(matrices.back());
+		});
+
+	benchmark.Add("MakeAffineMatrixBatch 10k", 100, kObjectCount, [scales, rotates, translates](uint32_t iterations) {
+		std::vector<Matrix4x4> matrices;
+		for (uint32_t i = 0; i < iterations; ++i) {
+			MakeAffineMatrixBatch(scales, rotates, translates, matrices);
+		}
+		Benchmark::Consume(matrices.back());
+		});
+
+	/*========================================================================================================================*/
+	// 逆行列
+
+	benchmark.Add("Inverse float", kIterations, 1, [matrixF](uint32_t iterations) {
+		Matrix4x4 result = matrixF;
+		for (uint32_t i = 0; i < iterations; ++i) {
+			result = Inverse(result);
+		}
+		Benchmark::Consume(result);
+		});
+
+	benchmark.Add("Inverse double", kIterations, 1, [matrixD](uint32_t iterations) {
+		Matrix4x4d result = matrixD;
+		for (uint32_t i = 0; i < iterations; ++i) {
+			result = Inverse(result);
+		}
+		Benchmark::Consume(result);
+		});
+
+	/*========================================================================================================================*/
+	// 座標変換
+
+	benchmark.Add("Transform float (baseline)", kIterations, 1, [rotateF](uint32_t iterations) {
+		Vec3f result = { 1.0f,1.0f,1.0f };
+		for (uint32_t i = 0; i < iterations; ++i) {
+			result = TransformBaseline(result, rotateF);
+		}
+		Benchmark::Consume(result);
+		});
+
+	benchmark.Add("Transform float", kIterations, 1, [rotateF](uint32_t iterations) {
+		Vec3f result = { 1.0f,1.0f,1.0f };
+		for (uint32_t i = 0; i < iterations; ++i) {
+			result = Transform(result, rotateF);
+		}
+		Benchmark::Consume(result);
+		});
+
+	benchmark.Add("Transform Matrix4x4A", kIterations, 1, [rotateF](uint32_t iterations) {
+		Matrix4x4A matrix(rotateF);
+		Vec3f result = { 1.0f,1.0f,1.0f };
+		for (uint32_t i = 0; i < iterations; ++i) {
+			result = Transform(result, matrix);
+		}
+		Benchmark::Consume(result);
+		});
+
+	benchmark.Add("Transform double", kIterations, 1, [rotateD](uint32_t iterations) {
+		Vec3d result = { 1.0,1.0,1.0 };
+		for (uint32_t i = 0; i < iterations; ++i) {
+			result = Transform(result, rotateD);
+		}
+		Benchmark::Consume(result);
+		});
+}
+
+/// <summary>
+/// ピッキングのベンチマークの登録
+/// </summary>
+/// <param name="benchmark"></param>
+void AddPickingBenchmarks(Benchmark& benchmark) {
+
+	const uint32_t kObjectCount = 100000;
+	const uint32_t kRayCount = 1024;
+
+	std::mt19937 random(0);
+	std::uniform_real_distribution<float> position(-50.0f, 50.0f);
+	std::uniform_real_distribution<float> size(0.05f, 0.5f);
+
+	// 球と線分を半分ずつ
+	auto picker = std::make_shared<Picker>();
+	for (uint32_t i = 0; i < kObjectCount / 2; ++i) {
+		picker->AddSphere({ { position(random), position(random), position(random) }, size(random) });
+		picker->AddSegment(
+			{ { position(random), position(random), position(random) }, { size(random), size(random), size(random) } }, 0.05f);
+	}
+	picker->Build();
+
+	// 手前から奥へ向かう半直線
+	auto rays = std::make_shared<std::vector<Ray>>();
+	for (uint32_t i = 0; i < kRayCount; ++i) {
+		Vec3f origin = { position(random), position(random), -100.0f };
+		Vec3f target = { position(random), position(random), 100.0f };
+		rays->push_back({ origin, target - origin });
+	}
+
+	benchmark.Add("Pick 100k objects", 100, kRayCount, [picker, rays](uint32_t iterations) {
+		uint32_t hitCount = 0;
+		for (uint32_t i = 0; i < iterations; ++i) {
+			for (const Ray& ray : *rays) {
+				hitCount += picker->Pick(ray).type != Picker::Type::kNone ? 1 : 0;
+			}
+		}
+		Benchmark::Consume(hitCount);
+		});
+}
+
+/// <summary>
+/// ソフトウェアラスタライザのベンチマークの登録
+/// </summary>
+/// <param name="benchmark"></param>
+void AddRasterizerBenchmarks(Benchmark& benchmark) {
+
+	const uint32_t kLineCount = 100000;
+
+	std::mt19937 random(0);
+	std::uniform_real_distribution<float> x(0.0f, 1280.0f);
+	std::uniform_real_distribution<float> y(0.0f, 720.0f);
+	std::uniform_real_distribution<float> depth(0.0f, 1.0f);
+	std::uniform_real_distribution<float> length(-32.0f, 32.0f);
+
+	// グリッドや球の線に近い、短めの線
+	auto lines = std::make_shared<std::vector<ScreenLine>>();
+	for (uint32_t i = 0; i < kLineCount; ++i) {
+		Vec3f start = { x(random), y(random), depth(random) };
+		Vec3f end = { start.x + length(random), start.y + length(random), depth(random) };
+		lines->push_back({ start, end, 0xffffffff });
+	}
+
+	auto rasterizer = std::make_shared<SoftRasterizer>();
+	rasterizer->Init(1280, 720);
+
+	benchmark.Add("SoftRasterizer 100k lines", 10, kLineCount, [rasterizer, lines](uint32_t iterations) {
+		for (uint32_t i = 0; i < iterations; ++i) {
+			rasterizer->Clear(0x000000ff);
+			rasterizer->DrawLines(*lines);
+		}
+		Benchmark::Consume(rasterizer->GetColorBuffer()[0]);
+		});
+}
+
+/// <summary>
+/// 折れ線とスプライン曲線のベンチマークの登録
+/// </summary>
+/// <param name="benchmark"></param>
+void AddCurveBenchmarks(Benchmark& benchmark) {
+
+	const uint32_t kSegmentCount = 10000;
+	const uint32_t kQueryCount = 1000;
+
+	std::mt19937 random(0);
+	std::uniform_real_distribution<float> step(-0.1f, 0.1f);
+	std::uniform_real_distribution<float> position(-3.0f, 3.0f);
+
+	// 少しずつ曲がりながら進む長い経路
+	std::vector<Vec3f> points;
+	Vec3f current = { 0.0f,0.0f,0.0f };
+	for (uint32_t i = 0; i <= kSegmentCount; ++i) {
+		points.push_back(current);
+		current += { step(random), step(random), step(random) };
+	}
+
+	auto polyline = std::make_shared<Polyline>();
+	polyline->SetPoints(points);
+
+	auto queries = std::make_shared<std::vector<Vec3f>>();
+	for (uint32_t i = 0; i < kQueryCount; ++i) {
+		queries->push_back({ position(random), position(random), position(random) });
+	}
+
+	/*========================================================================================================================*/
+	// 折れ線の最近接点、結果は1回の問い合わせあたり
+
+	benchmark.Add("Polyline ClosestPoint 10k segments (brute force)", 1, kQueryCount, [polyline, queries](uint32_t iterations) {
+		float distance = 0.0f;
+		for (uint32_t i = 0; i < iterations; ++i) {
+			for (const Vec3f& query : *queries) {
+				distance += polyline->ClosestPointBruteForce(query).distanceSquared;
+			}
+		}
+		Benchmark::Consume(distance);
+		});
+
+	benchmark.Add("Polyline ClosestPoint 10k segments", 10, kQueryCount, [polyline, queries](uint32_t iterations) {
+		float distance = 0.0f;
+		for (uint32_t i = 0; i < iterations; ++i) {
+			for (const Vec3f& query : *queries) {
+				distance += polyline->ClosestPoint(query).distanceSquared;
+			}
+		}
+		Benchmark::Consume(distance);
+		});
+
+	/*========================================================================================================================*/
+	// スプライン曲線の分割、制御点を通る1000区間のCatmull-Rom曲線
+
+	auto spline = std::make_shared<Spline>();
+	spline->SetControlPoints(Spline::Type::kCatmullRom, std::vector<Vec3f>(points.begin(), points.begin() + 1001));
+
+	benchmark.Add("Spline Flatten 1k pieces", 10, 1000, [spline](uint32_t iterations) {
+		Polyline flattened;
+		for (uint32_t i = 0; i < iterations; ++i) {
+			spline->Flatten(0.001f, flattened);
+		}
+		Benchmark::Consume(flattened.GetPointCount());
+		});
+}
+
+/// <summary>
+/// エンティティの更新のベンチマークの登録
+/// </summary>
+/// <param name="benchmark"></param>
+void AddSimulationBenchmarks(Benchmark& benchmark) {
+
+	const uint32_t kPointCount = 50000;
+	const uint32_t kSegmentCount = 5000;
+
+	auto entityStore = std::make_shared<EntityStore>();
+	entityStore->Spawn(kPointCount, kSegmentCount, 0);
+
+	// 1回 = 全エンティティの1ティック、結果は1エンティティあたり
+	benchmark.Add("EntityStore tick 55k entities", 100, kPointCount + kSegmentCount, [entityStore](uint32_t iterations) {
+		for (uint32_t i = 0; i < iterations; ++i) {
+			entityStore->Tick(1.0f / 60.0f);
+		}
+		Benchmark::Consume(entityStore->GetState().closestPoints.x[0]);
+		});
+}
+
+/// <summary>
+/// 命令セットごとの数学関数のベンチマークの登録
+/// </summary>
+/// <param name="benchmark"></param>
+void AddDispatchBenchmarks(Benchmark& benchmark) {
+
+	const uint32_t kCount = 10000;
+
+	std::mt19937 random(0);
+	std::uniform_real_distribution<float> value(-10.0f, 10.0f);
+
+	auto points = std::make_shared<Vec3fSoA>();
+	auto segments = std::make_shared<SegmentSoA>();
+	auto angles = std::make_shared<std::vector<float>>();
+	points->Resize(kCount);
+	segments->Resize(kCount);
+	angles->resize(kCount);
+	for (uint32_t i = 0; i < kCount; ++i) {
+		points->Set(i, { value(random), value(random), value(random) });
+		segments->Set(i, { { value(random), value(random), value(random) }, { value(random), value(random), value(random) } });
+		(*angles)[i] = value(random);
+	}
+
+	Matrix4x4 matrix = MakeAffineMatrix({ 1.0f,2.0f,3.0f }, { 0.3f,0.2f,0.1f }, { 4.0f,5.0f,6.0f });
+	// 積を続けて掛けても値が発散しない(infやNaNにならない)ように、回転だけの行列を掛ける
+	Matrix4x4 rotateMatrix = MakeAffineMatrix({ 1.0f,1.0f,1.0f }, { 0.3f,0.2f,0.1f }, { 0.0f,0.0f,0.0f });
+
+	for (int level = 0; level <= static_cast<int>(GetDetectedSimdLevel()); ++level) {
+
+		const MathKernels& kernels = GetMathKernels(static_cast<SimdLevel>(level));
+		std::string suffix = std::string(" (") + ToString(kernels.level) + ")";
+
+		benchmark.Add("Multiply" + suffix, 1000000, 1, [&kernels, rotateMatrix](uint32_t iterations) {
+			Matrix4x4 result = rotateMatrix;
+			for (uint32_t i = 0; i < iterations; ++i) {
+				result = kernels.multiply(result, rotateMatrix);
+			}
+			Benchmark::Consume(result);
+			});
+
+		benchmark.Add("TransformBatch 10k" + suffix, 100, kCount, [&kernels, points, matrix](uint32_t iterations) {
+			Vec3fSoA out;
+			for (uint32_t i = 0; i < iterations; ++i) {
+				kernels.transformBatch(*points, matrix, out);
+			}
+			Benchmark::Consume(out.x[0]);
+			});
+
+		benchmark.Add("ClosestPointBatch 10k" + suffix, 100, kCount, [&kernels, points, segments](uint32_t iterations) {
+			Vec3fSoA out;
+			for (uint32_t i = 0; i < iterations; ++i) {
+				kernels.closestPointBatch(*points, *segments, out);
+			}
+			Benchmark::Consume(out.x[0]);
+			});
+
+		benchmark.Add("SinCosBatch 10k" + suffix, 100, kCount, [&kernels, angles](uint32_t iterations) {
+			std::vector<float> outSin;
+			std::vector<float> outCos;
+			for (uint32_t i = 0; i < iterations; ++i) {
+				kernels.sinCosBatch(*angles, outSin, outCos);
+			}
+			Benchmark::Consume(outSin[0] + outCos[0]);
+			});
+	}
+}
+
+/// <summary>
+/// 衝突判定のベンチマークの登録(1回 = 1組の判定)
+/// 半分ほどが交差するように散らばせた10000組で、1つずつの判定とバッチ処理を比べる
+/// </summary>
+/// <param name="benchmark"></param>
+void AddCollisionBenchmarks(Benchmark& benchmark) {
+
+	const uint32_t kCount = 10000;
+
+	std::mt19937 random(0);
+	std::uniform_real_distribution<float> position(-2.0f, 2.0f);
+	std::uniform_real_distribution<float> size(0.1f, 1.5f);
+	std::uniform_real_distribution<float> angle(-3.14f, 3.14f);
+
+	auto aabbs1 = std::make_shared<AABBSoA>();
+	auto aabbs2 = std::make_shared<AABBSoA>();
+	auto obbs1 = std::make_shared<OBBSoA>();
+	auto obbs2 = std::make_shared<OBBSoA>();
+	auto spheres = std::make_shared<SphereSoA>();
+	auto segments = std::make_shared<SegmentSoA>();
+	aabbs1->Resize(kCount);
+	aabbs2->Resize(kCount);
+	obbs1->Resize(kCount);
+	obbs2->Resize(kCount);
+	spheres->Resize(kCount);
+	segments->Resize(kCount);
+
+	for (uint32_t i = 0; i < kCount; ++i) {
+
+		Vec3f center1 = { position(random), position(random), position(random) };
+		Vec3f center2 = { position(random), position(random), position(random) };
+		Vec3f size1 = { size(random), size(random), size(random) };
+		Vec3f size2 = { size(random), size(random), size(random) };
+
+		aabbs1->Set(i, { center1 - size1, center1 + size1 });
+		aabbs2->Set(i, { center2 - size2, center2 + size2 });
+		obbs1->Set(i, MakeOBB(center1, { angle(random), angle(random), angle(random) }, size1));
+		obbs2->Set(i, MakeOBB(center2, { angle(random), angle(random), angle(random) }, size2));
+		spheres->Set(i, { center2, size2.x });
+		segments->Set(i, { center2, Vec3f{ position(random), position(random), position(random) } });
+	}
+
+	/*========================================================================================================================*/
+	// AABB同士
+
+	benchmark.Add("AABBIntersection 10k", 100, kCount, [aabbs1, aabbs2](uint32_t iterations) {
+		uint32_t hitCount = 0;
+		for (uint32_t i = 0; i < iterations; ++i) {
+			for (uint32_t j = 0; j < kCount; ++j) {
+				hitCount += AABBIntersection(aabbs1->Get(j), aabbs2->Get(j)) ? 1 : 0;
+			}
+		}
+		Benchmark::Consume(hitCount);
+		});
+
+	benchmark.Add("AABBIntersectionBatch 10k", 100, kCount, [aabbs1, aabbs2](uint32_t iterations) {
+		std::vector<uint8_t> hits;
+		for (uint32_t i = 0; i < iterations; ++i) {
+			AABBIntersectionBatch(*aabbs1, *aabbs2, hits);
+		}
+		Benchmark::Consume(hits[0]);
+		});
+
+	/*========================================================================================================================*/
+	// OBB同士
+
+	benchmark.Add("OBBIntersection 10k", 100, kCount, [obbs1, obbs2](uint32_t iterations) {
+		uint32_t hitCount = 0;
+		for (uint32_t i = 0; i < iterations; ++i) {
+			for (uint32_t j = 0; j < kCount; ++j) {
+				hitCount += OBBIntersection(obbs1->Get(j), obbs2->Get(j)) ? 1 : 0;
+			}
+		}
+		Benchmark::Consume(hitCount);
+		});
+
+	benchmark.Add("OBBIntersectionBatch 10k", 100, kCount, [obbs1, obbs2](uint32_t iterations) {
+		std::vector<uint8_t> hits;
+		for (uint32_t i = 0; i < iterations; ++i) {
+			OBBIntersectionBatch(*obbs1, *obbs2, hits);
+		}
+		Benchmark::Consume(hits[0]);
+		});
+
+	/*========================================================================================================================*/
+	// 球とAABB
+
+	benchmark.Add("SphereAABBIntersection 10k", 100, kCount, [spheres, aabbs1](uint32_t iterations) {
+		uint32_t hitCount = 0;
+		for (uint32_t i = 0; i < iterations; ++i) {
+			for (uint32_t j = 0; j < kCount; ++j) {
+				hitCount += SphereAABBIntersection(spheres->Get(j), aabbs1->Get(j)) ? 1 : 0;
+			}
+		}
+		Benchmark::Consume(hitCount);
+		});
+
+	benchmark.Add("SphereAABBIntersectionBatch 10k", 100, kCount, [spheres, aabbs1](uint32_t iterations) {
+		std::vector<uint8_t> hits;
+		for (uint32_t i = 0; i < iterations; ++i) {
+			SphereAABBIntersectionBatch(*spheres, *aabbs1, hits);
+		}
+		Benchmark::Consume(hits[0]);
+		});
+
+	/*========================================================================================================================*/
+	// 線分とAABB
+
+	benchmark.Add("SegmentAABBIntersection 10k", 100, kCount, [segments, aabbs1](uint32_t iterations) {
+		float sum = 0.0f;
+		for (uint32_t i = 0; i < iterations; ++i) {
+			for (uint32_t j = 0; j < kCount; ++j) {
+				float t = 0.0f;
+				sum += SegmentAABBIntersection(segments->Get(j), aabbs1->Get(j), t) ? t : 0.0f;
+			}
+		}
+		Benchmark::Consume(sum);
+		});
+
+	benchmark.Add("SegmentAABBIntersectionBatch 10k", 100, kCount, [segments, aabbs1](uint32_t iterations) {
+		std::vector<float> t;
+		for (uint32_t i = 0; i < iterations; ++i) {
+			SegmentAABBIntersectionBatch(*segments, *aabbs1, t);
+		}
+		Benchmark::Consume(t[0]);
+		});
+}
+
+/// <summary>
+/// ブロードフェーズのベンチマークの登録(1回 = 球1つ分)
+/// 毎回球を少しずつ動かしてから更新するので、並びの持ち越しが効く場面の時間になる
+/// 球1つあたりの時間が球の数によらず同じくらいなら線形に伸びている
+/// </summary>
+/// <param name="benchmark"></param>
+void AddBroadphaseBenchmarks(Benchmark& benchmark) {
+
+	const uint32_t kCounts[] = { 1000, 10000, 100000 };
+
+	for (uint32_t count : kCounts) {
+
+		std::string suffix = " " + std::to_string(count / 1000) + "k";
+
+		auto scene = std::make_shared<MovingSpheres>(count, count);
+		auto broadphase = std::make_shared<SortAndSweep>();
+		broadphase->Init();
+		broadphase->Update(scene->spheres);
+
+		benchmark.Add("SortAndSweep" + suffix, 100, count, [scene, broadphase](uint32_t iterations) {
+			for (uint32_t i = 0; i < iterations; ++i) {
+				scene->Step();
+				broadphase->Update(scene->spheres);
+			}
+			Benchmark::Consume(broadphase->GetStats().pairCount);
+			});
+	}
+
+	// 1スレッドとの比較
+	auto scene = std::make_shared<MovingSpheres>(100000, 1);
+	auto broadphase = std::make_shared<SortAndSweep>();
+	broadphase->Init(1);
+	broadphase->Update(scene->spheres);
+
+	benchmark.Add("SortAndSweep 100k (1 thread)", 100, 100000, [scene, broadphase](uint32_t iterations) {
+		for (uint32_t i = 0; i < iterations; ++i) {
+			scene->Step();
+			broadphase->Update(scene->spheres);
+		}
+		Benchmark::Consume(broadphase->GetStats().pairCount);
+		});
+
+	// 総当たりとの比較
+	auto bruteForceScene = std::make_shared<MovingSpheres>(1000, 1000);
+
+	benchmark.Add("Broadphase brute force 1k", 10, 1000, [bruteForceScene](uint32_t iterations) {
+		std::vector<SortAndSweep::Pair> pairs;
+		for (uint32_t i = 0; i < iterations; ++i) {
+			bruteForceScene->Step();
+			SortAndSweep::FindPairsBruteForce(bruteForceScene->spheres, pairs);
+		}
+		Benchmark::Consume(pairs.size());
+		});
+}
+
+/// <summary>
+/// 線の形式(floatとPackedLine)のベンチマークの登録
+/// 1フレーム100万本の線を作る処理(座標変換と書き込み)と、描画側で読む処理(ScreenLineへの取り込み)と、その両方を続けた時を比べる
+/// </summary>
+/// <param name="benchmark"></param>
+void AddLineFormatBenchmarks(Benchmark& benchmark) {
+
+	const uint32_t kLineCount = 1000000;
+
+	std::mt19937 random(0);
+	std::uniform_real_distribution<float> position(-10.0f, 10.0f);
+	std::uniform_real_distribution<float> length(-0.5f, 0.5f);
+
+	// 短い線をばらまく
+	auto starts = std::make_shared<Vec3fSoA>();
+	auto ends = std::make_shared<Vec3fSoA>();
+	starts->Resize(kLineCount);
+	ends->Resize(kLineCount);
+	for (uint32_t i = 0; i < kLineCount; ++i) {
+		Vec3f start = { position(random), position(random), position(random) };
+		starts->Set(i, start);
+		ends->Set(i, start + Vec3f{ length(random), length(random), length(random) });
+	}
+
+	// -10から10の立方体を1280x720の画面と0から1の深度に写す
+	Matrix4x4 matrix = MakeAffineMatrix({ 64.0f,-36.0f,0.05f }, { 0.0f,0.0f,0.0f }, { 640.0f,360.0f,0.5f });
+
+	auto palette = std::make_shared<LinePalette>();
+	uint16_t colorIndex = palette->Register(0xffffffff);
+
+	auto floatLines = std::make_shared<std::vector<ScreenLine>>();
+	auto packedLines = std::make_shared<std::vector<PackedLine>>();
+	PackLinesBatch(*starts, *ends, matrix, colorIndex, *packedLines);
+
+	const std::string kFloatSize = std::to_string(sizeof(ScreenLine));
+	const std::string kPackedSize = std::to_string(sizeof(PackedLine));
+
+	/*========================================================================================================================*/
+	// 作る側: 座標変換して1フレーム分の線を書く、結果は1本あたり
+
+	benchmark.Add("Line frame 1M encode float (" + kFloatSize + " B/line)", 5, kLineCount,
+		[starts, ends, matrix, floatLines](uint32_t iterations) {
+		Vec3fSoA screenStarts;
+		Vec3fSoA screenEnds;
+		for (uint32_t i = 0; i < iterations; ++i) {
+			TransformBatch(*starts, matrix, screenStarts);
+			TransformBatch(*ends, matrix, screenEnds);
+			floatLines->resize(kLineCount);
+			for (uint32_t j = 0; j < kLineCount; ++j) {
+				(*floatLines)[j] = { screenStarts.Get(j), screenEnds.Get(j), 0xffffffff };
+			}
+		}
+		Benchmark::Consume((*floatLines)[0]);
+		});
+
+	benchmark.Add("Line frame 1M encode packed (" + kPackedSize + " B/line)", 5, kLineCount,
+		[starts, ends, matrix, colorIndex, packedLines](uint32_t iterations) {
+		for (uint32_t i = 0; i < iterations; ++i) {
+			packedLines->clear();
+			PackLinesBatch(*starts, *ends, matrix, colorIndex, *packedLines);
+		}
+		Benchmark::Consume((*packedLines)[0]);
+		});
+
+	/*========================================================================================================================*/
+	// 描画側: 1フレーム分の線を読んでLineBatcherと同じようにScreenLineへ取り込む、結果は1本あたり
+
+	benchmark.Add("Line frame 1M read float (" + kFloatSize + " B/line)", 5, kLineCount,
+		[floatLines](uint32_t iterations) {
+		std::vector<ScreenLine> lines;
+		for (uint32_t i = 0; i < iterations; ++i) {
+			lines.clear();
+			lines.insert(lines.end(), floatLines->begin(), floatLines->end());
+		}
+		Benchmark::Consume(lines.back());
+		});
+
+	// LineBatcher::AddPackedLinesと同じくUnpackLinesでまとめて戻す
+	benchmark.Add("Line frame 1M read packed (" + kPackedSize + " B/line)", 5, kLineCount,
+		[packedLines, palette](uint32_t iterations) {
+		std::vector<ScreenLine> lines;
+		for (uint32_t i = 0; i < iterations; ++i) {
+			lines.clear();
+			lines.resize(packedLines->size());
+			UnpackLines(packedLines->data(), packedLines->size(), *palette, lines.data());
+		}
+		Benchmark::Consume(lines.back());
+		});
+
+	// 1本ずつUnpackLineで戻す(MultiViewRendererが切り取りながら読む形)
+	benchmark.Add("Line frame 1M read packed per line (" + kPackedSize + " B/line)", 5, kLineCount,
+		[packedLines, palette](uint32_t iterations) {
+		std::vector<ScreenLine> lines;
+		for (uint32_t i = 0; i < iterations; ++i) {
+			lines.clear();
+			lines.resize(packedLines->size());
+			for (size_t j = 0; j < packedLines->size(); ++j) {
+				lines[j] = UnpackLine((*packedLines)[j], *palette);
+			}
+		}
+		Benchmark::Consume(lines.back());
+		});
+
+	/*========================================================================================================================*/
+	// 作る側と描画側を続けて: SimulationThreadが線を作り、LineBatcherが取り込むまで、結果は1本あたり
+
+	benchmark.Add("Line frame 1M encode + read float (" + kFloatSize + " B/line)", 5, kLineCount,
+		[starts, ends, matrix](uint32_t iterations) {
+		Vec3fSoA screenStarts;
+		Vec3fSoA screenEnds;
+		std::vector<ScreenLine> snapshotLines;
+		std::vector<ScreenLine> lines;
+		for (uint32_t i = 0; i < iterations; ++i) {
+			TransformBatch(*starts, matrix, screenStarts);
+			TransformBatch(*ends, matrix, screenEnds);
+			snapshotLines.resize(kLineCount);
+			for (uint32_t j = 0; j < kLineCount; ++j) {
+				snapshotLines[j] = { screenStarts.Get(j), screenEnds.Get(j), 0xffffffff };
+			}
+			lines.clear();
+			lines.insert(lines.end(), snapshotLines.begin(), snapshotLines.end());
+		}
+		Benchmark::Consume(lines.back());
+		});
+
+	benchmark.Add("Line frame 1M encode + read packed (" + kPackedSize + " B/line)", 5, kLineCount,
+		[starts, ends, matrix, colorIndex, palette](uint32_t iterations) {
+		std::vector<PackedLine> snapshotLines;
+		std::vector<ScreenLine> lines;
+		for (uint32_t i = 0; i < iterations; ++i) {
+			snapshotLines.clear();
+			PackLinesBatch(*starts, *ends, matrix, colorIndex, snapshotLines);
+			lines.clear();
+			lines.resize(snapshotLines.size());
+			UnpackLines(snapshotLines.data(), snapshotLines.size(), *palette, lines.data());
+		}
+		Benchmark::Consume(lines.back());
+		});
+}
+
+/// <summary>
+/// 描画キューのベンチマークの登録(1回 = 描画する物1つ分)
+/// 1フレーム分(積む、深度を求める、並べ替える)を測る
+/// </summary>
+/// <param name="benchmark"></param>
+void AddRenderQueueBenchmarks(Benchmark& benchmark) {
+
+	const uint32_t kDrawableCount = 100000;
+	const uint32_t kMaterialCount = 64;
+
+	std::mt19937 random(0);
+	std::uniform_real_distribution<float> position(-50.0f, 50.0f);
+
+	auto centers = std::make_shared<Vec3fSoA>();
+	auto materials = std::make_shared<std::vector<uint16_t>>(kDrawableCount);
+	auto types = std::make_shared<std::vector<RenderQueue::PrimitiveType>>(kDrawableCount);
+	centers->Resize(kDrawableCount);
+	for (uint32_t i = 0; i < kDrawableCount; ++i) {
+		centers->Set(i, { position(random), position(random), position(random) });
+		(*materials)[i] = static_cast<uint16_t>(random() % kMaterialCount);
+		(*types)[i] = static_cast<RenderQueue::PrimitiveType>(random() % (static_cast<uint32_t>(RenderQueue::PrimitiveType::kPackedLines) + 1));
+	}
+
+	// 原点から60奥にある物を見る
+	Matrix4x4 viewMatrix = MakeAffineMatrix({ 1.0f,1.0f,1.0f }, { 0.0f,0.0f,0.0f }, { 0.0f,0.0f,60.0f });
+
+	auto queue = std::make_shared<RenderQueue>();
+
+	auto addRadix = [&benchmark, centers, materials, types, viewMatrix, queue](const std::string& name, RenderQueue::SortMode sortMode) {
+		benchmark.Add(name, 20, kDrawableCount,
+			[centers, materials, types, viewMatrix, queue, sortMode](uint32_t iterations) {
+			queue->SetSortMode(sortMode);
+			for (uint32_t i = 0; i < iterations; ++i) {
+				queue->Begin(viewMatrix, 0.1f, 200.0f);
+				for (uint32_t j = 0; j < kDrawableCount; ++j) {
+					queue->Add(centers->Get(j), (*materials)[j], (*types)[j], j);
+				}
+				queue->Sort();
+			}
+			Benchmark::Consume(queue->GetPayload(0));
+			});
+		};
+
+	addRadix("RenderQueue 100k front to back (radix)", RenderQueue::SortMode::kFrontToBack);
+	addRadix("RenderQueue 100k by material (radix)", RenderQueue::SortMode::kByMaterial);
+
+	// 比較用: 深度をfloatのまま持ち、比較関数でstd::sortする
+	benchmark.Add("RenderQueue 100k front to back (std::sort)", 20, kDrawableCount,
+		[centers, materials, types, viewMatrix](uint32_t iterations) {
+
+		struct Item {
+			float depth;
+			uint16_t material;
+			RenderQueue::PrimitiveType type;
+			uint32_t payload;
+		};
+
+		std::vector<Item> items;
+		for (uint32_t i = 0; i < iterations; ++i) {
+			items.clear();
+			for (uint32_t j = 0; j < kDrawableCount; ++j) {
+				Vec3f center = centers->Get(j);
+				float depth = center.x * viewMatrix.m[0][2] + center.y * viewMatrix.m[1][2] + center.z * viewMatrix.m[2][2] + viewMatrix.m[3][2];
+				items.push_back({ depth, (*materials)[j], (*types)[j], j });
+			}
+			std::sort(items.begin(), items.end(), [](const Item& a, const Item& b) {
+				if (a.depth != b.depth) {
+					return a.depth < b.depth;
+				}
+				if (a.material != b.material) {
+					return a.material < b.material;
+				}
+				return a.type < b.type;
+				});
+		}
+		Benchmark::Consume(items[0].payload);
+		});
+}
+
+/// <summary>
+/// 複数の視点の描画のベンチマークの登録
+/// 4つの視点で、視点ごとに全ての端点をTransformBatchしてから切り取る場合と、
+/// MultiViewRenderer::Drawで塊ごとに変換と切り取りを続けて行う場合を比べる(どちらも線はLineBatcherに溜めるだけ)
+/// </summary>
+/// <param name="benchmark"></param>
+void AddMultiViewBenchmarks(Benchmark& benchmark) {
+
+	const uint32_t kLineCount = 50000;
+	const uint32_t kViewCount = 4;
+
+	std::mt19937 random(0);
+	std::uniform_real_distribution<float> position(-10.0f, 10.0f);
+	std::uniform_real_distribution<float> length(-0.5f, 0.5f);
+
+	auto lines = std::make_shared<WorldLines>();
+	for (uint32_t i = 0; i < kLineCount; ++i) {
+		Vec3f start = { position(random), position(random), position(random) };
+		lines->Add(start, start + Vec3f{ length(random), length(random), length(random) }, 0xffffffff);
+	}
+
+	// 4分割の時と同じ配置(メインのカメラと、上、前、横から見た正射影)
+	auto matrices = std::make_shared<std::vector<Matrix4x4>>();
+	auto rects = std::make_shared<std::vector<MultiViewRenderer::ViewRect>>();
+	const Vec3f rotates[kViewCount] = { { 0.26f,0.0f,0.0f },{ Pi() / 2.0f,0.0f,0.0f },{ 0.0f,0.0f,0.0f },{ 0.0f,Pi() / 2.0f,0.0f } };
+	const Vec3d translates[kViewCount] = { { 0.0f,1.9f,-6.49f },{ 0.0f,20.0f,0.0f },{ 0.0f,0.0f,-20.0f },{ -20.0f,0.0f,0.0f } };
+	for (uint32_t i = 0; i < kViewCount; ++i) {
+		Camera camera;
+		camera.Init(1280, 720);
+		if (i != 0) {
+			camera.SetProjection(Camera::Projection::kOrthographic);
+		}
+		camera.SetTransform({ 1.0f,1.0f,1.0f }, rotates[i], translates[i]);
+		camera.SetViewport((i % 2) * 640, (i / 2) * 360, 640, 360);
+		matrices->push_back(camera.GetViewProjectionViewportMatrix());
+		rects->push_back({ static_cast<float>((i % 2) * 640), static_cast<float>((i / 2) * 360), 640.0f, 360.0f });
+	}
+
+	// 視点ごとに全ての端点を変換し、線の配列を作ってから切り取る(塊に分ける前のDraw)
+	benchmark.Add("MultiView 50k lines x 4 views (per view)", 20, kLineCount * kViewCount,
+		[lines, matrices, rects](uint32_t iterations) {
+		LineBatcher lineBatcher;
+		MultiViewRenderer renderer;
+		std::vector<ScreenLine> emittedLines;
+		std::vector<ScreenLine> screenLines;
+		std::vector<Vec3fSoA> screenPositions(matrices->size());
+		lineBatcher.BeginCapture(emittedLines);
+		for (uint32_t i = 0; i < iterations; ++i) {
+			emittedLines.clear();
+			renderer.Clear();
+			for (size_t view = 0; view < matrices->size(); ++view) {
+				renderer.AddView((*matrices)[view], (*rects)[view]);
+				TransformBatch(lines->positions, (*matrices)[view], screenPositions[view]);
+			}
+			for (size_t view = 0; view < matrices->size(); ++view) {
+				screenLines.clear();
+				for (size_t line = 0; line < lines->Size(); ++line) {
+					screenLines.push_back({ screenPositions[view].Get(line * 2), screenPositions[view].Get(line * 2 + 1), lines->colors[line] });
+				}
+				renderer.DrawScreenLines(screenLines, view, lineBatcher);
+			}
+		}
+		lineBatcher.EndCapture();
+		Benchmark::Consume(emittedLines.size());
+		});
+
+	// 塊ごとに全ての視点で変換し、そのまま切り取る
+	benchmark.Add("MultiView 50k lines x 4 views (blocked)", 20, kLineCount * kViewCount,
+		[lines, matrices, rects](uint32_t iterations) {
+		LineBatcher lineBatcher;
+		MultiViewRenderer renderer;
+		std::vector<ScreenLine> emittedLines;
+		lineBatcher.BeginCapture(emittedLines);
+		for (uint32_t i = 0; i < iterations; ++i) {
+			emittedLines.clear();
+			renderer.Clear();
+			for (size_t view = 0; view < matrices->size(); ++view) {
+				renderer.AddView((*matrices)[view], (*rects)[view]);
+			}
+			renderer.Draw(*lines, lineBatcher);
+		}
+		lineBatcher.EndCapture();
+		Benchmark::Consume(emittedLines.size());
+		});
+}
@@ -0,0 +1,68 @@
+﻿#pragma once
+#include "Benchmark.h"
+
+/// <summary>
+/// 数学関数のベンチマークの登録
+/// </summary>
+/// <param name="benchmark"></param>
+void AddMathBenchmarks(Benchmark& benchmark);
+
+/// <summary>
+/// ピッキングのベンチマークの登録
+/// </summary>
+/// <param name="benchmark"></param>
+void AddPickingBenchmarks(Benchmark& benchmark);
+
+/// <summary>
+/// ソフトウェアラスタライザのベンチマークの登録
+/// </summary>
+/// <param name="benchmark"></param>
+void AddRasterizerBenchmarks(Benchmark& benchmark);
+
+/// <summary>
+/// エンティティの更新のベンチマークの登録
+/// </summary>
+/// <param name="benchmark"></param>
+void AddSimulationBenchmarks(Benchmark& benchmark);
+
+/// <summary>
+/// 命令セットごとの数学関数のベンチマークの登録(CPUが対応している段階だけ)
+/// </summary>
+/// <param name="benchmark"></param>
+void AddDispatchBenchmarks(Benchmark& benchmark);
+
+/// <summary>
+/// 折れ線とスプライン曲線のベンチマークの登録
+/// </summary>
+/// <param name="benchmark"></param>
+void AddCurveBenchmarks(Benchmark& benchmark);
+
+/// <summary>
+/// 衝突判定のベンチマークの登録(1回 = 1組の判定)
+/// </summary>
+/// <param name="benchmark"></param>
+void AddCollisionBenchmarks(Benchmark& benchmark);
+
+/// <summary>
+/// ブロードフェーズのベンチマークの登録(1回 = 球1つ分)
+/// </summary>
+/// <param name="benchmark"></param>
+void AddBroadphaseBenchmarks(Benchmark& benchmark);
+
+/// <summary>
+/// 線の形式(floatとPackedLine)のベンチマークの登録(1回 = 線1本分)
+/// </summary>
+/// <param name="benchmark"></param>
+void AddLineFormatBenchmarks(Benchmark& benchmark);
+
+/// <summary>
+/// 描画キューのベンチマークの登録(1回 = 描画する物1つ分)
+/// </summary>
+/// <param name="benchmark"></param>
+void AddRenderQueueBenchmarks(Benchmark& benchmark);
+
+/// <summary>
+/// 複数の視点の描画のベンチマークの登録(1回 = 線1本を1つの視点で変換して切り取る分)
+/// </summary>
+/// <param name="benchmark"></param>
+void AddMultiViewBenchmarks(Benchmark& benchmark);
@@ -1,4 +1,5 @@
 ﻿#include "Camera.h"
+#include "Counters.h"
 
 /// <summary>
 /// 透視投影行列
@@ -90,21 +91,129 @@ Matrix4x4 Camera::MakeViewportMatrix(float left, float top, float width, float h
 /// <summary>
 /// 初期化
 /// </summary>
-void Camera::Init() {
+/// <param name="width">描画先の幅</param>
+/// <param name="height">描画先の高さ</param>
+void Camera::Init(uint32_t width, uint32_t height) {
 
 	// アフィン
 	scale_ = { 1.0f,1.0f,1.0f };
 	rotate_ = { 0.26f,0.0f,0.0f };
 	translate_ = { 0.0f,1.9f,-6.49f };
 
-	cameraMatrix_ =
-		MakeAffineMatrix(scale_, rotate_, translate_);
-	viewMatrix_ = Inverse(cameraMatrix_);
+	width_ = width;
+	height_ = height;
+
+	UpdateProjectionMatrix();
+}
+
+/// <summary>
+/// 解像度が変わった時だけ射影行列とビューポート行列を作り直す
+/// </summary>
+/// <param name="width"></param>
+/// <param name="height"></param>
+void Camera::SetResolution(uint32_t width, uint32_t height) {
+
+	if (width == width_ && height == height_) {
+		return;
+	}
+
+	width_ = width;
+	height_ = height;
+
+	UpdateProjectionMatrix();
+}
+
+/// <summary>
+/// 描画先の矩形が変わった時だけ射影行列とビューポート行列を作り直す
+/// </summary>
+/// <param name="left"></param>
+/// <param name="top"></param>
+/// <param name="width"></param>
+/// <param name="height"></param>
+void Camera::SetViewport(uint32_t left, uint32_t top, uint32_t width, uint32_t height) {
+
+	if (left == left_ && top == top_ && width == width_ && height == height_) {
+		return;
+	}
+
+	left_ = left;
+	top_ = top;
+	width_ = width;
+	height_ = height;
+
+	UpdateProjectionMatrix();
+}
+
+/// <summary>
+/// 投影の方法が変わった時だけ射影行列を作り直す
+/// </summary>
+/// <param name="projection"></param>
+void Camera::SetProjection(Projection projection) {
+
+	if (projection == projection_) {
+		return;
+	}
+
+	projection_ = projection;
+
+	UpdateProjectionMatrix();
+}
+
+/// <summary>
+/// 正射影で映す縦の幅の設定
+/// </summary>
+/// <param name="orthographicHeight"></param>
+void Camera::SetOrthographicHeight(float orthographicHeight) {
+
+	if (orthographicHeight == orthographicHeight_) {
+		return;
+	}
+
+	orthographicHeight_ = orthographicHeight;
+
+	UpdateProjectionMatrix();
+}
+
+/// <summary>
+/// 位置と向きの設定
+/// </summary>
+/// <param name="scale"></param>
+/// <param name="rotate"></param>
+/// <param name="translate">ワールド座標</param>
+void Camera::SetTransform(const Vec3f& scale, const Vec3f& rotate, const Vec3d& translate) {
+
+	scale_ = scale;
+	rotate_ = rotate;
+	translate_ = translate;
+
+	UpdateViewMatrix();
+}
 
-	projectionMatrix_ =
-		MakePerspectiveFovMatrix(0.45f, 1280.0f / 720.0f, 0.1f, 100.0f);
+/// <summary>
+/// 射影行列とビューポート行列を作り直す
+/// 正射影の行列は縦の幅と矩形の縦横比から常に作っておき、正射影の時はそれを射影行列にする
+/// 両方を含むビュー x 射影 x ビューポート行列も作り直す
+/// </summary>
+void Camera::UpdateProjectionMatrix() {
+
+	float width = static_cast<float>((std::max)(width_, 1u));
+	float height = static_cast<float>((std::max)(height_, 1u));
+
+	float halfHeight = orthographicHeight_ * 0.5f;
+	float halfWidth = halfHeight * width / height;
+	orthoMatrix_ =
+		MakeOrthographicMatrix(-halfWidth, halfHeight, halfWidth, -halfHeight, nearClip_, farClip_);
+
+	if (projection_ == Projection::kOrthographic) {
+		projectionMatrix_ = orthoMatrix_;
+	} else {
+		projectionMatrix_ =
+			MakePerspectiveFovMatrix(fovY_, width / height, nearClip_, farClip_);
+	}
 	viewportMatrix_ =
-		MakeViewportMatrix(0.0f, 0.0f, 1280.0f, 720.0f, 0.0f, 1.0f);
+		MakeViewportMatrix(static_cast<float>(left_), static_cast<float>(top_), width, height, 0.0f, 1.0f);
+
+	UpdateViewMatrix();
 }
 
 /// <summary>
@@ -116,13 +225,125 @@ void Camera::Update() {
 
 	ImGui::Begin("Camera");
 
-	ImGui::SliderFloat3("scale", &scale_.x, -1.0f, 1.0f);
-	ImGui::SliderFloat3("rotate", &rotate_.x, -1.0f, 1.0f);
-	ImGui::SliderFloat3("translate", &translate_.x, -10.0f, 10.0f);
+	// 値が変わった時だけ行列を作り直す
+	bool isChanged = false;
+	isChanged |= ImGui::SliderFloat3("scale", &scale_.x, -1.0f, 1.0f);
+	isChanged |= ImGui::SliderFloat3("rotate", &rotate_.x, -1.0f, 1.0f);
+	isChanged |= ImGui::DragScalarN("translate", ImGuiDataType_Double, &translate_.x, 3, 0.01f);
+	isChanged |= ImGui::Checkbox("cameraRelative", &isCameraRelative_);
+	// シーンを遠くに置くと、相対描画が無効な時は単精度の桁落ちで線が揺れる
+	// カメラも同じだけ動かし、シーンが映ったままにする
+	Vec3d worldOrigin = worldOrigin_;
+	bool isOriginChanged = false;
+	isOriginChanged |= ImGui::InputDouble("worldOriginX", &worldOrigin.x, 1000.0, 1000000.0, "%.1f");
+	isOriginChanged |= ImGui::InputDouble("worldOriginY", &worldOrigin.y, 1000.0, 1000000.0, "%.1f");
+	isOriginChanged |= ImGui::InputDouble("worldOriginZ", &worldOrigin.z, 1000.0, 1000000.0, "%.1f");
+	if (isOriginChanged) {
+		translate_ += worldOrigin - worldOrigin_;
+		worldOrigin_ = worldOrigin;
+		isChanged = true;
+	}
+
+	bool isOrthographic = projection_ == Projection::kOrthographic;
+	bool isProjectionChanged = ImGui::Checkbox("orthographic", &isOrthographic);
+	isProjectionChanged |= ImGui::SliderFloat("orthographicHeight", &orthographicHeight_, 0.5f, 50.0f);
 
 	ImGui::End();
 
+	if (isProjectionChanged) {
+		projection_ = isOrthographic ? Projection::kOrthographic : Projection::kPerspective;
+		UpdateProjectionMatrix();
+	} else if (isChanged) {
+		UpdateViewMatrix();
+	}
+}
+
+/// <summary>
+/// ビュー行列を作り直す
+/// ビュー行列はシーンの原点からの座標をビュー空間へ移す
+/// カメラ相対の時は、シーンの原点とカメラの位置(どちらも倍精度のワールド座標)の差を倍精度で求めてから単精度にし、回転だけの逆行列の前に掛ける
+/// そうでない時は、シーンの原点とカメラの位置を単精度のワールド座標にしてから行列を掛け合わせる
+/// </summary>
+void Camera::UpdateViewMatrix() {
+
 	cameraMatrix_ =
-		MakeAffineMatrix(scale_, rotate_, translate_);
-	viewMatrix_ = Inverse(cameraMatrix_);
-}
\ No newline at end of file
+		MakeAffineMatrix(scale_, rotate_, GetPosition());
+
+	if (isCameraRelative_) {
+
+		// ワールド座標同士の引き算は倍精度で行うので、原点が遠くても差は小さいまま
+		Vec3f cameraOffset = MathT::ConvertVector<float>(worldOrigin_ - translate_);
+		Matrix4x4 rotateMatrix =
+			MakeAffineMatrix(scale_, rotate_, { 0.0f,0.0f,0.0f });
+		viewMatrix_ = Multiply(MakeTranslateMatrix(cameraOffset), Inverse(rotateMatrix));
+	} else {
+
+		// 大きなワールド座標を単精度で持つので、原点が遠いと桁落ちする
+		Matrix4x4 worldCameraMatrix =
+			MakeAffineMatrix(scale_, rotate_, MathT::ConvertVector<float>(translate_));
+		viewMatrix_ = Multiply(MakeTranslateMatrix(MathT::ConvertVector<float>(worldOrigin_)), Inverse(worldCameraMatrix));
+	}
+
+	// スクリーン座標とワールド座標の相互変換用、続けて掛ける積は64バイト境界の行列で求める
+	viewProjectionViewportMatrix_ =
+		Matrix4x4A(viewMatrix_) * Matrix4x4A(projectionMatrix_) * Matrix4x4A(viewportMatrix_);
+	inverseViewProjectionViewportMatrix_ = Inverse(viewProjectionViewportMatrix_);
+
+	// 行列の関数の中では数えないので、作り直す時にまとめて数える
+	AddCounter(Counter::kMultiplyCalls, 3);
+	AddCounter(Counter::kInverseCalls, 2);
+
+	++version_;
+}
+
+/// <summary>
+/// シーンの原点をworldOriginに置いた時の誤差を測る
+/// カメラを単精度の1ULPより細かい歩幅で倍精度のワールド座標の上で動かし、
+/// シーンの点を単精度のワールド座標で描いた時とカメラ相対で描いた時のスクリーン座標を、全て倍精度で計算した値と比べる
+/// </summary>
+/// <param name="worldOrigin"></param>
+/// <returns></returns>
+Camera::PrecisionReport Camera::MeasurePrecision(const Vec3d& worldOrigin) {
+
+	const uint32_t kStepCount = 64;
+	const Vec3d kCameraOffset = { 0.0, 1.9, -6.49 };
+	const Vec3d kCameraStep = { 0.0013, 0.0007, 0.0011 };
+	const int32_t kGridHalfCount = 4;
+	const float kGridStep = 0.5f;
+
+	Camera worldCamera;
+	worldCamera.Init(1280, 720);
+	worldCamera.SetWorldOrigin(worldOrigin);
+	Camera relativeCamera = worldCamera;
+	relativeCamera.SetCameraRelative(true);
+
+	PrecisionReport report = {};
+	for (uint32_t step = 0; step < kStepCount; ++step) {
+
+		Vec3d position = worldOrigin + kCameraOffset + kCameraStep * static_cast<double>(step);
+		worldCamera.SetTransform(worldCamera.scale_, worldCamera.rotate_, position);
+		relativeCamera.SetTransform(relativeCamera.scale_, relativeCamera.rotate_, position);
+
+		// 基準はワールド座標のまま倍精度で計算する
+		Matrix4x4d referenceMatrix = Multiply(
+			Inverse(MakeAffineMatrix4x4d(MathT::ConvertVector<double>(worldCamera.scale_), MathT::ConvertVector<double>(worldCamera.rotate_), position)),
+			ToMatrix4x4d(Multiply(worldCamera.projectionMatrix_, worldCamera.viewportMatrix_)));
+
+		for (int32_t z = -kGridHalfCount; z <= kGridHalfCount; ++z) {
+			for (int32_t x = -kGridHalfCount; x <= kGridHalfCount; ++x) {
+
+				Vec3f local = { static_cast<float>(x) * kGridStep, 0.0f, static_cast<float>(z) * kGridStep };
+				Vec3d reference = Transform(worldOrigin + MathT::ConvertVector<double>(local), referenceMatrix);
+
+				Vec3f world = Transform(local, worldCamera.viewProjectionViewportMatrix_);
+				Vec3f relative = Transform(local, relativeCamera.viewProjectionViewportMatrix_);
+				report.worldMaxError = (std::max)(report.worldMaxError, static_cast<float>(
+					(std::max)(std::abs(world.x - reference.x), std::abs(world.y - reference.y))));
+				report.relativeMaxError = (std::max)(report.relativeMaxError, static_cast<float>(
+					(std::max)(std::abs(relative.x - reference.x), std::abs(relative.y - reference.y))));
+			}
+		}
+	}
+
+	return report;
+}
@@ -1,10 +1,31 @@
 ﻿#pragma once
 #include "MyMath.h"
+#include "Derived.h"
 
 /// <summary>
 /// カメラクラス
+/// 行列が変わるたびにバージョンが進むので、派生値の依存先にできる
 /// </summary>
-class Camera {
+class Camera : public VersionSource {
+public:
+	/// <summary>
+	/// 型定義
+	/// </summary>
+
+	// 投影の方法
+	enum class Projection : uint32_t {
+
+		kPerspective,
+		kOrthographic,
+	};
+
+	// 遠い原点での誤差(スクリーン座標のピクセル)
+	struct PrecisionReport {
+
+		float worldMaxError;    // ワールド座標を単精度で扱った時
+		float relativeMaxError; // カメラ相対描画の時
+	};
+
 private:
 	/// <summary>
 	/// メンバ変数
@@ -16,9 +37,41 @@ private:
 	Matrix4x4 projectionMatrix_{};
 	Matrix4x4 viewportMatrix_{};
 
+	// ビュー x 射影 x ビューポート行列とその逆行列(ピッキング用)
+	Matrix4x4 viewProjectionViewportMatrix_{};
+	Matrix4x4 inverseViewProjectionViewportMatrix_{};
+
 	Vec3f scale_{};
 	Vec3f rotate_{};
-	Vec3f translate_{};
+	// カメラの位置(倍精度のワールド座標)
+	Vec3d translate_{};
+
+	// 描画先の矩形(画面の一部にも描ける)と投影の設定
+	uint32_t left_ = 0;
+	uint32_t top_ = 0;
+	uint32_t width_ = 0;
+	uint32_t height_ = 0;
+	Projection projection_ = Projection::kPerspective;
+	float fovY_ = 0.45f;
+	// 正射影で映す縦の幅(ワールド座標)
+	float orthographicHeight_ = 8.0f;
+	float nearClip_ = 0.1f;
+	float farClip_ = 100.0f;
+
+	// カメラ相対描画用
+	// シーンの物はworldOrigin_(倍精度のワールド座標)に置き、頂点はそこからの単精度の座標で持つ
+	// 有効な時はworldOrigin_とtranslate_の差を倍精度で求め、最後のビュー x 射影 x ビューポート行列を作る時だけ単精度にする
+	// 無効な時はワールド座標を単精度にしてから行列を掛け合わせる(比較用、worldOrigin_が遠いと線が揺れる)
+	bool isCameraRelative_ = false;
+	Vec3d worldOrigin_{};
+
+	// 行列を作り直した回数
+	uint64_t version_ = 0;
+
+	// ビュー行列を作り直す
+	void UpdateViewMatrix();
+	// 射影行列とビューポート行列を作り直す
+	void UpdateProjectionMatrix();
 
 	// 透視投影行列
 	Matrix4x4 MakePerspectiveFovMatrix(float fovY, float aspectRatio, float nearClip, float farClip);
@@ -34,16 +87,58 @@ public:
 	// コンストラクタ
 	Camera() {}
 	// デストラクタ
-	~Camera() {}
+	~Camera() override {}
 
-	void Init();
+	void Init(uint32_t width, uint32_t height);
 	void Update();
+	// ImGuiを使わずに位置と向きを決める(操作しない視点用)
+	void SetTransform(const Vec3f& scale, const Vec3f& rotate, const Vec3d& translate);
+	// シーンの原点をworldOriginに置いた時の、単精度のワールド座標とカメラ相対描画の誤差を測る
+	static PrecisionReport MeasurePrecision(const Vec3d& worldOrigin);
 
 	/// <summary>
 	/// ゲッター
 	/// </summary>
 	/// <returns></returns>
+	Matrix4x4 GetCameraMatrix() const { return cameraMatrix_; }
+	// ビュー行列以降はシーンの原点からの座標を受け取る
 	Matrix4x4 GetViewMatrix() const { return viewMatrix_; }
 	Matrix4x4 GetProjectionMatrix() const { return projectionMatrix_; }
 	Matrix4x4 GetViewportMatrix() const { return viewportMatrix_; }
+	Matrix4x4 GetViewProjectionViewportMatrix() const { return viewProjectionViewportMatrix_; }
+	Matrix4x4 GetInverseViewProjectionViewportMatrix() const { return inverseViewProjectionViewportMatrix_; }
+
+	// シーンの原点から見たカメラの位置(描画やピッキングで使う座標)、差は倍精度で求める
+	Vec3f GetPosition() const { return MathT::ConvertVector<float>(translate_ - worldOrigin_); }
+	Vec3d GetWorldPosition() const { return translate_; }
+	Vec3d GetWorldOrigin() const { return worldOrigin_; }
+	bool IsCameraRelative() const { return isCameraRelative_; }
+	uint64_t GetVersion() const override { return version_; }
+	uint32_t GetWidth() const { return width_; }
+	uint32_t GetHeight() const { return height_; }
+	uint32_t GetLeft() const { return left_; }
+	uint32_t GetTop() const { return top_; }
+	Projection GetProjection() const { return projection_; }
+	float GetNearClip() const { return nearClip_; }
+	float GetFarClip() const { return farClip_; }
+
+	/// <summary>
+	/// セッター
+	/// </summary>
+	/// <param name="worldOrigin">シーンの原点のワールド座標</param>
+	void SetWorldOrigin(const Vec3d& worldOrigin) {
+		worldOrigin_ = worldOrigin;
+		UpdateViewMatrix();
+	}
+	void SetCameraRelative(bool isCameraRelative) {
+		isCameraRelative_ = isCameraRelative;
+		UpdateViewMatrix();
+	}
+	// 解像度が変わった時だけ射影行列とビューポート行列を作り直す
+	void SetResolution(uint32_t width, uint32_t height);
+	// 描画先の矩形が変わった時だけ射影行列とビューポート行列を作り直す
+	void SetViewport(uint32_t left, uint32_t top, uint32_t width, uint32_t height);
+	// 投影の方法が変わった時だけ射影行列を作り直す
+	void SetProjection(Projection projection);
+	void SetOrthographicHeight(float orthographicHeight);
 };
\ No newline at end of file
@@ -0,0 +1,485 @@
+﻿#include "SortAndSweep.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+
+/// <summary>
+/// 初期化
+/// </summary>
+/// <param name="threadCount">0ならハードウェアのスレッド数</param>
+void SortAndSweep::Init(uint32_t threadCount) {
+
+	workerPool_.Init(threadCount);
+
+	entries_.clear();
+	axis_ = 0;
+	grid_ = {};
+	pairs_.clear();
+	stats_ = {};
+}
+
+/// <summary>
+/// 分散が最も大きい軸を選ぶ
+/// 球が散らばっている軸ほど投影した区間が重なりにくい
+/// 分散が近い軸の間で毎フレーム切り替わって全体のソートが続かないよう、差が大きい時だけ変える
+/// </summary>
+/// <param name="spheres"></param>
+/// <returns></returns>
+uint32_t SortAndSweep::ChooseAxis(const SphereSoA& spheres) const {
+
+	const size_t kCount = spheres.Size();
+	if (kCount == 0) {
+		return axis_;
+	}
+
+	const std::vector<float>* centers[3] = { &spheres.center.x, &spheres.center.y, &spheres.center.z };
+
+	double variances[3] = {};
+	for (uint32_t axis = 0; axis < 3; ++axis) {
+
+		double sum = 0.0;
+		double sumSquared = 0.0;
+		for (float value : *centers[axis]) {
+			sum += value;
+			sumSquared += static_cast<double>(value) * value;
+		}
+
+		double mean = sum / static_cast<double>(kCount);
+		variances[axis] = sumSquared / static_cast<double>(kCount) - mean * mean;
+	}
+
+	uint32_t bestAxis = axis_;
+	for (uint32_t axis = 0; axis < 3; ++axis) {
+		if (variances[axis] > variances[bestAxis]) {
+			bestAxis = axis;
+		}
+	}
+
+	return variances[bestAxis] > variances[axis_] * kAxisSwitchRatio ? bestAxis : axis_;
+}
+
+namespace {
+
+	// (格子, 区間の始点)の順
+	template <typename T>
+	bool IsEntryLess(const T& a, const T& b) {
+		return a.cell < b.cell || (a.cell == b.cell && a.min < b.min);
+	}
+}
+
+/// <summary>
+/// 座標が入る格子の番号(範囲外は端の格子)
+/// 端に寄せても隣り合う値の格子の差は1以下のままなので、重なる球は同じ格子か隣の格子に入る
+/// </summary>
+/// <param name="gridAxis">格子の軸(0か1)</param>
+/// <param name="value"></param>
+/// <returns></returns>
+uint32_t SortAndSweep::Grid::CellOf(int gridAxis, float value) const {
+
+	float cell = (value - origin[gridAxis]) * inverseCellSize;
+	if (!(cell > 0.0f)) {
+		return 0;
+	}
+	return static_cast<uint32_t>((std::min)(cell, static_cast<float>(count[gridAxis] - 1)));
+}
+
+/// <summary>
+/// 球の範囲と半径から格子を決める
+/// 格子の一辺が最大の直径より小さくなった時、中心が格子から1つ分以上はみ出した時、
+/// 一辺が求める大きさから2倍以上ずれた時だけ作り直し、それ以外は前の格子を使い続けて並びを持ち越す
+/// </summary>
+/// <param name="spheres"></param>
+/// <param name="isForced">必ず作り直すか</param>
+/// <returns>作り直したか</returns>
+bool SortAndSweep::UpdateGrid(const SphereSoA& spheres, bool isForced) {
+
+	const size_t kCount = spheres.Size();
+	const std::vector<float>* centers[3] = { &spheres.center.x, &spheres.center.y, &spheres.center.z };
+	const uint32_t kAxes[2] = { (axis_ + 1) % 3, (axis_ + 2) % 3 };
+
+	// 中心の範囲と半径
+	float minValues[2] = { std::numeric_limits<float>::infinity(), std::numeric_limits<float>::infinity() };
+	float maxValues[2] = { -std::numeric_limits<float>::infinity(), -std::numeric_limits<float>::infinity() };
+	for (int gridAxis = 0; gridAxis < 2; ++gridAxis) {
+		for (float value : *centers[kAxes[gridAxis]]) {
+			minValues[gridAxis] = (std::min)(minValues[gridAxis], value);
+			maxValues[gridAxis] = (std::max)(maxValues[gridAxis], value);
+		}
+	}
+	float maxRadius = 0.0f;
+	double radiusSum = 0.0;
+	for (float radius : spheres.radius) {
+		maxRadius = (std::max)(maxRadius, radius);
+		radiusSum += radius;
+	}
+
+	// 格子は平均の直径の数倍、ただし最大の直径(丸め誤差の分だけ大きく)より小さくせず、1軸あたりの数に上限を設ける
+	float averageRadius = kCount > 0 ? static_cast<float>(radiusSum / static_cast<double>(kCount)) : 0.0f;
+	float minCellSize = 2.0f * maxRadius * 1.001f;
+	float cellSize = (std::max)(kCellSizeScale * 2.0f * averageRadius, minCellSize);
+	for (int gridAxis = 0; gridAxis < 2; ++gridAxis) {
+		float extent = kCount > 0 ? maxValues[gridAxis] - minValues[gridAxis] : 0.0f;
+		cellSize = (std::max)(cellSize, extent / static_cast<float>(kMaxCellsPerAxis));
+	}
+	if (!(cellSize > 0.0f) || !std::isfinite(cellSize)) {
+		cellSize = 1.0f;
+	}
+
+	// 今の格子で足りているか
+	if (!isForced && grid_.axes[0] == kAxes[0] && grid_.axes[1] == kAxes[1] &&
+		grid_.cellSize >= minCellSize && grid_.cellSize <= cellSize * 2.0f && grid_.cellSize * 2.0f >= cellSize) {
+
+		bool isInside = true;
+		for (int gridAxis = 0; gridAxis < 2; ++gridAxis) {
+			float gridMax = grid_.origin[gridAxis] + static_cast<float>(grid_.count[gridAxis]) * grid_.cellSize;
+			if (minValues[gridAxis] < grid_.origin[gridAxis] - grid_.cellSize || maxValues[gridAxis] > gridMax + grid_.cellSize) {
+				isInside = false;
+			}
+		}
+		if (isInside) {
+			return false;
+		}
+	}
+
+	grid_.axes[0] = kAxes[0];
+	grid_.axes[1] = kAxes[1];
+	grid_.cellSize = cellSize;
+	grid_.inverseCellSize = 1.0f / cellSize;
+	for (int gridAxis = 0; gridAxis < 2; ++gridAxis) {
+		grid_.origin[gridAxis] = kCount > 0 ? minValues[gridAxis] : 0.0f;
+		float extent = kCount > 0 ? maxValues[gridAxis] - minValues[gridAxis] : 0.0f;
+		float count = std::isfinite(extent) ? std::floor(extent * grid_.inverseCellSize) + 1.0f : 1.0f;
+		grid_.count[gridAxis] = static_cast<uint32_t>(std::clamp(count, 1.0f, static_cast<float>(kMaxCellsPerAxis)));
+	}
+
+	return true;
+}
+
+/// <summary>
+/// 今のフレームの値を球の番号の順に作る
+/// 球の配列は番号の順に読むだけにして、並びの順に飛び飛びに読むのは1つの球につき1要素で済むようにする
+/// </summary>
+/// <param name="spheres"></param>
+void SortAndSweep::BuildSphereEntries(const SphereSoA& spheres) {
+
+	const size_t kCount = spheres.Size();
+	const std::vector<float>* centers[3] = { &spheres.center.x, &spheres.center.y, &spheres.center.z };
+	const std::vector<float>& center = *centers[axis_];
+	const std::vector<float>& centerB = *centers[grid_.axes[0]];
+	const std::vector<float>& centerC = *centers[grid_.axes[1]];
+
+	sphereEntries_.resize(kCount);
+	for (size_t i = 0; i < kCount; ++i) {
+
+		Entry& entry = sphereEntries_[i];
+		entry.index = static_cast<uint32_t>(i);
+		entry.center = spheres.center.Get(i);
+		entry.radius = spheres.radius[i];
+		entry.min = center[i] - entry.radius;
+		entry.max = center[i] + entry.radius;
+		entry.cell = grid_.CellOf(1, centerC[i]) * grid_.count[0] + grid_.CellOf(0, centerB[i]);
+	}
+}
+
+/// <summary>
+/// 全ての球から並びを作り直す
+/// </summary>
+void SortAndSweep::RebuildEntries() {
+
+	entries_ = sphereEntries_;
+	std::sort(entries_.begin(), entries_.end(), IsEntryLess<Entry>);
+}
+
+/// <summary>
+/// 持ち越した並びを今のフレームの値で更新して並べ直す
+/// 格子を移った球は抜き出してソートし、最後に併合する
+/// 残りは格子の順が変わらないので、格子の中の区間の始点だけを挿入ソートで直す
+/// </summary>
+/// <returns>崩れすぎていて全体をソートし直すべきならfalse</returns>
+bool SortAndSweep::UpdateEntries() {
+
+	const size_t kCount = entries_.size();
+
+	/****************************************************************************************************************************/
+	// 今の値に置き換え、格子を移った球を抜き出す
+
+	const size_t kMaxMovedCount = static_cast<size_t>(static_cast<float>(kCount) * kMaxCellChangeRatio);
+	movedEntries_.clear();
+
+	size_t keptCount = 0;
+	for (size_t i = 0; i < kCount; ++i) {
+
+		const Entry& entry = sphereEntries_[entries_[i].index];
+		if (entry.cell != entries_[i].cell) {
+			movedEntries_.push_back(entry);
+			if (movedEntries_.size() > kMaxMovedCount) {
+				return false;
+			}
+			continue;
+		}
+
+		entries_[keptCount++] = entry;
+	}
+	entries_.resize(keptCount);
+
+	/****************************************************************************************************************************/
+	// 残りを挿入ソートで直す、ずらした回数が多すぎる時はソートに切り替える
+
+	const uint64_t kMaxShiftCount = static_cast<uint64_t>(kMaxShiftsPerSphere) * kCount;
+	uint64_t shiftCount = 0;
+
+	for (size_t i = 1; i < keptCount; ++i) {
+
+		if (!IsEntryLess(entries_[i], entries_[i - 1])) {
+			continue;
+		}
+
+		Entry entry = entries_[i];
+		size_t j = i;
+		while (j > 0 && IsEntryLess(entry, entries_[j - 1])) {
+			entries_[j] = entries_[j - 1];
+			--j;
+		}
+		entries_[j] = entry;
+
+		shiftCount += i - j;
+		if (shiftCount > kMaxShiftCount) {
+			std::sort(entries_.begin(), entries_.end(), IsEntryLess<Entry>);
+			stats_.isFullSort = true;
+			break;
+		}
+	}
+
+	stats_.shiftCount = shiftCount;
+	stats_.cellChangeCount = static_cast<uint32_t>(movedEntries_.size());
+
+	/****************************************************************************************************************************/
+	// 格子を移った球を併合する
+
+	if (!movedEntries_.empty()) {
+
+		std::sort(movedEntries_.begin(), movedEntries_.end(), IsEntryLess<Entry>);
+
+		mergeBuffer_.resize(kCount);
+		std::merge(entries_.begin(), entries_.end(), movedEntries_.begin(), movedEntries_.end(), mergeBuffer_.begin(), IsEntryLess<Entry>);
+		entries_.swap(mergeBuffer_);
+	}
+
+	return true;
+}
+
+/// <summary>
+/// 格子ごとの並びの範囲と、スレッドに渡す区切りを作る
+/// </summary>
+void SortAndSweep::BuildCells() {
+
+	const uint32_t kCellCount = grid_.count[0] * grid_.count[1];
+	const uint32_t kCount = static_cast<uint32_t>(entries_.size());
+
+	// 並びは格子の順なので、先頭から見ていけば各格子の始まりが分かる
+	cellStarts_.resize(static_cast<size_t>(kCellCount) + 1);
+	uint32_t entry = 0;
+	for (uint32_t cell = 0; cell <= kCellCount; ++cell) {
+		while (entry < kCount && entries_[entry].cell < cell) {
+			++entry;
+		}
+		cellStarts_[cell] = entry;
+	}
+	cellStarts_[kCellCount] = kCount;
+
+	// 球の数がkPartitionSizeくらいずつになるように格子をまとめる
+	partitionCells_.clear();
+	partitionCells_.push_back(0);
+	for (uint32_t cell = 0; cell < kCellCount; ++cell) {
+		if (cellStarts_[cell + 1] - cellStarts_[partitionCells_.back()] >= kPartitionSize) {
+			partitionCells_.push_back(cell + 1);
+		}
+	}
+	if (partitionCells_.back() != kCellCount) {
+		partitionCells_.push_back(kCellCount);
+	}
+}
+
+/// <summary>
+/// [beginCell, endCell)の格子の中と、隣の格子との間で重なる球を調べる
+/// 格子の中の並びはソート済みなので、後ろの区間の始点が今の区間の終点を超えた時点でそれ以降も重ならない
+/// 隣の格子は(b+1, c)(b-1, c+1)(b, c+1)(b+1, c+1)の4つだけを見て、組を一度だけ数える
+/// 隣の格子とは、2つのソート済みの並びを始点の順に進めながら調べる
+/// </summary>
+/// <param name="beginCell"></param>
+/// <param name="endCell"></param>
+/// <param name="outPairs"></param>
+/// <param name="outTestCount"></param>
+void SortAndSweep::Sweep(size_t beginCell, size_t endCell, std::vector<Pair>& outPairs, uint64_t& outTestCount) const {
+
+	const Entry* entries = entries_.data();
+	uint64_t testCount = 0;
+
+	auto test = [&outPairs, &testCount](const Entry& a, const Entry& b) {
+
+		++testCount;
+
+		float dx = b.center.x - a.center.x;
+		float dy = b.center.y - a.center.y;
+		float dz = b.center.z - a.center.z;
+		float radiusSum = a.radius + b.radius;
+		if (dx * dx + dy * dy + dz * dz <= radiusSum * radiusSum) {
+			outPairs.push_back({ (std::min)(a.index, b.index), (std::max)(a.index, b.index) });
+		}
+		};
+
+	const int32_t kCountB = static_cast<int32_t>(grid_.count[0]);
+	const int32_t kCountC = static_cast<int32_t>(grid_.count[1]);
+	const int32_t kNeighbors[4][2] = { { 1, 0 }, { -1, 1 }, { 0, 1 }, { 1, 1 } };
+
+	for (size_t cell = beginCell; cell < endCell; ++cell) {
+
+		const uint32_t kBegin = cellStarts_[cell];
+		const uint32_t kEnd = cellStarts_[cell + 1];
+		if (kBegin == kEnd) {
+			continue;
+		}
+
+		// 格子の中
+		for (uint32_t entry1 = kBegin; entry1 < kEnd; ++entry1) {
+			const float kMax = entries[entry1].max;
+			for (uint32_t entry2 = entry1 + 1; entry2 < kEnd && entries[entry2].min <= kMax; ++entry2) {
+				test(entries[entry1], entries[entry2]);
+			}
+		}
+
+		// 隣の格子
+		const int32_t kCellB = static_cast<int32_t>(cell % grid_.count[0]);
+		const int32_t kCellC = static_cast<int32_t>(cell / grid_.count[0]);
+		for (const int32_t* neighbor : kNeighbors) {
+
+			const int32_t kNeighborB = kCellB + neighbor[0];
+			const int32_t kNeighborC = kCellC + neighbor[1];
+			if (kNeighborB < 0 || kNeighborB >= kCountB || kNeighborC >= kCountC) {
+				continue;
+			}
+
+			const size_t kNeighborCell = static_cast<size_t>(kNeighborC) * grid_.count[0] + static_cast<size_t>(kNeighborB);
+			uint32_t a = kBegin;
+			uint32_t b = cellStarts_[kNeighborCell];
+			const uint32_t kEndB = cellStarts_[kNeighborCell + 1];
+
+			// 始点が小さい方を取り出し、もう一方の並びで区間が重なるものを調べる
+			while (a < kEnd && b < kEndB) {
+				if (entries[a].min <= entries[b].min) {
+					const float kMax = entries[a].max;
+					for (uint32_t other = b; other < kEndB && entries[other].min <= kMax; ++other) {
+						test(entries[a], entries[other]);
+					}
+					++a;
+				} else {
+					const float kMax = entries[b].max;
+					for (uint32_t other = a; other < kEnd && entries[other].min <= kMax; ++other) {
+						test(entries[b], entries[other]);
+					}
+					++b;
+				}
+			}
+		}
+	}
+
+	outTestCount = testCount;
+}
+
+/// <summary>
+/// 球の位置で重なっている組を探し直す
+/// </summary>
+/// <param name="spheres"></param>
+void SortAndSweep::Update(const SphereSoA& spheres) {
+
+	auto start = std::chrono::steady_clock::now();
+
+	const size_t kCount = spheres.Size();
+
+	stats_.isFullSort = false;
+	stats_.shiftCount = 0;
+	stats_.cellChangeCount = 0;
+
+	// 球の数、軸、格子のどれかが変わったら並びを作り直す
+	bool isRebuild = entries_.size() != kCount;
+
+	uint32_t axis = ChooseAxis(spheres);
+	if (axis != axis_) {
+		axis_ = axis;
+		isRebuild = true;
+	}
+
+	if (UpdateGrid(spheres, isRebuild)) {
+		isRebuild = true;
+	}
+
+	BuildSphereEntries(spheres);
+
+	if (isRebuild || !UpdateEntries()) {
+		RebuildEntries();
+		stats_.isFullSort = true;
+	}
+
+	BuildCells();
+
+	/****************************************************************************************************************************/
+	// 格子をまとめた区切りごとに調べる
+
+	const size_t kPartitionCount = partitionCells_.size() - 1;
+	partitionPairs_.resize(kPartitionCount);
+	partitionTestCounts_.assign(kPartitionCount, 0);
+
+	std::function<void(size_t)> sweepPartition = [this](size_t partition) {
+		partitionPairs_[partition].clear();
+		Sweep(partitionCells_[partition], partitionCells_[partition + 1], partitionPairs_[partition], partitionTestCounts_[partition]);
+		};
+
+	if (kCount >= kParallelThreshold) {
+		workerPool_.Run(kPartitionCount, sweepPartition);
+	} else {
+		for (size_t partition = 0; partition < kPartitionCount; ++partition) {
+			sweepPartition(partition);
+		}
+	}
+
+	pairs_.clear();
+	stats_.testCount = 0;
+	for (size_t partition = 0; partition < kPartitionCount; ++partition) {
+		pairs_.insert(pairs_.end(), partitionPairs_[partition].begin(), partitionPairs_[partition].end());
+		stats_.testCount += partitionTestCounts_[partition];
+	}
+
+	auto end = std::chrono::steady_clock::now();
+
+	stats_.sphereCount = static_cast<uint32_t>(kCount);
+	stats_.pairCount = static_cast<uint32_t>(pairs_.size());
+	stats_.axis = axis_;
+	stats_.cellCount = grid_.count[0] * grid_.count[1];
+	stats_.milliseconds = std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+/// <summary>
+/// 全ての組を調べる(比較用)
+/// </summary>
+/// <param name="spheres"></param>
+/// <param name="outPairs"></param>
+void SortAndSweep::FindPairsBruteForce(const SphereSoA& spheres, std::vector<Pair>& outPairs) {
+
+	outPairs.clear();
+
+	const size_t kCount = spheres.Size();
+	for (size_t i = 0; i < kCount; ++i) {
+		for (size_t j = i + 1; j < kCount; ++j) {
+
+			float dx = spheres.center.x[j] - spheres.center.x[i];
+			float dy = spheres.center.y[j] - spheres.center.y[i];
+			float dz = spheres.center.z[j] - spheres.center.z[i];
+			float radiusSum = spheres.radius[i] + spheres.radius[j];
+
+			if (dx * dx + dy * dy + dz * dz <= radiusSum * radiusSum) {
+				outPairs.push_back({ static_cast<uint32_t>(i), static_cast<uint32_t>(j) });
+			}
+		}
+	}
+}
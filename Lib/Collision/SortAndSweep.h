@@ -0,0 +1,150 @@
+﻿#pragma once
+#include <vector>
+#include "MyMath.h"
+#include "MyMathBatch.h"
+#include "WorkerPool.h"
+
+/// <summary>
+/// 球の重なりを探すブロードフェーズ(ソートアンドスイープ)
+/// 球を1つの軸に投影した区間でスイープする、スイープしない残りの2軸は格子に区切り、
+/// 球は中心が入る格子の1つだけに入れて、並びを(格子, 区間の始点)の順に持つ
+/// 格子の一辺は最大の直径以上なので、重なる球は同じ格子か隣の格子にあり、格子ごとに自分と隣の半分だけを調べる
+/// 並びは次のフレームに持ち越し、格子を移った球だけを抜き出してソートしてから併合し、残りは挿入ソートで直す
+/// 格子の中の球の数は球の総数によらないので、少しずつ動く場面では1つあたりの手間が球の数によらずほぼ一定
+/// 球が多い時は格子をまとめた区切りごとに、一度だけ立てたスレッドで調べる
+/// </summary>
+class SortAndSweep {
+public:
+	/// <summary>
+	/// 型定義
+	/// </summary>
+
+	// 重なっている球の組(first < second)
+	struct Pair {
+
+		uint32_t first;
+		uint32_t second;
+	};
+
+	// 1回の更新の統計
+	struct Stats {
+
+		uint32_t sphereCount;
+		uint32_t pairCount;
+		uint32_t axis;            // 投影した軸(0:x 1:y 2:z)
+		uint32_t cellCount;       // 残りの2軸の格子の数
+		bool isFullSort;          // 持ち越した並びを使わずに全体をソートし直したか
+		uint32_t cellChangeCount; // 格子を移って並びに入れ直した球の数
+		uint64_t shiftCount;      // 挿入ソートで要素をずらした回数
+		uint64_t testCount;       // 区間が重なって球同士を調べた回数
+		double milliseconds;
+	};
+
+private:
+	// 並びの1要素、スイープの時に順に読めるよう球の値も持つ
+	struct Entry {
+
+		uint32_t cell;  // 中心が入る格子
+		float min;      // 投影した区間
+		float max;
+		uint32_t index; // 球の番号
+		Vec3f center;
+		float radius;
+	};
+
+	// スイープしない2軸の格子
+	struct Grid {
+
+		uint32_t axes[2];      // 格子にする軸
+		float origin[2];       // 格子の最小点
+		float cellSize;
+		float inverseCellSize;
+		uint32_t count[2];     // 軸ごとの格子の数
+
+		// 座標が入る格子の番号(範囲外は端の格子)
+		uint32_t CellOf(int gridAxis, float value) const;
+	};
+
+	/// <summary>
+	/// メンバ変数
+	/// </summary>
+
+	// これより球が少なければ1スレッドで調べる
+	static const uint32_t kParallelThreshold = 16384;
+	// 1スレッドが1回に受け持つ球の数の目安
+	static const uint32_t kPartitionSize = 2048;
+	// 挿入ソートで1要素あたりこれ以上ずらしたら、並びが崩れているとみなして全体をソートする
+	static const uint32_t kMaxShiftsPerSphere = 16;
+	// 格子を移った球がこの割合を超えたら全体をソートする
+	static constexpr float kMaxCellChangeRatio = 0.25f;
+	// 軸を変えるのは、分散が今の軸よりこの倍率以上大きくなった時
+	static constexpr float kAxisSwitchRatio = 1.25f;
+	// 格子の一辺(平均の直径に対する倍率、最大の直径より小さくはしない)
+	static constexpr float kCellSizeScale = 2.0f;
+	// 格子の1軸あたりの数の上限
+	static const uint32_t kMaxCellsPerAxis = 256;
+
+	WorkerPool workerPool_;
+
+	// (格子, 区間の始点)の順の並び(フレームをまたいで持ち越す)
+	std::vector<Entry> entries_;
+	// 今のフレームの値を球の番号の順に並べたもの、並びの更新ではここから1回の読み込みで取り出す
+	std::vector<Entry> sphereEntries_;
+	std::vector<Entry> movedEntries_;
+	std::vector<Entry> mergeBuffer_;
+	uint32_t axis_ = 0;
+
+	// 格子ごとの並びの範囲、cellStarts_[cell]からcellStarts_[cell + 1]まで
+	Grid grid_{};
+	std::vector<uint32_t> cellStarts_;
+
+	// スレッドに渡す区切りの先頭の格子、最後に格子の数を入れる
+	std::vector<uint32_t> partitionCells_;
+
+	// 区切りごとの結果、区切りの順につなげるのでスレッド数によらず同じ並びになる
+	std::vector<std::vector<Pair>> partitionPairs_;
+	std::vector<uint64_t> partitionTestCounts_;
+	std::vector<Pair> pairs_;
+
+	Stats stats_{};
+
+	// 分散が最も大きい軸を選ぶ
+	uint32_t ChooseAxis(const SphereSoA& spheres) const;
+	// 球の範囲と半径から格子を決める、今の格子で足りていればfalse
+	bool UpdateGrid(const SphereSoA& spheres, bool isForced);
+	// 今のフレームの値を球の番号の順に作る
+	void BuildSphereEntries(const SphereSoA& spheres);
+	// 全ての球から並びを作り直す
+	void RebuildEntries();
+	// 持ち越した並びを今のフレームの値で更新して並べ直す、崩れすぎていればfalse
+	bool UpdateEntries();
+	// 格子ごとの範囲と、スレッドに渡す区切りを作る
+	void BuildCells();
+	// [beginCell, endCell)の格子の中と、隣の格子との間で重なる球を調べる
+	void Sweep(size_t beginCell, size_t endCell, std::vector<Pair>& outPairs, uint64_t& outTestCount) const;
+
+public:
+	/// <summary>
+	/// メンバ関数
+	/// </summary>
+
+	// コンストラクタ
+	SortAndSweep() {}
+	// デストラクタ
+	~SortAndSweep() {}
+
+	// 初期化、threadCountが0ならハードウェアのスレッド数を使う
+	void Init(uint32_t threadCount = 0);
+	// 球の位置で重なっている組を探し直す
+	void Update(const SphereSoA& spheres);
+
+	// 全ての組を調べる(比較用)
+	static void FindPairsBruteForce(const SphereSoA& spheres, std::vector<Pair>& outPairs);
+
+	/// <summary>
+	/// ゲッター
+	/// </summary>
+	/// <returns></returns>
+	const std::vector<Pair>& GetPairs() const { return pairs_; }
+	const Stats& GetStats() const { return stats_; }
+};
@@ -0,0 +1,185 @@
+﻿#pragma once
+#include <condition_variable>
+#include <coroutine>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <utility>
+
+/// <summary>
+/// 戻り値の無いコルーチン
+/// 作っただけでは始まらず、Startか、キューに積まれて再開された時に進む
+/// 途中で止まっている間にTaskを破棄すると再開できなくなるので、持ち主は終わるまで持っておくこと
+/// </summary>
+class Task {
+public:
+	/// <summary>
+	/// 型定義
+	/// </summary>
+
+	struct promise_type {
+
+		Task get_return_object() { return Task(std::coroutine_handle<promise_type>::from_promise(*this)); }
+		std::suspend_always initial_suspend() noexcept { return {}; }
+		// 終わった後もhandleを持ち主が破棄するまで残す
+		std::suspend_always final_suspend() noexcept { return {}; }
+		void return_void() {}
+		// このリポジトリでは例外を使わないので、来たら終了する
+		void unhandled_exception() { std::terminate(); }
+	};
+
+private:
+	/// <summary>
+	/// メンバ変数
+	/// </summary>
+
+	std::coroutine_handle<promise_type> handle_;
+
+	explicit Task(std::coroutine_handle<promise_type> handle) : handle_(handle) {}
+
+public:
+	/// <summary>
+	/// メンバ関数
+	/// </summary>
+
+	// コンストラクタ
+	Task() {}
+	Task(Task&& other) noexcept : handle_(std::exchange(other.handle_, {})) {}
+	Task& operator=(Task&& other) noexcept {
+		if (this != &other) {
+			Reset();
+			handle_ = std::exchange(other.handle_, {});
+		}
+		return *this;
+	}
+	Task(const Task&) = delete;
+	Task& operator=(const Task&) = delete;
+	// デストラクタ
+	~Task() { Reset(); }
+
+	// 最初の中断点まで進める
+	void Start() {
+		if (handle_ && !handle_.done()) {
+			handle_.resume();
+		}
+	}
+
+	// 破棄する(終わっているか、始まっていない時だけ呼ぶ)
+	void Reset() {
+		if (handle_) {
+			handle_.destroy();
+			handle_ = {};
+		}
+	}
+
+	/// <summary>
+	/// ゲッター
+	/// </summary>
+	/// <returns></returns>
+	bool IsValid() const { return static_cast<bool>(handle_); }
+	bool IsDone() const { return !handle_ || handle_.done(); }
+};
+
+/// <summary>
+/// コルーチンを再開するスレッドを決めるキュー
+/// co_await queue.Schedule() で今のコルーチンを積み、キューを持つスレッドがRunPendingかRunOneで再開する
+/// </summary>
+class TaskQueue {
+private:
+	/// <summary>
+	/// メンバ変数
+	/// </summary>
+
+	std::mutex mutex_;
+	std::condition_variable condition_;
+	std::deque<std::coroutine_handle<>> handles_;
+	std::deque<std::coroutine_handle<>> runningHandles_;
+	bool isClosed_ = false;
+
+public:
+	/// <summary>
+	/// 型定義
+	/// </summary>
+
+	// co_awaitで今のコルーチンをキューに積む
+	struct ScheduleAwaiter {
+
+		TaskQueue& queue;
+
+		bool await_ready() const noexcept { return false; }
+		// 積んだ直前から別のスレッドで再開されうるので、積んだ後はこのAwaiterに触らない
+		void await_suspend(std::coroutine_handle<> handle) { queue.Push(handle); }
+		void await_resume() const noexcept {}
+	};
+
+	/// <summary>
+	/// メンバ関数
+	/// </summary>
+
+	// コンストラクタ
+	TaskQueue() {}
+	// デストラクタ
+	~TaskQueue() {}
+
+	// 今のコルーチンをこのキューで再開させる
+	ScheduleAwaiter Schedule() { return { *this }; }
+
+	// コルーチンを積む
+	void Push(std::coroutine_handle<> handle) {
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			handles_.push_back(handle);
+		}
+		condition_.notify_one();
+	}
+
+	/// <summary>
+	/// 積まれているコルーチンを全て再開する
+	/// 再開中に積まれたものは次の呼び出しまで待たせる(1フレームに1回呼ぶと、次のフレームで再開する)
+	/// </summary>
+	/// <returns>再開した数</returns>
+	size_t RunPending() {
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			runningHandles_.swap(handles_);
+		}
+
+		size_t count = runningHandles_.size();
+		for (std::coroutine_handle<> handle : runningHandles_) {
+			handle.resume();
+		}
+		runningHandles_.clear();
+
+		return count;
+	}
+
+	/// <summary>
+	/// コルーチンが積まれるまで待って1つ再開する
+	/// </summary>
+	/// <returns>Closeされて積まれたものが無くなったらfalse</returns>
+	bool RunOne() {
+
+		std::coroutine_handle<> handle;
+		{
+			std::unique_lock<std::mutex> lock(mutex_);
+			condition_.wait(lock, [this]() { return isClosed_ || !handles_.empty(); });
+			if (handles_.empty()) {
+				return false;
+			}
+			handle = handles_.front();
+			handles_.pop_front();
+		}
+
+		handle.resume();
+		return true;
+	}
+
+	// RunOneで待っているスレッドを起こして終わらせる
+	void Close() {
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			isClosed_ = true;
+		}
+		condition_.notify_all();
+	}
+};
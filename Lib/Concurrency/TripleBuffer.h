@@ -0,0 +1,76 @@
+﻿#pragma once
+#include <stdint.h>
+#include <atomic>
+
+/// <summary>
+/// 書き込み側と読み込み側がそれぞれ別のスレッドから使う、ロックの無いトリプルバッファ
+/// 書き込み側は常に空いているバッファに書けて、読み込み側は常に最新の完成したバッファを読める
+/// 読まれなかった古い値は上書きされる(最新の値だけが届く)
+/// </summary>
+template<typename T>
+class TripleBuffer {
+private:
+	/// <summary>
+	/// メンバ変数
+	/// </summary>
+
+	// 受け渡し用の番号に立てる、新しい値が入っている印
+	static const uint32_t kDirtyBit = 0x4;
+	static const uint32_t kIndexMask = 0x3;
+
+	T buffers_[3]{};
+
+	// 書き込み側と読み込み側がそれぞれ持っているバッファの番号
+	uint32_t writeIndex_ = 0;
+	uint32_t readIndex_ = 1;
+
+	// 受け渡し用のバッファの番号
+	std::atomic<uint32_t> sharedIndex_{ 2 };
+
+public:
+	/// <summary>
+	/// メンバ関数
+	/// </summary>
+
+	// コンストラクタ
+	TripleBuffer() {}
+	// デストラクタ
+	~TripleBuffer() {}
+
+	/// <summary>
+	/// 書き込み側: 書き込むバッファ
+	/// 中身は2つ前に書いた値なので、全て書き直すこと
+	/// </summary>
+	/// <returns></returns>
+	T& GetWriteBuffer() { return buffers_[writeIndex_]; }
+
+	/// <summary>
+	/// 書き込み側: 書き終えたバッファを受け渡し用と交換する
+	/// </summary>
+	void Publish() {
+
+		uint32_t previous = sharedIndex_.exchange(writeIndex_ | kDirtyBit, std::memory_order_acq_rel);
+		writeIndex_ = previous & kIndexMask;
+	}
+
+	/// <summary>
+	/// 読み込み側: 新しい値があれば受け取る
+	/// </summary>
+	/// <returns>新しい値を受け取ったか</returns>
+	bool Update() {
+
+		if ((sharedIndex_.load(std::memory_order_relaxed) & kDirtyBit) == 0) {
+			return false;
+		}
+
+		uint32_t previous = sharedIndex_.exchange(readIndex_, std::memory_order_acq_rel);
+		readIndex_ = previous & kIndexMask;
+		return true;
+	}
+
+	/// <summary>
+	/// 読み込み側: 最後に受け取った値
+	/// </summary>
+	/// <returns></returns>
+	const T& GetReadBuffer() const { return buffers_[readIndex_]; }
+};
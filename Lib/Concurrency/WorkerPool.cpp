@@ -0,0 +1,113 @@
+﻿#include "WorkerPool.h"
+#include <algorithm>
+
+/// <summary>
+/// 初期化
+/// 前に立てたスレッドは止めてから立て直す
+/// </summary>
+/// <param name="threadCount">呼び出し元を含む数、0ならハードウェアのスレッド数</param>
+void WorkerPool::Init(uint32_t threadCount) {
+
+	Stop();
+
+	if (threadCount == 0) {
+		threadCount = (std::max)(1u, std::thread::hardware_concurrency());
+	}
+
+	isStopping_ = false;
+	workers_.reserve(threadCount - 1);
+	for (uint32_t i = 0; i + 1 < threadCount; ++i) {
+		workers_.emplace_back(&WorkerPool::WorkerLoop, this);
+	}
+}
+
+/// <summary>
+/// スレッドを止める
+/// </summary>
+void WorkerPool::Stop() {
+
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		isStopping_ = true;
+	}
+	startCondition_.notify_all();
+
+	for (std::thread& worker : workers_) {
+		worker.join();
+	}
+	workers_.clear();
+}
+
+/// <summary>
+/// 残りの仕事を取り出しながら行う
+/// </summary>
+void WorkerPool::Work() {
+
+	for (size_t job = nextJob_++; job < jobCount_; job = nextJob_++) {
+		(*job_)(job);
+	}
+}
+
+/// <summary>
+/// 立てたスレッドの本体
+/// Runで番号が進むまで眠り、仕事が無くなったら終わったことを知らせる
+/// </summary>
+void WorkerPool::WorkerLoop() {
+
+	uint64_t seenGeneration = 0;
+
+	while (true) {
+
+		{
+			std::unique_lock<std::mutex> lock(mutex_);
+			startCondition_.wait(lock, [&]() { return isStopping_ || generation_ != seenGeneration; });
+			if (isStopping_) {
+				return;
+			}
+			seenGeneration = generation_;
+		}
+
+		Work();
+
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			if (--pendingWorkerCount_ == 0) {
+				doneCondition_.notify_one();
+			}
+		}
+	}
+}
+
+/// <summary>
+/// 0からjobCount - 1の番号でjobを呼び、全て終わるまで待つ
+/// 仕事が1つ以下かスレッドが無い時は呼び出し元だけで行う
+/// </summary>
+/// <param name="jobCount"></param>
+/// <param name="job"></param>
+void WorkerPool::Run(size_t jobCount, const std::function<void(size_t)>& job) {
+
+	if (workers_.empty() || jobCount <= 1) {
+		for (size_t i = 0; i < jobCount; ++i) {
+			job(i);
+		}
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		job_ = &job;
+		jobCount_ = jobCount;
+		nextJob_ = 0;
+		pendingWorkerCount_ = workers_.size();
+		++generation_;
+	}
+	startCondition_.notify_all();
+
+	Work();
+
+	// 立てたスレッドが全て仕事を終えるまで、jobは破棄できない
+	std::unique_lock<std::mutex> lock(mutex_);
+	doneCondition_.wait(lock, [this]() { return pendingWorkerCount_ == 0; });
+	job_ = nullptr;
+	jobCount_ = 0;
+}
@@ -0,0 +1,66 @@
+﻿#pragma once
+#include <stdint.h>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/// <summary>
+/// 一度だけ立てたスレッドを使い回して、番号で分けた仕事を並列に行うクラス
+/// Runを呼んだスレッドも仕事をするので、Initで指定した数のうち1つは呼び出し元になる
+/// Runは同時に1つのスレッドからしか呼ばないこと
+/// </summary>
+class WorkerPool {
+private:
+	/// <summary>
+	/// メンバ変数
+	/// </summary>
+
+	std::vector<std::thread> workers_;
+
+	std::mutex mutex_;
+	std::condition_variable startCondition_;
+	std::condition_variable doneCondition_;
+
+	// Runごとに進める番号、スレッドはこれが変わると起きる
+	uint64_t generation_ = 0;
+	bool isStopping_ = false;
+	size_t pendingWorkerCount_ = 0;
+
+	// 今のRunの仕事
+	const std::function<void(size_t)>* job_ = nullptr;
+	size_t jobCount_ = 0;
+	std::atomic<size_t> nextJob_ = 0;
+
+	// 残りの仕事を取り出しながら行う
+	void Work();
+	// 立てたスレッドの本体
+	void WorkerLoop();
+	// スレッドを止める
+	void Stop();
+
+public:
+	/// <summary>
+	/// メンバ関数
+	/// </summary>
+
+	// コンストラクタ
+	WorkerPool() {}
+	WorkerPool(const WorkerPool&) = delete;
+	WorkerPool& operator=(const WorkerPool&) = delete;
+	// デストラクタ
+	~WorkerPool() { Stop(); }
+
+	// 初期化、threadCountは呼び出し元を含む数で、0ならハードウェアのスレッド数
+	void Init(uint32_t threadCount = 0);
+	// 0からjobCount - 1の番号でjobを呼び、全て終わるまで待つ
+	void Run(size_t jobCount, const std::function<void(size_t)>& job);
+
+	/// <summary>
+	/// ゲッター
+	/// </summary>
+	/// <returns></returns>
+	uint32_t GetThreadCount() const { return static_cast<uint32_t>(workers_.size()) + 1; }
+};
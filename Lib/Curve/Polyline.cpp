@@ -0,0 +1,316 @@
+﻿#include "Polyline.h"
+#include "MyMathSSE.h"
+#include <algorithm>
+#include <limits>
+#include <utility>
+
+namespace {
+
+	using namespace MathSSE;
+
+	const float kInfinity = std::numeric_limits<float>::infinity();
+
+	// 4の倍数に切り上げる
+	size_t AlignTo4(size_t count) {
+		return (count + 3) & ~static_cast<size_t>(3);
+	}
+
+	/// <summary>
+	/// 点と4つのAABBの距離の2乗(AABBの中の点は0)
+	/// 空のAABB(最小が+∞、最大が-∞)は∞になる
+	/// </summary>
+	__m128 DistanceSquaredToAABB(const Vec3x4& point, const Vec3fSoA& min, const Vec3fSoA& max, size_t index) {
+
+		const __m128 zero = _mm_setzero_ps();
+
+		Vec3x4 lower = Load(min, index);
+		Vec3x4 upper = Load(max, index);
+
+		__m128 dx = _mm_max_ps(_mm_max_ps(_mm_sub_ps(lower.x, point.x), _mm_sub_ps(point.x, upper.x)), zero);
+		__m128 dy = _mm_max_ps(_mm_max_ps(_mm_sub_ps(lower.y, point.y), _mm_sub_ps(point.y, upper.y)), zero);
+		__m128 dz = _mm_max_ps(_mm_max_ps(_mm_sub_ps(lower.z, point.z), _mm_sub_ps(point.z, upper.z)), zero);
+
+		return _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+	}
+
+	// 空のAABBで埋める
+	void FillEmpty(Vec3fSoA& min, Vec3fSoA& max, size_t begin) {
+		for (size_t i = begin; i < min.Size(); ++i) {
+			min.Set(i, { kInfinity, kInfinity, kInfinity });
+			max.Set(i, { -kInfinity, -kInfinity, -kInfinity });
+		}
+	}
+}
+
+/// <summary>
+/// 配列を線分の数に合わせて伸ばす
+/// 増えた分は空のAABBと長さ0の線分で埋めるので、4本ずつ読んでも余りが最近接にならない
+/// </summary>
+/// <param name="segmentCount"></param>
+void Polyline::Reserve(size_t segmentCount) {
+
+	size_t alignedSegmentCount = AlignTo4(segmentCount);
+	size_t oldSegmentCount = segments_.Size();
+	if (oldSegmentCount < alignedSegmentCount) {
+
+		segments_.Resize(alignedSegmentCount);
+		segmentMin_.Resize(alignedSegmentCount);
+		segmentMax_.Resize(alignedSegmentCount);
+		for (size_t i = oldSegmentCount; i < alignedSegmentCount; ++i) {
+			segments_.Set(i, { { 0.0f,0.0f,0.0f }, { 0.0f,0.0f,0.0f } });
+		}
+		FillEmpty(segmentMin_, segmentMax_, oldSegmentCount);
+	}
+
+	size_t alignedChunkCount = AlignTo4((segmentCount + kChunkSize - 1) / kChunkSize);
+	size_t oldChunkCount = chunkMin_.Size();
+	if (oldChunkCount < alignedChunkCount) {
+
+		chunkMin_.Resize(alignedChunkCount);
+		chunkMax_.Resize(alignedChunkCount);
+		FillEmpty(chunkMin_, chunkMax_, oldChunkCount);
+	}
+}
+
+/// <summary>
+/// 線分とそのAABBを書き込み、塊のAABBを広げる
+/// </summary>
+/// <param name="index"></param>
+void Polyline::WriteSegment(size_t index) {
+
+	Vec3f start = points_.Get(index);
+	Vec3f end = points_.Get(index + 1);
+	segments_.Set(index, { start, end - start });
+
+	Vec3f min = { (std::min)(start.x, end.x), (std::min)(start.y, end.y), (std::min)(start.z, end.z) };
+	Vec3f max = { (std::max)(start.x, end.x), (std::max)(start.y, end.y), (std::max)(start.z, end.z) };
+	segmentMin_.Set(index, min);
+	segmentMax_.Set(index, max);
+
+	size_t chunk = index / kChunkSize;
+	Vec3f chunkMin = chunkMin_.Get(chunk);
+	Vec3f chunkMax = chunkMax_.Get(chunk);
+	chunkMin_.Set(chunk, { (std::min)(chunkMin.x, min.x), (std::min)(chunkMin.y, min.y), (std::min)(chunkMin.z, min.z) });
+	chunkMax_.Set(chunk, { (std::max)(chunkMax.x, max.x), (std::max)(chunkMax.y, max.y), (std::max)(chunkMax.z, max.z) });
+}
+
+/// <summary>
+/// 頂点を全て置き換える
+/// </summary>
+/// <param name="points"></param>
+void Polyline::SetPoints(const std::vector<Vec3f>& points) {
+
+	Clear();
+
+	points_.Resize(points.size());
+	for (size_t i = 0; i < points.size(); ++i) {
+		points_.Set(i, points[i]);
+	}
+
+	size_t segmentCount = GetSegmentCount();
+	Reserve(segmentCount);
+	for (size_t i = 0; i < segmentCount; ++i) {
+		WriteSegment(i);
+	}
+}
+
+/// <summary>
+/// 頂点を末尾に足す
+/// </summary>
+/// <param name="point"></param>
+void Polyline::AddPoint(const Vec3f& point) {
+
+	size_t pointCount = points_.Size() + 1;
+	points_.Resize(pointCount);
+	points_.Set(pointCount - 1, point);
+
+	if (pointCount >= 2) {
+		Reserve(pointCount - 1);
+		WriteSegment(pointCount - 2);
+	}
+}
+
+/// <summary>
+/// 頂点を全て消す
+/// </summary>
+void Polyline::Clear() {
+
+	points_.Resize(0);
+	segments_.Resize(0);
+	segmentMin_.Resize(0);
+	segmentMax_.Resize(0);
+	chunkMin_.Resize(0);
+	chunkMax_.Resize(0);
+}
+
+/// <summary>
+/// 最近接点
+/// 塊のAABBまでの距離が近い順に塊を調べ、それまでの最短距離より遠い塊に来たら終わる
+/// 塊の中では線分のAABBで4本ずつ絞り込み、残った線分だけ最近接点を求める
+/// </summary>
+/// <param name="point"></param>
+/// <returns></returns>
+Polyline::ClosestResult Polyline::ClosestPoint(const Vec3f& point) const {
+
+	ClosestResult result = { point, kNoSegment, kInfinity };
+
+	size_t segmentCount = GetSegmentCount();
+	if (segmentCount == 0) {
+		if (points_.Size() == 1) {
+			result.point = points_.Get(0);
+			result.distanceSquared = Dot(result.point - point, result.point - point);
+		}
+		return result;
+	}
+
+	const Vec3x4 point4 = { _mm_set1_ps(point.x), _mm_set1_ps(point.y), _mm_set1_ps(point.z) };
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 infinity = _mm_set1_ps(kInfinity);
+
+	// 塊を近い順に並べる
+	size_t chunkCount = (segmentCount + kChunkSize - 1) / kChunkSize;
+	std::vector<std::pair<float, uint32_t>> chunks;
+	chunks.reserve(chunkCount);
+
+	for (size_t chunk = 0; chunk < chunkCount; chunk += 4) {
+
+		alignas(16) float distances[4];
+		_mm_store_ps(distances, DistanceSquaredToAABB(point4, chunkMin_, chunkMax_, chunk));
+		for (size_t lane = 0; lane < 4 && chunk + lane < chunkCount; ++lane) {
+			chunks.push_back({ distances[lane], static_cast<uint32_t>(chunk + lane) });
+		}
+	}
+	std::sort(chunks.begin(), chunks.end());
+
+	for (const std::pair<float, uint32_t>& chunk : chunks) {
+
+		if (!(chunk.first < result.distanceSquared)) {
+			break;
+		}
+
+		size_t begin = static_cast<size_t>(chunk.second) * kChunkSize;
+		size_t end = (std::min)(begin + kChunkSize, segments_.Size());
+		for (size_t i = begin; i < end; i += 4) {
+
+			__m128 best = _mm_set1_ps(result.distanceSquared);
+
+			// AABBが今の最短距離より近い線分だけ調べる
+			__m128 isCandidate = _mm_cmplt_ps(DistanceSquaredToAABB(point4, segmentMin_, segmentMax_, i), best);
+			if (_mm_movemask_ps(isCandidate) == 0) {
+				continue;
+			}
+
+			// ClosestPointBatchと同じ計算
+			Vec3x4 origin = Load(segments_.origin, i);
+			Vec3x4 diff = Load(segments_.diff, i);
+			__m128 t = Clamp01(_mm_mul_ps(Dot(Sub(point4, origin), diff), SafeReciprocal(Dot(diff, diff), zero)));
+			Vec3x4 closest = MulAdd(origin, diff, t);
+			Vec3x4 toClosest = Sub(closest, point4);
+			__m128 distance = Select(isCandidate, Dot(toClosest, toClosest), infinity);
+
+			if (_mm_movemask_ps(_mm_cmplt_ps(distance, best)) == 0) {
+				continue;
+			}
+
+			alignas(16) float distances[4];
+			alignas(16) float closestX[4];
+			alignas(16) float closestY[4];
+			alignas(16) float closestZ[4];
+			_mm_store_ps(distances, distance);
+			_mm_store_ps(closestX, closest.x);
+			_mm_store_ps(closestY, closest.y);
+			_mm_store_ps(closestZ, closest.z);
+
+			for (size_t lane = 0; lane < 4; ++lane) {
+				if (distances[lane] < result.distanceSquared) {
+					result.point = { closestX[lane], closestY[lane], closestZ[lane] };
+					result.segmentIndex = i + lane;
+					result.distanceSquared = distances[lane];
+				}
+			}
+		}
+	}
+
+	return result;
+}
+
+/// <summary>
+/// 最近接点(全ての線分をClosestPointで調べる、比較用)
+/// </summary>
+/// <param name="point"></param>
+/// <returns></returns>
+Polyline::ClosestResult Polyline::ClosestPointBruteForce(const Vec3f& point) const {
+
+	ClosestResult result = { point, kNoSegment, kInfinity };
+
+	size_t segmentCount = GetSegmentCount();
+	if (segmentCount == 0) {
+		if (points_.Size() == 1) {
+			result.point = points_.Get(0);
+			result.distanceSquared = Dot(result.point - point, result.point - point);
+		}
+		return result;
+	}
+
+	for (size_t i = 0; i < segmentCount; ++i) {
+
+		Vec3f closest = ::ClosestPoint(point, segments_.Get(i));
+		float distanceSquared = Dot(closest - point, closest - point);
+		if (distanceSquared < result.distanceSquared) {
+			result = { closest, i, distanceSquared };
+		}
+	}
+
+	return result;
+}
+
+/// <summary>
+/// 描画
+/// 前に描いた頂点から近すぎる頂点を飛ばすので、画面上で細かい折れ線ほど線の数が減る
+/// </summary>
+/// <param name="color"></param>
+/// <param name="minPixelLength"></param>
+/// <param name="viewProjectionViewportMatrix"></param>
+/// <param name="lineBatcher"></param>
+void Polyline::Draw(uint32_t color, float minPixelLength, const Matrix4x4& viewProjectionViewportMatrix, LineBatcher& lineBatcher) {
+
+	size_t pointCount = points_.Size();
+	if (pointCount < 2) {
+		return;
+	}
+
+	TransformBatch(points_, viewProjectionViewportMatrix, screenPositions_);
+
+	const float kMinLengthSquared = minPixelLength * minPixelLength;
+
+	Vec3f start = screenPositions_.Get(0);
+	for (size_t i = 1; i < pointCount; ++i) {
+
+		Vec3f end = screenPositions_.Get(i);
+
+		// 最後の頂点は必ず描く
+		if (i + 1 < pointCount) {
+			float dx = end.x - start.x;
+			float dy = end.y - start.y;
+			if (dx * dx + dy * dy < kMinLengthSquared) {
+				continue;
+			}
+		}
+
+		lineBatcher.AddLine(start, end, color);
+		start = end;
+	}
+}
+
+/// <summary>
+/// 線分をワールド座標の線として足す
+/// 画面上の長さは視点ごとに違うので、ここでは間引かない
+/// </summary>
+/// <param name="color"></param>
+/// <param name="outLines"></param>
+void Polyline::AddWorldLines(uint32_t color, WorldLines& outLines) const {
+
+	for (size_t i = 1; i < points_.Size(); ++i) {
+		outLines.Add(points_.Get(i - 1), points_.Get(i), color);
+	}
+}
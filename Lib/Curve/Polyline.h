@@ -0,0 +1,91 @@
+﻿#pragma once
+#include <vector>
+#include "MyMath.h"
+#include "MyMathBatch.h"
+#include "LineBatcher.h"
+#include "WorldLines.h"
+
+/// <summary>
+/// 折れ線クラス
+/// 線分ごとのAABBと、線分をまとめた塊ごとのAABBを持ち、最近接点の問い合わせで遠い線分を読み飛ばす
+/// 線分の配列は4の倍数に切り上げ、余りには空のAABBを入れてSSEで4本ずつ調べる
+/// </summary>
+class Polyline {
+public:
+	/// <summary>
+	/// 型定義
+	/// </summary>
+
+	// 最近接点の問い合わせ結果
+	struct ClosestResult {
+
+		Vec3f point;           // 最近接点
+		size_t segmentIndex;   // 最近接点がある線分(線分が無ければkNoSegment)
+		float distanceSquared; // 距離の2乗
+	};
+
+	static const size_t kNoSegment = static_cast<size_t>(-1);
+
+private:
+	/// <summary>
+	/// メンバ変数
+	/// </summary>
+
+	// 1つの塊に入れる線分の数(4の倍数)
+	static const size_t kChunkSize = 32;
+
+	// 頂点
+	Vec3fSoA points_;
+
+	// 線分とそのAABB(4の倍数に切り上げた数)
+	SegmentSoA segments_;
+	Vec3fSoA segmentMin_;
+	Vec3fSoA segmentMax_;
+
+	// 塊のAABB(4の倍数に切り上げた数)
+	Vec3fSoA chunkMin_;
+	Vec3fSoA chunkMax_;
+
+	// 描画用(フレームをまたいで使い回す)
+	Vec3fSoA screenPositions_;
+
+	// 配列を線分の数に合わせて伸ばす
+	void Reserve(size_t segmentCount);
+	// 線分とそのAABBを書き込み、塊のAABBを広げる
+	void WriteSegment(size_t index);
+
+public:
+	/// <summary>
+	/// メンバ関数
+	/// </summary>
+
+	// コンストラクタ
+	Polyline() {}
+	// デストラクタ
+	~Polyline() {}
+
+	// 頂点を全て置き換える
+	void SetPoints(const std::vector<Vec3f>& points);
+	// 頂点を末尾に足す
+	void AddPoint(const Vec3f& point);
+	// 頂点を全て消す
+	void Clear();
+
+	// 最近接点(AABBで絞り込み、SSEで4本ずつ調べる)
+	ClosestResult ClosestPoint(const Vec3f& point) const;
+	// 最近接点(全ての線分をClosestPointで調べる、比較用)
+	ClosestResult ClosestPointBruteForce(const Vec3f& point) const;
+
+	// 描画、前に描いた頂点からminPixelLength未満しか離れていない頂点は飛ばす
+	void Draw(uint32_t color, float minPixelLength, const Matrix4x4& viewProjectionViewportMatrix, LineBatcher& lineBatcher);
+	// 線分をワールド座標の線として足す(複数の視点で描く時)
+	void AddWorldLines(uint32_t color, WorldLines& outLines) const;
+
+	/// <summary>
+	/// ゲッター
+	/// </summary>
+	/// <returns></returns>
+	const Vec3fSoA& GetPoints() const { return points_; }
+	size_t GetPointCount() const { return points_.Size(); }
+	size_t GetSegmentCount() const { return points_.Size() == 0 ? 0 : points_.Size() - 1; }
+};
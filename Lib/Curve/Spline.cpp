@@ -0,0 +1,273 @@
+﻿#include "Spline.h"
+#include "Counters.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+	// これより小さいwの点はカメラの後ろとみなす
+	const float kMinW = 1.0e-3f;
+
+	/// <summary>
+	/// 3次Bezier曲線をt=0.5で2つに分ける(de Casteljauのアルゴリズム)
+	/// 同次座標の制御点を分けても、射影した曲線を分けたものと一致する
+	/// </summary>
+	template<typename Vector>
+	void SplitBezier(const Vector (&points)[4], Vector (&outLeft)[4], Vector (&outRight)[4]) {
+
+		Vector p01 = (points[0] + points[1]) * 0.5f;
+		Vector p12 = (points[1] + points[2]) * 0.5f;
+		Vector p23 = (points[2] + points[3]) * 0.5f;
+		Vector p012 = (p01 + p12) * 0.5f;
+		Vector p123 = (p12 + p23) * 0.5f;
+		Vector middle = (p012 + p123) * 0.5f;
+
+		outLeft[0] = points[0];
+		outLeft[1] = p01;
+		outLeft[2] = p012;
+		outLeft[3] = middle;
+
+		outRight[0] = middle;
+		outRight[1] = p123;
+		outRight[2] = p23;
+		outRight[3] = points[3];
+	}
+
+	/// <summary>
+	/// 3次Bezier曲線が弦(始点と終点を結ぶ線分)から離れている距離の上限の2乗
+	/// 曲線は制御点の凸包に収まるので、中の2つの制御点と弦の距離で抑えられる
+	/// </summary>
+	float FlatnessSquared(const Vec3f (&points)[4]) {
+
+		Segement chord = { points[0], points[3] - points[0] };
+
+		Vec3f offset1 = ClosestPoint(points[1], chord) - points[1];
+		Vec3f offset2 = ClosestPoint(points[2], chord) - points[2];
+
+		return (std::max)(Dot(offset1, offset1), Dot(offset2, offset2));
+	}
+
+	// 同次座標への変換(wで割らない)
+	Vec4f TransformHomogeneous(const Vec3f& vector, const Matrix4x4& matrix) {
+
+		return {
+			vector.x * matrix.m[0][0] + vector.y * matrix.m[1][0] + vector.z * matrix.m[2][0] + matrix.m[3][0],
+			vector.x * matrix.m[0][1] + vector.y * matrix.m[1][1] + vector.z * matrix.m[2][1] + matrix.m[3][1],
+			vector.x * matrix.m[0][2] + vector.y * matrix.m[1][2] + vector.z * matrix.m[2][2] + matrix.m[3][2],
+			vector.x * matrix.m[0][3] + vector.y * matrix.m[1][3] + vector.z * matrix.m[2][3] + matrix.m[3][3] };
+	}
+
+	/// <summary>
+	/// ワールド空間で分割して折れ線に頂点を足す(始点は足さない)
+	/// </summary>
+	void FlattenPiece(const Vec3f (&points)[4], uint32_t depth, uint32_t maxDepth, float toleranceSquared, Polyline& outPolyline) {
+
+		if (depth >= maxDepth || FlatnessSquared(points) <= toleranceSquared) {
+			outPolyline.AddPoint(points[3]);
+			return;
+		}
+
+		Vec3f left[4];
+		Vec3f right[4];
+		SplitBezier(points, left, right);
+
+		FlattenPiece(left, depth + 1, maxDepth, toleranceSquared, outPolyline);
+		FlattenPiece(right, depth + 1, maxDepth, toleranceSquared, outPolyline);
+	}
+}
+
+/// <summary>
+/// 制御点を全て置き換え、区間ごとの3次Bezier曲線に直す
+/// Catmull-Rom曲線の両端は端の制御点を重ねて延長する
+/// </summary>
+/// <param name="type"></param>
+/// <param name="controlPoints"></param>
+void Spline::SetControlPoints(Type type, const std::vector<Vec3f>& controlPoints) {
+
+	type_ = type;
+	controlPoints_ = controlPoints;
+	pieces_.clear();
+	++version_;
+
+	const size_t kCount = controlPoints_.size();
+	if (kCount < 2) {
+		return;
+	}
+
+	if (type_ == Type::kCatmullRom) {
+
+		pieces_.reserve(kCount - 1);
+		for (size_t i = 0; i + 1 < kCount; ++i) {
+
+			const Vec3f& p0 = controlPoints_[i == 0 ? 0 : i - 1];
+			const Vec3f& p1 = controlPoints_[i];
+			const Vec3f& p2 = controlPoints_[i + 1];
+			const Vec3f& p3 = controlPoints_[(std::min)(i + 2, kCount - 1)];
+
+			// 接線が(p2 - p0) / 2なので、Bezierの制御点は1/3ずらした位置
+			pieces_.push_back({ { p1, p1 + (p2 - p0) * (1.0f / 6.0f), p2 - (p3 - p1) * (1.0f / 6.0f), p2 } });
+		}
+	} else {
+
+		// 余った制御点は使わない
+		pieces_.reserve((kCount - 1) / 3);
+		for (size_t i = 0; i + 3 < kCount; i += 3) {
+			pieces_.push_back({ { controlPoints_[i], controlPoints_[i + 1], controlPoints_[i + 2], controlPoints_[i + 3] } });
+		}
+	}
+}
+
+/// <summary>
+/// 曲線上の点
+/// </summary>
+/// <param name="t">0から区間の数まで、整数部が区間の番号</param>
+/// <returns></returns>
+Vec3f Spline::Evaluate(float t) const {
+
+	if (pieces_.empty()) {
+		return controlPoints_.empty() ? Vec3f{ 0.0f,0.0f,0.0f } : controlPoints_.front();
+	}
+
+	float maxT = static_cast<float>(pieces_.size());
+	t = std::clamp(t, 0.0f, maxT);
+
+	size_t index = (std::min)(static_cast<size_t>(t), pieces_.size() - 1);
+	float u = t - static_cast<float>(index);
+	float v = 1.0f - u;
+
+	const Piece& piece = pieces_[index];
+	return piece.points[0] * (v * v * v) + piece.points[1] * (3.0f * v * v * u) +
+		piece.points[2] * (3.0f * v * u * u) + piece.points[3] * (u * u * u);
+}
+
+/// <summary>
+/// 同次座標で分割して線を描く
+/// 全ての制御点がカメラの前にあれば、射影した制御点の凸包に曲線が収まるので、
+/// 画面外の判定と平らさの判定を射影した制御点で行える
+/// </summary>
+/// <param name="points">同次座標の制御点</param>
+/// <param name="depth"></param>
+/// <param name="color"></param>
+/// <param name="tolerance">ピクセル</param>
+/// <param name="width"></param>
+/// <param name="height"></param>
+/// <param name="lineBatcher"></param>
+void Spline::DrawPiece(const Vec4f (&points)[4], uint32_t depth, uint32_t color, float tolerance, float width, float height, LineBatcher& lineBatcher) {
+
+	uint32_t frontCount = 0;
+	for (const Vec4f& point : points) {
+		if (point.w > kMinW) {
+			++frontCount;
+		}
+	}
+
+	// 全てカメラの後ろ
+	if (frontCount == 0) {
+		++stats_.culledCount;
+		return;
+	}
+
+	if (frontCount == 4) {
+
+		Vec3f screen[4];
+		float minX = std::numeric_limits<float>::infinity();
+		float minY = std::numeric_limits<float>::infinity();
+		float maxX = -std::numeric_limits<float>::infinity();
+		float maxY = -std::numeric_limits<float>::infinity();
+		for (int i = 0; i < 4; ++i) {
+
+			float inverseW = 1.0f / points[i].w;
+			screen[i] = { points[i].x * inverseW, points[i].y * inverseW, points[i].z * inverseW };
+
+			minX = (std::min)(minX, screen[i].x);
+			minY = (std::min)(minY, screen[i].y);
+			maxX = (std::max)(maxX, screen[i].x);
+			maxY = (std::max)(maxY, screen[i].y);
+		}
+
+		// 凸包が画面外
+		if (maxX < 0.0f || minX > width || maxY < 0.0f || minY > height) {
+			++stats_.culledCount;
+			return;
+		}
+
+		// 平らさは画面上(深度を除いた2次元)で測る
+		Vec3f flat[4];
+		for (int i = 0; i < 4; ++i) {
+			flat[i] = { screen[i].x, screen[i].y, 0.0f };
+		}
+
+		if (depth >= kMaxSubdivisionDepth || FlatnessSquared(flat) <= tolerance * tolerance) {
+			lineBatcher.AddLine(screen[0], screen[3], color);
+			++stats_.lineCount;
+			return;
+		}
+	} else if (depth >= kMaxSubdivisionDepth) {
+
+		// カメラをまたいだまま分割しきれなかった区間は描かない
+		++stats_.culledCount;
+		return;
+	}
+
+	Vec4f left[4];
+	Vec4f right[4];
+	SplitBezier(points, left, right);
+
+	DrawPiece(left, depth + 1, color, tolerance, width, height, lineBatcher);
+	DrawPiece(right, depth + 1, color, tolerance, width, height, lineBatcher);
+}
+
+/// <summary>
+/// 画面上の誤差がpixelTolerance以下になるように分割して描画
+/// 座標変換は区間の制御点だけで、分割は同次座標のまま行う
+/// </summary>
+/// <param name="color"></param>
+/// <param name="pixelTolerance"></param>
+/// <param name="viewProjectionViewportMatrix"></param>
+/// <param name="lineBatcher"></param>
+void Spline::Draw(uint32_t color, float pixelTolerance, const Matrix4x4& viewProjectionViewportMatrix, LineBatcher& lineBatcher) {
+
+	stats_ = {};
+
+	// 0にすると分割が止まらないので下限を設ける
+	float tolerance = (std::max)(pixelTolerance, 0.01f);
+	float width = static_cast<float>(lineBatcher.GetWidth());
+	float height = static_cast<float>(lineBatcher.GetHeight());
+
+	AddCounter(Counter::kVerticesTransformed, pieces_.size() * 4);
+
+	for (const Piece& piece : pieces_) {
+
+		Vec4f points[4];
+		for (int i = 0; i < 4; ++i) {
+			points[i] = TransformHomogeneous(piece.points[i], viewProjectionViewportMatrix);
+		}
+
+		DrawPiece(points, 0, color, tolerance, width, height, lineBatcher);
+	}
+}
+
+/// <summary>
+/// ワールド空間での誤差がworldTolerance以下になるように分割した折れ線
+/// </summary>
+/// <param name="worldTolerance"></param>
+/// <param name="outPolyline"></param>
+void Spline::Flatten(float worldTolerance, Polyline& outPolyline) const {
+
+	outPolyline.Clear();
+
+	if (pieces_.empty()) {
+		if (!controlPoints_.empty()) {
+			outPolyline.AddPoint(controlPoints_.front());
+		}
+		return;
+	}
+
+	float toleranceSquared = worldTolerance * worldTolerance;
+
+	outPolyline.AddPoint(pieces_.front().points[0]);
+	for (const Piece& piece : pieces_) {
+		FlattenPiece(piece.points, 0, kMaxSubdivisionDepth, toleranceSquared, outPolyline);
+	}
+}
@@ -0,0 +1,90 @@
+﻿#pragma once
+#include <vector>
+#include "MyMath.h"
+#include "LineBatcher.h"
+#include "Polyline.h"
+#include "Derived.h"
+
+/// <summary>
+/// スプライン曲線クラス
+/// Catmull-Rom曲線もBezier曲線も、区間ごとの3次Bezier曲線に直して持つ
+/// 描画は同次座標の制御点を画面上の誤差が許容値以下になるまで分割するので、画面に小さく映る曲線ほど線が少ない
+/// 制御点を置き換えるとバージョンが進む
+/// </summary>
+class Spline : public VersionSource {
+public:
+	/// <summary>
+	/// 型定義
+	/// </summary>
+
+	// 制御点の解釈
+	enum class Type {
+
+		kCatmullRom, // 全ての制御点を通る
+		kBezier,     // 3次Bezier曲線をつないだもの(制御点は3n+1個)
+	};
+
+	// 描画の統計
+	struct Stats {
+
+		uint32_t lineCount;   // 描いた線の数
+		uint32_t culledCount; // 画面外やカメラの後ろで捨てた区間の数
+	};
+
+private:
+	// 3次Bezier曲線の1区間
+	struct Piece {
+
+		Vec3f points[4];
+	};
+
+	/// <summary>
+	/// メンバ変数
+	/// </summary>
+
+	// 1区間を分割する深さの上限(1区間あたり最大で2の乗数本の線になる)
+	static const uint32_t kMaxSubdivisionDepth = 10;
+
+	Type type_ = Type::kCatmullRom;
+	std::vector<Vec3f> controlPoints_;
+	std::vector<Piece> pieces_;
+
+	Stats stats_{};
+
+	uint64_t version_ = 1;
+
+	// 同次座標で分割して線を描く
+	void DrawPiece(const Vec4f (&points)[4], uint32_t depth, uint32_t color, float tolerance, float width, float height, LineBatcher& lineBatcher);
+
+public:
+	/// <summary>
+	/// メンバ関数
+	/// </summary>
+
+	// コンストラクタ
+	Spline() {}
+	// デストラクタ
+	~Spline() override {}
+
+	// 制御点を全て置き換える
+	void SetControlPoints(Type type, const std::vector<Vec3f>& controlPoints);
+
+	// 曲線上の点、tは0から区間の数まで
+	Vec3f Evaluate(float t) const;
+
+	// 画面上の誤差がpixelTolerance以下になるように分割して描画
+	void Draw(uint32_t color, float pixelTolerance, const Matrix4x4& viewProjectionViewportMatrix, LineBatcher& lineBatcher);
+
+	// ワールド空間での誤差がworldTolerance以下になるように分割した折れ線(最近接点の問い合わせ用)
+	void Flatten(float worldTolerance, Polyline& outPolyline) const;
+
+	/// <summary>
+	/// ゲッター
+	/// </summary>
+	/// <returns></returns>
+	Type GetType() const { return type_; }
+	const std::vector<Vec3f>& GetControlPoints() const { return controlPoints_; }
+	size_t GetPieceCount() const { return pieces_.size(); }
+	const Stats& GetStats() const { return stats_; }
+	uint64_t GetVersion() const override { return version_; }
+};
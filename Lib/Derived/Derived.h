@@ -0,0 +1,159 @@
+﻿#pragma once
+#include <stdint.h>
+#include <cstring>
+#include <functional>
+#include <initializer_list>
+#include <type_traits>
+#include <vector>
+#include "Counters.h"
+
+/// <summary>
+/// 変更を追跡できる値の基底
+/// 値が変わるたびにバージョンが増える
+/// </summary>
+class VersionSource {
+public:
+
+	virtual ~VersionSource() {}
+
+	// 現在のバージョン
+	virtual uint64_t GetVersion() const = 0;
+};
+
+/// <summary>
+/// 派生値の再計算の統計
+/// </summary>
+struct DerivedStats {
+
+	uint64_t hitCount = 0;  // キャッシュを使った回数
+	uint64_t missCount = 0; // 再計算した回数
+
+	// キャッシュの利用率
+	float GetHitRate() const {
+		uint64_t total = hitCount + missCount;
+		return total > 0 ? static_cast<float>(hitCount) / static_cast<float>(total) : 0.0f;
+	}
+};
+
+/// <summary>
+/// 入力値
+/// Setで値が変わった時だけバージョンを進める
+/// </summary>
+template<typename T>
+class Tracked : public VersionSource {
+private:
+	/// <summary>
+	/// メンバ変数
+	/// </summary>
+
+	static_assert(std::is_trivially_copyable_v<T>, "Tracked は比較にmemcmpを使うため、トリビアルコピー可能な型のみ扱う");
+
+	T value_{};
+	uint64_t version_ = 1;
+
+public:
+	/// <summary>
+	/// メンバ関数
+	/// </summary>
+
+	// コンストラクタ
+	Tracked() {}
+	Tracked(const T& value) : value_(value) {}
+	// デストラクタ
+	~Tracked() override {}
+
+	// 値の設定、変化がなければバージョンは進めない
+	void Set(const T& value) {
+		if (std::memcmp(&value_, &value, sizeof(T)) != 0) {
+			value_ = value;
+			++version_;
+		}
+	}
+
+	// 外部で書き換えた時に変更を通知する
+	void MarkDirty() { ++version_; }
+
+	/// <summary>
+	/// ゲッター
+	/// </summary>
+	/// <returns></returns>
+	const T& Get() const { return value_; }
+	uint64_t GetVersion() const override { return version_; }
+};
+
+/// <summary>
+/// 派生値
+/// 依存している値のどれかのバージョンが変わった時だけ再計算する
+/// 派生値自身もVersionSourceなので、派生値を入力にした派生値も作れる
+/// </summary>
+template<typename T>
+class Derived : public VersionSource {
+private:
+	/// <summary>
+	/// メンバ変数
+	/// </summary>
+
+	std::function<T()> compute_;
+	std::vector<const VersionSource*> sources_;
+	// 最後に計算した時の依存先のバージョン
+	mutable std::vector<uint64_t> seenVersions_;
+
+	mutable T value_{};
+	mutable uint64_t version_ = 0;
+	mutable bool isValid_ = false;
+
+	DerivedStats* stats_ = nullptr;
+
+	// 依存先が変わっていれば再計算する、再計算したらtrueを返す
+	bool Refresh() const {
+
+		bool isDirty = !isValid_;
+		for (size_t i = 0; i < sources_.size(); ++i) {
+
+			uint64_t version = sources_[i]->GetVersion();
+			if (version != seenVersions_[i]) {
+				seenVersions_[i] = version;
+				isDirty = true;
+			}
+		}
+
+		if (isDirty) {
+			value_ = compute_();
+			isValid_ = true;
+			++version_;
+		}
+
+		return isDirty;
+	}
+
+public:
+	/// <summary>
+	/// メンバ関数
+	/// </summary>
+
+	// コンストラクタ
+	Derived(std::function<T()> compute, std::initializer_list<const VersionSource*> sources, DerivedStats* stats = nullptr)
+		: compute_(std::move(compute)), sources_(sources), seenVersions_(sources.size(), 0), stats_(stats) {}
+	// デストラクタ
+	~Derived() override {}
+
+	/// <summary>
+	/// ゲッター
+	/// </summary>
+	/// <returns></returns>
+	const T& Get() const {
+
+		bool isRecomputed = Refresh();
+		AddCounter(isRecomputed ? Counter::kCacheMisses : Counter::kCacheHits);
+		if (stats_) {
+			++(isRecomputed ? stats_->missCount : stats_->hitCount);
+		}
+
+		return value_;
+	}
+
+	uint64_t GetVersion() const override {
+		Refresh();
+		return version_;
+	}
+};
@@ -0,0 +1,505 @@
+﻿#include "MeshTables.h"
+#include <algorithm>
+#include <array>
+#include <fstream>
+#include <memory>
+#include <vector>
+
+namespace {
+
+	/*========================================================================================================================*/
+	// コンパイル時に作る表
+
+	constexpr double kPiD = 3.14159265358979323846;
+
+	/// <summary>
+	/// コンパイル時に使えるsin(-πからπに寄せてからTaylor展開する)
+	/// </summary>
+	constexpr double ConstexprSin(double x) {
+
+		while (x > kPiD) {
+			x -= 2.0 * kPiD;
+		}
+		while (x < -kPiD) {
+			x += 2.0 * kPiD;
+		}
+
+		double term = x;
+		double sum = x;
+		for (int n = 1; n < 12; ++n) {
+			term *= -x * x / ((2.0 * n) * (2.0 * n + 1.0));
+			sum += term;
+		}
+		return sum;
+	}
+
+	constexpr double ConstexprCos(double x) {
+		return ConstexprSin(x + kPiD / 2.0);
+	}
+
+	/// <summary>
+	/// 球の1区画のa、b、c(緯度と経度のsinとcosから)
+	/// </summary>
+	constexpr void MakeSphereCell(float sinLat, float cosLat, float sinNextLat, float cosNextLat,
+		float sinLon, float cosLon, float sinNextLon, float cosNextLon, Vec3f (&outPoints)[3]) {
+
+		outPoints[0] = { cosLat * cosLon, sinLat, cosLat * sinLon };
+		outPoints[1] = { cosNextLat * cosLon, sinNextLat, cosNextLat * sinLon };
+		outPoints[2] = { cosLat * cosNextLon, sinLat, cosLat * sinNextLon };
+	}
+
+	/// <summary>
+	/// 格子の1本の線
+	/// 縦線(xが一定)を先に、横線(zが一定)を後に並べ、真ん中の線は黒、その他は灰色にする
+	/// </summary>
+	constexpr void MakeGridLine(uint32_t subdivision, float halfWidth, uint32_t lineIndex, Vec3f& outStart, Vec3f& outEnd, uint32_t& outColor) {
+
+		const float every = (halfWidth * 2.0f) / static_cast<float>(subdivision);
+
+		uint32_t index = lineIndex % (subdivision + 1);
+		float position = -halfWidth + static_cast<float>(index) * every;
+
+		if (lineIndex <= subdivision) {
+			outStart = { position, 0.0f, halfWidth };
+			outEnd = { position, 0.0f, -halfWidth };
+		} else {
+			outStart = { -halfWidth, 0.0f, position };
+			outEnd = { halfWidth, 0.0f, position };
+		}
+
+		outColor = index == subdivision / 2 ? 0x000000ffu : 0xaaaaaaffu;
+	}
+
+	template<uint32_t Subdivision>
+	struct SphereArrays {
+
+		static const size_t kCount = Subdivision * Subdivision * 3;
+
+		std::array<float, kCount> x;
+		std::array<float, kCount> y;
+		std::array<float, kCount> z;
+	};
+
+	template<uint32_t Subdivision>
+	constexpr SphereArrays<Subdivision> MakeSphereArrays() {
+
+		SphereArrays<Subdivision> arrays{};
+
+		for (uint32_t latIndex = 0; latIndex < Subdivision; ++latIndex) {
+
+			// 緯度 -π/2 ~ π/2
+			double lat = -kPiD / 2.0 + kPiD * latIndex / Subdivision;
+			double nextLat = -kPiD / 2.0 + kPiD * (latIndex + 1) / Subdivision;
+
+			for (uint32_t lonIndex = 0; lonIndex < Subdivision; ++lonIndex) {
+
+				// 経度 0 ~ 2π
+				double lon = 2.0 * kPiD * lonIndex / Subdivision;
+				double nextLon = 2.0 * kPiD * (lonIndex + 1) / Subdivision;
+
+				Vec3f points[3] = {};
+				MakeSphereCell(
+					static_cast<float>(ConstexprSin(lat)), static_cast<float>(ConstexprCos(lat)),
+					static_cast<float>(ConstexprSin(nextLat)), static_cast<float>(ConstexprCos(nextLat)),
+					static_cast<float>(ConstexprSin(lon)), static_cast<float>(ConstexprCos(lon)),
+					static_cast<float>(ConstexprSin(nextLon)), static_cast<float>(ConstexprCos(nextLon)),
+					points);
+
+				size_t index = (static_cast<size_t>(latIndex) * Subdivision + lonIndex) * 3;
+				for (size_t k = 0; k < 3; ++k) {
+					arrays.x[index + k] = points[k].x;
+					arrays.y[index + k] = points[k].y;
+					arrays.z[index + k] = points[k].z;
+				}
+			}
+		}
+
+		return arrays;
+	}
+
+	template<uint32_t Subdivision>
+	struct GridArrays {
+
+		static const size_t kLineCount = (Subdivision + 1) * 2;
+
+		std::array<float, kLineCount * 2> x;
+		std::array<float, kLineCount * 2> y;
+		std::array<float, kLineCount * 2> z;
+		std::array<uint32_t, kLineCount> colors;
+	};
+
+	template<uint32_t Subdivision>
+	constexpr GridArrays<Subdivision> MakeGridArrays(float halfWidth) {
+
+		GridArrays<Subdivision> arrays{};
+
+		for (uint32_t lineIndex = 0; lineIndex < GridArrays<Subdivision>::kLineCount; ++lineIndex) {
+
+			Vec3f start = {};
+			Vec3f end = {};
+			MakeGridLine(Subdivision, halfWidth, lineIndex, start, end, arrays.colors[lineIndex]);
+
+			arrays.x[lineIndex * 2] = start.x;
+			arrays.y[lineIndex * 2] = start.y;
+			arrays.z[lineIndex * 2] = start.z;
+			arrays.x[lineIndex * 2 + 1] = end.x;
+			arrays.y[lineIndex * 2 + 1] = end.y;
+			arrays.z[lineIndex * 2 + 1] = end.z;
+		}
+
+		return arrays;
+	}
+
+	constexpr SphereArrays<kDefaultSphereSubdivision> kBuiltInSphere = MakeSphereArrays<kDefaultSphereSubdivision>();
+	constexpr GridArrays<kDefaultGridSubdivision> kBuiltInGrid = MakeGridArrays<kDefaultGridSubdivision>(kDefaultGridHalfWidth);
+
+	/*========================================================================================================================*/
+	// 表の一覧
+
+	struct Registry {
+
+		std::vector<std::unique_ptr<SphereTable>> spheres;
+		std::vector<std::unique_ptr<GridTable>> grids;
+	};
+
+	Registry& GetRegistry() {
+		static Registry registry;
+		return registry;
+	}
+
+	SphereTable* FindSphereTable(uint32_t subdivision) {
+		for (const std::unique_ptr<SphereTable>& table : GetRegistry().spheres) {
+			if (table->subdivision == subdivision) {
+				return table.get();
+			}
+		}
+		return nullptr;
+	}
+
+	GridTable* FindGridTable(uint32_t subdivision, float halfWidth) {
+		for (const std::unique_ptr<GridTable>& table : GetRegistry().grids) {
+			if (table->subdivision == subdivision && table->halfWidth == halfWidth) {
+				return table.get();
+			}
+		}
+		return nullptr;
+	}
+
+	template<size_t Count>
+	void CopyToSoA(const std::array<float, Count>& x, const std::array<float, Count>& y, const std::array<float, Count>& z, Vec3fSoA& outVectors) {
+		outVectors.x.assign(x.begin(), x.end());
+		outVectors.y.assign(y.begin(), y.end());
+		outVectors.z.assign(z.begin(), z.end());
+	}
+
+	/// <summary>
+	/// 実行時に球の表を作る(緯度と経度のsinとcosはまとめて求める)
+	/// </summary>
+	void GenerateSphereTable(uint32_t subdivision, SphereTable& outTable) {
+
+		const float kLatEvery = Pi() / static_cast<float>(subdivision);
+		const float kLonEvery = 2.0f * Pi() / static_cast<float>(subdivision);
+
+		// 緯度 -π/2 ~ π/2 と経度 0 ~ 2π のsinとcos(緯度subdivision+1個、経度subdivision+1個の順)
+		const uint32_t kLonOffset = subdivision + 1;
+		std::vector<float> angles((subdivision + 1) * 2);
+		for (uint32_t index = 0; index <= subdivision; ++index) {
+			angles[index] = -Pi() / 2.0f + kLatEvery * static_cast<float>(index);
+			angles[kLonOffset + index] = kLonEvery * static_cast<float>(index);
+		}
+
+		std::vector<float> sinTable;
+		std::vector<float> cosTable;
+		SinCosBatch(angles, sinTable, cosTable);
+
+		outTable.unitPositions.Resize(static_cast<size_t>(subdivision) * subdivision * 3);
+		for (uint32_t latIndex = 0; latIndex < subdivision; ++latIndex) {
+			for (uint32_t lonIndex = 0; lonIndex < subdivision; ++lonIndex) {
+
+				Vec3f points[3];
+				MakeSphereCell(
+					sinTable[latIndex], cosTable[latIndex], sinTable[latIndex + 1], cosTable[latIndex + 1],
+					sinTable[kLonOffset + lonIndex], cosTable[kLonOffset + lonIndex],
+					sinTable[kLonOffset + lonIndex + 1], cosTable[kLonOffset + lonIndex + 1],
+					points);
+
+				size_t index = (static_cast<size_t>(latIndex) * subdivision + lonIndex) * 3;
+				for (size_t k = 0; k < 3; ++k) {
+					outTable.unitPositions.Set(index + k, points[k]);
+				}
+			}
+		}
+	}
+
+	/// <summary>
+	/// 実行時に格子の表を作る
+	/// </summary>
+	void GenerateGridTable(uint32_t subdivision, float halfWidth, GridTable& outTable) {
+
+		const uint32_t kLineCount = (subdivision + 1) * 2;
+		outTable.positions.Resize(kLineCount * 2);
+		outTable.colors.resize(kLineCount);
+
+		for (uint32_t lineIndex = 0; lineIndex < kLineCount; ++lineIndex) {
+
+			Vec3f start;
+			Vec3f end;
+			MakeGridLine(subdivision, halfWidth, lineIndex, start, end, outTable.colors[lineIndex]);
+			outTable.positions.Set(lineIndex * 2, start);
+			outTable.positions.Set(lineIndex * 2 + 1, end);
+		}
+	}
+
+	/*========================================================================================================================*/
+	// キャッシュのファイル
+	// [magic "MTBL"][version][球の数][格子の数]
+	// 球:   [分割数][頂点数][x...][y...][z...]
+	// 格子: [分割数][半分の幅][線の数][x...][y...][z...][色...]
+
+	const char kCacheMagic[4] = { 'M', 'T', 'B', 'L' };
+	const uint32_t kCacheVersion = 1;
+
+	template<typename T>
+	void WriteValue(std::ofstream& file, const T& value) {
+		file.write(reinterpret_cast<const char*>(&value), sizeof(T));
+	}
+
+	template<typename T>
+	bool ReadValue(std::ifstream& file, T& value) {
+		return static_cast<bool>(file.read(reinterpret_cast<char*>(&value), sizeof(T)));
+	}
+
+	template<typename T>
+	void WriteArray(std::ofstream& file, const std::vector<T>& values) {
+		file.write(reinterpret_cast<const char*>(values.data()), static_cast<std::streamsize>(values.size() * sizeof(T)));
+	}
+
+	template<typename T>
+	bool ReadArray(std::ifstream& file, std::vector<T>& values, size_t count) {
+		values.resize(count);
+		return static_cast<bool>(file.read(reinterpret_cast<char*>(values.data()), static_cast<std::streamsize>(count * sizeof(T))));
+	}
+
+	void WriteSoA(std::ofstream& file, const Vec3fSoA& vectors) {
+		WriteArray(file, vectors.x);
+		WriteArray(file, vectors.y);
+		WriteArray(file, vectors.z);
+	}
+
+	bool ReadSoA(std::ifstream& file, Vec3fSoA& vectors, size_t count) {
+		return ReadArray(file, vectors.x, count) && ReadArray(file, vectors.y, count) && ReadArray(file, vectors.z, count);
+	}
+}
+
+/// <summary>
+/// 球の表、無ければ作る
+/// 既定の分割数はコンパイル時に作った表を写すだけで、三角関数を使わない
+/// </summary>
+/// <param name="subdivision"></param>
+/// <returns></returns>
+const SphereTable& GetSphereTable(uint32_t subdivision) {
+
+	subdivision = std::clamp(subdivision, 1u, kMaxMeshSubdivision);
+
+	if (SphereTable* table = FindSphereTable(subdivision)) {
+		return *table;
+	}
+
+	auto table = std::make_unique<SphereTable>();
+	table->subdivision = subdivision;
+	if (subdivision == kDefaultSphereSubdivision) {
+		table->source = MeshTableSource::kBuiltIn;
+		CopyToSoA(kBuiltInSphere.x, kBuiltInSphere.y, kBuiltInSphere.z, table->unitPositions);
+	} else {
+		table->source = MeshTableSource::kGenerated;
+		GenerateSphereTable(subdivision, *table);
+	}
+
+	GetRegistry().spheres.push_back(std::move(table));
+	return *GetRegistry().spheres.back();
+}
+
+/// <summary>
+/// 格子の表、無ければ作る
+/// </summary>
+/// <param name="subdivision"></param>
+/// <param name="halfWidth"></param>
+/// <returns></returns>
+const GridTable& GetGridTable(uint32_t subdivision, float halfWidth) {
+
+	subdivision = std::clamp(subdivision, 1u, kMaxMeshSubdivision);
+
+	if (GridTable* table = FindGridTable(subdivision, halfWidth)) {
+		return *table;
+	}
+
+	auto table = std::make_unique<GridTable>();
+	table->subdivision = subdivision;
+	table->halfWidth = halfWidth;
+	if (subdivision == kDefaultGridSubdivision && halfWidth == kDefaultGridHalfWidth) {
+		table->source = MeshTableSource::kBuiltIn;
+		CopyToSoA(kBuiltInGrid.x, kBuiltInGrid.y, kBuiltInGrid.z, table->positions);
+		table->colors.assign(kBuiltInGrid.colors.begin(), kBuiltInGrid.colors.end());
+	} else {
+		table->source = MeshTableSource::kGenerated;
+		GenerateGridTable(subdivision, halfWidth, *table);
+	}
+
+	GetRegistry().grids.push_back(std::move(table));
+	return *GetRegistry().grids.back();
+}
+
+/// <summary>
+/// キャッシュのファイルから表を読む
+/// 形式や大きさが合わないファイルは途中まで読んだ表も含めて使わない
+/// </summary>
+/// <param name="filePath"></param>
+/// <returns></returns>
+bool LoadMeshTableCache(const std::string& filePath) {
+
+	std::ifstream file(filePath, std::ios::binary);
+	if (!file) {
+		return false;
+	}
+
+	char magic[4] = {};
+	uint32_t version = 0;
+	uint32_t sphereCount = 0;
+	uint32_t gridCount = 0;
+	if (!file.read(magic, sizeof(magic)) || !std::equal(magic, magic + 4, kCacheMagic) ||
+		!ReadValue(file, version) || version != kCacheVersion ||
+		!ReadValue(file, sphereCount) || !ReadValue(file, gridCount) ||
+		sphereCount > kMaxMeshSubdivision || gridCount > kMaxMeshSubdivision) {
+		return false;
+	}
+
+	std::vector<std::unique_ptr<SphereTable>> spheres;
+	for (uint32_t i = 0; i < sphereCount; ++i) {
+
+		auto table = std::make_unique<SphereTable>();
+		uint32_t vertexCount = 0;
+		if (!ReadValue(file, table->subdivision) || !ReadValue(file, vertexCount) ||
+			table->subdivision == 0 || table->subdivision > kMaxMeshSubdivision ||
+			vertexCount != table->subdivision * table->subdivision * 3 ||
+			!ReadSoA(file, table->unitPositions, vertexCount)) {
+			return false;
+		}
+
+		table->source = MeshTableSource::kLoaded;
+		spheres.push_back(std::move(table));
+	}
+
+	std::vector<std::unique_ptr<GridTable>> grids;
+	for (uint32_t i = 0; i < gridCount; ++i) {
+
+		auto table = std::make_unique<GridTable>();
+		uint32_t lineCount = 0;
+		if (!ReadValue(file, table->subdivision) || !ReadValue(file, table->halfWidth) || !ReadValue(file, lineCount) ||
+			table->subdivision == 0 || table->subdivision > kMaxMeshSubdivision ||
+			lineCount != (table->subdivision + 1) * 2 ||
+			!ReadSoA(file, table->positions, lineCount * 2) || !ReadArray(file, table->colors, lineCount)) {
+			return false;
+		}
+
+		table->source = MeshTableSource::kLoaded;
+		grids.push_back(std::move(table));
+	}
+
+	// 全て読めてから登録する
+	Registry& registry = GetRegistry();
+	for (std::unique_ptr<SphereTable>& table : spheres) {
+		if (!FindSphereTable(table->subdivision)) {
+			registry.spheres.push_back(std::move(table));
+		}
+	}
+	for (std::unique_ptr<GridTable>& table : grids) {
+		if (!FindGridTable(table->subdivision, table->halfWidth)) {
+			registry.grids.push_back(std::move(table));
+		}
+	}
+
+	return true;
+}
+
+/// <summary>
+/// コンパイル時に作った表以外をキャッシュのファイルに書く
+/// </summary>
+/// <param name="filePath"></param>
+/// <returns></returns>
+bool SaveMeshTableCache(const std::string& filePath) {
+
+	std::ofstream file(filePath, std::ios::binary);
+	if (!file) {
+		return false;
+	}
+
+	const Registry& registry = GetRegistry();
+
+	uint32_t sphereCount = 0;
+	for (const std::unique_ptr<SphereTable>& table : registry.spheres) {
+		sphereCount += table->source != MeshTableSource::kBuiltIn ? 1 : 0;
+	}
+	uint32_t gridCount = 0;
+	for (const std::unique_ptr<GridTable>& table : registry.grids) {
+		gridCount += table->source != MeshTableSource::kBuiltIn ? 1 : 0;
+	}
+
+	file.write(kCacheMagic, sizeof(kCacheMagic));
+	WriteValue(file, kCacheVersion);
+	WriteValue(file, sphereCount);
+	WriteValue(file, gridCount);
+
+	for (const std::unique_ptr<SphereTable>& table : registry.spheres) {
+		if (table->source == MeshTableSource::kBuiltIn) {
+			continue;
+		}
+		WriteValue(file, table->subdivision);
+		WriteValue(file, static_cast<uint32_t>(table->unitPositions.Size()));
+		WriteSoA(file, table->unitPositions);
+	}
+
+	for (const std::unique_ptr<GridTable>& table : registry.grids) {
+		if (table->source == MeshTableSource::kBuiltIn) {
+			continue;
+		}
+		WriteValue(file, table->subdivision);
+		WriteValue(file, table->halfWidth);
+		WriteValue(file, static_cast<uint32_t>(table->colors.size()));
+		WriteSoA(file, table->positions);
+		WriteArray(file, table->colors);
+	}
+
+	return static_cast<bool>(file);
+}
+
+/// <summary>
+/// 表の数
+/// </summary>
+/// <returns></returns>
+MeshTableStats GetMeshTableStats() {
+
+	MeshTableStats stats{};
+
+	auto count = [&stats](MeshTableSource source) {
+		switch (source) {
+		case MeshTableSource::kBuiltIn:
+			++stats.builtInCount;
+			break;
+		case MeshTableSource::kGenerated:
+			++stats.generatedCount;
+			break;
+		case MeshTableSource::kLoaded:
+			++stats.loadedCount;
+			break;
+		}
+		};
+
+	for (const std::unique_ptr<SphereTable>& table : GetRegistry().spheres) {
+		count(table->source);
+	}
+	for (const std::unique_ptr<GridTable>& table : GetRegistry().grids) {
+		count(table->source);
+	}
+
+	return stats;
+}
@@ -0,0 +1,98 @@
+﻿#pragma once
+#include <stdint.h>
+#include <string>
+#include "MyMath.h"
+#include "MyMathBatch.h"
+
+/*
+* 球と格子の頂点の表
+* 既定の分割数の表はコンパイル時に作っておき、それ以外の分割数は初回に作るか、キャッシュのファイルから読む
+* 表は作った後は変えないので、返した参照は終了まで使える(描画側のスレッドからだけ使う)
+*/
+
+// 既定の分割数(コンパイル時に表を作る)
+constexpr uint32_t kDefaultSphereSubdivision = 12;
+constexpr uint32_t kDefaultGridSubdivision = 10;
+constexpr float kDefaultGridHalfWidth = 2.0f;
+
+// キャッシュから読む分割数の上限
+const uint32_t kMaxMeshSubdivision = 256;
+
+/// <summary>
+/// 表の作り方
+/// </summary>
+enum class MeshTableSource : uint32_t {
+
+	kBuiltIn,   // コンパイル時に作った
+	kGenerated, // 実行時に作った
+	kLoaded,    // キャッシュから読んだ
+};
+
+/// <summary>
+/// 単位球の頂点の表
+/// 1区画につきa、b、cの3点(abとacを線で結ぶ)
+/// </summary>
+struct SphereTable {
+
+	uint32_t subdivision;
+	MeshTableSource source;
+	Vec3fSoA unitPositions;
+};
+
+/// <summary>
+/// 格子の頂点の表
+/// 縦線と横線の始点と終点の順に並べ、線ごとの色を持つ
+/// </summary>
+struct GridTable {
+
+	uint32_t subdivision;
+	float halfWidth;
+	MeshTableSource source;
+	Vec3fSoA positions;
+	std::vector<uint32_t> colors;
+};
+
+/// <summary>
+/// 表の数
+/// </summary>
+struct MeshTableStats {
+
+	uint32_t builtInCount;
+	uint32_t generatedCount;
+	uint32_t loadedCount;
+};
+
+/// <summary>
+/// 球の表、無ければ作る
+/// </summary>
+/// <param name="subdivision"></param>
+/// <returns></returns>
+const SphereTable& GetSphereTable(uint32_t subdivision);
+
+/// <summary>
+/// 格子の表、無ければ作る
+/// </summary>
+/// <param name="subdivision"></param>
+/// <param name="halfWidth"></param>
+/// <returns></returns>
+const GridTable& GetGridTable(uint32_t subdivision, float halfWidth);
+
+/// <summary>
+/// キャッシュのファイルから表を読む(既にある表は読み飛ばす)
+/// </summary>
+/// <param name="filePath"></param>
+/// <returns>読めたか</returns>
+bool LoadMeshTableCache(const std::string& filePath);
+
+/// <summary>
+/// コンパイル時に作った表以外をキャッシュのファイルに書く
+/// </summary>
+/// <param name="filePath"></param>
+/// <returns>書けたか</returns>
+bool SaveMeshTableCache(const std::string& filePath);
+
+/// <summary>
+/// 表の数
+/// </summary>
+/// <returns></returns>
+MeshTableStats GetMeshTableStats();
@@ -0,0 +1,108 @@
+﻿#include "CpuFeatures.h"
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+
+namespace {
+
+	/// <summary>
+	/// cpuidの呼び出し
+	/// </summary>
+	void CpuId(uint32_t leaf, uint32_t subLeaf, uint32_t outRegisters[4]) {
+
+#ifdef _MSC_VER
+		int registers[4];
+		__cpuidex(registers, static_cast<int>(leaf), static_cast<int>(subLeaf));
+		for (int i = 0; i < 4; ++i) {
+			outRegisters[i] = static_cast<uint32_t>(registers[i]);
+		}
+#else
+		__cpuid_count(leaf, subLeaf, outRegisters[0], outRegisters[1], outRegisters[2], outRegisters[3]);
+#endif
+	}
+
+	/// <summary>
+	/// OSが保存するレジスタの種類(XCR0)
+	/// </summary>
+	uint64_t GetXCR0() {
+
+#ifdef _MSC_VER
+		return _xgetbv(0);
+#else
+		uint32_t eax = 0;
+		uint32_t edx = 0;
+		__asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+		return (static_cast<uint64_t>(edx) << 32) | eax;
+#endif
+	}
+
+	bool HasBit(uint32_t value, uint32_t bit) {
+		return (value >> bit) & 1u;
+	}
+}
+
+/// <summary>
+/// CPUとOSが対応している一番上の段階を調べる
+/// 命令に対応していても、OSがレジスタを保存しなければ使えないのでXCR0も確認する
+/// </summary>
+/// <returns></returns>
+SimdLevel DetectSimdLevel() {
+
+	uint32_t registers[4] = {};
+
+	CpuId(0, 0, registers);
+	uint32_t maxLeaf = registers[0];
+	if (maxLeaf < 7) {
+		return SimdLevel::kSSE2;
+	}
+
+	// leaf 1: ecx
+	CpuId(1, 0, registers);
+	bool hasFMA = HasBit(registers[2], 12);
+	bool hasOSXSAVE = HasBit(registers[2], 27);
+	bool hasAVX = HasBit(registers[2], 28);
+	if (!hasOSXSAVE || !hasAVX) {
+		return SimdLevel::kSSE2;
+	}
+
+	// XMM、YMMの上位、ZMM(opmask、上位256bit、16~31番)を保存するか
+	uint64_t xcr0 = GetXCR0();
+	bool isYmmEnabled = (xcr0 & 0x6) == 0x6;
+	bool isZmmEnabled = (xcr0 & 0xe6) == 0xe6;
+
+	// leaf 7: ebx
+	CpuId(7, 0, registers);
+	bool hasAVX2 = HasBit(registers[1], 5);
+	bool hasAVX512F = HasBit(registers[1], 16);
+
+	if (!isYmmEnabled || !hasAVX2 || !hasFMA) {
+		return SimdLevel::kSSE2;
+	}
+
+	if (isZmmEnabled && hasAVX512F) {
+		return SimdLevel::kAVX512;
+	}
+
+	return SimdLevel::kAVX2;
+}
+
+/// <summary>
+/// 段階の表示名
+/// </summary>
+/// <param name="level"></param>
+/// <returns></returns>
+const char* ToString(SimdLevel level) {
+
+	switch (level) {
+	case SimdLevel::kSSE2:
+		return "SSE2";
+	case SimdLevel::kAVX2:
+		return "AVX2";
+	case SimdLevel::kAVX512:
+		return "AVX-512";
+	default:
+		return "unknown";
+	}
+}
@@ -0,0 +1,26 @@
+﻿#pragma once
+#include <stdint.h>
+
+/// <summary>
+/// 使えるSIMD命令の段階
+/// </summary>
+enum class SimdLevel {
+
+	kSSE2,   // x64なら必ず使える
+	kAVX2,   // AVX2 + FMA
+	kAVX512, // AVX-512F
+	kCount,
+};
+
+/// <summary>
+/// CPUとOSが対応している一番上の段階を調べる(cpuid、xgetbv)
+/// </summary>
+/// <returns></returns>
+SimdLevel DetectSimdLevel();
+
+/// <summary>
+/// 段階の表示名
+/// </summary>
+/// <param name="level"></param>
+/// <returns></returns>
+const char* ToString(SimdLevel level);
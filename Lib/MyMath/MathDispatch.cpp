@@ -0,0 +1,239 @@
+﻿#include "MathDispatch.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+
+namespace {
+
+	// 段階ごとの実装、SimdLevelの順に並べる
+	constexpr MathKernels kMathKernels[] = {
+		{ SimdLevel::kSSE2, MultiplySSE2, TransformBatchSSE2, TransformBatchRangeSSE2, ClosestPointBatchSSE2, SinCosBatchSSE2 },
+		{ SimdLevel::kAVX2, MultiplyAVX2, TransformBatchAVX2, TransformBatchRangeAVX2, ClosestPointBatchAVX2, SinCosBatchAVX2 },
+		{ SimdLevel::kAVX512, MultiplyAVX512, TransformBatchAVX512, TransformBatchRangeAVX512, ClosestPointBatchAVX512, SinCosBatchAVX512 },
+	};
+
+	// 実際に使う段階ごとの実装
+	// 段階はCPUが対応しているかで決めるが、Multiplyは1回が短く、幅の広い命令が速いとは限らないので、
+	// InitMathDispatchで測って、その段階以下で一番速いものに差し替える
+	MathKernels selectedKernels[] = { kMathKernels[0], kMathKernels[1], kMathKernels[2] };
+	SimdLevel multiplyLevels[] = { SimdLevel::kSSE2, SimdLevel::kAVX2, SimdLevel::kAVX512 };
+
+	// 初期化前でも動くようにSSE2から始める
+	// シミュレーション側のスレッドからも呼ばれるので、切り替えはatomicで行う
+	std::atomic<const MathKernels*> currentKernels{ &selectedKernels[0] };
+
+	SimdLevel detectedLevel = SimdLevel::kSSE2;
+	bool isDetected = false;
+
+	/// <summary>
+	/// 環境変数の文字列を段階にする
+	/// </summary>
+	bool ParseSimdLevel(const char* text, SimdLevel& outLevel) {
+
+		if (std::strcmp(text, "sse2") == 0) {
+			outLevel = SimdLevel::kSSE2;
+		} else if (std::strcmp(text, "avx2") == 0) {
+			outLevel = SimdLevel::kAVX2;
+		} else if (std::strcmp(text, "avx512") == 0) {
+			outLevel = SimdLevel::kAVX512;
+		} else {
+			return false;
+		}
+
+		return true;
+	}
+
+	/// <summary>
+	/// Multiplyの1回あたりの時間を測る(前の結果を次に掛けるので、実際の使い方と同じく待ち時間で決まる)
+	/// </summary>
+	/// <returns>ns</returns>
+	double MeasureMultiply(const MathKernels& kernels) {
+
+		const uint32_t kCallCount = 4096;
+		const uint32_t kRoundCount = 5;
+
+		// 回転だけの行列なので掛け続けても発散しない
+		const float c = 0.8f;
+		const float s = 0.6f;
+		Matrix4x4 rotate = { { { c,s,0.0f,0.0f },{ -s,c,0.0f,0.0f },{ 0.0f,0.0f,1.0f,0.0f },{ 0.0f,0.0f,0.0f,1.0f } } };
+
+		double best = 0.0;
+		for (uint32_t round = 0; round < kRoundCount; ++round) {
+
+			Matrix4x4 result = rotate;
+			auto start = std::chrono::steady_clock::now();
+			for (uint32_t i = 0; i < kCallCount; ++i) {
+				result = kernels.multiply(result, rotate);
+			}
+			double nanoseconds = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / kCallCount;
+
+			// 計算が消されないように結果を使う
+			if (result.m[3][3] != 1.0f) {
+				nanoseconds += 1.0;
+			}
+
+			best = round == 0 ? nanoseconds : (std::min)(best, nanoseconds);
+		}
+
+		return best;
+	}
+
+	/// <summary>
+	/// 対応している段階のMultiplyを測り、段階ごとにそれ以下で一番速いものを選ぶ
+	/// 測った時間の差が小さい時は低い段階を使う
+	/// </summary>
+	void SelectMultiply() {
+
+		const size_t supportedCount = static_cast<size_t>(detectedLevel) + 1;
+
+		double nanoseconds[std::size(kMathKernels)] = {};
+		for (size_t i = 0; i < supportedCount; ++i) {
+			nanoseconds[i] = MeasureMultiply(kMathKernels[i]);
+		}
+
+		for (size_t level = 0; level < supportedCount; ++level) {
+
+			size_t fastest = 0;
+			for (size_t i = 1; i <= level; ++i) {
+				if (nanoseconds[i] < nanoseconds[fastest] * 0.9) {
+					fastest = i;
+				}
+			}
+
+			selectedKernels[level].multiply = kMathKernels[fastest].multiply;
+			multiplyLevels[level] = kMathKernels[fastest].level;
+		}
+
+		Novice::ConsolePrintf("MathDispatch: Multiply SSE2 %.1f ns, AVX2 %.1f ns, AVX-512 %.1f ns (0 = not supported)\n",
+			nanoseconds[0], nanoseconds[1], nanoseconds[2]);
+	}
+}
+
+/// <summary>
+/// CPUを調べて実装を選び、結果をコンソールに出す
+/// </summary>
+void InitMathDispatch() {
+
+	detectedLevel = DetectSimdLevel();
+	isDetected = true;
+
+	SelectMultiply();
+
+	SimdLevel level = detectedLevel;
+
+	// 環境変数で上限を指定する
+	char* forced = nullptr;
+	size_t forcedLength = 0;
+#ifdef _MSC_VER
+	_dupenv_s(&forced, &forcedLength, "MT3_SIMD_LEVEL");
+#else
+	const char* env = std::getenv("MT3_SIMD_LEVEL");
+	forced = env ? strdup(env) : nullptr;
+	forcedLength = forced ? std::strlen(forced) : 0;
+#endif
+
+	SimdLevel forcedLevel = SimdLevel::kSSE2;
+	bool isForced = forcedLength > 0 && ParseSimdLevel(forced, forcedLevel);
+	std::free(forced);
+
+	if (isForced) {
+		level = forcedLevel;
+	}
+
+	bool isApplied = SetSimdLevel(level);
+
+	Novice::ConsolePrintf("MathDispatch: detected %s, using %s (Multiply %s)%s\n",
+		ToString(detectedLevel), ToString(GetSimdLevel()), ToString(GetMultiplySimdLevel()),
+		isForced ? (isApplied ? " (forced by MT3_SIMD_LEVEL)" : " (MT3_SIMD_LEVEL not supported by this CPU)") : "");
+}
+
+/// <summary>
+/// 使う段階を指定する
+/// </summary>
+/// <param name="level"></param>
+/// <returns>指定通りにできたか</returns>
+bool SetSimdLevel(SimdLevel level) {
+
+	SimdLevel supported = GetDetectedSimdLevel();
+	SimdLevel applied = level > supported ? supported : level;
+
+	currentKernels.store(&selectedKernels[static_cast<size_t>(applied)], std::memory_order_release);
+
+	return applied == level;
+}
+
+/// <summary>
+/// 今使っている段階
+/// </summary>
+/// <returns></returns>
+SimdLevel GetSimdLevel() {
+
+	return GetMathKernels().level;
+}
+
+/// <summary>
+/// 今使っているMultiplyの段階
+/// </summary>
+/// <returns></returns>
+SimdLevel GetMultiplySimdLevel() {
+
+	return multiplyLevels[static_cast<size_t>(GetSimdLevel())];
+}
+
+/// <summary>
+/// CPUが対応している一番上の段階
+/// </summary>
+/// <returns></returns>
+SimdLevel GetDetectedSimdLevel() {
+
+	if (!isDetected) {
+		detectedLevel = DetectSimdLevel();
+		isDetected = true;
+	}
+
+	return detectedLevel;
+}
+
+/// <summary>
+/// 今使っている実装
+/// </summary>
+/// <returns></returns>
+const MathKernels& GetMathKernels() {
+
+	return *currentKernels.load(std::memory_order_acquire);
+}
+
+/// <summary>
+/// 段階を指定して実装を取得する
+/// </summary>
+/// <param name="level"></param>
+/// <returns></returns>
+const MathKernels& GetMathKernels(SimdLevel level) {
+
+	return kMathKernels[static_cast<size_t>(level)];
+}
+
+/// <summary>
+/// 段階の切り替えをImGuiで描画
+/// </summary>
+void DrawMathDispatchImGui() {
+
+	ImGui::Begin("MathDispatch");
+
+	ImGui::Text("detected %s", ToString(GetDetectedSimdLevel()));
+	ImGui::Text("Multiply %s", ToString(GetMultiplySimdLevel()));
+
+	int current = static_cast<int>(GetSimdLevel());
+	int supportedCount = static_cast<int>(GetDetectedSimdLevel()) + 1;
+	for (int i = 0; i < supportedCount; ++i) {
+		if (ImGui::RadioButton(ToString(static_cast<SimdLevel>(i)), current == i)) {
+			SetSimdLevel(static_cast<SimdLevel>(i));
+			Novice::ConsolePrintf("MathDispatch: using %s (Multiply %s)\n", ToString(GetSimdLevel()), ToString(GetMultiplySimdLevel()));
+		}
+	}
+
+	ImGui::End();
+}
@@ -0,0 +1,125 @@
+﻿#pragma once
+#include <vector>
+#include "MyMath.h"
+#include "MyMathBatch.h"
+#include "CpuFeatures.h"
+
+/*
+* 重い計算をCPUが対応している命令セットに合わせて切り替える
+* 実行ファイルはSSE2のままで、AVX2やAVX-512の実装は起動時に使えると分かった時だけ呼ぶ
+* Multiply、TransformBatch、TransformBatchRange、ClosestPointBatch、SinCosBatchはここで選ばれた実装を通る
+*/
+
+/// <summary>
+/// 1つの命令セットの実装一式
+/// </summary>
+struct MathKernels {
+
+	SimdLevel level;
+	Matrix4x4(*multiply)(const Matrix4x4& m1, const Matrix4x4& m2);
+	void (*transformBatch)(const Vec3fSoA& vectors, const Matrix4x4& matrix, Vec3fSoA& outVectors);
+	void (*transformBatchRange)(const Vec3fSoA& vectors, size_t begin, size_t end, const Matrix4x4& matrix, Vec3fSoA& outVectors);
+	void (*closestPointBatch)(const Vec3fSoA& points, const SegmentSoA& segments, Vec3fSoA& outClosestPoints);
+	void (*sinCosBatch)(const std::vector<float>& angles, std::vector<float>& outSin, std::vector<float>& outCos);
+};
+
+/// <summary>
+/// CPUを調べて実装を選び、結果をコンソールに出す
+/// Multiplyだけは段階ごとに測って、その段階以下で一番速い実装を使う
+/// 環境変数 MT3_SIMD_LEVEL (sse2 / avx2 / avx512) で上限を指定できる
+/// </summary>
+void InitMathDispatch();
+
+/// <summary>
+/// 使う段階を指定する(テスト用)、CPUが対応していない段階は対応している一番上に下げる
+/// </summary>
+/// <param name="level"></param>
+/// <returns>指定通りにできたか</returns>
+bool SetSimdLevel(SimdLevel level);
+
+/// <summary>
+/// 今使っている段階
+/// </summary>
+/// <returns></returns>
+SimdLevel GetSimdLevel();
+
+/// <summary>
+/// 今使っているMultiplyの段階(今の段階以下で測って一番速かったもの)
+/// </summary>
+/// <returns></returns>
+SimdLevel GetMultiplySimdLevel();
+
+/// <summary>
+/// CPUが対応している一番上の段階
+/// </summary>
+/// <returns></returns>
+SimdLevel GetDetectedSimdLevel();
+
+/// <summary>
+/// 今使っている実装
+/// </summary>
+/// <returns></returns>
+const MathKernels& GetMathKernels();
+
+/// <summary>
+/// 段階を指定して実装を取得する(比較用、Multiplyも差し替えずにその段階のもの、CPUが対応しているかは呼ぶ側で確認する)
+/// </summary>
+/// <param name="level"></param>
+/// <returns></returns>
+const MathKernels& GetMathKernels(SimdLevel level);
+
+/// <summary>
+/// 段階の切り替えをImGuiで描画
+/// </summary>
+void DrawMathDispatchImGui();
+
+/// <summary>
+/// SinCosBatchで使う定数、全ての実装で同じものを使う
+/// </summary>
+namespace SinCosConstants {
+
+	// 範囲の縮小に使う定数(π/2を3つに分けたもの)
+	constexpr float kTwoOverPi = 0.636619772367581343f;
+	constexpr float kPiOverTwo1 = 1.5703125f;
+	constexpr float kPiOverTwo2 = 4.837512969970703125e-4f;
+	constexpr float kPiOverTwo3 = 7.54978995489188216e-8f;
+
+	// [-π/4, π/4]でのsin、cosの多項式の係数
+	constexpr float kSin1 = -1.6666654611e-1f;
+	constexpr float kSin2 = 8.3321608736e-3f;
+	constexpr float kSin3 = -1.9515295891e-4f;
+	constexpr float kCos1 = 4.166664568298827e-2f;
+	constexpr float kCos2 = -1.388731625493765e-3f;
+	constexpr float kCos3 = 2.443315711809948e-5f;
+}
+
+/// <summary>
+/// 多項式近似のsinとcos(SinCosBatchの端数と同じ計算)
+/// </summary>
+/// <param name="angle">ラジアン、|angle| < 1e5 程度まで</param>
+/// <param name="outSin"></param>
+/// <param name="outCos"></param>
+void SinCosPolynomial(float angle, float& outSin, float& outCos);
+
+/*
+* 命令セットごとの実装、通常は上のディスパッチを通して呼ぶ
+* SSE2はMyMathBatch.cpp、AVX2はMathKernelsAVX2.cpp、AVX-512はMathKernelsAVX512.cppにある
+*/
+
+Matrix4x4 MultiplySSE2(const Matrix4x4& m1, const Matrix4x4& m2);
+void TransformBatchSSE2(const Vec3fSoA& vectors, const Matrix4x4& matrix, Vec3fSoA& outVectors);
+void TransformBatchRangeSSE2(const Vec3fSoA& vectors, size_t begin, size_t end, const Matrix4x4& matrix, Vec3fSoA& outVectors);
+void ClosestPointBatchSSE2(const Vec3fSoA& points, const SegmentSoA& segments, Vec3fSoA& outClosestPoints);
+void SinCosBatchSSE2(const std::vector<float>& angles, std::vector<float>& outSin, std::vector<float>& outCos);
+
+Matrix4x4 MultiplyAVX2(const Matrix4x4& m1, const Matrix4x4& m2);
+void TransformBatchAVX2(const Vec3fSoA& vectors, const Matrix4x4& matrix, Vec3fSoA& outVectors);
+void TransformBatchRangeAVX2(const Vec3fSoA& vectors, size_t begin, size_t end, const Matrix4x4& matrix, Vec3fSoA& outVectors);
+void ClosestPointBatchAVX2(const Vec3fSoA& points, const SegmentSoA& segments, Vec3fSoA& outClosestPoints);
+void SinCosBatchAVX2(const std::vector<float>& angles, std::vector<float>& outSin, std::vector<float>& outCos);
+
+Matrix4x4 MultiplyAVX512(const Matrix4x4& m1, const Matrix4x4& m2);
+void TransformBatchAVX512(const Vec3fSoA& vectors, const Matrix4x4& matrix, Vec3fSoA& outVectors);
+void TransformBatchRangeAVX512(const Vec3fSoA& vectors, size_t begin, size_t end, const Matrix4x4& matrix, Vec3fSoA& outVectors);
+void ClosestPointBatchAVX512(const Vec3fSoA& points, const SegmentSoA& segments, Vec3fSoA& outClosestPoints);
+void SinCosBatchAVX512(const std::vector<float>& angles, std::vector<float>& outSin, std::vector<float>& outCos);
@@ -0,0 +1,244 @@
+﻿#include "MathDispatch.h"
+#include <cassert>
+#include <immintrin.h>
+
+/*
+* AVX2 + FMA の実装
+* MSVCでは/arch:AVX2を付けずにビルドする(組み込み関数はそのまま使える)
+* /archを付けるとヘッダーのinline関数までAVX2で作られ、古いCPUで他の翻訳単位から呼ばれて落ちることがある
+*/
+
+namespace {
+
+	/// <summary>
+	/// 8要素分の三次元ベクトル
+	/// </summary>
+	struct Vec3x8 {
+
+		__m256 x;
+		__m256 y;
+		__m256 z;
+	};
+
+	Vec3x8 Load(const Vec3fSoA& v, size_t index) {
+		return { _mm256_loadu_ps(&v.x[index]), _mm256_loadu_ps(&v.y[index]), _mm256_loadu_ps(&v.z[index]) };
+	}
+
+	void Store(Vec3fSoA& v, size_t index, const Vec3x8& value) {
+		_mm256_storeu_ps(&v.x[index], value.x);
+		_mm256_storeu_ps(&v.y[index], value.y);
+		_mm256_storeu_ps(&v.z[index], value.z);
+	}
+
+	__m256 Dot(const Vec3x8& v1, const Vec3x8& v2) {
+		return _mm256_fmadd_ps(v1.z, v2.z, _mm256_fmadd_ps(v1.y, v2.y, _mm256_mul_ps(v1.x, v2.x)));
+	}
+
+	/// <summary>
+	/// 8要素に広げた4x4行列
+	/// </summary>
+	struct Matrix4x4x8 {
+
+		__m256 m[4][4];
+	};
+
+	Matrix4x4x8 Broadcast(const Matrix4x4& matrix) {
+
+		Matrix4x4x8 result;
+		for (int i = 0; i < 4; i++) {
+			for (int j = 0; j < 4; j++) {
+				result.m[i][j] = _mm256_set1_ps(matrix.m[i][j]);
+			}
+		}
+		return result;
+	}
+
+	/// <summary>
+	/// [begin, end)の座標変換、i番目の結果をoutVectorsのi - begin番目に書き込む(outVectorsは呼ぶ側でリサイズしておく)
+	/// </summary>
+	void TransformRange(const Vec3fSoA& vectors, const Matrix4x4& matrix, const Matrix4x4x8& m, size_t begin, size_t end, Vec3fSoA& outVectors) {
+
+		const __m256 zero = _mm256_setzero_ps();
+		const __m256 one = _mm256_set1_ps(1.0f);
+
+		size_t i = begin;
+		for (; i + 8 <= end; i += 8) {
+
+			Vec3x8 v = Load(vectors, i);
+
+			__m256 result[4];
+			for (int j = 0; j < 4; j++) {
+				result[j] = _mm256_fmadd_ps(v.x, m.m[0][j], _mm256_fmadd_ps(v.y, m.m[1][j], _mm256_fmadd_ps(v.z, m.m[2][j], m.m[3][j])));
+			}
+
+			// wが0の要素は割らない
+			__m256 w = result[3];
+			__m256 invW = _mm256_blendv_ps(one, _mm256_div_ps(one, w), _mm256_cmp_ps(w, zero, _CMP_NEQ_UQ));
+
+			Store(outVectors, i - begin, { _mm256_mul_ps(result[0], invW), _mm256_mul_ps(result[1], invW), _mm256_mul_ps(result[2], invW) });
+		}
+
+		// 端数
+		for (; i < end; ++i) {
+			outVectors.Set(i - begin, Transform(vectors.Get(i), matrix));
+		}
+	}
+}
+
+/// <summary>
+/// 4x4行列の積(AVX2)
+/// 2行ずつ、m2の各行を上下128bitに並べて計算する
+/// </summary>
+/// <param name="m1"></param>
+/// <param name="m2"></param>
+/// <returns></returns>
+Matrix4x4 MultiplyAVX2(const Matrix4x4& m1, const Matrix4x4& m2) {
+
+	__m256 rows[4];
+	for (int k = 0; k < 4; ++k) {
+		rows[k] = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(m2.m[k]));
+	}
+
+	Matrix4x4 result;
+	for (int i = 0; i < 4; i += 2) {
+
+		__m256 row = _mm256_mul_ps(_mm256_set_m128(_mm_set1_ps(m1.m[i + 1][0]), _mm_set1_ps(m1.m[i][0])), rows[0]);
+		for (int k = 1; k < 4; ++k) {
+			__m256 coefficient = _mm256_set_m128(_mm_set1_ps(m1.m[i + 1][k]), _mm_set1_ps(m1.m[i][k]));
+			row = _mm256_fmadd_ps(coefficient, rows[k], row);
+		}
+
+		_mm256_storeu_ps(result.m[i], row);
+	}
+
+	return result;
+}
+
+/// <summary>
+/// 4x4行列の座標変換のバッチ処理(AVX2)
+/// </summary>
+/// <param name="vectors"></param>
+/// <param name="matrix"></param>
+/// <param name="outVectors"></param>
+void TransformBatchAVX2(const Vec3fSoA& vectors, const Matrix4x4& matrix, Vec3fSoA& outVectors) {
+
+	const size_t count = vectors.Size();
+	outVectors.Resize(count);
+
+	TransformRange(vectors, matrix, Broadcast(matrix), 0, count, outVectors);
+}
+
+/// <summary>
+/// 頂点の一部の座標変換のバッチ処理(AVX2)
+/// </summary>
+/// <param name="vectors"></param>
+/// <param name="begin"></param>
+/// <param name="end"></param>
+/// <param name="matrix"></param>
+/// <param name="outVectors"></param>
+void TransformBatchRangeAVX2(const Vec3fSoA& vectors, size_t begin, size_t end, const Matrix4x4& matrix, Vec3fSoA& outVectors) {
+
+	outVectors.Resize(end - begin);
+
+	TransformRange(vectors, matrix, Broadcast(matrix), begin, end, outVectors);
+}
+
+/// <summary>
+/// 最近接点(点と線分)のバッチ処理(AVX2)
+/// </summary>
+/// <param name="points"></param>
+/// <param name="segments"></param>
+/// <param name="outClosestPoints"></param>
+void ClosestPointBatchAVX2(const Vec3fSoA& points, const SegmentSoA& segments, Vec3fSoA& outClosestPoints) {
+
+	assert(points.Size() == segments.Size());
+
+	const size_t count = points.Size();
+	outClosestPoints.Resize(count);
+
+	const __m256 zero = _mm256_setzero_ps();
+	const __m256 one = _mm256_set1_ps(1.0f);
+
+	size_t i = 0;
+	for (; i + 8 <= count; i += 8) {
+
+		Vec3x8 point = Load(points, i);
+		Vec3x8 origin = Load(segments.origin, i);
+		Vec3x8 diff = Load(segments.diff, i);
+
+		Vec3x8 toPoint = { _mm256_sub_ps(point.x, origin.x), _mm256_sub_ps(point.y, origin.y), _mm256_sub_ps(point.z, origin.z) };
+
+		// 長さ0の線分は始点を返す
+		__m256 lengthSq = Dot(diff, diff);
+		__m256 invLengthSq = _mm256_and_ps(_mm256_cmp_ps(lengthSq, zero, _CMP_GT_OQ), _mm256_div_ps(one, lengthSq));
+		__m256 t = _mm256_mul_ps(Dot(toPoint, diff), invLengthSq);
+		t = _mm256_min_ps(_mm256_max_ps(t, zero), one);
+
+		Store(outClosestPoints, i, {
+			_mm256_fmadd_ps(diff.x, t, origin.x), _mm256_fmadd_ps(diff.y, t, origin.y), _mm256_fmadd_ps(diff.z, t, origin.z) });
+	}
+
+	// 端数
+	for (; i < count; ++i) {
+
+		Vec3f origin = segments.origin.Get(i);
+		Vec3f diff = segments.diff.Get(i);
+		float lengthSq = Dot(diff, diff);
+		float t = lengthSq > 0.0f ? std::clamp(Dot(points.Get(i) - origin, diff) / lengthSq, 0.0f, 1.0f) : 0.0f;
+
+		outClosestPoints.Set(i, origin + diff * t);
+	}
+}
+
+/// <summary>
+/// sinとcosのバッチ処理(AVX2)
+/// </summary>
+/// <param name="angles"></param>
+/// <param name="outSin"></param>
+/// <param name="outCos"></param>
+void SinCosBatchAVX2(const std::vector<float>& angles, std::vector<float>& outSin, std::vector<float>& outCos) {
+
+	using namespace SinCosConstants;
+
+	const size_t count = angles.size();
+	outSin.resize(count);
+	outCos.resize(count);
+
+	const __m256i one = _mm256_set1_epi32(1);
+	const __m256i two = _mm256_set1_epi32(2);
+
+	size_t i = 0;
+	for (; i + 8 <= count; i += 8) {
+
+		__m256 angle = _mm256_loadu_ps(&angles[i]);
+
+		__m256i quadrant = _mm256_cvtps_epi32(_mm256_mul_ps(angle, _mm256_set1_ps(kTwoOverPi)));
+		__m256 q = _mm256_cvtepi32_ps(quadrant);
+
+		__m256 r = _mm256_fnmadd_ps(q, _mm256_set1_ps(kPiOverTwo1), angle);
+		r = _mm256_fnmadd_ps(q, _mm256_set1_ps(kPiOverTwo2), r);
+		r = _mm256_fnmadd_ps(q, _mm256_set1_ps(kPiOverTwo3), r);
+		__m256 z = _mm256_mul_ps(r, r);
+
+		__m256 s = _mm256_fmadd_ps(z, _mm256_set1_ps(kSin3), _mm256_set1_ps(kSin2));
+		s = _mm256_fmadd_ps(z, s, _mm256_set1_ps(kSin1));
+		s = _mm256_fmadd_ps(_mm256_mul_ps(r, z), s, r);
+
+		__m256 c = _mm256_fmadd_ps(z, _mm256_set1_ps(kCos3), _mm256_set1_ps(kCos2));
+		c = _mm256_fmadd_ps(z, c, _mm256_set1_ps(kCos1));
+		c = _mm256_fmadd_ps(_mm256_mul_ps(z, z), c, _mm256_fnmadd_ps(_mm256_set1_ps(0.5f), z, _mm256_set1_ps(1.0f)));
+
+		// 象限に合わせて入れ替えと符号反転(2のビットを符号ビットへ移す)
+		__m256 swap = _mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_and_si256(quadrant, one), one));
+		__m256 sinSign = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(quadrant, two), 30));
+		__m256 cosSign = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(_mm256_add_epi32(quadrant, one), two), 30));
+
+		_mm256_storeu_ps(&outSin[i], _mm256_xor_ps(_mm256_blendv_ps(s, c, swap), sinSign));
+		_mm256_storeu_ps(&outCos[i], _mm256_xor_ps(_mm256_blendv_ps(c, s, swap), cosSign));
+	}
+
+	// 端数
+	for (; i < count; ++i) {
+		SinCosPolynomial(angles[i], outSin[i], outCos[i]);
+	}
+}
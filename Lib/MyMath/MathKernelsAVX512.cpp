@@ -0,0 +1,228 @@
+﻿#include "MathDispatch.h"
+#include <cassert>
+#include <immintrin.h>
+
+/*
+* AVX-512F の実装
+* MSVCでは/arch:AVX512を付けずにビルドする(理由はMathKernelsAVX2.cppと同じ)
+* 端数はマスク付きの読み書きで同じループの中で処理する
+*/
+
+namespace {
+
+	/// <summary>
+	/// 16要素分の三次元ベクトル
+	/// </summary>
+	struct Vec3x16 {
+
+		__m512 x;
+		__m512 y;
+		__m512 z;
+	};
+
+	Vec3x16 Load(const Vec3fSoA& v, size_t index, __mmask16 mask) {
+		return {
+			_mm512_maskz_loadu_ps(mask, &v.x[index]),
+			_mm512_maskz_loadu_ps(mask, &v.y[index]),
+			_mm512_maskz_loadu_ps(mask, &v.z[index]) };
+	}
+
+	void Store(Vec3fSoA& v, size_t index, __mmask16 mask, const Vec3x16& value) {
+		_mm512_mask_storeu_ps(&v.x[index], mask, value.x);
+		_mm512_mask_storeu_ps(&v.y[index], mask, value.y);
+		_mm512_mask_storeu_ps(&v.z[index], mask, value.z);
+	}
+
+	__m512 Dot(const Vec3x16& v1, const Vec3x16& v2) {
+		return _mm512_fmadd_ps(v1.z, v2.z, _mm512_fmadd_ps(v1.y, v2.y, _mm512_mul_ps(v1.x, v2.x)));
+	}
+
+	// 残りの要素数のマスク
+	__mmask16 RemainMask(size_t remain) {
+		return remain >= 16 ? static_cast<__mmask16>(0xffff) : static_cast<__mmask16>((1u << remain) - 1u);
+	}
+
+	/// <summary>
+	/// 16要素に広げた4x4行列
+	/// </summary>
+	struct Matrix4x4x16 {
+
+		__m512 m[4][4];
+	};
+
+	Matrix4x4x16 Broadcast(const Matrix4x4& matrix) {
+
+		Matrix4x4x16 result;
+		for (int i = 0; i < 4; i++) {
+			for (int j = 0; j < 4; j++) {
+				result.m[i][j] = _mm512_set1_ps(matrix.m[i][j]);
+			}
+		}
+		return result;
+	}
+
+	/// <summary>
+	/// [begin, end)の座標変換、i番目の結果をoutVectorsのi - begin番目に書き込む(outVectorsは呼ぶ側でリサイズしておく)
+	/// </summary>
+	void TransformRange(const Vec3fSoA& vectors, const Matrix4x4x16& m, size_t begin, size_t end, Vec3fSoA& outVectors) {
+
+		const __m512 zero = _mm512_setzero_ps();
+		const __m512 one = _mm512_set1_ps(1.0f);
+
+		for (size_t i = begin; i < end; i += 16) {
+
+			__mmask16 mask = RemainMask(end - i);
+			Vec3x16 v = Load(vectors, i, mask);
+
+			__m512 result[4];
+			for (int j = 0; j < 4; j++) {
+				result[j] = _mm512_fmadd_ps(v.x, m.m[0][j], _mm512_fmadd_ps(v.y, m.m[1][j], _mm512_fmadd_ps(v.z, m.m[2][j], m.m[3][j])));
+			}
+
+			// wが0の要素は割らない
+			__m512 w = result[3];
+			__m512 invW = _mm512_mask_div_ps(one, _mm512_cmp_ps_mask(w, zero, _CMP_NEQ_UQ), one, w);
+
+			Store(outVectors, i - begin, mask, { _mm512_mul_ps(result[0], invW), _mm512_mul_ps(result[1], invW), _mm512_mul_ps(result[2], invW) });
+		}
+	}
+}
+
+/// <summary>
+/// 4x4行列の積(AVX-512)
+/// m1全体を1レジスタに入れ、k列目の値を128bitの中で各行に広げてm2のk行目と掛ける
+/// 128bitをまたぐ並べ替え(vpermps)はCPUによって遅いので、128bitの中の並べ替え(vpermilps)だけを使う
+/// </summary>
+/// <param name="m1"></param>
+/// <param name="m2"></param>
+/// <returns></returns>
+Matrix4x4 MultiplyAVX512(const Matrix4x4& m1, const Matrix4x4& m2) {
+
+	__m512 a = _mm512_loadu_ps(&m1.m[0][0]);
+
+	__m512 row = _mm512_mul_ps(_mm512_permute_ps(a, 0x00), _mm512_broadcast_f32x4(_mm_loadu_ps(m2.m[0])));
+	row = _mm512_fmadd_ps(_mm512_permute_ps(a, 0x55), _mm512_broadcast_f32x4(_mm_loadu_ps(m2.m[1])), row);
+	row = _mm512_fmadd_ps(_mm512_permute_ps(a, 0xaa), _mm512_broadcast_f32x4(_mm_loadu_ps(m2.m[2])), row);
+	row = _mm512_fmadd_ps(_mm512_permute_ps(a, 0xff), _mm512_broadcast_f32x4(_mm_loadu_ps(m2.m[3])), row);
+
+	Matrix4x4 result;
+	_mm512_storeu_ps(&result.m[0][0], row);
+
+	return result;
+}
+
+/// <summary>
+/// 4x4行列の座標変換のバッチ処理(AVX-512)
+/// </summary>
+/// <param name="vectors"></param>
+/// <param name="matrix"></param>
+/// <param name="outVectors"></param>
+void TransformBatchAVX512(const Vec3fSoA& vectors, const Matrix4x4& matrix, Vec3fSoA& outVectors) {
+
+	const size_t count = vectors.Size();
+	outVectors.Resize(count);
+
+	TransformRange(vectors, Broadcast(matrix), 0, count, outVectors);
+}
+
+/// <summary>
+/// 頂点の一部の座標変換のバッチ処理(AVX-512)
+/// </summary>
+/// <param name="vectors"></param>
+/// <param name="begin"></param>
+/// <param name="end"></param>
+/// <param name="matrix"></param>
+/// <param name="outVectors"></param>
+void TransformBatchRangeAVX512(const Vec3fSoA& vectors, size_t begin, size_t end, const Matrix4x4& matrix, Vec3fSoA& outVectors) {
+
+	outVectors.Resize(end - begin);
+
+	TransformRange(vectors, Broadcast(matrix), begin, end, outVectors);
+}
+
+/// <summary>
+/// 最近接点(点と線分)のバッチ処理(AVX-512)
+/// </summary>
+/// <param name="points"></param>
+/// <param name="segments"></param>
+/// <param name="outClosestPoints"></param>
+void ClosestPointBatchAVX512(const Vec3fSoA& points, const SegmentSoA& segments, Vec3fSoA& outClosestPoints) {
+
+	assert(points.Size() == segments.Size());
+
+	const size_t count = points.Size();
+	outClosestPoints.Resize(count);
+
+	const __m512 zero = _mm512_setzero_ps();
+	const __m512 one = _mm512_set1_ps(1.0f);
+
+	for (size_t i = 0; i < count; i += 16) {
+
+		__mmask16 mask = RemainMask(count - i);
+		Vec3x16 point = Load(points, i, mask);
+		Vec3x16 origin = Load(segments.origin, i, mask);
+		Vec3x16 diff = Load(segments.diff, i, mask);
+
+		Vec3x16 toPoint = { _mm512_sub_ps(point.x, origin.x), _mm512_sub_ps(point.y, origin.y), _mm512_sub_ps(point.z, origin.z) };
+
+		// 長さ0の線分は始点を返す
+		__m512 lengthSq = Dot(diff, diff);
+		__m512 invLengthSq = _mm512_maskz_div_ps(_mm512_cmp_ps_mask(lengthSq, zero, _CMP_GT_OQ), one, lengthSq);
+		__m512 t = _mm512_mul_ps(Dot(toPoint, diff), invLengthSq);
+		t = _mm512_min_ps(_mm512_max_ps(t, zero), one);
+
+		Store(outClosestPoints, i, mask, {
+			_mm512_fmadd_ps(diff.x, t, origin.x), _mm512_fmadd_ps(diff.y, t, origin.y), _mm512_fmadd_ps(diff.z, t, origin.z) });
+	}
+}
+
+/// <summary>
+/// sinとcosのバッチ処理(AVX-512)
+/// </summary>
+/// <param name="angles"></param>
+/// <param name="outSin"></param>
+/// <param name="outCos"></param>
+void SinCosBatchAVX512(const std::vector<float>& angles, std::vector<float>& outSin, std::vector<float>& outCos) {
+
+	using namespace SinCosConstants;
+
+	const size_t count = angles.size();
+	outSin.resize(count);
+	outCos.resize(count);
+
+	const __m512i one = _mm512_set1_epi32(1);
+	const __m512i two = _mm512_set1_epi32(2);
+
+	for (size_t i = 0; i < count; i += 16) {
+
+		__mmask16 mask = RemainMask(count - i);
+		__m512 angle = _mm512_maskz_loadu_ps(mask, &angles[i]);
+
+		__m512i quadrant = _mm512_cvtps_epi32(_mm512_mul_ps(angle, _mm512_set1_ps(kTwoOverPi)));
+		__m512 q = _mm512_cvtepi32_ps(quadrant);
+
+		__m512 r = _mm512_fnmadd_ps(q, _mm512_set1_ps(kPiOverTwo1), angle);
+		r = _mm512_fnmadd_ps(q, _mm512_set1_ps(kPiOverTwo2), r);
+		r = _mm512_fnmadd_ps(q, _mm512_set1_ps(kPiOverTwo3), r);
+		__m512 z = _mm512_mul_ps(r, r);
+
+		__m512 s = _mm512_fmadd_ps(z, _mm512_set1_ps(kSin3), _mm512_set1_ps(kSin2));
+		s = _mm512_fmadd_ps(z, s, _mm512_set1_ps(kSin1));
+		s = _mm512_fmadd_ps(_mm512_mul_ps(r, z), s, r);
+
+		__m512 c = _mm512_fmadd_ps(z, _mm512_set1_ps(kCos3), _mm512_set1_ps(kCos2));
+		c = _mm512_fmadd_ps(z, c, _mm512_set1_ps(kCos1));
+		c = _mm512_fmadd_ps(_mm512_mul_ps(z, z), c, _mm512_fnmadd_ps(_mm512_set1_ps(0.5f), z, _mm512_set1_ps(1.0f)));
+
+		// 象限に合わせて入れ替えと符号反転(2のビットを符号ビットへ移す)
+		__mmask16 swap = _mm512_test_epi32_mask(quadrant, one);
+		__m512i sinSign = _mm512_slli_epi32(_mm512_and_si512(quadrant, two), 30);
+		__m512i cosSign = _mm512_slli_epi32(_mm512_and_si512(_mm512_add_epi32(quadrant, one), two), 30);
+
+		__m512 sinValue = _mm512_mask_blend_ps(swap, s, c);
+		__m512 cosValue = _mm512_mask_blend_ps(swap, c, s);
+
+		_mm512_mask_storeu_ps(&outSin[i], mask, _mm512_castsi512_ps(_mm512_xor_si512(_mm512_castps_si512(sinValue), sinSign)));
+		_mm512_mask_storeu_ps(&outCos[i], mask, _mm512_castsi512_ps(_mm512_xor_si512(_mm512_castps_si512(cosValue), cosSign)));
+	}
+}
@@ -0,0 +1,109 @@
+﻿#pragma once
+#include <Matrix4x4.h>
+#include <immintrin.h>
+#include "Vector.h"
+
+// alignasによるパディングの警告(C4324)は意図したものなので出さない
+#ifdef _MSC_VER
+#pragma warning(push)
+#pragma warning(disable : 4324)
+#endif
+
+/// <summary>
+/// 64バイト境界に置く4x4行列
+/// 要素の並びはNoviceのMatrix4x4と同じ行優先(行ベクトル x 行列)で、各行をそのままSSEのレジスタに読み込める
+/// 1行が16バイトなので、行列全体がキャッシュラインの1本に収まる
+/// </summary>
+struct alignas(64) Matrix4x4A {
+
+	float m[4][4];
+
+	// コンストラクタ(要素は初期化しない、Matrix4x4と同じ)
+	Matrix4x4A() {}
+
+	// Matrix4x4からの変換
+	explicit Matrix4x4A(const Matrix4x4& matrix) {
+		for (int i = 0; i < 4; ++i) {
+			_mm_store_ps(m[i], _mm_loadu_ps(matrix.m[i]));
+		}
+	}
+
+	// Matrix4x4への変換、要素をそのまま写すので誤差は無い
+	operator Matrix4x4() const {
+		Matrix4x4 matrix;
+		for (int i = 0; i < 4; ++i) {
+			_mm_storeu_ps(matrix.m[i], _mm_load_ps(m[i]));
+		}
+		return matrix;
+	}
+
+	__m128 LoadRow(int row) const {
+		return _mm_load_ps(m[row]);
+	}
+
+	void StoreRow(int row, __m128 value) {
+		_mm_store_ps(m[row], value);
+	}
+
+	// 行列の積、結果の各行は左の行列の行の要素で右の行列の行を重み付けして足したもの
+	Matrix4x4A operator*(const Matrix4x4A& other) const {
+
+		__m128 rows[4] = { other.LoadRow(0), other.LoadRow(1), other.LoadRow(2), other.LoadRow(3) };
+
+		Matrix4x4A matrix;
+		for (int i = 0; i < 4; ++i) {
+			__m128 row = _mm_mul_ps(_mm_set1_ps(m[i][0]), rows[0]);
+			row = _mm_add_ps(row, _mm_mul_ps(_mm_set1_ps(m[i][1]), rows[1]));
+			row = _mm_add_ps(row, _mm_mul_ps(_mm_set1_ps(m[i][2]), rows[2]));
+			row = _mm_add_ps(row, _mm_mul_ps(_mm_set1_ps(m[i][3]), rows[3]));
+			matrix.StoreRow(i, row);
+		}
+		return matrix;
+	}
+
+	Matrix4x4A& operator*=(const Matrix4x4A& other) {
+		*this = *this * other;
+		return *this;
+	}
+};
+
+#ifdef _MSC_VER
+#pragma warning(pop)
+#endif
+
+/// <summary>
+/// 4x4行列の積(64バイト境界の行列)
+/// MathTのテンプレートから呼ばれた時もこちらが選ばれる
+/// </summary>
+/// <param name="m1"></param>
+/// <param name="m2"></param>
+/// <returns></returns>
+inline Matrix4x4A Multiply(const Matrix4x4A& m1, const Matrix4x4A& m2) {
+
+	return m1 * m2;
+}
+
+/// <summary>
+/// 4x4行列の座標変換(64バイト境界の行列)
+/// 行を読み込んで足すだけなので、途中の値はレジスタから出ない
+/// </summary>
+/// <param name="vector"></param>
+/// <param name="matrix"></param>
+/// <returns></returns>
+inline Vec3f Transform(const Vec3f& vector, const Matrix4x4A& matrix) {
+
+	__m128 result = _mm_mul_ps(_mm_set1_ps(vector.x), matrix.LoadRow(0));
+	result = _mm_add_ps(result, _mm_mul_ps(_mm_set1_ps(vector.y), matrix.LoadRow(1)));
+	result = _mm_add_ps(result, _mm_mul_ps(_mm_set1_ps(vector.z), matrix.LoadRow(2)));
+	result = _mm_add_ps(result, matrix.LoadRow(3));
+
+	// wが0でなければ割る
+	__m128 w = _mm_shuffle_ps(result, result, _MM_SHUFFLE(3, 3, 3, 3));
+	if (_mm_cvtss_f32(w) != 0.0f) {
+		result = _mm_div_ps(result, w);
+	}
+
+	alignas(16) float values[4];
+	_mm_store_ps(values, result);
+	return Vec3f(values[0], values[1], values[2]);
+}
@@ -1,4 +1,5 @@
 ﻿#include "MyMath.h"
+#include "MathDispatch.h"
 
 /// <summary>
 /// πの値の取得
@@ -14,7 +15,7 @@ float Pi() { return static_cast<float>(M_PI); }
 /// <returns></returns>
 float Dot(const Vec3f& v1, const Vec3f& v2) {
 
-	return v1.x * v2.x + v1.y * v2.y + v1.z * v2.z;
+	return MathT::Dot(v1, v2);
 }
 
 /// <summary>
@@ -24,7 +25,7 @@ float Dot(const Vec3f& v1, const Vec3f& v2) {
 /// <returns></returns>
 float Length(const Vec3f& v) {
 
-	return sqrtf(v.x * v.x + v.y * v.y + v.z * v.z);
+	return MathT::Length(v);
 }
 
 /// <summary>
@@ -34,15 +35,7 @@ float Length(const Vec3f& v) {
 /// <returns></returns>
 Vec3f Normalize(const Vec3f& v) {
 
-	float length = Length(v);
-	if (length != 0) {
-		return Vec3f(v.x / length, v.y / length, v.z / length);
-	}
-	else {
-
-		// 値が入ってなければnullで返す
-		return Vec3f(0.0f, 0.0f, 0.0f);
-	}
+	return MathT::Normalize(v);
 }
 
 /// <summary>
@@ -53,11 +46,7 @@ Vec3f Normalize(const Vec3f& v) {
 /// <returns></returns>
 Vec3f Cross(const Vec3f& v1, const Vec3f& v2) {
 
-	return Vec3f(
-		v1.y * v2.z - v1.z * v2.y,
-		v1.z * v2.x - v1.x * v2.z,
-		v1.x * v2.y - v1.y * v2.x
-	);
+	return MathT::Cross(v1, v2);
 }
 
 /// <summary>
@@ -68,13 +57,7 @@ Vec3f Cross(const Vec3f& v1, const Vec3f& v2) {
 /// <returns></returns>
 Matrix4x4 Add(const Matrix4x4& m1, const Matrix4x4& m2) {
 
-	Matrix4x4 matrix;
-	for (int i = 0; i < 4; i++) {
-		for (int j = 0; j < 4; j++) {
-			matrix.m[i][j] = m1.m[i][j] + m2.m[i][j];
-		}
-	}
-	return matrix;
+	return MathT::Add(m1, m2);
 }
 
 /// <summary>
@@ -85,13 +68,7 @@ Matrix4x4 Add(const Matrix4x4& m1, const Matrix4x4& m2) {
 /// <returns></returns>
 Matrix4x4 Subtract(const Matrix4x4& m1, const Matrix4x4& m2) {
 
-	Matrix4x4 matrix;
-	for (int i = 0; i < 4; i++) {
-		for (int j = 0; j < 4; j++) {
-			matrix.m[i][j] = m1.m[i][j] - m2.m[i][j];
-		}
-	}
-	return matrix;
+	return MathT::Subtract(m1, m2);
 }
 
 /// <summary>
@@ -102,16 +79,8 @@ Matrix4x4 Subtract(const Matrix4x4& m1, const Matrix4x4& m2) {
 /// <returns></returns>
 Matrix4x4 Multiply(const Matrix4x4& m1, const Matrix4x4& m2) {
 
-	Matrix4x4 matrix;
-	for (int i = 0; i < 4; i++) {
-		for (int j = 0; j < 4; j++) {
-			matrix.m[i][j] = 0;
-			for (int k = 0; k < 4; ++k) {
-				matrix.m[i][j] += m1.m[i][k] * m2.m[k][j];
-			}
-		}
-	}
-	return matrix;
+	// CPUに合わせた実装(MathDispatch)を使う
+	return GetMathKernels().multiply(m1, m2);
 }
 
 /// <summary>
@@ -121,98 +90,7 @@ Matrix4x4 Multiply(const Matrix4x4& m1, const Matrix4x4& m2) {
 /// <returns></returns>
 Matrix4x4 Inverse(const Matrix4x4& m) {
 
-	Matrix4x4 matrix = {};
-
-	float det =
-		m.m[0][0] * (m.m[1][1] * m.m[2][2] * m.m[3][3] + m.m[1][2] * m.m[2][3] * m.m[3][1] +
-			m.m[1][3] * m.m[2][1] * m.m[3][2] - m.m[1][1] * m.m[2][3] * m.m[3][2] -
-			m.m[1][2] * m.m[2][1] * m.m[3][3] - m.m[1][3] * m.m[2][2] * m.m[3][1]) -
-		m.m[0][1] * (m.m[1][0] * m.m[2][2] * m.m[3][3] + m.m[1][2] * m.m[2][3] * m.m[3][0] +
-			m.m[1][3] * m.m[2][0] * m.m[3][2] - m.m[1][0] * m.m[2][3] * m.m[3][2] -
-			m.m[1][2] * m.m[2][0] * m.m[3][3] - m.m[1][3] * m.m[2][2] * m.m[3][0]) +
-		m.m[0][2] * (m.m[1][0] * m.m[2][1] * m.m[3][3] + m.m[1][1] * m.m[2][3] * m.m[3][0] +
-			m.m[1][3] * m.m[2][0] * m.m[3][1] - m.m[1][0] * m.m[2][3] * m.m[3][1] -
-			m.m[1][1] * m.m[2][0] * m.m[3][3] - m.m[1][3] * m.m[2][1] * m.m[3][0]) -
-		m.m[0][3] * (m.m[1][0] * m.m[2][1] * m.m[3][2] + m.m[1][1] * m.m[2][2] * m.m[3][0] +
-			m.m[1][2] * m.m[2][0] * m.m[3][1] - m.m[1][0] * m.m[2][2] * m.m[3][1] -
-			m.m[1][1] * m.m[2][0] * m.m[3][2] - m.m[1][2] * m.m[2][1] * m.m[3][0]);
-
-	float invDet = 1.0f / det;
-
-	matrix.m[0][0] = (m.m[1][1] * m.m[2][2] * m.m[3][3] + m.m[1][2] * m.m[2][3] * m.m[3][1] +
-		m.m[1][3] * m.m[2][1] * m.m[3][2] - m.m[1][1] * m.m[2][3] * m.m[3][2] -
-		m.m[1][2] * m.m[2][1] * m.m[3][3] - m.m[1][3] * m.m[2][2] * m.m[3][1]) *
-		invDet;
-	matrix.m[0][1] = (m.m[0][1] * m.m[2][3] * m.m[3][2] + m.m[0][2] * m.m[2][1] * m.m[3][3] +
-		m.m[0][3] * m.m[2][2] * m.m[3][1] - m.m[0][1] * m.m[2][2] * m.m[3][3] -
-		m.m[0][2] * m.m[2][3] * m.m[3][1] - m.m[0][3] * m.m[2][1] * m.m[3][2]) *
-		invDet;
-	matrix.m[0][2] = (m.m[0][1] * m.m[1][2] * m.m[3][3] + m.m[0][2] * m.m[1][3] * m.m[3][1] +
-		m.m[0][3] * m.m[1][1] * m.m[3][2] - m.m[0][1] * m.m[1][3] * m.m[3][2] -
-		m.m[0][2] * m.m[1][1] * m.m[3][3] - m.m[0][3] * m.m[1][2] * m.m[3][1]) *
-		invDet;
-	matrix.m[0][3] = (m.m[0][1] * m.m[1][3] * m.m[2][2] + m.m[0][2] * m.m[1][1] * m.m[2][3] +
-		m.m[0][3] * m.m[1][2] * m.m[2][1] - m.m[0][1] * m.m[1][2] * m.m[2][3] -
-		m.m[0][2] * m.m[1][3] * m.m[2][1] - m.m[0][3] * m.m[1][1] * m.m[2][2]) *
-		invDet;
-
-	matrix.m[1][0] = (m.m[1][0] * m.m[2][3] * m.m[3][2] + m.m[1][2] * m.m[2][0] * m.m[3][3] +
-		m.m[1][3] * m.m[2][2] * m.m[3][0] - m.m[1][0] * m.m[2][2] * m.m[3][3] -
-		m.m[1][2] * m.m[2][3] * m.m[3][0] - m.m[1][3] * m.m[2][0] * m.m[3][2]) *
-		invDet;
-	matrix.m[1][1] = (m.m[0][0] * m.m[2][2] * m.m[3][3] + m.m[0][2] * m.m[2][3] * m.m[3][0] +
-		m.m[0][3] * m.m[2][0] * m.m[3][2] - m.m[0][0] * m.m[2][3] * m.m[3][2] -
-		m.m[0][2] * m.m[2][0] * m.m[3][3] - m.m[0][3] * m.m[2][2] * m.m[3][0]) *
-		invDet;
-	matrix.m[1][2] = (m.m[0][0] * m.m[1][3] * m.m[3][2] + m.m[0][2] * m.m[1][0] * m.m[3][3] +
-		m.m[0][3] * m.m[1][2] * m.m[3][0] - m.m[0][0] * m.m[1][2] * m.m[3][3] -
-		m.m[0][2] * m.m[1][3] * m.m[3][0] - m.m[0][3] * m.m[1][0] * m.m[3][2]) *
-		invDet;
-	matrix.m[1][3] = (m.m[0][0] * m.m[1][2] * m.m[2][3] + m.m[0][2] * m.m[1][3] * m.m[2][0] +
-		m.m[0][3] * m.m[1][0] * m.m[2][2] - m.m[0][0] * m.m[1][3] * m.m[2][2] -
-		m.m[0][2] * m.m[1][0] * m.m[2][3] - m.m[0][3] * m.m[1][2] * m.m[2][0]) *
-		invDet;
-
-	matrix.m[2][0] = (m.m[1][0] * m.m[2][1] * m.m[3][3] + m.m[1][1] * m.m[2][3] * m.m[3][0] +
-		m.m[1][3] * m.m[2][0] * m.m[3][1] - m.m[1][0] * m.m[2][3] * m.m[3][1] -
-		m.m[1][1] * m.m[2][0] * m.m[3][3] - m.m[1][3] * m.m[2][1] * m.m[3][0]) *
-		invDet;
-	matrix.m[2][1] = (m.m[0][0] * m.m[2][3] * m.m[3][1] + m.m[0][1] * m.m[2][0] * m.m[3][3] +
-		m.m[0][3] * m.m[2][1] * m.m[3][0] - m.m[0][0] * m.m[2][1] * m.m[3][3] -
-		m.m[0][1] * m.m[2][3] * m.m[3][0] - m.m[0][3] * m.m[2][0] * m.m[3][1]) *
-		invDet;
-	matrix.m[2][2] = (m.m[0][0] * m.m[1][1] * m.m[3][3] + m.m[0][1] * m.m[1][3] * m.m[3][0] +
-		m.m[0][3] * m.m[1][0] * m.m[3][1] - m.m[0][0] * m.m[1][3] * m.m[3][1] -
-		m.m[0][1] * m.m[1][0] * m.m[3][3] - m.m[0][3] * m.m[1][1] * m.m[3][0]) *
-		invDet;
-	matrix.m[2][3] = (m.m[0][0] * m.m[1][3] * m.m[2][1] + m.m[0][1] * m.m[1][0] * m.m[2][3] +
-		m.m[0][3] * m.m[1][1] * m.m[2][0] - m.m[0][0] * m.m[1][1] * m.m[2][3] -
-		m.m[0][1] * m.m[1][3] * m.m[2][0] - m.m[0][3] * m.m[1][0] * m.m[2][1]) *
-		invDet;
-
-	matrix.m[3][0] = (m.m[1][0] * m.m[2][2] * m.m[3][1] + m.m[1][1] * m.m[2][0] * m.m[3][2] +
-		m.m[1][2] * m.m[2][1] * m.m[3][0] - m.m[1][0] * m.m[2][1] * m.m[3][2] -
-		m.m[1][1] * m.m[2][2] * m.m[3][0] - m.m[1][2] * m.m[2][0] * m.m[3][1]) *
-		invDet;
-	matrix.m[3][1] = (m.m[0][0] * m.m[2][1] * m.m[3][2] + m.m[0][1] * m.m[2][2] * m.m[3][0] +
-		m.m[0][2] * m.m[2][0] * m.m[3][1] - m.m[0][0] * m.m[2][2] * m.m[3][1] -
-		m.m[0][1] * m.m[2][0] * m.m[3][2] - m.m[0][2] * m.m[2][1] * m.m[3][0]) *
-		invDet;
-	matrix.m[3][2] = (m.m[0][0] * m.m[1][2] * m.m[3][1] + m.m[0][1] * m.m[1][0] * m.m[3][2] +
-		m.m[0][2] * m.m[1][1] * m.m[3][0] - m.m[0][0] * m.m[1][1] * m.m[3][2] -
-		m.m[0][1] * m.m[1][2] * m.m[3][0] - m.m[0][2] * m.m[1][0] * m.m[3][1]) *
-		invDet;
-	matrix.m[3][3] = (m.m[0][0] * m.m[1][1] * m.m[2][2] + m.m[0][1] * m.m[1][2] * m.m[2][0] +
-		m.m[0][2] * m.m[1][0] * m.m[2][1] - m.m[0][0] * m.m[1][2] * m.m[2][1] -
-		m.m[0][1] * m.m[1][0] * m.m[2][2] - m.m[0][2] * m.m[1][1] * m.m[2][0]) *
-		invDet;
-
-	if (det == 0) {
-
-		return matrix;
-	}
-
-	return matrix;
+	return MathT::Inverse(m);
 }
 
 /// <summary>
@@ -222,14 +100,7 @@ Matrix4x4 Inverse(const Matrix4x4& m) {
 /// <returns></returns>
 Matrix4x4 Transpose(const Matrix4x4& m) {
 
-	Matrix4x4 matrix;
-	for (int i = 0; i < 4; i++) {
-		for (int j = 0; j < 4; j++) {
-			matrix.m[i][j] = m.m[j][i];
-		}
-	}
-
-	return matrix;
+	return MathT::Transpose(m);
 }
 
 /// <summary>
@@ -238,14 +109,7 @@ Matrix4x4 Transpose(const Matrix4x4& m) {
 /// <returns></returns>
 Matrix4x4 MakeIdentity4x4() {
 
-	Matrix4x4 matrix;
-	for (int i = 0; i < 4; i++) {
-		for (int j = 0; j < 4; j++) {
-			matrix.m[i][j] = (i == j) ? 1.0f : 0.0f;
-		}
-	}
-
-	return matrix;
+	return MathT::MakeIdentity4x4<Matrix4x4>();
 }
 
 /// <summary>
@@ -255,14 +119,7 @@ Matrix4x4 MakeIdentity4x4() {
 /// <returns></returns>
 Matrix4x4 MakeScaleMatrix(const Vec3f& scale) {
 
-	Matrix4x4 scaleMatrix = {
-		scale.x, 0.0f, 0.0f ,0.0f,
-		0.0f, scale.y, 0.0f, 0.0f,
-		0.0f, 0.0f, scale.z, 0.0f,
-		0.0f ,0.0f, 0.0f, 1.0f
-	};
-
-	return scaleMatrix;
+	return MathT::MakeScaleMatrix<Matrix4x4>(scale);
 }
 
 /// <summary>
@@ -272,16 +129,7 @@ Matrix4x4 MakeScaleMatrix(const Vec3f& scale) {
 /// <returns></returns>
 Matrix4x4 MakePitchMatrix(float radian) {
 
-	float cosTheta = std::cos(radian);
-	float sinTheta = std::sin(radian);
-
-	Matrix4x4 pitchMatrix = {
-		1.0f, 0.0f,0.0f,0.0f,
-		0.0f, cosTheta, sinTheta, 0.0f,
-		0.0f, -sinTheta, cosTheta, 0.0f,
-		0.0f, 0.0f, 0.0f, 1.0f };
-
-	return pitchMatrix;
+	return MathT::MakePitchMatrix<Matrix4x4>(radian);
 }
 
 /// <summary>
@@ -291,17 +139,7 @@ Matrix4x4 MakePitchMatrix(float radian) {
 /// <returns></returns>
 Matrix4x4 MakeYawMatrix(float radian) {
 
-	float cosTheta = std::cos(radian);
-	float sinTheta = std::sin(radian);
-
-	Matrix4x4 yawMatrix = {
-		cosTheta, 0.0f, -sinTheta, 0.0f,
-		0.0f, 1.0f, 0.0f, 0.0f,
-		sinTheta, 0.0f, cosTheta, 0.0f,
-		0.0f, 0.0f, 0.0f, 1.0f
-	};
-
-	return yawMatrix;
+	return MathT::MakeYawMatrix<Matrix4x4>(radian);
 }
 
 /// <summary>
@@ -311,17 +149,7 @@ Matrix4x4 MakeYawMatrix(float radian) {
 /// <returns></returns>
 Matrix4x4 MakeRollMatrix(float radian) {
 
-	float cosTheta = std::cos(radian);
-	float sinTheta = std::sin(radian);
-
-	Matrix4x4 rollMatrix = {
-		cosTheta, sinTheta, 0.0f, 0.0f,
-		-sinTheta, cosTheta, 0.0f, 0.0f,
-		0.0f, 0.0f, 1.0f, 0.0f,
-		0.0f,0.0f,0.0f, 1.0f
-	};
-
-	return rollMatrix;
+	return MathT::MakeRollMatrix<Matrix4x4>(radian);
 }
 
 /// <summary>
@@ -331,13 +159,8 @@ Matrix4x4 MakeRollMatrix(float radian) {
 /// <returns></returns>
 Matrix4x4 MakeRotateMatrix(const Vec3f& rotate) {
 
-	Matrix4x4 pitchMatrix = MakePitchMatrix(rotate.x);	// X軸回転行列
-	Matrix4x4 yawMatrix = MakeYawMatrix(rotate.y);		// Y軸回転行列
-	Matrix4x4 rollMatrix = MakeRollMatrix(rotate.z);	// Z軸回転行列
-
-	Matrix4x4 rotateMatrix = Multiply(pitchMatrix, Multiply(yawMatrix, rollMatrix));
-
-	return rotateMatrix;
+	// 途中の積は64バイト境界の行列で求める
+	return MathT::MakeRotateMatrix<Matrix4x4A>(rotate);
 }
 
 /// <summary>
@@ -347,14 +170,7 @@ Matrix4x4 MakeRotateMatrix(const Vec3f& rotate) {
 /// <returns></returns>
 Matrix4x4 MakeTranslateMatrix(const Vec3f& translate) {
 
-	Matrix4x4 translateMatrix = {
-		1.0f, 0.0f, 0.0f, 0.0f,
-		0.0f, 1.0f, 0.0f, 0.0f,
-		0.0f, 0.0f, 1.0f, 0.0f,
-		translate.x, translate.y, translate.z, 1.0f
-	};
-
-	return translateMatrix;
+	return MathT::MakeTranslateMatrix<Matrix4x4>(translate);
 }
 
 /// <summary>
@@ -366,16 +182,8 @@ Matrix4x4 MakeTranslateMatrix(const Vec3f& translate) {
 /// <returns></returns>
 Matrix4x4 MakeAffineMatrix(const Vec3f& scale, const Vec3f& rotate, const Vec3f& translate) {
 
-	Matrix4x4 matrix = {};
-
-	Matrix4x4 scaleMatrix = MakeScaleMatrix(scale);
-	Matrix4x4 rotateMatrix = MakeRotateMatrix(rotate);
-	Matrix4x4 translateMatrix = MakeTranslateMatrix(translate);
-
-	matrix = Multiply(scaleMatrix, rotateMatrix);
-	matrix = Multiply(matrix, translateMatrix);
-
-	return matrix;
+	// 行列の積を使わない閉じた式で作る
+	return MathT::ComposeAffineMatrix<Matrix4x4>(scale, rotate, translate);
 }
 
 /// <summary>
@@ -386,26 +194,7 @@ Matrix4x4 MakeAffineMatrix(const Vec3f& scale, const Vec3f& rotate, const Vec3f&
 /// <returns></returns>
 Vec3f Transform(const Vec3f& vector, const Matrix4x4& matrix) {
 
-	Vec3f result;
-
-	// ベクトルと行列の乗算
-	result.x = vector.x * matrix.m[0][0] + vector.y * matrix.m[1][0] + vector.z * matrix.m[2][0] +
-		matrix.m[3][0];
-	result.y = vector.x * matrix.m[0][1] + vector.y * matrix.m[1][1] + vector.z * matrix.m[2][1] +
-		matrix.m[3][1];
-	result.z = vector.x * matrix.m[0][2] + vector.y * matrix.m[1][2] + vector.z * matrix.m[2][2] +
-		matrix.m[3][2];
-	float w = vector.x * matrix.m[0][3] + vector.y * matrix.m[1][3] + vector.z * matrix.m[2][3] +
-		matrix.m[3][3];
-
-	// ベクトルの正規化
-	if (w != 0.0f) {
-		result.x /= w;
-		result.y /= w;
-		result.z /= w;
-	}
-
-	return result;
+	return MathT::Transform(vector, matrix);
 }
 
 /// <summary>
@@ -439,4 +228,522 @@ Vec3f ClosestPoint(const Vec3f& point, const Segement& segment) {
 	float t = std::clamp(Dot(projection - segment.origin, segment.diff) / Dot(segment.diff, segment.diff), 0.0f, 1.0f);
 
 	return segment.origin + segment.diff * t;
-}
\ No newline at end of file
+}
+
+/// <summary>
+/// 2線分間の最近接点
+/// </summary>
+/// <param name="segment1"></param>
+/// <param name="segment2"></param>
+/// <returns></returns>
+ClosestPointPair ClosestPoints(const Segement& segment1, const Segement& segment2) {
+
+	const float kEpsilon = 1.0e-6f;
+	// 平行とみなす角度(sinの2乗)
+	const float kParallelEpsilon = 1.0e-10f;
+
+	Vec3f r = segment1.origin - segment2.origin;
+	float a = Dot(segment1.diff, segment1.diff);
+	float e = Dot(segment2.diff, segment2.diff);
+	float f = Dot(segment2.diff, r);
+
+	float s = 0.0f;
+	float t = 0.0f;
+
+	if (a <= kEpsilon && e <= kEpsilon) {
+
+		// 両方とも点に縮退
+		return { segment1.origin, segment2.origin };
+	}
+
+	if (a <= kEpsilon) {
+
+		// 線分1が点に縮退
+		t = std::clamp(f / e, 0.0f, 1.0f);
+	} else {
+
+		float c = Dot(segment1.diff, r);
+		if (e <= kEpsilon) {
+
+			// 線分2が点に縮退
+			s = std::clamp(-c / a, 0.0f, 1.0f);
+		} else {
+
+			float b = Dot(segment1.diff, segment2.diff);
+
+			// a * e - b * b、b * f - c * eは平行に近いと打ち消しで精度が無くなるので、外積で求める
+			Vec3f normal = Cross(segment1.diff, segment2.diff);
+			float denom = Dot(normal, normal);
+			float numer = Dot(normal, Cross(segment2.diff, r));
+
+			// 平行でなければ線分1上の最近接点を求める、平行なら始点を使う
+			if (denom > kParallelEpsilon * a * e) {
+				s = std::clamp(numer / denom, 0.0f, 1.0f);
+			}
+
+			t = (b * s + f) / e;
+
+			// tが範囲外ならクランプしてsを求め直す
+			if (t < 0.0f) {
+				t = 0.0f;
+				s = std::clamp(-c / a, 0.0f, 1.0f);
+			} else if (t > 1.0f) {
+				t = 1.0f;
+				s = std::clamp((b - c) / a, 0.0f, 1.0f);
+			}
+		}
+	}
+
+	return { segment1.origin + segment1.diff * s, segment2.origin + segment2.diff * t };
+}
+
+/// <summary>
+/// 半直線、線分と球の交差判定の共通処理
+/// </summary>
+/// <param name="origin"></param>
+/// <param name="diff"></param>
+/// <param name="sphere"></param>
+/// <param name="tMax"></param>
+/// <param name="t"></param>
+/// <returns></returns>
+static bool IntersectSphere(const Vec3f& origin, const Vec3f& diff, const SphereShape& sphere, float tMax, float& t) {
+
+	Vec3f m = origin - sphere.center;
+	float c = Dot(m, m) - sphere.radius * sphere.radius;
+
+	// 始点が球の内側
+	if (c <= 0.0f) {
+		t = 0.0f;
+		return true;
+	}
+
+	float a = Dot(diff, diff);
+	float b = Dot(m, diff);
+
+	// 球から離れる方向、または方向ベクトルが0
+	if (b >= 0.0f || a == 0.0f) {
+		return false;
+	}
+
+	float discriminant = b * b - a * c;
+	if (discriminant < 0.0f) {
+		return false;
+	}
+
+	float hitT = (-b - std::sqrt(discriminant)) / a;
+	if (hitT > tMax) {
+		return false;
+	}
+
+	t = hitT;
+	return true;
+}
+
+/// <summary>
+/// 半直線と球の交差判定
+/// </summary>
+/// <param name="ray"></param>
+/// <param name="sphere"></param>
+/// <param name="t"></param>
+/// <returns></returns>
+bool RaySphereIntersection(const Ray& ray, const SphereShape& sphere, float& t) {
+
+	return IntersectSphere(ray.origin, ray.diff, sphere, std::numeric_limits<float>::infinity(), t);
+}
+
+/// <summary>
+/// 線分と球の交差判定
+/// </summary>
+/// <param name="segment"></param>
+/// <param name="sphere"></param>
+/// <param name="t"></param>
+/// <returns></returns>
+bool SegmentSphereIntersection(const Segement& segment, const SphereShape& sphere, float& t) {
+
+	return IntersectSphere(segment.origin, segment.diff, sphere, 1.0f, t);
+}
+
+/// <summary>
+/// 点と球の距離(球内なら負)
+/// </summary>
+/// <param name="point"></param>
+/// <param name="sphere"></param>
+/// <returns></returns>
+float DistancePointSphere(const Vec3f& point, const SphereShape& sphere) {
+
+	return Length(point - sphere.center) - sphere.radius;
+}
+
+/// <summary>
+/// 半直線、線分とAABBの交差判定の共通処理
+/// 各軸のスラブとの交差区間を[0, tMax]から狭めていく
+/// </summary>
+/// <param name="origin"></param>
+/// <param name="diff"></param>
+/// <param name="aabb"></param>
+/// <param name="tMax"></param>
+/// <param name="t"></param>
+/// <returns></returns>
+static bool IntersectAABB(const Vec3f& origin, const Vec3f& diff, const AABB& aabb, float tMax, float& t) {
+
+	const float origins[3] = { origin.x, origin.y, origin.z };
+	const float diffs[3] = { diff.x, diff.y, diff.z };
+	const float boxMin[3] = { aabb.min.x, aabb.min.y, aabb.min.z };
+	const float boxMax[3] = { aabb.max.x, aabb.max.y, aabb.max.z };
+
+	float tNear = 0.0f;
+	float tFar = tMax;
+
+	for (int axis = 0; axis < 3; ++axis) {
+
+		if (diffs[axis] == 0.0f) {
+
+			// 軸に平行ならスラブの外にある時点で交差しない
+			if (origins[axis] < boxMin[axis] || origins[axis] > boxMax[axis]) {
+				return false;
+			}
+			continue;
+		}
+
+		float invDiff = 1.0f / diffs[axis];
+		float t1 = (boxMin[axis] - origins[axis]) * invDiff;
+		float t2 = (boxMax[axis] - origins[axis]) * invDiff;
+
+		tNear = (std::max)(tNear, (std::min)(t1, t2));
+		tFar = (std::min)(tFar, (std::max)(t1, t2));
+
+		if (tNear > tFar) {
+			return false;
+		}
+	}
+
+	t = tNear;
+	return true;
+}
+
+/// <summary>
+/// 半直線とAABBの交差判定
+/// </summary>
+/// <param name="ray"></param>
+/// <param name="aabb"></param>
+/// <param name="t"></param>
+/// <returns></returns>
+bool RayAABBIntersection(const Ray& ray, const AABB& aabb, float& t) {
+
+	return IntersectAABB(ray.origin, ray.diff, aabb, std::numeric_limits<float>::infinity(), t);
+}
+
+/// <summary>
+/// 線分とAABBの交差判定
+/// </summary>
+/// <param name="segment"></param>
+/// <param name="aabb"></param>
+/// <param name="t"></param>
+/// <returns></returns>
+bool SegmentAABBIntersection(const Segement& segment, const AABB& aabb, float& t) {
+
+	return IntersectAABB(segment.origin, segment.diff, aabb, 1.0f, t);
+}
+
+/// <summary>
+/// AABB同士の交差判定
+/// 分離軸はワールドの3軸だけなので、区間が重ならない軸があれば交差しない
+/// </summary>
+/// <param name="aabb1"></param>
+/// <param name="aabb2"></param>
+/// <returns></returns>
+bool AABBIntersection(const AABB& aabb1, const AABB& aabb2) {
+
+	return aabb1.min.x <= aabb2.max.x && aabb1.max.x >= aabb2.min.x &&
+		aabb1.min.y <= aabb2.max.y && aabb1.max.y >= aabb2.min.y &&
+		aabb1.min.z <= aabb2.max.z && aabb1.max.z >= aabb2.min.z;
+}
+
+/// <summary>
+/// 球とAABBの交差判定
+/// 箱の中で球の中心に一番近い点が球の中にあれば交差する
+/// </summary>
+/// <param name="sphere"></param>
+/// <param name="aabb"></param>
+/// <returns></returns>
+bool SphereAABBIntersection(const SphereShape& sphere, const AABB& aabb) {
+
+	Vec3f closest = {
+		std::clamp(sphere.center.x, aabb.min.x, aabb.max.x),
+		std::clamp(sphere.center.y, aabb.min.y, aabb.max.y),
+		std::clamp(sphere.center.z, aabb.min.z, aabb.max.z) };
+
+	Vec3f toCenter = sphere.center - closest;
+	return Dot(toCenter, toCenter) <= sphere.radius * sphere.radius;
+}
+
+/// <summary>
+/// OBB同士の交差判定(分離軸定理)
+/// 候補の軸は各OBBの3軸と、その外積の9軸の計15軸で、分離している軸が見つかった時点で終わる
+/// 計算はOBB1の座標系で行う
+/// </summary>
+/// <param name="obb1"></param>
+/// <param name="obb2"></param>
+/// <returns></returns>
+bool OBBIntersection(const OBB& obb1, const OBB& obb2) {
+
+	// 辺が平行な時に外積が0になり、誤差で分離と判定しないための余裕
+	const float kEpsilon = 1.0e-6f;
+
+	const float a[3] = { obb1.size.x, obb1.size.y, obb1.size.z };
+	const float b[3] = { obb2.size.x, obb2.size.y, obb2.size.z };
+
+	// OBB2の軸をOBB1の座標系で表した回転行列とその絶対値
+	float r[3][3];
+	float absR[3][3];
+	for (int i = 0; i < 3; ++i) {
+		for (int j = 0; j < 3; ++j) {
+			r[i][j] = Dot(obb1.orientations[i], obb2.orientations[j]);
+			absR[i][j] = std::abs(r[i][j]) + kEpsilon;
+		}
+	}
+
+	// 中心間のベクトル(OBB1の座標系)
+	Vec3f distance = obb2.center - obb1.center;
+	const float t[3] = { Dot(distance, obb1.orientations[0]), Dot(distance, obb1.orientations[1]), Dot(distance, obb1.orientations[2]) };
+
+	// OBB1の軸
+	for (int i = 0; i < 3; ++i) {
+		float radius2 = b[0] * absR[i][0] + b[1] * absR[i][1] + b[2] * absR[i][2];
+		if (std::abs(t[i]) > a[i] + radius2) {
+			return false;
+		}
+	}
+
+	// OBB2の軸
+	for (int j = 0; j < 3; ++j) {
+		float radius1 = a[0] * absR[0][j] + a[1] * absR[1][j] + a[2] * absR[2][j];
+		if (std::abs(t[0] * r[0][j] + t[1] * r[1][j] + t[2] * r[2][j]) > radius1 + b[j]) {
+			return false;
+		}
+	}
+
+	// OBB1の軸iとOBB2の軸jの外積
+	for (int i = 0; i < 3; ++i) {
+
+		int i1 = (i + 1) % 3;
+		int i2 = (i + 2) % 3;
+
+		for (int j = 0; j < 3; ++j) {
+
+			int j1 = (j + 1) % 3;
+			int j2 = (j + 2) % 3;
+
+			float radius1 = a[i1] * absR[i2][j] + a[i2] * absR[i1][j];
+			float radius2 = b[j1] * absR[i][j2] + b[j2] * absR[i][j1];
+			if (std::abs(t[i2] * r[i1][j] - t[i1] * r[i2][j]) > radius1 + radius2) {
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+/// <summary>
+/// 線分と平面の交差判定
+/// </summary>
+/// <param name="segment"></param>
+/// <param name="plane"></param>
+/// <param name="t"></param>
+/// <returns></returns>
+bool SegmentPlaneIntersection(const Segement& segment, const Plane& plane, float& t) {
+
+	float denominator = Dot(plane.normal, segment.diff);
+
+	// 平面と平行
+	if (denominator == 0.0f) {
+		return false;
+	}
+
+	float hitT = (plane.distance - Dot(segment.origin, plane.normal)) / denominator;
+	if (hitT < 0.0f || hitT > 1.0f) {
+		return false;
+	}
+
+	t = hitT;
+	return true;
+}
+
+/// <summary>
+/// 回転から座標軸を作ったOBB
+/// 回転行列の各行がそのまま座標軸になる
+/// </summary>
+/// <param name="center"></param>
+/// <param name="rotate"></param>
+/// <param name="size"></param>
+/// <returns></returns>
+OBB MakeOBB(const Vec3f& center, const Vec3f& rotate, const Vec3f& size) {
+
+	Matrix4x4 rotateMatrix = MakeRotateMatrix(rotate);
+
+	OBB obb;
+	obb.center = center;
+	for (int i = 0; i < 3; ++i) {
+		obb.orientations[i] = { rotateMatrix.m[i][0], rotateMatrix.m[i][1], rotateMatrix.m[i][2] };
+	}
+	obb.size = size;
+
+	return obb;
+}
+
+/// <summary>
+/// AABBをOBBとして扱う
+/// </summary>
+/// <param name="aabb"></param>
+/// <returns></returns>
+OBB ToOBB(const AABB& aabb) {
+
+	return {
+		(aabb.min + aabb.max) * 0.5f,
+		{ { 1.0f,0.0f,0.0f }, { 0.0f,1.0f,0.0f }, { 0.0f,0.0f,1.0f } },
+		(aabb.max - aabb.min) * 0.5f };
+}
+
+/// <summary>
+/// スクリーン座標からワールド空間の半直線を求める
+/// </summary>
+/// <param name="screenPos"></param>
+/// <param name="inverseViewProjectionViewportMatrix"></param>
+/// <returns></returns>
+Ray ScreenToWorldRay(const Vec2f& screenPos, const Matrix4x4& inverseViewProjectionViewportMatrix) {
+
+	// 深度0が近クリップ面、1が遠クリップ面
+	Vec3f nearPos = Transform({ screenPos.x, screenPos.y, 0.0f }, inverseViewProjectionViewportMatrix);
+	Vec3f farPos = Transform({ screenPos.x, screenPos.y, 1.0f }, inverseViewProjectionViewportMatrix);
+
+	return { nearPos, farPos - nearPos };
+}
+
+/*============================================================================================================================*/
+// 倍精度版
+
+/// <summary>
+/// 内積(倍精度)
+/// </summary>
+/// <param name="v1"></param>
+/// <param name="v2"></param>
+/// <returns></returns>
+double Dot(const Vec3d& v1, const Vec3d& v2) {
+
+	return MathT::Dot(v1, v2);
+}
+
+/// <summary>
+/// 長さ、ノルム(倍精度)
+/// </summary>
+/// <param name="v"></param>
+/// <returns></returns>
+double Length(const Vec3d& v) {
+
+	return MathT::Length(v);
+}
+
+/// <summary>
+/// 正規化(倍精度)
+/// </summary>
+/// <param name="v"></param>
+/// <returns></returns>
+Vec3d Normalize(const Vec3d& v) {
+
+	return MathT::Normalize(v);
+}
+
+/// <summary>
+/// クロス積(倍精度)
+/// </summary>
+/// <param name="v1"></param>
+/// <param name="v2"></param>
+/// <returns></returns>
+Vec3d Cross(const Vec3d& v1, const Vec3d& v2) {
+
+	return MathT::Cross(v1, v2);
+}
+
+/// <summary>
+/// 4x4行列の積(倍精度)
+/// </summary>
+/// <param name="m1"></param>
+/// <param name="m2"></param>
+/// <returns></returns>
+Matrix4x4d Multiply(const Matrix4x4d& m1, const Matrix4x4d& m2) {
+
+	return MathT::Multiply(m1, m2);
+}
+
+/// <summary>
+/// 4x4行列の逆行列(倍精度)
+/// </summary>
+/// <param name="m"></param>
+/// <returns></returns>
+Matrix4x4d Inverse(const Matrix4x4d& m) {
+
+	return MathT::Inverse(m);
+}
+
+/// <summary>
+/// 4x4行列の転置行列(倍精度)
+/// </summary>
+/// <param name="m"></param>
+/// <returns></returns>
+Matrix4x4d Transpose(const Matrix4x4d& m) {
+
+	return MathT::Transpose(m);
+}
+
+/// <summary>
+/// 4x4行列の単位行列(倍精度)
+/// </summary>
+/// <returns></returns>
+Matrix4x4d MakeIdentity4x4d() {
+
+	return MathT::MakeIdentity4x4<Matrix4x4d>();
+}
+
+/// <summary>
+/// 4x4行列のアフィン変換(倍精度)
+/// </summary>
+/// <param name="scale"></param>
+/// <param name="rotate"></param>
+/// <param name="translate"></param>
+/// <returns></returns>
+Matrix4x4d MakeAffineMatrix4x4d(const Vec3d& scale, const Vec3d& rotate, const Vec3d& translate) {
+
+	return MathT::ComposeAffineMatrix<Matrix4x4d>(scale, rotate, translate);
+}
+
+/// <summary>
+/// 4x4行列の座標変換(倍精度)
+/// </summary>
+/// <param name="vector"></param>
+/// <param name="matrix"></param>
+/// <returns></returns>
+Vec3d Transform(const Vec3d& vector, const Matrix4x4d& matrix) {
+
+	return MathT::Transform(vector, matrix);
+}
+
+/// <summary>
+/// 倍精度の行列を単精度に変換
+/// </summary>
+/// <param name="m"></param>
+/// <returns></returns>
+Matrix4x4 ToMatrix4x4f(const Matrix4x4d& m) {
+
+	return MathT::ConvertMatrix<Matrix4x4>(m);
+}
+
+/// <summary>
+/// 単精度の行列を倍精度に変換
+/// </summary>
+/// <param name="m"></param>
+/// <returns></returns>
+Matrix4x4d ToMatrix4x4d(const Matrix4x4& m) {
+
+	return MathT::ConvertMatrix<Matrix4x4d>(m);
+}
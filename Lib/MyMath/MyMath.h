@@ -1,10 +1,13 @@
 ﻿#pragma once
 #include <algorithm>
+#include <limits>
 #include <stdint.h>
 #include <Novice.h>
 #include <Matrix4x4.h>
 #include <ImGui.h>
 #include "Vector.h"
+#include "Matrix4x4A.h"
+#include "MyMathTemplate.h"
 
 /// <summary>
 /// 線分
@@ -15,6 +18,61 @@ struct Segement {
 	Vec3f diff;   // 終点への差分ベクトル
 };
 
+/// <summary>
+/// 半直線
+/// </summary>
+struct Ray {
+
+	Vec3f origin; // 始点
+	Vec3f diff;   // 方向ベクトル
+};
+
+/// <summary>
+/// 球(衝突判定用)
+/// </summary>
+struct SphereShape {
+
+	Vec3f center; // 中心
+	float radius; // 半径
+};
+
+/// <summary>
+/// 軸平行境界箱
+/// </summary>
+struct AABB {
+
+	Vec3f min; // 最小点
+	Vec3f max; // 最大点
+};
+
+/// <summary>
+/// 有向境界箱
+/// </summary>
+struct OBB {
+
+	Vec3f center;          // 中心
+	Vec3f orientations[3]; // 座標軸(正規化済みで互いに直交)
+	Vec3f size;            // 座標軸方向の長さの半分
+};
+
+/// <summary>
+/// 平面
+/// </summary>
+struct Plane {
+
+	Vec3f normal;   // 法線(正規化済み)
+	float distance; // 原点からの距離
+};
+
+/// <summary>
+/// 2線分間の最近接点の組
+/// </summary>
+struct ClosestPointPair {
+
+	Vec3f point1; // 線分1上の最近接点
+	Vec3f point2; // 線分2上の最近接点
+};
+
 /// <summary>
 /// πの値の取得
 /// </summary>
@@ -168,4 +226,206 @@ Vec3f Project(const Vec3f& v1, const Vec3f& v2);
 /// <param name="point"></param>
 /// <param name="segment"></param>
 /// <returns></returns>
-Vec3f ClosestPoint(const Vec3f& point, const Segement& segment);
\ No newline at end of file
+Vec3f ClosestPoint(const Vec3f& point, const Segement& segment);
+
+/// <summary>
+/// 2線分間の最近接点
+/// </summary>
+/// <param name="segment1"></param>
+/// <param name="segment2"></param>
+/// <returns></returns>
+ClosestPointPair ClosestPoints(const Segement& segment1, const Segement& segment2);
+
+/// <summary>
+/// 半直線と球の交差判定
+/// </summary>
+/// <param name="ray"></param>
+/// <param name="sphere"></param>
+/// <param name="t">交点の媒介変数(始点が球内なら0)</param>
+/// <returns></returns>
+bool RaySphereIntersection(const Ray& ray, const SphereShape& sphere, float& t);
+
+/// <summary>
+/// 線分と球の交差判定
+/// </summary>
+/// <param name="segment"></param>
+/// <param name="sphere"></param>
+/// <param name="t">交点の媒介変数 0 ~ 1 (始点が球内なら0)</param>
+/// <returns></returns>
+bool SegmentSphereIntersection(const Segement& segment, const SphereShape& sphere, float& t);
+
+/// <summary>
+/// 点と球の距離(球内なら負)
+/// </summary>
+/// <param name="point"></param>
+/// <param name="sphere"></param>
+/// <returns></returns>
+float DistancePointSphere(const Vec3f& point, const SphereShape& sphere);
+
+/// <summary>
+/// 半直線とAABBの交差判定
+/// </summary>
+/// <param name="ray"></param>
+/// <param name="aabb"></param>
+/// <param name="t">箱に入る位置の媒介変数(始点が箱内なら0)</param>
+/// <returns></returns>
+bool RayAABBIntersection(const Ray& ray, const AABB& aabb, float& t);
+
+/// <summary>
+/// 線分とAABBの交差判定
+/// </summary>
+/// <param name="segment"></param>
+/// <param name="aabb"></param>
+/// <param name="t">箱に入る位置の媒介変数(始点が箱内なら0)</param>
+/// <returns></returns>
+bool SegmentAABBIntersection(const Segement& segment, const AABB& aabb, float& t);
+
+/// <summary>
+/// AABB同士の交差判定
+/// </summary>
+/// <param name="aabb1"></param>
+/// <param name="aabb2"></param>
+/// <returns></returns>
+bool AABBIntersection(const AABB& aabb1, const AABB& aabb2);
+
+/// <summary>
+/// 球とAABBの交差判定
+/// </summary>
+/// <param name="sphere"></param>
+/// <param name="aabb"></param>
+/// <returns></returns>
+bool SphereAABBIntersection(const SphereShape& sphere, const AABB& aabb);
+
+/// <summary>
+/// OBB同士の交差判定(分離軸定理)
+/// </summary>
+/// <param name="obb1"></param>
+/// <param name="obb2"></param>
+/// <returns></returns>
+bool OBBIntersection(const OBB& obb1, const OBB& obb2);
+
+/// <summary>
+/// 線分と平面の交差判定
+/// </summary>
+/// <param name="segment"></param>
+/// <param name="plane"></param>
+/// <param name="t">交点の媒介変数</param>
+/// <returns></returns>
+bool SegmentPlaneIntersection(const Segement& segment, const Plane& plane, float& t);
+
+/// <summary>
+/// 回転から座標軸を作ったOBB
+/// </summary>
+/// <param name="center"></param>
+/// <param name="rotate"></param>
+/// <param name="size">座標軸方向の長さの半分</param>
+/// <returns></returns>
+OBB MakeOBB(const Vec3f& center, const Vec3f& rotate, const Vec3f& size);
+
+/// <summary>
+/// AABBをOBBとして扱う
+/// </summary>
+/// <param name="aabb"></param>
+/// <returns></returns>
+OBB ToOBB(const AABB& aabb);
+
+/// <summary>
+/// スクリーン座標からワールド空間の半直線を求める
+/// 近クリップ面上の点を始点、遠クリップ面上の点への差分を方向とする
+/// </summary>
+/// <param name="screenPos"></param>
+/// <param name="inverseViewProjectionViewportMatrix">ビュー x 射影 x ビューポート行列の逆行列</param>
+/// <returns></returns>
+Ray ScreenToWorldRay(const Vec2f& screenPos, const Matrix4x4& inverseViewProjectionViewportMatrix);
+
+/*============================================================================================================================*/
+// 倍精度版
+
+/// <summary>
+/// 内積(倍精度)
+/// </summary>
+/// <param name="v1"></param>
+/// <param name="v2"></param>
+/// <returns></returns>
+double Dot(const Vec3d& v1, const Vec3d& v2);
+
+/// <summary>
+/// 長さ、ノルム(倍精度)
+/// </summary>
+/// <param name="v"></param>
+/// <returns></returns>
+double Length(const Vec3d& v);
+
+/// <summary>
+/// 正規化(倍精度)
+/// </summary>
+/// <param name="v"></param>
+/// <returns></returns>
+Vec3d Normalize(const Vec3d& v);
+
+/// <summary>
+/// クロス積(倍精度)
+/// </summary>
+/// <param name="v1"></param>
+/// <param name="v2"></param>
+/// <returns></returns>
+Vec3d Cross(const Vec3d& v1, const Vec3d& v2);
+
+/// <summary>
+/// 4x4行列の積(倍精度)
+/// </summary>
+/// <param name="m1"></param>
+/// <param name="m2"></param>
+/// <returns></returns>
+Matrix4x4d Multiply(const Matrix4x4d& m1, const Matrix4x4d& m2);
+
+/// <summary>
+/// 4x4行列の逆行列(倍精度)
+/// </summary>
+/// <param name="m"></param>
+/// <returns></returns>
+Matrix4x4d Inverse(const Matrix4x4d& m);
+
+/// <summary>
+/// 4x4行列の転置行列(倍精度)
+/// </summary>
+/// <param name="m"></param>
+/// <returns></returns>
+Matrix4x4d Transpose(const Matrix4x4d& m);
+
+/// <summary>
+/// 4x4行列の単位行列(倍精度)
+/// </summary>
+/// <returns></returns>
+Matrix4x4d MakeIdentity4x4d();
+
+/// <summary>
+/// 4x4行列のアフィン変換(倍精度)
+/// </summary>
+/// <param name="scale"></param>
+/// <param name="rotate"></param>
+/// <param name="translate"></param>
+/// <returns></returns>
+Matrix4x4d MakeAffineMatrix4x4d(const Vec3d& scale, const Vec3d& rotate, const Vec3d& translate);
+
+/// <summary>
+/// 4x4行列の座標変換(倍精度)
+/// </summary>
+/// <param name="vector"></param>
+/// <param name="matrix"></param>
+/// <returns></returns>
+Vec3d Transform(const Vec3d& vector, const Matrix4x4d& matrix);
+
+/// <summary>
+/// 倍精度の行列を単精度に変換
+/// </summary>
+/// <param name="m"></param>
+/// <returns></returns>
+Matrix4x4 ToMatrix4x4f(const Matrix4x4d& m);
+
+/// <summary>
+/// 単精度の行列を倍精度に変換
+/// </summary>
+/// <param name="m"></param>
+/// <returns></returns>
+Matrix4x4d ToMatrix4x4d(const Matrix4x4& m);
@@ -0,0 +1,738 @@
+﻿#include "MyMathBatch.h"
+#include "MathDispatch.h"
+#include "Counters.h"
+#include "MyMathSSE.h"
+#include <cassert>
+#include <cmath>
+
+namespace {
+
+	using namespace MathSSE;
+
+	// 4要素分の判定結果を1と0で書き込む
+	void StoreHits(std::vector<uint8_t>& outHits, size_t index, __m128 mask) {
+		int bits = _mm_movemask_ps(mask);
+		for (int lane = 0; lane < 4; ++lane) {
+			outHits[index + lane] = static_cast<uint8_t>((bits >> lane) & 1);
+		}
+	}
+
+	/// <summary>
+	/// 4要素に広げた4x4行列
+	/// </summary>
+	struct Matrix4x4x4 {
+
+		__m128 m[4][4];
+	};
+
+	Matrix4x4x4 Broadcast(const Matrix4x4& matrix) {
+
+		Matrix4x4x4 result;
+		for (int i = 0; i < 4; i++) {
+			for (int j = 0; j < 4; j++) {
+				result.m[i][j] = _mm_set1_ps(matrix.m[i][j]);
+			}
+		}
+		return result;
+	}
+
+	/// <summary>
+	/// [begin, end)の座標変換、i番目の結果をoutVectorsのi - begin番目に書き込む(outVectorsは呼ぶ側でリサイズしておく)
+	/// </summary>
+	void TransformRange(const Vec3fSoA& vectors, const Matrix4x4& matrix, const Matrix4x4x4& m, size_t begin, size_t end, Vec3fSoA& outVectors) {
+
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 one = _mm_set1_ps(1.0f);
+
+		size_t i = begin;
+		for (; i + 4 <= end; i += 4) {
+
+			Vec3x4 v = Load(vectors, i);
+
+			__m128 result[4];
+			for (int j = 0; j < 4; j++) {
+				result[j] = _mm_add_ps(
+					_mm_add_ps(_mm_mul_ps(v.x, m.m[0][j]), _mm_mul_ps(v.y, m.m[1][j])),
+					_mm_add_ps(_mm_mul_ps(v.z, m.m[2][j]), m.m[3][j]));
+			}
+
+			// wが0の要素は割らない
+			__m128 w = result[3];
+			__m128 invW = Select(_mm_cmpneq_ps(w, zero), _mm_div_ps(one, w), one);
+
+			Store(outVectors, i - begin, { _mm_mul_ps(result[0], invW), _mm_mul_ps(result[1], invW), _mm_mul_ps(result[2], invW) });
+		}
+
+		// 端数
+		for (; i < end; ++i) {
+			outVectors.Set(i - begin, Transform(vectors.Get(i), matrix));
+		}
+	}
+
+	/// <summary>
+	/// 半直線、線分と球の交差判定の共通処理
+	/// </summary>
+	void IntersectSphereBatch(const SegmentSoA& lines, const SphereSoA& spheres, float tMax, std::vector<float>& outT) {
+
+		assert(lines.Size() == spheres.Size());
+
+		const size_t count = lines.Size();
+		outT.resize(count);
+
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 miss = _mm_set1_ps(-1.0f);
+		const __m128 tMax4 = _mm_set1_ps(tMax);
+
+		size_t i = 0;
+		for (; i + 4 <= count; i += 4) {
+
+			Vec3x4 origin = Load(lines.origin, i);
+			Vec3x4 diff = Load(lines.diff, i);
+			Vec3x4 center = Load(spheres.center, i);
+			__m128 radius = _mm_loadu_ps(&spheres.radius[i]);
+
+			Vec3x4 m = Sub(origin, center);
+			__m128 c = _mm_sub_ps(Dot(m, m), _mm_mul_ps(radius, radius));
+			__m128 a = Dot(diff, diff);
+			__m128 b = Dot(m, diff);
+			__m128 discriminant = _mm_sub_ps(_mm_mul_ps(b, b), _mm_mul_ps(a, c));
+
+			__m128 hitT = _mm_div_ps(
+				_mm_sub_ps(_mm_sub_ps(zero, b), _mm_sqrt_ps(_mm_max_ps(discriminant, zero))), a);
+
+			// 球に向かっていて判別式が0以上、かつ範囲内で交差
+			__m128 hit = _mm_and_ps(_mm_cmplt_ps(b, zero), _mm_cmpneq_ps(a, zero));
+			hit = _mm_and_ps(hit, _mm_cmpge_ps(discriminant, zero));
+			hit = _mm_and_ps(hit, _mm_cmple_ps(hitT, tMax4));
+
+			// 始点が球の内側なら0
+			__m128 inside = _mm_cmple_ps(c, zero);
+
+			_mm_storeu_ps(&outT[i], Select(inside, zero, Select(hit, hitT, miss)));
+		}
+
+		// 端数
+		for (; i < count; ++i) {
+
+			float t = 0.0f;
+			Segement line = lines.Get(i);
+			bool hit = tMax == 1.0f ?
+				SegmentSphereIntersection(line, spheres.Get(i), t) :
+				RaySphereIntersection({ line.origin, line.diff }, spheres.Get(i), t);
+			outT[i] = hit ? t : -1.0f;
+		}
+	}
+}
+
+/// <summary>
+/// 4x4行列の座標変換のバッチ処理
+/// </summary>
+/// <param name="vectors"></param>
+/// <param name="matrix"></param>
+/// <param name="outVectors"></param>
+void TransformBatch(const Vec3fSoA& vectors, const Matrix4x4& matrix, Vec3fSoA& outVectors) {
+
+	AddCounter(Counter::kVerticesTransformed, vectors.Size());
+
+	GetMathKernels().transformBatch(vectors, matrix, outVectors);
+}
+
+/// <summary>
+/// 頂点の一部の座標変換のバッチ処理
+/// </summary>
+/// <param name="vectors"></param>
+/// <param name="begin"></param>
+/// <param name="end"></param>
+/// <param name="matrix"></param>
+/// <param name="outVectors"></param>
+void TransformBatchRange(const Vec3fSoA& vectors, size_t begin, size_t end, const Matrix4x4& matrix, Vec3fSoA& outVectors) {
+
+	assert(begin <= end && end <= vectors.Size());
+
+	AddCounter(Counter::kVerticesTransformed, end - begin);
+
+	GetMathKernels().transformBatchRange(vectors, begin, end, matrix, outVectors);
+}
+
+/// <summary>
+/// 最近接点(点と線分)のバッチ処理
+/// </summary>
+/// <param name="points"></param>
+/// <param name="segments"></param>
+/// <param name="outClosestPoints"></param>
+void ClosestPointBatch(const Vec3fSoA& points, const SegmentSoA& segments, Vec3fSoA& outClosestPoints) {
+
+	GetMathKernels().closestPointBatch(points, segments, outClosestPoints);
+}
+
+/// <summary>
+/// sinとcosのバッチ処理
+/// </summary>
+/// <param name="angles"></param>
+/// <param name="outSin"></param>
+/// <param name="outCos"></param>
+void SinCosBatch(const std::vector<float>& angles, std::vector<float>& outSin, std::vector<float>& outCos) {
+
+	GetMathKernels().sinCosBatch(angles, outSin, outCos);
+}
+
+/// <summary>
+/// アフィン変換行列のバッチ処理
+/// sinとcosはSinCosBatchでまとめて求め、行列は閉じた式(MathT::ComposeAffineMatrix)で作る
+/// </summary>
+/// <param name="scales"></param>
+/// <param name="rotates"></param>
+/// <param name="translates"></param>
+/// <param name="outMatrices"></param>
+void MakeAffineMatrixBatch(const Vec3fSoA& scales, const Vec3fSoA& rotates, const Vec3fSoA& translates, std::vector<Matrix4x4>& outMatrices) {
+
+	assert(scales.Size() == rotates.Size() && scales.Size() == translates.Size());
+
+	const size_t count = scales.Size();
+	outMatrices.resize(count);
+
+	Vec3fSoA sinRotates;
+	Vec3fSoA cosRotates;
+	SinCosBatch(rotates.x, sinRotates.x, cosRotates.x);
+	SinCosBatch(rotates.y, sinRotates.y, cosRotates.y);
+	SinCosBatch(rotates.z, sinRotates.z, cosRotates.z);
+
+	for (size_t i = 0; i < count; ++i) {
+		outMatrices[i] = MathT::ComposeAffineMatrix<Matrix4x4>(scales.Get(i), sinRotates.Get(i), cosRotates.Get(i), translates.Get(i));
+	}
+}
+
+/// <summary>
+/// 4x4行列の積(SSE2)
+/// 足す順番はMathT::Multiplyと同じ
+/// </summary>
+/// <param name="m1"></param>
+/// <param name="m2"></param>
+/// <returns></returns>
+Matrix4x4 MultiplySSE2(const Matrix4x4& m1, const Matrix4x4& m2) {
+
+	__m128 rows[4];
+	for (int k = 0; k < 4; ++k) {
+		rows[k] = _mm_loadu_ps(m2.m[k]);
+	}
+
+	Matrix4x4 result;
+	for (int i = 0; i < 4; ++i) {
+
+		__m128 row = _mm_mul_ps(_mm_set1_ps(m1.m[i][0]), rows[0]);
+		for (int k = 1; k < 4; ++k) {
+			row = _mm_add_ps(row, _mm_mul_ps(_mm_set1_ps(m1.m[i][k]), rows[k]));
+		}
+
+		_mm_storeu_ps(result.m[i], row);
+	}
+
+	return result;
+}
+
+/// <summary>
+/// 4x4行列の座標変換のバッチ処理(SSE2)
+/// </summary>
+/// <param name="vectors"></param>
+/// <param name="matrix"></param>
+/// <param name="outVectors"></param>
+void TransformBatchSSE2(const Vec3fSoA& vectors, const Matrix4x4& matrix, Vec3fSoA& outVectors) {
+
+	const size_t count = vectors.Size();
+	outVectors.Resize(count);
+
+	TransformRange(vectors, matrix, Broadcast(matrix), 0, count, outVectors);
+}
+
+/// <summary>
+/// 頂点の一部の座標変換のバッチ処理(SSE2)
+/// </summary>
+/// <param name="vectors"></param>
+/// <param name="begin"></param>
+/// <param name="end"></param>
+/// <param name="matrix"></param>
+/// <param name="outVectors"></param>
+void TransformBatchRangeSSE2(const Vec3fSoA& vectors, size_t begin, size_t end, const Matrix4x4& matrix, Vec3fSoA& outVectors) {
+
+	outVectors.Resize(end - begin);
+
+	TransformRange(vectors, matrix, Broadcast(matrix), begin, end, outVectors);
+}
+
+/// <summary>
+/// 最近接点(点と線分)のバッチ処理(SSE2)
+/// </summary>
+/// <param name="points"></param>
+/// <param name="segments"></param>
+/// <param name="outClosestPoints"></param>
+void ClosestPointBatchSSE2(const Vec3fSoA& points, const SegmentSoA& segments, Vec3fSoA& outClosestPoints) {
+
+	assert(points.Size() == segments.Size());
+
+	const size_t count = points.Size();
+	outClosestPoints.Resize(count);
+
+	const __m128 epsilon = _mm_setzero_ps();
+
+	size_t i = 0;
+	for (; i + 4 <= count; i += 4) {
+
+		Vec3x4 point = Load(points, i);
+		Vec3x4 origin = Load(segments.origin, i);
+		Vec3x4 diff = Load(segments.diff, i);
+
+		// 長さ0の線分は始点を返す
+		__m128 t = _mm_mul_ps(Dot(Sub(point, origin), diff), SafeReciprocal(Dot(diff, diff), epsilon));
+
+		Store(outClosestPoints, i, MulAdd(origin, diff, Clamp01(t)));
+	}
+
+	// 端数
+	for (; i < count; ++i) {
+
+		Vec3f origin = segments.origin.Get(i);
+		Vec3f diff = segments.diff.Get(i);
+		float lengthSq = Dot(diff, diff);
+		float t = lengthSq > 0.0f ? std::clamp(Dot(points.Get(i) - origin, diff) / lengthSq, 0.0f, 1.0f) : 0.0f;
+
+		outClosestPoints.Set(i, origin + diff * t);
+	}
+}
+
+/// <summary>
+/// 多項式近似のsinとcos
+/// π/2ごとに区切って[-π/4, π/4]に寄せ、その範囲の多項式で求める
+/// </summary>
+/// <param name="angle"></param>
+/// <param name="outSin"></param>
+/// <param name="outCos"></param>
+void SinCosPolynomial(float angle, float& outSin, float& outCos) {
+
+	using namespace SinCosConstants;
+
+	if (!std::isfinite(angle)) {
+		outSin = std::numeric_limits<float>::quiet_NaN();
+		outCos = outSin;
+		return;
+	}
+
+	// 最も近いπ/2の倍数
+	int32_t quadrant = static_cast<int32_t>(std::nearbyint(angle * kTwoOverPi));
+	float q = static_cast<float>(quadrant);
+
+	// π/2を3つに分けて引くことで誤差を抑える
+	float r = ((angle - q * kPiOverTwo1) - q * kPiOverTwo2) - q * kPiOverTwo3;
+	float z = r * r;
+
+	float s = r + r * z * (kSin1 + z * (kSin2 + z * kSin3));
+	float c = 1.0f - 0.5f * z + z * z * (kCos1 + z * (kCos2 + z * kCos3));
+
+	// 象限に合わせて入れ替えと符号反転
+	float sinValue = (quadrant & 1) ? c : s;
+	float cosValue = (quadrant & 1) ? s : c;
+	outSin = (quadrant & 2) ? -sinValue : sinValue;
+	outCos = ((quadrant + 1) & 2) ? -cosValue : cosValue;
+}
+
+/// <summary>
+/// sinとcosのバッチ処理(SSE2)
+/// </summary>
+/// <param name="angles"></param>
+/// <param name="outSin"></param>
+/// <param name="outCos"></param>
+void SinCosBatchSSE2(const std::vector<float>& angles, std::vector<float>& outSin, std::vector<float>& outCos) {
+
+	using namespace SinCosConstants;
+
+	const size_t count = angles.size();
+	outSin.resize(count);
+	outCos.resize(count);
+
+	const __m128i one = _mm_set1_epi32(1);
+	const __m128i two = _mm_set1_epi32(2);
+
+	size_t i = 0;
+	for (; i + 4 <= count; i += 4) {
+
+		__m128 angle = _mm_loadu_ps(&angles[i]);
+
+		__m128i quadrant = _mm_cvtps_epi32(_mm_mul_ps(angle, _mm_set1_ps(kTwoOverPi)));
+		__m128 q = _mm_cvtepi32_ps(quadrant);
+
+		__m128 r = _mm_sub_ps(angle, _mm_mul_ps(q, _mm_set1_ps(kPiOverTwo1)));
+		r = _mm_sub_ps(r, _mm_mul_ps(q, _mm_set1_ps(kPiOverTwo2)));
+		r = _mm_sub_ps(r, _mm_mul_ps(q, _mm_set1_ps(kPiOverTwo3)));
+		__m128 z = _mm_mul_ps(r, r);
+
+		__m128 s = _mm_add_ps(_mm_set1_ps(kSin2), _mm_mul_ps(z, _mm_set1_ps(kSin3)));
+		s = _mm_add_ps(_mm_set1_ps(kSin1), _mm_mul_ps(z, s));
+		s = _mm_add_ps(r, _mm_mul_ps(_mm_mul_ps(r, z), s));
+
+		__m128 c = _mm_add_ps(_mm_set1_ps(kCos2), _mm_mul_ps(z, _mm_set1_ps(kCos3)));
+		c = _mm_add_ps(_mm_set1_ps(kCos1), _mm_mul_ps(z, c));
+		c = _mm_add_ps(_mm_sub_ps(_mm_set1_ps(1.0f), _mm_mul_ps(_mm_set1_ps(0.5f), z)), _mm_mul_ps(_mm_mul_ps(z, z), c));
+
+		// 象限に合わせて入れ替えと符号反転(2のビットを符号ビットへ移す)
+		__m128 swap = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(quadrant, one), one));
+		__m128 sinSign = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(quadrant, two), 30));
+		__m128 cosSign = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(_mm_add_epi32(quadrant, one), two), 30));
+
+		_mm_storeu_ps(&outSin[i], _mm_xor_ps(Select(swap, c, s), sinSign));
+		_mm_storeu_ps(&outCos[i], _mm_xor_ps(Select(swap, s, c), cosSign));
+	}
+
+	// 端数
+	for (; i < count; ++i) {
+		SinCosPolynomial(angles[i], outSin[i], outCos[i]);
+	}
+}
+
+/// <summary>
+/// 2線分間の最近接点のバッチ処理
+/// </summary>
+/// <param name="segments1"></param>
+/// <param name="segments2"></param>
+/// <param name="outPoints1"></param>
+/// <param name="outPoints2"></param>
+void ClosestPointsBatch(const SegmentSoA& segments1, const SegmentSoA& segments2, Vec3fSoA& outPoints1, Vec3fSoA& outPoints2) {
+
+	assert(segments1.Size() == segments2.Size());
+
+	const size_t count = segments1.Size();
+	outPoints1.Resize(count);
+	outPoints2.Resize(count);
+
+	// スカラー版のClosestPointsと同じ分岐をマスクで表現する
+	const __m128 epsilon = _mm_set1_ps(1.0e-6f);
+	const __m128 parallelEpsilon = _mm_set1_ps(1.0e-10f);
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 one = _mm_set1_ps(1.0f);
+
+	size_t i = 0;
+	for (; i + 4 <= count; i += 4) {
+
+		Vec3x4 origin1 = Load(segments1.origin, i);
+		Vec3x4 diff1 = Load(segments1.diff, i);
+		Vec3x4 origin2 = Load(segments2.origin, i);
+		Vec3x4 diff2 = Load(segments2.diff, i);
+
+		Vec3x4 r = Sub(origin1, origin2);
+		__m128 a = Dot(diff1, diff1);
+		__m128 e = Dot(diff2, diff2);
+		__m128 f = Dot(diff2, r);
+		__m128 c = Dot(diff1, r);
+		__m128 b = Dot(diff1, diff2);
+
+		// スカラー版と同じく外積で分母と分子を求める
+		Vec3x4 normal = Cross(diff1, diff2);
+		__m128 denom = Dot(normal, normal);
+		__m128 numer = Dot(normal, Cross(diff2, r));
+
+		// 縮退した線分は逆数を0にしておく
+		__m128 invA = SafeReciprocal(a, epsilon);
+		__m128 invE = SafeReciprocal(e, epsilon);
+		__m128 degenerate1 = _mm_cmple_ps(a, epsilon);
+		__m128 degenerate2 = _mm_cmple_ps(e, epsilon);
+
+		// 線分1上の媒介変数、平行なら0
+		__m128 s = Select(
+			_mm_cmpgt_ps(denom, _mm_mul_ps(parallelEpsilon, _mm_mul_ps(a, e))),
+			Clamp01(_mm_div_ps(numer, denom)),
+			zero);
+		s = Select(degenerate2, Clamp01(_mm_mul_ps(_mm_sub_ps(zero, c), invA)), s);
+		s = _mm_andnot_ps(degenerate1, s);
+
+		// 線分2上の媒介変数
+		__m128 t = _mm_mul_ps(_mm_add_ps(_mm_mul_ps(b, s), f), invE);
+
+		// tが範囲外ならクランプしてsを求め直す
+		__m128 tLow = _mm_andnot_ps(degenerate1, _mm_cmplt_ps(t, zero));
+		__m128 tHigh = _mm_andnot_ps(degenerate1, _mm_cmpgt_ps(t, one));
+		s = Select(tLow, Clamp01(_mm_mul_ps(_mm_sub_ps(zero, c), invA)), s);
+		s = Select(tHigh, Clamp01(_mm_mul_ps(_mm_sub_ps(b, c), invA)), s);
+		t = Clamp01(t);
+
+		Store(outPoints1, i, MulAdd(origin1, diff1, s));
+		Store(outPoints2, i, MulAdd(origin2, diff2, t));
+	}
+
+	// 端数
+	for (; i < count; ++i) {
+
+		ClosestPointPair pair = ClosestPoints(segments1.Get(i), segments2.Get(i));
+		outPoints1.Set(i, pair.point1);
+		outPoints2.Set(i, pair.point2);
+	}
+}
+
+/// <summary>
+/// 半直線と球の交差判定のバッチ処理
+/// </summary>
+/// <param name="rays"></param>
+/// <param name="spheres"></param>
+/// <param name="outT"></param>
+void RaySphereIntersectionBatch(const RaySoA& rays, const SphereSoA& spheres, std::vector<float>& outT) {
+
+	IntersectSphereBatch(rays, spheres, std::numeric_limits<float>::infinity(), outT);
+}
+
+/// <summary>
+/// 線分と球の交差判定のバッチ処理
+/// </summary>
+/// <param name="segments"></param>
+/// <param name="spheres"></param>
+/// <param name="outT"></param>
+void SegmentSphereIntersectionBatch(const SegmentSoA& segments, const SphereSoA& spheres, std::vector<float>& outT) {
+
+	IntersectSphereBatch(segments, spheres, 1.0f, outT);
+}
+
+/// <summary>
+/// 点と球の距離のバッチ処理
+/// </summary>
+/// <param name="points"></param>
+/// <param name="spheres"></param>
+/// <param name="outDistances"></param>
+void DistancePointSphereBatch(const Vec3fSoA& points, const SphereSoA& spheres, std::vector<float>& outDistances) {
+
+	assert(points.Size() == spheres.Size());
+
+	const size_t count = points.Size();
+	outDistances.resize(count);
+
+	size_t i = 0;
+	for (; i + 4 <= count; i += 4) {
+
+		Vec3x4 d = Sub(Load(points, i), Load(spheres.center, i));
+		__m128 distance = _mm_sub_ps(_mm_sqrt_ps(Dot(d, d)), _mm_loadu_ps(&spheres.radius[i]));
+
+		_mm_storeu_ps(&outDistances[i], distance);
+	}
+
+	// 端数
+	for (; i < count; ++i) {
+		outDistances[i] = DistancePointSphere(points.Get(i), spheres.Get(i));
+	}
+}
+
+/// <summary>
+/// 線分とAABBの交差判定のバッチ処理
+/// 軸に平行な線分は、その軸のスラブの中にあれば区間を狭めない(0 x ∞でNaNにしない)
+/// </summary>
+/// <param name="segments"></param>
+/// <param name="aabbs"></param>
+/// <param name="outT"></param>
+void SegmentAABBIntersectionBatch(const SegmentSoA& segments, const AABBSoA& aabbs, std::vector<float>& outT) {
+
+	assert(segments.Size() == aabbs.Size());
+
+	const size_t count = segments.Size();
+	outT.resize(count);
+
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 one = _mm_set1_ps(1.0f);
+	const __m128 miss = _mm_set1_ps(-1.0f);
+	const __m128 infinity = _mm_set1_ps(std::numeric_limits<float>::infinity());
+
+	size_t i = 0;
+	for (; i + 4 <= count; i += 4) {
+
+		Vec3x4 origin = Load(segments.origin, i);
+		Vec3x4 diff = Load(segments.diff, i);
+		Vec3x4 boxMin = Load(aabbs.min, i);
+		Vec3x4 boxMax = Load(aabbs.max, i);
+
+		__m128 tNear = zero;
+		__m128 tFar = one;
+		__m128 isMiss = _mm_setzero_ps();
+
+		const __m128 origins[3] = { origin.x, origin.y, origin.z };
+		const __m128 diffs[3] = { diff.x, diff.y, diff.z };
+		const __m128 mins[3] = { boxMin.x, boxMin.y, boxMin.z };
+		const __m128 maxs[3] = { boxMax.x, boxMax.y, boxMax.z };
+
+		for (int axis = 0; axis < 3; ++axis) {
+
+			__m128 isParallel = _mm_cmpeq_ps(diffs[axis], zero);
+			__m128 isOutside = _mm_or_ps(_mm_cmplt_ps(origins[axis], mins[axis]), _mm_cmpgt_ps(origins[axis], maxs[axis]));
+			isMiss = _mm_or_ps(isMiss, _mm_and_ps(isParallel, isOutside));
+
+			__m128 invDiff = _mm_div_ps(one, diffs[axis]);
+			__m128 t1 = _mm_mul_ps(_mm_sub_ps(mins[axis], origins[axis]), invDiff);
+			__m128 t2 = _mm_mul_ps(_mm_sub_ps(maxs[axis], origins[axis]), invDiff);
+
+			tNear = _mm_max_ps(tNear, Select(isParallel, _mm_sub_ps(zero, infinity), _mm_min_ps(t1, t2)));
+			tFar = _mm_min_ps(tFar, Select(isParallel, infinity, _mm_max_ps(t1, t2)));
+		}
+
+		isMiss = _mm_or_ps(isMiss, _mm_cmpgt_ps(tNear, tFar));
+		_mm_storeu_ps(&outT[i], Select(isMiss, miss, tNear));
+	}
+
+	// 端数
+	for (; i < count; ++i) {
+		float t = 0.0f;
+		outT[i] = SegmentAABBIntersection(segments.Get(i), aabbs.Get(i), t) ? t : -1.0f;
+	}
+}
+
+/// <summary>
+/// AABB同士の交差判定のバッチ処理
+/// </summary>
+/// <param name="aabbs1"></param>
+/// <param name="aabbs2"></param>
+/// <param name="outHits"></param>
+void AABBIntersectionBatch(const AABBSoA& aabbs1, const AABBSoA& aabbs2, std::vector<uint8_t>& outHits) {
+
+	assert(aabbs1.Size() == aabbs2.Size());
+
+	const size_t count = aabbs1.Size();
+	outHits.resize(count);
+
+	size_t i = 0;
+	for (; i + 4 <= count; i += 4) {
+
+		Vec3x4 min1 = Load(aabbs1.min, i);
+		Vec3x4 max1 = Load(aabbs1.max, i);
+		Vec3x4 min2 = Load(aabbs2.min, i);
+		Vec3x4 max2 = Load(aabbs2.max, i);
+
+		__m128 hit = _mm_and_ps(_mm_cmple_ps(min1.x, max2.x), _mm_cmpge_ps(max1.x, min2.x));
+		hit = _mm_and_ps(hit, _mm_and_ps(_mm_cmple_ps(min1.y, max2.y), _mm_cmpge_ps(max1.y, min2.y)));
+		hit = _mm_and_ps(hit, _mm_and_ps(_mm_cmple_ps(min1.z, max2.z), _mm_cmpge_ps(max1.z, min2.z)));
+
+		StoreHits(outHits, i, hit);
+	}
+
+	// 端数
+	for (; i < count; ++i) {
+		outHits[i] = AABBIntersection(aabbs1.Get(i), aabbs2.Get(i)) ? 1 : 0;
+	}
+}
+
+/// <summary>
+/// 球とAABBの交差判定のバッチ処理
+/// </summary>
+/// <param name="spheres"></param>
+/// <param name="aabbs"></param>
+/// <param name="outHits"></param>
+void SphereAABBIntersectionBatch(const SphereSoA& spheres, const AABBSoA& aabbs, std::vector<uint8_t>& outHits) {
+
+	assert(spheres.Size() == aabbs.Size());
+
+	const size_t count = spheres.Size();
+	outHits.resize(count);
+
+	size_t i = 0;
+	for (; i + 4 <= count; i += 4) {
+
+		Vec3x4 center = Load(spheres.center, i);
+		Vec3x4 boxMin = Load(aabbs.min, i);
+		Vec3x4 boxMax = Load(aabbs.max, i);
+		__m128 radius = _mm_loadu_ps(&spheres.radius[i]);
+
+		// 箱の中で中心に一番近い点
+		Vec3x4 closest = {
+			_mm_min_ps(_mm_max_ps(center.x, boxMin.x), boxMax.x),
+			_mm_min_ps(_mm_max_ps(center.y, boxMin.y), boxMax.y),
+			_mm_min_ps(_mm_max_ps(center.z, boxMin.z), boxMax.z) };
+
+		Vec3x4 toCenter = Sub(center, closest);
+		StoreHits(outHits, i, _mm_cmple_ps(Dot(toCenter, toCenter), _mm_mul_ps(radius, radius)));
+	}
+
+	// 端数
+	for (; i < count; ++i) {
+		outHits[i] = SphereAABBIntersection(spheres.Get(i), aabbs.Get(i)) ? 1 : 0;
+	}
+}
+
+/// <summary>
+/// OBB同士の交差判定のバッチ処理
+/// OBBIntersectionと同じ15軸を4組ずつ調べ、軸の種類(OBB1の軸、OBB2の軸、外積)ごとに全ての組が分離していれば次の4組へ進む
+/// </summary>
+/// <param name="obbs1"></param>
+/// <param name="obbs2"></param>
+/// <param name="outHits"></param>
+void OBBIntersectionBatch(const OBBSoA& obbs1, const OBBSoA& obbs2, std::vector<uint8_t>& outHits) {
+
+	assert(obbs1.Size() == obbs2.Size());
+
+	const size_t count = obbs1.Size();
+	outHits.resize(count);
+
+	const __m128 epsilon = _mm_set1_ps(1.0e-6f);
+	const int kAllSeparated = 0xf;
+
+	size_t i = 0;
+	for (; i + 4 <= count; i += 4) {
+
+		Vec3x4 axes1[3] = { Load(obbs1.orientations[0], i), Load(obbs1.orientations[1], i), Load(obbs1.orientations[2], i) };
+		Vec3x4 axes2[3] = { Load(obbs2.orientations[0], i), Load(obbs2.orientations[1], i), Load(obbs2.orientations[2], i) };
+		Vec3x4 size1 = Load(obbs1.size, i);
+		Vec3x4 size2 = Load(obbs2.size, i);
+		const __m128 a[3] = { size1.x, size1.y, size1.z };
+		const __m128 b[3] = { size2.x, size2.y, size2.z };
+
+		// OBB2の軸をOBB1の座標系で表した回転行列とその絶対値
+		__m128 r[3][3];
+		__m128 absR[3][3];
+		for (int row = 0; row < 3; ++row) {
+			for (int column = 0; column < 3; ++column) {
+				r[row][column] = Dot(axes1[row], axes2[column]);
+				absR[row][column] = _mm_add_ps(Abs(r[row][column]), epsilon);
+			}
+		}
+
+		Vec3x4 distance = Sub(Load(obbs2.center, i), Load(obbs1.center, i));
+		const __m128 t[3] = { Dot(distance, axes1[0]), Dot(distance, axes1[1]), Dot(distance, axes1[2]) };
+
+		// OBB1の軸
+		__m128 isSeparated = _mm_setzero_ps();
+		for (int row = 0; row < 3; ++row) {
+			__m128 radius2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(b[0], absR[row][0]), _mm_mul_ps(b[1], absR[row][1])), _mm_mul_ps(b[2], absR[row][2]));
+			isSeparated = _mm_or_ps(isSeparated, _mm_cmpgt_ps(Abs(t[row]), _mm_add_ps(a[row], radius2)));
+		}
+		if (_mm_movemask_ps(isSeparated) == kAllSeparated) {
+			StoreHits(outHits, i, _mm_setzero_ps());
+			continue;
+		}
+
+		// OBB2の軸
+		for (int column = 0; column < 3; ++column) {
+			__m128 radius1 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(a[0], absR[0][column]), _mm_mul_ps(a[1], absR[1][column])), _mm_mul_ps(a[2], absR[2][column]));
+			__m128 projection = _mm_add_ps(_mm_add_ps(_mm_mul_ps(t[0], r[0][column]), _mm_mul_ps(t[1], r[1][column])), _mm_mul_ps(t[2], r[2][column]));
+			isSeparated = _mm_or_ps(isSeparated, _mm_cmpgt_ps(Abs(projection), _mm_add_ps(radius1, b[column])));
+		}
+		if (_mm_movemask_ps(isSeparated) == kAllSeparated) {
+			StoreHits(outHits, i, _mm_setzero_ps());
+			continue;
+		}
+
+		// OBB1の軸とOBB2の軸の外積
+		for (int row = 0; row < 3; ++row) {
+
+			int row1 = (row + 1) % 3;
+			int row2 = (row + 2) % 3;
+
+			for (int column = 0; column < 3; ++column) {
+
+				int column1 = (column + 1) % 3;
+				int column2 = (column + 2) % 3;
+
+				__m128 radius1 = _mm_add_ps(_mm_mul_ps(a[row1], absR[row2][column]), _mm_mul_ps(a[row2], absR[row1][column]));
+				__m128 radius2 = _mm_add_ps(_mm_mul_ps(b[column1], absR[row][column2]), _mm_mul_ps(b[column2], absR[row][column1]));
+				__m128 projection = _mm_sub_ps(_mm_mul_ps(t[row2], r[row1][column]), _mm_mul_ps(t[row1], r[row2][column]));
+				isSeparated = _mm_or_ps(isSeparated, _mm_cmpgt_ps(Abs(projection), _mm_add_ps(radius1, radius2)));
+			}
+		}
+
+		// 分離軸が見つからなかった組が交差している
+		StoreHits(outHits, i, _mm_andnot_ps(isSeparated, _mm_cmpeq_ps(epsilon, epsilon)));
+	}
+
+	// 端数
+	for (; i < count; ++i) {
+		outHits[i] = OBBIntersection(obbs1.Get(i), obbs2.Get(i)) ? 1 : 0;
+	}
+}
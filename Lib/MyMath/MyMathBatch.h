@@ -0,0 +1,248 @@
+﻿#pragma once
+#include <vector>
+#include "MyMath.h"
+
+/// <summary>
+/// 三次元ベクトルの配列(SoA)
+/// </summary>
+struct Vec3fSoA {
+
+	std::vector<float> x;
+	std::vector<float> y;
+	std::vector<float> z;
+
+	void Resize(size_t size) {
+		x.resize(size);
+		y.resize(size);
+		z.resize(size);
+	}
+
+	size_t Size() const { return x.size(); }
+
+	void Set(size_t index, const Vec3f& v) {
+		x[index] = v.x;
+		y[index] = v.y;
+		z[index] = v.z;
+	}
+
+	Vec3f Get(size_t index) const { return { x[index], y[index], z[index] }; }
+};
+
+/// <summary>
+/// 線分の配列(SoA)
+/// </summary>
+struct SegmentSoA {
+
+	Vec3fSoA origin; // 始点
+	Vec3fSoA diff;   // 終点への差分ベクトル
+
+	void Resize(size_t size) {
+		origin.Resize(size);
+		diff.Resize(size);
+	}
+
+	size_t Size() const { return origin.Size(); }
+
+	void Set(size_t index, const Segement& segment) {
+		origin.Set(index, segment.origin);
+		diff.Set(index, segment.diff);
+	}
+
+	Segement Get(size_t index) const { return { origin.Get(index), diff.Get(index) }; }
+};
+
+// 半直線も始点と方向ベクトルで同じ並びになる
+using RaySoA = SegmentSoA;
+
+/// <summary>
+/// 球の配列(SoA)
+/// </summary>
+struct SphereSoA {
+
+	Vec3fSoA center;           // 中心
+	std::vector<float> radius; // 半径
+
+	void Resize(size_t size) {
+		center.Resize(size);
+		radius.resize(size);
+	}
+
+	size_t Size() const { return radius.size(); }
+
+	void Set(size_t index, const SphereShape& sphere) {
+		center.Set(index, sphere.center);
+		radius[index] = sphere.radius;
+	}
+
+	SphereShape Get(size_t index) const { return { center.Get(index), radius[index] }; }
+};
+
+/// <summary>
+/// 軸平行境界箱の配列(SoA)
+/// </summary>
+struct AABBSoA {
+
+	Vec3fSoA min; // 最小点
+	Vec3fSoA max; // 最大点
+
+	void Resize(size_t size) {
+		min.Resize(size);
+		max.Resize(size);
+	}
+
+	size_t Size() const { return min.Size(); }
+
+	void Set(size_t index, const AABB& aabb) {
+		min.Set(index, aabb.min);
+		max.Set(index, aabb.max);
+	}
+
+	AABB Get(size_t index) const { return { min.Get(index), max.Get(index) }; }
+};
+
+/// <summary>
+/// 有向境界箱の配列(SoA)
+/// </summary>
+struct OBBSoA {
+
+	Vec3fSoA center;          // 中心
+	Vec3fSoA orientations[3]; // 座標軸
+	Vec3fSoA size;            // 座標軸方向の長さの半分
+
+	void Resize(size_t count) {
+		center.Resize(count);
+		for (Vec3fSoA& orientation : orientations) {
+			orientation.Resize(count);
+		}
+		size.Resize(count);
+	}
+
+	size_t Size() const { return center.Size(); }
+
+	void Set(size_t index, const OBB& obb) {
+		center.Set(index, obb.center);
+		for (int i = 0; i < 3; ++i) {
+			orientations[i].Set(index, obb.orientations[i]);
+		}
+		size.Set(index, obb.size);
+	}
+
+	OBB Get(size_t index) const {
+		return { center.Get(index), { orientations[0].Get(index), orientations[1].Get(index), orientations[2].Get(index) }, size.Get(index) };
+	}
+};
+
+/*
+* 以下のバッチ関数は入力配列のi番目同士を計算し、出力のi番目に書き込む
+* 出力は関数内で入力と同じ要素数にリサイズされる
+*/
+
+/// <summary>
+/// 4x4行列の座標変換のバッチ処理
+/// </summary>
+/// <param name="vectors"></param>
+/// <param name="matrix"></param>
+/// <param name="outVectors"></param>
+void TransformBatch(const Vec3fSoA& vectors, const Matrix4x4& matrix, Vec3fSoA& outVectors);
+
+/// <summary>
+/// 頂点の一部([begin, end))の座標変換のバッチ処理
+/// i番目の結果をoutVectorsのi - begin番目に書き込み、outVectorsはend - beginにリサイズされる
+/// 同じ頂点を複数の行列で変換する時に、L1に収まる塊ずつ変換して使い切るために使う
+/// </summary>
+/// <param name="vectors"></param>
+/// <param name="begin"></param>
+/// <param name="end"></param>
+/// <param name="matrix"></param>
+/// <param name="outVectors"></param>
+void TransformBatchRange(const Vec3fSoA& vectors, size_t begin, size_t end, const Matrix4x4& matrix, Vec3fSoA& outVectors);
+
+/// <summary>
+/// 最近接点(点と線分)のバッチ処理
+/// </summary>
+/// <param name="points"></param>
+/// <param name="segments"></param>
+/// <param name="outClosestPoints"></param>
+void ClosestPointBatch(const Vec3fSoA& points, const SegmentSoA& segments, Vec3fSoA& outClosestPoints);
+
+/// <summary>
+/// sinとcosのバッチ処理
+/// </summary>
+/// <param name="angles">ラジアン、|angle| < 1e5 程度まで</param>
+/// <param name="outSin"></param>
+/// <param name="outCos"></param>
+void SinCosBatch(const std::vector<float>& angles, std::vector<float>& outSin, std::vector<float>& outCos);
+
+/// <summary>
+/// アフィン変換行列のバッチ処理(多数の物体のワールド行列をまとめて作る)
+/// </summary>
+/// <param name="scales"></param>
+/// <param name="rotates"></param>
+/// <param name="translates"></param>
+/// <param name="outMatrices"></param>
+void MakeAffineMatrixBatch(const Vec3fSoA& scales, const Vec3fSoA& rotates, const Vec3fSoA& translates, std::vector<Matrix4x4>& outMatrices);
+
+/// <summary>
+/// 2線分間の最近接点のバッチ処理
+/// </summary>
+/// <param name="segments1"></param>
+/// <param name="segments2"></param>
+/// <param name="outPoints1"></param>
+/// <param name="outPoints2"></param>
+void ClosestPointsBatch(const SegmentSoA& segments1, const SegmentSoA& segments2, Vec3fSoA& outPoints1, Vec3fSoA& outPoints2);
+
+/// <summary>
+/// 半直線と球の交差判定のバッチ処理
+/// </summary>
+/// <param name="rays"></param>
+/// <param name="spheres"></param>
+/// <param name="outT">交点の媒介変数、交差しなければ負の値</param>
+void RaySphereIntersectionBatch(const RaySoA& rays, const SphereSoA& spheres, std::vector<float>& outT);
+
+/// <summary>
+/// 線分と球の交差判定のバッチ処理
+/// </summary>
+/// <param name="segments"></param>
+/// <param name="spheres"></param>
+/// <param name="outT">交点の媒介変数、交差しなければ負の値</param>
+void SegmentSphereIntersectionBatch(const SegmentSoA& segments, const SphereSoA& spheres, std::vector<float>& outT);
+
+/// <summary>
+/// 点と球の距離のバッチ処理
+/// </summary>
+/// <param name="points"></param>
+/// <param name="spheres"></param>
+/// <param name="outDistances"></param>
+void DistancePointSphereBatch(const Vec3fSoA& points, const SphereSoA& spheres, std::vector<float>& outDistances);
+
+/// <summary>
+/// 線分とAABBの交差判定のバッチ処理
+/// </summary>
+/// <param name="segments"></param>
+/// <param name="aabbs"></param>
+/// <param name="outT">箱に入る位置の媒介変数、交差しなければ負の値</param>
+void SegmentAABBIntersectionBatch(const SegmentSoA& segments, const AABBSoA& aabbs, std::vector<float>& outT);
+
+/// <summary>
+/// AABB同士の交差判定のバッチ処理
+/// </summary>
+/// <param name="aabbs1"></param>
+/// <param name="aabbs2"></param>
+/// <param name="outHits">交差すれば1</param>
+void AABBIntersectionBatch(const AABBSoA& aabbs1, const AABBSoA& aabbs2, std::vector<uint8_t>& outHits);
+
+/// <summary>
+/// 球とAABBの交差判定のバッチ処理
+/// </summary>
+/// <param name="spheres"></param>
+/// <param name="aabbs"></param>
+/// <param name="outHits">交差すれば1</param>
+void SphereAABBIntersectionBatch(const SphereSoA& spheres, const AABBSoA& aabbs, std::vector<uint8_t>& outHits);
+
+/// <summary>
+/// OBB同士の交差判定のバッチ処理
+/// </summary>
+/// <param name="obbs1"></param>
+/// <param name="obbs2"></param>
+/// <param name="outHits">交差すれば1</param>
+void OBBIntersectionBatch(const OBBSoA& obbs1, const OBBSoA& obbs2, std::vector<uint8_t>& outHits);
@@ -0,0 +1,72 @@
+﻿#pragma once
+#include <immintrin.h>
+#include "MyMathBatch.h"
+
+/*
+* SSE2で4要素ずつ計算するための小さな関数
+* バッチ処理や折れ線の最近接点など、SoAの配列を4要素ずつ読む処理で共有する
+*/
+namespace MathSSE {
+
+	/// <summary>
+	/// 4要素分の三次元ベクトル
+	/// </summary>
+	struct Vec3x4 {
+
+		__m128 x;
+		__m128 y;
+		__m128 z;
+	};
+
+	inline Vec3x4 Load(const Vec3fSoA& v, size_t index) {
+		return { _mm_loadu_ps(&v.x[index]), _mm_loadu_ps(&v.y[index]), _mm_loadu_ps(&v.z[index]) };
+	}
+
+	inline void Store(Vec3fSoA& v, size_t index, const Vec3x4& value) {
+		_mm_storeu_ps(&v.x[index], value.x);
+		_mm_storeu_ps(&v.y[index], value.y);
+		_mm_storeu_ps(&v.z[index], value.z);
+	}
+
+	inline Vec3x4 Sub(const Vec3x4& v1, const Vec3x4& v2) {
+		return { _mm_sub_ps(v1.x, v2.x), _mm_sub_ps(v1.y, v2.y), _mm_sub_ps(v1.z, v2.z) };
+	}
+
+	// v1 + v2 * s
+	inline Vec3x4 MulAdd(const Vec3x4& v1, const Vec3x4& v2, __m128 s) {
+		return {
+			_mm_add_ps(v1.x, _mm_mul_ps(v2.x, s)),
+			_mm_add_ps(v1.y, _mm_mul_ps(v2.y, s)),
+			_mm_add_ps(v1.z, _mm_mul_ps(v2.z, s)) };
+	}
+
+	inline Vec3x4 Cross(const Vec3x4& v1, const Vec3x4& v2) {
+		return {
+			_mm_sub_ps(_mm_mul_ps(v1.y, v2.z), _mm_mul_ps(v1.z, v2.y)),
+			_mm_sub_ps(_mm_mul_ps(v1.z, v2.x), _mm_mul_ps(v1.x, v2.z)),
+			_mm_sub_ps(_mm_mul_ps(v1.x, v2.y), _mm_mul_ps(v1.y, v2.x)) };
+	}
+
+	inline __m128 Dot(const Vec3x4& v1, const Vec3x4& v2) {
+		return _mm_add_ps(_mm_add_ps(_mm_mul_ps(v1.x, v2.x), _mm_mul_ps(v1.y, v2.y)), _mm_mul_ps(v1.z, v2.z));
+	}
+
+	inline __m128 Clamp01(__m128 v) {
+		return _mm_min_ps(_mm_max_ps(v, _mm_setzero_ps()), _mm_set1_ps(1.0f));
+	}
+
+	// maskが立っている要素はa、それ以外はb (SSE2の範囲で書く)
+	inline __m128 Select(__m128 mask, __m128 a, __m128 b) {
+		return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+	}
+
+	// 絶対値(符号ビットを落とす)
+	inline __m128 Abs(__m128 v) {
+		return _mm_andnot_ps(_mm_set1_ps(-0.0f), v);
+	}
+
+	// 0の要素は0を返す逆数
+	inline __m128 SafeReciprocal(__m128 v, __m128 epsilon) {
+		return _mm_and_ps(_mm_cmpgt_ps(v, epsilon), _mm_div_ps(_mm_set1_ps(1.0f), v));
+	}
+}
@@ -0,0 +1,480 @@
+﻿#pragma once
+#include <cmath>
+#include <type_traits>
+#include "Vector.h"
+
+/// <summary>
+/// 任意精度の4x4行列
+/// </summary>
+template<typename T>
+struct Matrix4x4T {
+
+	T m[4][4];
+};
+
+using Matrix4x4d = Matrix4x4T<double>;
+
+// 行列の要素の型
+template<typename Matrix>
+using MatrixScalar = std::remove_cvref_t<decltype(std::declval<Matrix>().m[0][0])>;
+
+/*
+* 精度に依存しない数学関数の本体
+* float版(MyMath.h)はこれをMatrix4x4で実体化したものを呼ぶだけなので、float経路に余計なコストは掛からない
+*/
+namespace MathT {
+
+	/// <summary>
+	/// 内積
+	/// </summary>
+	template<typename T>
+	T Dot(const Vec3<T>& v1, const Vec3<T>& v2) {
+
+		return v1.x * v2.x + v1.y * v2.y + v1.z * v2.z;
+	}
+
+	/// <summary>
+	/// 長さ、ノルム
+	/// </summary>
+	template<typename T>
+	T Length(const Vec3<T>& v) {
+
+		return std::sqrt(v.x * v.x + v.y * v.y + v.z * v.z);
+	}
+
+	/// <summary>
+	/// 正規化
+	/// </summary>
+	template<typename T>
+	Vec3<T> Normalize(const Vec3<T>& v) {
+
+		T length = Length(v);
+		if (length != 0) {
+			return Vec3<T>(v.x / length, v.y / length, v.z / length);
+		}
+		else {
+
+			// 値が入ってなければnullで返す
+			return Vec3<T>(T(0), T(0), T(0));
+		}
+	}
+
+	/// <summary>
+	/// クロス積
+	/// </summary>
+	template<typename T>
+	Vec3<T> Cross(const Vec3<T>& v1, const Vec3<T>& v2) {
+
+		return Vec3<T>(
+			v1.y * v2.z - v1.z * v2.y,
+			v1.z * v2.x - v1.x * v2.z,
+			v1.x * v2.y - v1.y * v2.x
+		);
+	}
+
+	/// <summary>
+	/// 4x4行列の加算
+	/// </summary>
+	template<typename Matrix>
+	Matrix Add(const Matrix& m1, const Matrix& m2) {
+
+		Matrix matrix;
+		for (int i = 0; i < 4; i++) {
+			for (int j = 0; j < 4; j++) {
+				matrix.m[i][j] = m1.m[i][j] + m2.m[i][j];
+			}
+		}
+		return matrix;
+	}
+
+	/// <summary>
+	/// 4x4行列の減算
+	/// </summary>
+	template<typename Matrix>
+	Matrix Subtract(const Matrix& m1, const Matrix& m2) {
+
+		Matrix matrix;
+		for (int i = 0; i < 4; i++) {
+			for (int j = 0; j < 4; j++) {
+				matrix.m[i][j] = m1.m[i][j] - m2.m[i][j];
+			}
+		}
+		return matrix;
+	}
+
+	/// <summary>
+	/// 4x4行列の積
+	/// </summary>
+	template<typename Matrix>
+	Matrix Multiply(const Matrix& m1, const Matrix& m2) {
+
+		Matrix matrix;
+		for (int i = 0; i < 4; i++) {
+			for (int j = 0; j < 4; j++) {
+				matrix.m[i][j] = 0;
+				for (int k = 0; k < 4; ++k) {
+					matrix.m[i][j] += m1.m[i][k] * m2.m[k][j];
+				}
+			}
+		}
+		return matrix;
+	}
+
+	/// <summary>
+	/// 4x4行列の逆行列
+	/// </summary>
+	template<typename Matrix>
+	Matrix Inverse(const Matrix& m) {
+
+		using T = MatrixScalar<Matrix>;
+
+		Matrix matrix = {};
+
+		T det =
+			m.m[0][0] * (m.m[1][1] * m.m[2][2] * m.m[3][3] + m.m[1][2] * m.m[2][3] * m.m[3][1] +
+				m.m[1][3] * m.m[2][1] * m.m[3][2] - m.m[1][1] * m.m[2][3] * m.m[3][2] -
+				m.m[1][2] * m.m[2][1] * m.m[3][3] - m.m[1][3] * m.m[2][2] * m.m[3][1]) -
+			m.m[0][1] * (m.m[1][0] * m.m[2][2] * m.m[3][3] + m.m[1][2] * m.m[2][3] * m.m[3][0] +
+				m.m[1][3] * m.m[2][0] * m.m[3][2] - m.m[1][0] * m.m[2][3] * m.m[3][2] -
+				m.m[1][2] * m.m[2][0] * m.m[3][3] - m.m[1][3] * m.m[2][2] * m.m[3][0]) +
+			m.m[0][2] * (m.m[1][0] * m.m[2][1] * m.m[3][3] + m.m[1][1] * m.m[2][3] * m.m[3][0] +
+				m.m[1][3] * m.m[2][0] * m.m[3][1] - m.m[1][0] * m.m[2][3] * m.m[3][1] -
+				m.m[1][1] * m.m[2][0] * m.m[3][3] - m.m[1][3] * m.m[2][1] * m.m[3][0]) -
+			m.m[0][3] * (m.m[1][0] * m.m[2][1] * m.m[3][2] + m.m[1][1] * m.m[2][2] * m.m[3][0] +
+				m.m[1][2] * m.m[2][0] * m.m[3][1] - m.m[1][0] * m.m[2][2] * m.m[3][1] -
+				m.m[1][1] * m.m[2][0] * m.m[3][2] - m.m[1][2] * m.m[2][1] * m.m[3][0]);
+
+		T invDet = T(1) / det;
+
+		matrix.m[0][0] = (m.m[1][1] * m.m[2][2] * m.m[3][3] + m.m[1][2] * m.m[2][3] * m.m[3][1] +
+			m.m[1][3] * m.m[2][1] * m.m[3][2] - m.m[1][1] * m.m[2][3] * m.m[3][2] -
+			m.m[1][2] * m.m[2][1] * m.m[3][3] - m.m[1][3] * m.m[2][2] * m.m[3][1]) *
+			invDet;
+		matrix.m[0][1] = (m.m[0][1] * m.m[2][3] * m.m[3][2] + m.m[0][2] * m.m[2][1] * m.m[3][3] +
+			m.m[0][3] * m.m[2][2] * m.m[3][1] - m.m[0][1] * m.m[2][2] * m.m[3][3] -
+			m.m[0][2] * m.m[2][3] * m.m[3][1] - m.m[0][3] * m.m[2][1] * m.m[3][2]) *
+			invDet;
+		matrix.m[0][2] = (m.m[0][1] * m.m[1][2] * m.m[3][3] + m.m[0][2] * m.m[1][3] * m.m[3][1] +
+			m.m[0][3] * m.m[1][1] * m.m[3][2] - m.m[0][1] * m.m[1][3] * m.m[3][2] -
+			m.m[0][2] * m.m[1][1] * m.m[3][3] - m.m[0][3] * m.m[1][2] * m.m[3][1]) *
+			invDet;
+		matrix.m[0][3] = (m.m[0][1] * m.m[1][3] * m.m[2][2] + m.m[0][2] * m.m[1][1] * m.m[2][3] +
+			m.m[0][3] * m.m[1][2] * m.m[2][1] - m.m[0][1] * m.m[1][2] * m.m[2][3] -
+			m.m[0][2] * m.m[1][3] * m.m[2][1] - m.m[0][3] * m.m[1][1] * m.m[2][2]) *
+			invDet;
+
+		matrix.m[1][0] = (m.m[1][0] * m.m[2][3] * m.m[3][2] + m.m[1][2] * m.m[2][0] * m.m[3][3] +
+			m.m[1][3] * m.m[2][2] * m.m[3][0] - m.m[1][0] * m.m[2][2] * m.m[3][3] -
+			m.m[1][2] * m.m[2][3] * m.m[3][0] - m.m[1][3] * m.m[2][0] * m.m[3][2]) *
+			invDet;
+		matrix.m[1][1] = (m.m[0][0] * m.m[2][2] * m.m[3][3] + m.m[0][2] * m.m[2][3] * m.m[3][0] +
+			m.m[0][3] * m.m[2][0] * m.m[3][2] - m.m[0][0] * m.m[2][3] * m.m[3][2] -
+			m.m[0][2] * m.m[2][0] * m.m[3][3] - m.m[0][3] * m.m[2][2] * m.m[3][0]) *
+			invDet;
+		matrix.m[1][2] = (m.m[0][0] * m.m[1][3] * m.m[3][2] + m.m[0][2] * m.m[1][0] * m.m[3][3] +
+			m.m[0][3] * m.m[1][2] * m.m[3][0] - m.m[0][0] * m.m[1][2] * m.m[3][3] -
+			m.m[0][2] * m.m[1][3] * m.m[3][0] - m.m[0][3] * m.m[1][0] * m.m[3][2]) *
+			invDet;
+		matrix.m[1][3] = (m.m[0][0] * m.m[1][2] * m.m[2][3] + m.m[0][2] * m.m[1][3] * m.m[2][0] +
+			m.m[0][3] * m.m[1][0] * m.m[2][2] - m.m[0][0] * m.m[1][3] * m.m[2][2] -
+			m.m[0][2] * m.m[1][0] * m.m[2][3] - m.m[0][3] * m.m[1][2] * m.m[2][0]) *
+			invDet;
+
+		matrix.m[2][0] = (m.m[1][0] * m.m[2][1] * m.m[3][3] + m.m[1][1] * m.m[2][3] * m.m[3][0] +
+			m.m[1][3] * m.m[2][0] * m.m[3][1] - m.m[1][0] * m.m[2][3] * m.m[3][1] -
+			m.m[1][1] * m.m[2][0] * m.m[3][3] - m.m[1][3] * m.m[2][1] * m.m[3][0]) *
+			invDet;
+		matrix.m[2][1] = (m.m[0][0] * m.m[2][3] * m.m[3][1] + m.m[0][1] * m.m[2][0] * m.m[3][3] +
+			m.m[0][3] * m.m[2][1] * m.m[3][0] - m.m[0][0] * m.m[2][1] * m.m[3][3] -
+			m.m[0][1] * m.m[2][3] * m.m[3][0] - m.m[0][3] * m.m[2][0] * m.m[3][1]) *
+			invDet;
+		matrix.m[2][2] = (m.m[0][0] * m.m[1][1] * m.m[3][3] + m.m[0][1] * m.m[1][3] * m.m[3][0] +
+			m.m[0][3] * m.m[1][0] * m.m[3][1] - m.m[0][0] * m.m[1][3] * m.m[3][1] -
+			m.m[0][1] * m.m[1][0] * m.m[3][3] - m.m[0][3] * m.m[1][1] * m.m[3][0]) *
+			invDet;
+		matrix.m[2][3] = (m.m[0][0] * m.m[1][3] * m.m[2][1] + m.m[0][1] * m.m[1][0] * m.m[2][3] +
+			m.m[0][3] * m.m[1][1] * m.m[2][0] - m.m[0][0] * m.m[1][1] * m.m[2][3] -
+			m.m[0][1] * m.m[1][3] * m.m[2][0] - m.m[0][3] * m.m[1][0] * m.m[2][1]) *
+			invDet;
+
+		matrix.m[3][0] = (m.m[1][0] * m.m[2][2] * m.m[3][1] + m.m[1][1] * m.m[2][0] * m.m[3][2] +
+			m.m[1][2] * m.m[2][1] * m.m[3][0] - m.m[1][0] * m.m[2][1] * m.m[3][2] -
+			m.m[1][1] * m.m[2][2] * m.m[3][0] - m.m[1][2] * m.m[2][0] * m.m[3][1]) *
+			invDet;
+		matrix.m[3][1] = (m.m[0][0] * m.m[2][1] * m.m[3][2] + m.m[0][1] * m.m[2][2] * m.m[3][0] +
+			m.m[0][2] * m.m[2][0] * m.m[3][1] - m.m[0][0] * m.m[2][2] * m.m[3][1] -
+			m.m[0][1] * m.m[2][0] * m.m[3][2] - m.m[0][2] * m.m[2][1] * m.m[3][0]) *
+			invDet;
+		matrix.m[3][2] = (m.m[0][0] * m.m[1][2] * m.m[3][1] + m.m[0][1] * m.m[1][0] * m.m[3][2] +
+			m.m[0][2] * m.m[1][1] * m.m[3][0] - m.m[0][0] * m.m[1][1] * m.m[3][2] -
+			m.m[0][1] * m.m[1][2] * m.m[3][0] - m.m[0][2] * m.m[1][0] * m.m[3][1]) *
+			invDet;
+		matrix.m[3][3] = (m.m[0][0] * m.m[1][1] * m.m[2][2] + m.m[0][1] * m.m[1][2] * m.m[2][0] +
+			m.m[0][2] * m.m[1][0] * m.m[2][1] - m.m[0][0] * m.m[1][2] * m.m[2][1] -
+			m.m[0][1] * m.m[1][0] * m.m[2][2] - m.m[0][2] * m.m[1][1] * m.m[2][0]) *
+			invDet;
+
+		if (det == 0) {
+
+			return matrix;
+		}
+
+		return matrix;
+	}
+
+	/// <summary>
+	/// 4x4行列の転置行列
+	/// </summary>
+	template<typename Matrix>
+	Matrix Transpose(const Matrix& m) {
+
+		Matrix matrix;
+		for (int i = 0; i < 4; i++) {
+			for (int j = 0; j < 4; j++) {
+				matrix.m[i][j] = m.m[j][i];
+			}
+		}
+
+		return matrix;
+	}
+
+	/// <summary>
+	/// 4x4行列の単位行列
+	/// </summary>
+	template<typename Matrix>
+	Matrix MakeIdentity4x4() {
+
+		using T = MatrixScalar<Matrix>;
+
+		Matrix matrix;
+		for (int i = 0; i < 4; i++) {
+			for (int j = 0; j < 4; j++) {
+				matrix.m[i][j] = (i == j) ? T(1) : T(0);
+			}
+		}
+
+		return matrix;
+	}
+
+	/// <summary>
+	/// 4x4行列の拡縮行列
+	/// </summary>
+	template<typename Matrix>
+	Matrix MakeScaleMatrix(const Vec3<MatrixScalar<Matrix>>& scale) {
+
+		Matrix scaleMatrix = MakeIdentity4x4<Matrix>();
+		scaleMatrix.m[0][0] = scale.x;
+		scaleMatrix.m[1][1] = scale.y;
+		scaleMatrix.m[2][2] = scale.z;
+
+		return scaleMatrix;
+	}
+
+	/// <summary>
+	/// 4x4行列のX軸回転行列
+	/// </summary>
+	template<typename Matrix>
+	Matrix MakePitchMatrix(MatrixScalar<Matrix> radian) {
+
+		auto cosTheta = std::cos(radian);
+		auto sinTheta = std::sin(radian);
+
+		Matrix pitchMatrix = MakeIdentity4x4<Matrix>();
+		pitchMatrix.m[1][1] = cosTheta;
+		pitchMatrix.m[1][2] = sinTheta;
+		pitchMatrix.m[2][1] = -sinTheta;
+		pitchMatrix.m[2][2] = cosTheta;
+
+		return pitchMatrix;
+	}
+
+	/// <summary>
+	/// 4x4行列のY軸回転行列
+	/// </summary>
+	template<typename Matrix>
+	Matrix MakeYawMatrix(MatrixScalar<Matrix> radian) {
+
+		auto cosTheta = std::cos(radian);
+		auto sinTheta = std::sin(radian);
+
+		Matrix yawMatrix = MakeIdentity4x4<Matrix>();
+		yawMatrix.m[0][0] = cosTheta;
+		yawMatrix.m[0][2] = -sinTheta;
+		yawMatrix.m[2][0] = sinTheta;
+		yawMatrix.m[2][2] = cosTheta;
+
+		return yawMatrix;
+	}
+
+	/// <summary>
+	/// 4x4行列のZ軸回転行列
+	/// </summary>
+	template<typename Matrix>
+	Matrix MakeRollMatrix(MatrixScalar<Matrix> radian) {
+
+		auto cosTheta = std::cos(radian);
+		auto sinTheta = std::sin(radian);
+
+		Matrix rollMatrix = MakeIdentity4x4<Matrix>();
+		rollMatrix.m[0][0] = cosTheta;
+		rollMatrix.m[0][1] = sinTheta;
+		rollMatrix.m[1][0] = -sinTheta;
+		rollMatrix.m[1][1] = cosTheta;
+
+		return rollMatrix;
+	}
+
+	/// <summary>
+	/// 4x4行列の回転行列
+	/// </summary>
+	template<typename Matrix>
+	Matrix MakeRotateMatrix(const Vec3<MatrixScalar<Matrix>>& rotate) {
+
+		Matrix pitchMatrix = MakePitchMatrix<Matrix>(rotate.x);	// X軸回転行列
+		Matrix yawMatrix = MakeYawMatrix<Matrix>(rotate.y);		// Y軸回転行列
+		Matrix rollMatrix = MakeRollMatrix<Matrix>(rotate.z);	// Z軸回転行列
+
+		return Multiply(pitchMatrix, Multiply(yawMatrix, rollMatrix));
+	}
+
+	/// <summary>
+	/// 4x4行列の平行移動行列
+	/// </summary>
+	template<typename Matrix>
+	Matrix MakeTranslateMatrix(const Vec3<MatrixScalar<Matrix>>& translate) {
+
+		Matrix translateMatrix = MakeIdentity4x4<Matrix>();
+		translateMatrix.m[3][0] = translate.x;
+		translateMatrix.m[3][1] = translate.y;
+		translateMatrix.m[3][2] = translate.z;
+
+		return translateMatrix;
+	}
+
+	/// <summary>
+	/// 4x4行列のアフィン変換
+	/// </summary>
+	template<typename Matrix>
+	Matrix MakeAffineMatrix(
+		const Vec3<MatrixScalar<Matrix>>& scale, const Vec3<MatrixScalar<Matrix>>& rotate, const Vec3<MatrixScalar<Matrix>>& translate) {
+
+		Matrix matrix = Multiply(MakeScaleMatrix<Matrix>(scale), MakeRotateMatrix<Matrix>(rotate));
+		matrix = Multiply(matrix, MakeTranslateMatrix<Matrix>(translate));
+
+		return matrix;
+	}
+
+	/// <summary>
+	/// 4x4行列のアフィン変換(sinとcosを求めた後の閉じた式)
+	/// 拡縮 x X軸回転 x Y軸回転 x Z軸回転 x 平行移動 を展開し、0でない12要素だけを直接書く
+	/// 掛ける順番はMakeAffineMatrixの積と同じにしてあるので、同じsinとcosなら結果も一致する
+	/// </summary>
+	template<typename Matrix>
+	Matrix ComposeAffineMatrix(
+		const Vec3<MatrixScalar<Matrix>>& scale, const Vec3<MatrixScalar<Matrix>>& sinRotate, const Vec3<MatrixScalar<Matrix>>& cosRotate,
+		const Vec3<MatrixScalar<Matrix>>& translate) {
+
+		using T = MatrixScalar<Matrix>;
+
+		const T sx = sinRotate.x, cx = cosRotate.x;
+		const T sy = sinRotate.y, cy = cosRotate.y;
+		const T sz = sinRotate.z, cz = cosRotate.z;
+
+		// Y軸回転 x Z軸回転 のうち、X軸回転で混ざる2行目と3行目の要素
+		const T sycz = sy * cz;
+		const T sysz = sy * sz;
+
+		Matrix matrix;
+
+		matrix.m[0][0] = scale.x * (cy * cz);
+		matrix.m[0][1] = scale.x * (cy * sz);
+		matrix.m[0][2] = scale.x * -sy;
+		matrix.m[0][3] = T(0);
+
+		matrix.m[1][0] = scale.y * (cx * -sz + sx * sycz);
+		matrix.m[1][1] = scale.y * (cx * cz + sx * sysz);
+		matrix.m[1][2] = scale.y * (sx * cy);
+		matrix.m[1][3] = T(0);
+
+		matrix.m[2][0] = scale.z * (-sx * -sz + cx * sycz);
+		matrix.m[2][1] = scale.z * (-sx * cz + cx * sysz);
+		matrix.m[2][2] = scale.z * (cx * cy);
+		matrix.m[2][3] = T(0);
+
+		matrix.m[3][0] = translate.x;
+		matrix.m[3][1] = translate.y;
+		matrix.m[3][2] = translate.z;
+		matrix.m[3][3] = T(1);
+
+		return matrix;
+	}
+
+	/// <summary>
+	/// 4x4行列のアフィン変換(閉じた式)
+	/// 一般の4x4行列の積を使わずに、MakeAffineMatrixと同じ行列を作る
+	/// </summary>
+	template<typename Matrix>
+	Matrix ComposeAffineMatrix(
+		const Vec3<MatrixScalar<Matrix>>& scale, const Vec3<MatrixScalar<Matrix>>& rotate, const Vec3<MatrixScalar<Matrix>>& translate) {
+
+		using T = MatrixScalar<Matrix>;
+
+		Vec3<T> sinRotate(std::sin(rotate.x), std::sin(rotate.y), std::sin(rotate.z));
+		Vec3<T> cosRotate(std::cos(rotate.x), std::cos(rotate.y), std::cos(rotate.z));
+
+		return ComposeAffineMatrix<Matrix>(scale, sinRotate, cosRotate, translate);
+	}
+
+	/// <summary>
+	/// 4x4行列の座標変換
+	/// </summary>
+	template<typename T, typename Matrix>
+	Vec3<T> Transform(const Vec3<T>& vector, const Matrix& matrix) {
+
+		Vec3<T> result;
+
+		// ベクトルと行列の乗算
+		result.x = vector.x * matrix.m[0][0] + vector.y * matrix.m[1][0] + vector.z * matrix.m[2][0] +
+			matrix.m[3][0];
+		result.y = vector.x * matrix.m[0][1] + vector.y * matrix.m[1][1] + vector.z * matrix.m[2][1] +
+			matrix.m[3][1];
+		result.z = vector.x * matrix.m[0][2] + vector.y * matrix.m[1][2] + vector.z * matrix.m[2][2] +
+			matrix.m[3][2];
+		T w = vector.x * matrix.m[0][3] + vector.y * matrix.m[1][3] + vector.z * matrix.m[2][3] +
+			matrix.m[3][3];
+
+		// ベクトルの正規化
+		if (w != T(0)) {
+			result.x /= w;
+			result.y /= w;
+			result.z /= w;
+		}
+
+		return result;
+	}
+
+	/// <summary>
+	/// 行列の精度変換
+	/// </summary>
+	template<typename To, typename From>
+	To ConvertMatrix(const From& m) {
+
+		To matrix;
+		for (int i = 0; i < 4; i++) {
+			for (int j = 0; j < 4; j++) {
+				matrix.m[i][j] = static_cast<MatrixScalar<To>>(m.m[i][j]);
+			}
+		}
+
+		return matrix;
+	}
+
+	/// <summary>
+	/// ベクトルの精度変換
+	/// </summary>
+	template<typename To, typename From>
+	Vec3<To> ConvertVector(const Vec3<From>& v) {
+
+		return Vec3<To>(static_cast<To>(v.x), static_cast<To>(v.y), static_cast<To>(v.z));
+	}
+}
@@ -6,30 +6,31 @@
 /// <summary>
 /// 二次元ベクトル
 /// </summary>
-struct Vec2f {
+template<typename T>
+struct Vec2 {
 
-	float x;
-	float y;
+	T x;
+	T y;
 
-	Vec2f operator+(const Vec2f& other) const {
+	Vec2 operator+(const Vec2& other) const {
 		return { x + other.x, y + other.y };
 	}
 
-	Vec2f operator-(const Vec2f& other) const {
+	Vec2 operator-(const Vec2& other) const {
 		return { x - other.x, y - other.y };
 	}
 
-	Vec2f operator*(float scalar) const {
+	Vec2 operator*(T scalar) const {
 		return { x * scalar, y * scalar };
 	}
 
-	Vec2f& operator+=(const Vec2f& other) {
+	Vec2& operator+=(const Vec2& other) {
 		x += other.x;
 		y += other.y;
 		return *this;
 	}
 
-	Vec2f& operator-=(const Vec2f& other) {
+	Vec2& operator-=(const Vec2& other) {
 		x -= other.x;
 		y -= other.y;
 		return *this;
@@ -39,28 +40,29 @@ struct Vec2f {
 /// <summary>
 /// 三次元ベクトル
 /// </summary>
-struct Vec3f {
+template<typename T>
+struct Vec3 {
 
-	float x;
-	float y;
-	float z;
+	T x;
+	T y;
+	T z;
 
-	Vec3f operator+(const Vec3f& other) const {
+	Vec3 operator+(const Vec3& other) const {
 		return { x + other.x, y + other.y, z + other.z };
 	}
 
-	Vec3f operator-(const Vec3f& other) const {
+	Vec3 operator-(const Vec3& other) const {
 		return { x - other.x, y - other.y, z - other.z };
 	}
 
-	Vec3f& operator+=(const Vec3f& other) {
+	Vec3& operator+=(const Vec3& other) {
 		x += other.x;
 		y += other.y;
 		z += other.z;
 		return *this;
 	}
 
-	Vec3f& operator-=(const Vec3f& other) {
+	Vec3& operator-=(const Vec3& other) {
 		x -= other.x;
 		y -= other.y;
 		z -= other.z;
@@ -68,35 +70,44 @@ struct Vec3f {
 	}
 
 	// 乗算演算子のオーバーロード
-	Vec3f operator*(float scalar) const {
-		return Vec3f(x * scalar, y * scalar, z * scalar);
+	Vec3 operator*(T scalar) const {
+		return Vec3(x * scalar, y * scalar, z * scalar);
 	}
 
 	// オーバーロードされた乗算演算子の逆向きのオーバーロード
-	friend Vec3f operator*(float scalar, const Vec3f& vec) {
-		return Vec3f(vec.x * scalar, vec.y * scalar, vec.z * scalar);
+	friend Vec3 operator*(T scalar, const Vec3& vec) {
+		return Vec3(vec.x * scalar, vec.y * scalar, vec.z * scalar);
 	}
 };
 
 /// <summary>
 /// 四次元ベクトル
 /// </summary>
-struct Vec4f {
+template<typename T>
+struct Vec4 {
 
-	float x;
-	float y;
-	float z;
-	float w;
+	T x;
+	T y;
+	T z;
+	T w;
 
-	Vec4f operator+(const Vec4f& other) const {
+	Vec4 operator+(const Vec4& other) const {
 		return { x + other.x, y + other.y, z + other.z, w + other.w };
 	}
 
-	Vec4f operator-(const Vec4f& other) const {
+	Vec4 operator-(const Vec4& other) const {
 		return { x - other.x, y - other.y, z - other.z, w - other.w };
 	}
 
-	Vec4f operator*(float scalar) const {
+	Vec4 operator*(T scalar) const {
 		return { x * scalar, y * scalar, z * scalar, w * scalar };
 	}
-};
\ No newline at end of file
+};
+
+using Vec2f = Vec2<float>;
+using Vec3f = Vec3<float>;
+using Vec4f = Vec4<float>;
+
+using Vec2d = Vec2<double>;
+using Vec3d = Vec3<double>;
+using Vec4d = Vec4<double>;
\ No newline at end of file
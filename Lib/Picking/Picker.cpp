@@ -0,0 +1,241 @@
+﻿#include "Picker.h"
+
+namespace {
+
+	/// <summary>
+	/// 2つのAABBを囲むAABB
+	/// </summary>
+	AABB Merge(const AABB& a, const AABB& b) {
+
+		return {
+			{ (std::min)(a.min.x, b.min.x), (std::min)(a.min.y, b.min.y), (std::min)(a.min.z, b.min.z) },
+			{ (std::max)(a.max.x, b.max.x), (std::max)(a.max.y, b.max.y), (std::max)(a.max.z, b.max.z) } };
+	}
+
+	float GetAxis(const Vec3f& v, int axis) {
+		return axis == 0 ? v.x : (axis == 1 ? v.y : v.z);
+	}
+}
+
+/// <summary>
+/// 登録したものを全て消す
+/// </summary>
+void Picker::Clear() {
+
+	spheres_.clear();
+	segments_.clear();
+	segmentRadii_.clear();
+	primitives_.clear();
+	nodes_.clear();
+}
+
+/// <summary>
+/// 球の登録
+/// </summary>
+/// <param name="sphere"></param>
+/// <returns>球の中での登録番号</returns>
+uint32_t Picker::AddSphere(const SphereShape& sphere) {
+
+	uint32_t index = static_cast<uint32_t>(spheres_.size());
+	spheres_.push_back(sphere);
+
+	Vec3f extent = { sphere.radius, sphere.radius, sphere.radius };
+	primitives_.push_back({ Type::kSphere, index, { sphere.center - extent, sphere.center + extent }, sphere.center });
+
+	return index;
+}
+
+/// <summary>
+/// 線分の登録
+/// </summary>
+/// <param name="segment"></param>
+/// <param name="radius">選択できる太さ</param>
+/// <returns>線分の中での登録番号</returns>
+uint32_t Picker::AddSegment(const Segement& segment, float radius) {
+
+	uint32_t index = static_cast<uint32_t>(segments_.size());
+	segments_.push_back(segment);
+	segmentRadii_.push_back(radius);
+
+	Vec3f end = segment.origin + segment.diff;
+	Vec3f extent = { radius, radius, radius };
+	AABB bounds = Merge({ segment.origin, segment.origin }, { end, end });
+	bounds.min -= extent;
+	bounds.max += extent;
+
+	primitives_.push_back({ Type::kSegment, index, bounds, segment.origin + segment.diff * 0.5f });
+
+	return index;
+}
+
+/// <summary>
+/// BVHの構築
+/// </summary>
+void Picker::Build() {
+
+	nodes_.clear();
+	if (primitives_.empty()) {
+		return;
+	}
+
+	// ノード数は最大で2N-1
+	nodes_.reserve(primitives_.size() * 2);
+	nodes_.push_back({});
+	BuildNode(0, 0, static_cast<uint32_t>(primitives_.size()));
+}
+
+/// <summary>
+/// ノードの分割
+/// 最も長い軸で中央値分割する
+/// </summary>
+/// <param name="nodeIndex"></param>
+/// <param name="first"></param>
+/// <param name="count"></param>
+void Picker::BuildNode(uint32_t nodeIndex, uint32_t first, uint32_t count) {
+
+	AABB bounds = primitives_[first].bounds;
+	AABB centroidBounds = { primitives_[first].centroid, primitives_[first].centroid };
+	for (uint32_t i = first + 1; i < first + count; ++i) {
+		bounds = Merge(bounds, primitives_[i].bounds);
+		centroidBounds = Merge(centroidBounds, { primitives_[i].centroid, primitives_[i].centroid });
+	}
+
+	nodes_[nodeIndex].bounds = bounds;
+
+	// 葉
+	if (count <= kMaxLeafSize) {
+		nodes_[nodeIndex].first = first;
+		nodes_[nodeIndex].count = count;
+		return;
+	}
+
+	// 分割軸
+	Vec3f extent = centroidBounds.max - centroidBounds.min;
+	int axis = 0;
+	if (extent.y > extent.x) {
+		axis = 1;
+	}
+	if (extent.z > GetAxis(extent, axis)) {
+		axis = 2;
+	}
+
+	uint32_t half = count / 2;
+	std::nth_element(
+		primitives_.begin() + first, primitives_.begin() + first + half, primitives_.begin() + first + count,
+		[axis](const Primitive& a, const Primitive& b) { return GetAxis(a.centroid, axis) < GetAxis(b.centroid, axis); });
+
+	// 子は連続した位置に置く
+	uint32_t leftIndex = static_cast<uint32_t>(nodes_.size());
+	nodes_.push_back({});
+	nodes_.push_back({});
+
+	nodes_[nodeIndex].first = leftIndex;
+	nodes_[nodeIndex].count = 0;
+
+	BuildNode(leftIndex, first, half);
+	BuildNode(leftIndex + 1, first + half, count - half);
+}
+
+/// <summary>
+/// プリミティブと半直線の交差判定
+/// </summary>
+/// <param name="primitive"></param>
+/// <param name="ray"></param>
+/// <param name="t"></param>
+/// <returns></returns>
+bool Picker::IntersectPrimitive(const Primitive& primitive, const Segement& ray, float& t) const {
+
+	if (primitive.type == Type::kSphere) {
+		return SegmentSphereIntersection(ray, spheres_[primitive.index], t);
+	}
+
+	// 線分は太さを持ったカプセルとして扱う
+	const Segement& segment = segments_[primitive.index];
+	float radius = segmentRadii_[primitive.index];
+
+	ClosestPointPair pair = ClosestPoints(ray, segment);
+	Vec3f d = pair.point1 - pair.point2;
+	if (Dot(d, d) > radius * radius) {
+		return false;
+	}
+
+	float lengthSq = Dot(ray.diff, ray.diff);
+	t = lengthSq > 0.0f ? Dot(pair.point1 - ray.origin, ray.diff) / lengthSq : 0.0f;
+	return true;
+}
+
+/// <summary>
+/// 最も手前で交差するものを探す
+/// </summary>
+/// <param name="ray">ScreenToWorldRayで求めた半直線、媒介変数0 ~ 1の範囲を探す</param>
+/// <returns></returns>
+Picker::Result Picker::Pick(const Ray& ray) const {
+
+	Result result;
+	visitedNodeCount_ = 0;
+
+	if (nodes_.empty()) {
+		return result;
+	}
+
+	Segement raySegment = { ray.origin, ray.diff };
+	float bestT = 1.0f;
+
+	// 深さ優先で、手前の子から辿る
+	uint32_t stack[64];
+	uint32_t stackSize = 0;
+	stack[stackSize++] = 0;
+
+	while (stackSize > 0) {
+
+		const Node& node = nodes_[stack[--stackSize]];
+		++visitedNodeCount_;
+
+		float tEnter = 0.0f;
+		if (!RayAABBIntersection(ray, node.bounds, tEnter) || tEnter > bestT) {
+			continue;
+		}
+
+		if (node.count > 0) {
+
+			// 葉
+			for (uint32_t i = node.first; i < node.first + node.count; ++i) {
+
+				float t = 0.0f;
+				if (IntersectPrimitive(primitives_[i], raySegment, t) && t <= bestT) {
+					bestT = t;
+					result.type = primitives_[i].type;
+					result.index = primitives_[i].index;
+					result.t = t;
+				}
+			}
+			continue;
+		}
+
+		// 近い方の子を後に積んで先に取り出す
+		float tLeft = 0.0f;
+		float tRight = 0.0f;
+		bool hitLeft = RayAABBIntersection(ray, nodes_[node.first].bounds, tLeft);
+		bool hitRight = RayAABBIntersection(ray, nodes_[node.first + 1].bounds, tRight);
+
+		if (hitLeft && hitRight) {
+			if (tLeft < tRight) {
+				stack[stackSize++] = node.first + 1;
+				stack[stackSize++] = node.first;
+			} else {
+				stack[stackSize++] = node.first;
+				stack[stackSize++] = node.first + 1;
+			}
+		} else if (hitLeft) {
+			stack[stackSize++] = node.first;
+		} else if (hitRight) {
+			stack[stackSize++] = node.first + 1;
+		}
+	}
+
+	if (result.type != Type::kNone) {
+		result.position = ray.origin + ray.diff * result.t;
+	}
+
+	return result;
+}
@@ -0,0 +1,106 @@
+﻿#pragma once
+#include <vector>
+#include "MyMath.h"
+
+/// <summary>
+/// ピッキングクラス
+/// 球と線分をBVHに登録し、スクリーンからの半直線で最も手前の物を探す
+/// </summary>
+class Picker {
+public:
+	/// <summary>
+	/// 型定義
+	/// </summary>
+
+	// 選択された物の種類
+	enum class Type {
+
+		kNone,
+		kSphere,
+		kSegment,
+	};
+
+	/// <summary>
+	/// ピッキングの結果
+	/// </summary>
+	struct Result {
+
+		Type type = Type::kNone;
+		uint32_t index = 0; // 種類ごとの登録順
+		float t = 0.0f;     // 半直線上の媒介変数
+		Vec3f position{};   // 交点のワールド座標
+	};
+
+private:
+	/// <summary>
+	/// メンバ変数
+	/// </summary>
+
+	// 葉に入れる最大の数
+	static const uint32_t kMaxLeafSize = 4;
+
+	/// <summary>
+	/// BVHのノード
+	/// </summary>
+	struct Node {
+
+		AABB bounds;
+		uint32_t first; // 葉なら最初のプリミティブ、節なら左の子
+		uint32_t count; // 葉ならプリミティブの数、節なら0
+	};
+
+	/// <summary>
+	/// 登録されたプリミティブ
+	/// </summary>
+	struct Primitive {
+
+		Type type;
+		uint32_t index;
+		AABB bounds;
+		Vec3f centroid;
+	};
+
+	std::vector<SphereShape> spheres_;
+	std::vector<Segement> segments_;
+	std::vector<float> segmentRadii_;
+
+	std::vector<Primitive> primitives_;
+	std::vector<Node> nodes_;
+
+	// 直前のPickで訪れたノード数
+	mutable uint32_t visitedNodeCount_ = 0;
+
+	// ノードの分割
+	void BuildNode(uint32_t nodeIndex, uint32_t first, uint32_t count);
+	// プリミティブと半直線の交差判定
+	bool IntersectPrimitive(const Primitive& primitive, const Segement& ray, float& t) const;
+
+public:
+	/// <summary>
+	/// メンバ関数
+	/// </summary>
+
+	// コンストラクタ
+	Picker() {}
+	// デストラクタ
+	~Picker() {}
+
+	// 登録したものを全て消す
+	void Clear();
+	// 球の登録
+	uint32_t AddSphere(const SphereShape& sphere);
+	// 線分の登録、radiusは選択できる太さ
+	uint32_t AddSegment(const Segement& segment, float radius);
+	// BVHの構築
+	void Build();
+
+	// 最も手前で交差するものを探す
+	Result Pick(const Ray& ray) const;
+
+	/// <summary>
+	/// ゲッター
+	/// </summary>
+	/// <returns></returns>
+	uint32_t GetVisitedNodeCount() const { return visitedNodeCount_; }
+	size_t GetPrimitiveCount() const { return primitives_.size(); }
+};
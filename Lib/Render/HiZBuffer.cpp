@@ -0,0 +1,264 @@
+﻿#include "HiZBuffer.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+	// 遮蔽物が無いタイルの深度
+	const float kNoOccluder = std::numeric_limits<float>::infinity();
+}
+
+/// <summary>
+/// 球を画面に投影する
+/// 半径は球面上の点を2方向に投影した短い方を使うので、近似的に投影の内側に収まる
+/// </summary>
+/// <param name="sphere"></param>
+/// <param name="cameraPosition"></param>
+/// <param name="viewProjectionViewportMatrix"></param>
+/// <param name="outDisc"></param>
+/// <returns>遮蔽物として使えるか</returns>
+bool HiZBuffer::ProjectSphere(const SphereShape& sphere, const Vec3f& cameraPosition, const Matrix4x4& viewProjectionViewportMatrix, Disc& outDisc) {
+
+	Vec3f toCenter = sphere.center - cameraPosition;
+	float distance = Length(toCenter);
+	if (distance <= sphere.radius) {
+		return false;
+	}
+
+	Vec3f direction = toCenter * (1.0f / distance);
+
+	// 視線方向の手前と奥の点
+	outDisc.nearDepth = Transform(sphere.center - direction * sphere.radius, viewProjectionViewportMatrix).z;
+	outDisc.farDepth = Transform(sphere.center + direction * sphere.radius, viewProjectionViewportMatrix).z;
+
+	// 深度の範囲に収まっていない(クリップされる)球は使わない
+	if (!(outDisc.nearDepth >= 0.0f && outDisc.farDepth <= 1.0f)) {
+		return false;
+	}
+
+	Vec3f center = Transform(sphere.center, viewProjectionViewportMatrix);
+	outDisc.center = { center.x, center.y };
+
+	// 視線に垂直な2方向
+	Vec3f helper = std::abs(direction.y) < 0.9f ? Vec3f(0.0f, 1.0f, 0.0f) : Vec3f(1.0f, 0.0f, 0.0f);
+	Vec3f perpendicular1 = Normalize(Cross(direction, helper));
+	Vec3f perpendicular2 = Cross(direction, perpendicular1);
+
+	Vec3f edge1 = Transform(sphere.center + perpendicular1 * sphere.radius, viewProjectionViewportMatrix);
+	Vec3f edge2 = Transform(sphere.center + perpendicular2 * sphere.radius, viewProjectionViewportMatrix);
+	float radius1 = std::hypot(edge1.x - center.x, edge1.y - center.y);
+	float radius2 = std::hypot(edge2.x - center.x, edge2.y - center.y);
+	outDisc.radius = (std::min)(radius1, radius2);
+
+	return std::isfinite(outDisc.radius) && std::isfinite(outDisc.center.x) && std::isfinite(outDisc.center.y);
+}
+
+/// <summary>
+/// 初期化
+/// </summary>
+/// <param name="width"></param>
+/// <param name="height"></param>
+void HiZBuffer::Init(uint32_t width, uint32_t height) {
+
+	width_ = width;
+	height_ = height;
+
+	levels_.clear();
+
+	uint32_t levelWidth = (width + kTileSize - 1) / kTileSize;
+	uint32_t levelHeight = (height + kTileSize - 1) / kTileSize;
+	while (true) {
+
+		levels_.push_back({ levelWidth, levelHeight, std::vector<float>(static_cast<size_t>(levelWidth) * levelHeight, kNoOccluder) });
+		if (levelWidth == 1 && levelHeight == 1) {
+			break;
+		}
+
+		levelWidth = (levelWidth + 1) / 2;
+		levelHeight = (levelHeight + 1) / 2;
+	}
+
+	occluderCount_ = 0;
+}
+
+/// <summary>
+/// 遮蔽物を全て消す
+/// </summary>
+void HiZBuffer::Clear() {
+
+	for (Level& level : levels_) {
+		std::fill(level.depth.begin(), level.depth.end(), kNoOccluder);
+	}
+
+	occluderCount_ = 0;
+}
+
+/// <summary>
+/// 画面上の円を遮蔽物として書き込む
+/// </summary>
+/// <param name="disc"></param>
+void HiZBuffer::AddDisc(const Disc& disc) {
+
+	AddDisc(disc, GetScreenRect());
+}
+
+/// <summary>
+/// 画面上の円を、矩形の中のタイルにだけ遮蔽物として書き込む
+/// 円に完全に覆われるタイルだけに、球の一番奥の深度を書く
+/// 分割表示では視点ごとに深度の意味が違うので、隣の視点の線を隠さないよう矩形からはみ出すタイルには書かない
+/// 線の判定は1ピクセル広げて行うので、画面の端でない辺は1ピクセル内側までにする
+/// </summary>
+/// <param name="disc"></param>
+/// <param name="rect">書き込む範囲</param>
+void HiZBuffer::AddDisc(const Disc& disc, const Rect& rect) {
+
+	if (levels_.empty() || disc.radius <= 0.0f) {
+		return;
+	}
+
+	Level& level = levels_[0];
+	const float kTileSizeF = static_cast<float>(kTileSize);
+
+	// 円の外接矩形に掛かるタイル
+	int32_t tileMinX = (std::max)(static_cast<int32_t>(std::floor((disc.center.x - disc.radius) / kTileSizeF)), 0);
+	int32_t tileMinY = (std::max)(static_cast<int32_t>(std::floor((disc.center.y - disc.radius) / kTileSizeF)), 0);
+	int32_t tileMaxX = (std::min)(static_cast<int32_t>(std::floor((disc.center.x + disc.radius) / kTileSizeF)), static_cast<int32_t>(level.width) - 1);
+	int32_t tileMaxY = (std::min)(static_cast<int32_t>(std::floor((disc.center.y + disc.radius) / kTileSizeF)), static_cast<int32_t>(level.height) - 1);
+
+	// 矩形に収まるタイルに絞る(画面の端の辺はそのまま)
+	const float kRight = rect.left + rect.width;
+	const float kBottom = rect.top + rect.height;
+	if (rect.left > 0.0f) {
+		tileMinX = (std::max)(tileMinX, static_cast<int32_t>(std::ceil((rect.left + 1.0f) / kTileSizeF)));
+	}
+	if (rect.top > 0.0f) {
+		tileMinY = (std::max)(tileMinY, static_cast<int32_t>(std::ceil((rect.top + 1.0f) / kTileSizeF)));
+	}
+	if (kRight < static_cast<float>(width_)) {
+		tileMaxX = (std::min)(tileMaxX, static_cast<int32_t>(std::floor((kRight - 1.0f) / kTileSizeF)) - 1);
+	}
+	if (kBottom < static_cast<float>(height_)) {
+		tileMaxY = (std::min)(tileMaxY, static_cast<int32_t>(std::floor((kBottom - 1.0f) / kTileSizeF)) - 1);
+	}
+
+	float radiusSquared = disc.radius * disc.radius;
+	bool isWritten = false;
+
+	for (int32_t tileY = tileMinY; tileY <= tileMaxY; ++tileY) {
+		for (int32_t tileX = tileMinX; tileX <= tileMaxX; ++tileX) {
+
+			// 円の中心から一番遠い角が円の中にあれば、タイル全体が覆われている
+			float left = static_cast<float>(tileX) * kTileSizeF;
+			float top = static_cast<float>(tileY) * kTileSizeF;
+			float farX = (std::max)(std::abs(left - disc.center.x), std::abs(left + kTileSizeF - disc.center.x));
+			float farY = (std::max)(std::abs(top - disc.center.y), std::abs(top + kTileSizeF - disc.center.y));
+			if (farX * farX + farY * farY > radiusSquared) {
+				continue;
+			}
+
+			float& depth = level.depth[static_cast<size_t>(tileY) * level.width + tileX];
+			depth = (std::min)(depth, disc.farDepth);
+			isWritten = true;
+		}
+	}
+
+	if (isWritten) {
+		++occluderCount_;
+	}
+}
+
+/// <summary>
+/// 上の階層を作る
+/// 子の4タイルのうち最も奥の深度を持つ
+/// </summary>
+void HiZBuffer::Build() {
+
+	for (size_t levelIndex = 1; levelIndex < levels_.size(); ++levelIndex) {
+
+		const Level& child = levels_[levelIndex - 1];
+		Level& parent = levels_[levelIndex];
+
+		for (uint32_t y = 0; y < parent.height; ++y) {
+			for (uint32_t x = 0; x < parent.width; ++x) {
+
+				float depth = 0.0f;
+				for (uint32_t childY = y * 2; childY < (std::min)(y * 2 + 2, child.height); ++childY) {
+					for (uint32_t childX = x * 2; childX < (std::min)(x * 2 + 2, child.width); ++childX) {
+						depth = (std::max)(depth, child.depth[static_cast<size_t>(childY) * child.width + childX]);
+					}
+				}
+
+				parent.depth[static_cast<size_t>(y) * parent.width + x] = depth;
+			}
+		}
+	}
+}
+
+/// <summary>
+/// 線が遮蔽物に完全に隠れるか
+/// 線の外接矩形に掛かる全てのタイルで、遮蔽物が線の一番手前より手前にあれば隠れる
+/// 粗い階層から順に調べ、判定できなければ細かい階層へ進む
+/// </summary>
+/// <param name="line"></param>
+/// <returns></returns>
+bool HiZBuffer::IsOccluded(const ScreenLine& line) const {
+
+	if (occluderCount_ == 0 || levels_.empty()) {
+		return false;
+	}
+
+	float nearestDepth = (std::min)(line.start.z, line.end.z);
+	if (!std::isfinite(nearestDepth)) {
+		return false;
+	}
+
+	// アンチエイリアスで広がる分も含めて1ピクセル広げる
+	float minX = (std::min)(line.start.x, line.end.x) - 1.0f;
+	float minY = (std::min)(line.start.y, line.end.y) - 1.0f;
+	float maxX = (std::max)(line.start.x, line.end.x) + 1.0f;
+	float maxY = (std::max)(line.start.y, line.end.y) + 1.0f;
+	if (!(std::isfinite(minX) && std::isfinite(minY) && std::isfinite(maxX) && std::isfinite(maxY))) {
+		return false;
+	}
+
+	// 画面外は描かれないので画面内だけ調べる
+	minX = (std::max)(minX, 0.0f);
+	minY = (std::max)(minY, 0.0f);
+	maxX = (std::min)(maxX, static_cast<float>(width_) - 1.0f);
+	maxY = (std::min)(maxY, static_cast<float>(height_) - 1.0f);
+	if (minX > maxX || minY > maxY) {
+		return false;
+	}
+
+	for (size_t levelIndex = levels_.size(); levelIndex-- > 0;) {
+
+		const Level& level = levels_[levelIndex];
+		float tileSize = static_cast<float>(kTileSize << levelIndex);
+
+		uint32_t tileMinX = static_cast<uint32_t>(minX / tileSize);
+		uint32_t tileMinY = static_cast<uint32_t>(minY / tileSize);
+		uint32_t tileMaxX = (std::min)(static_cast<uint32_t>(maxX / tileSize), level.width - 1);
+		uint32_t tileMaxY = (std::min)(static_cast<uint32_t>(maxY / tileSize), level.height - 1);
+
+		// 細かい階層ほどタイル数が増えるので、上限を超えたらそこで諦める
+		if ((tileMaxX - tileMinX + 1) * (tileMaxY - tileMinY + 1) > kMaxTestTileCount) {
+			break;
+		}
+
+		bool isOccluded = true;
+		for (uint32_t tileY = tileMinY; tileY <= tileMaxY && isOccluded; ++tileY) {
+			for (uint32_t tileX = tileMinX; tileX <= tileMaxX; ++tileX) {
+				if (level.depth[static_cast<size_t>(tileY) * level.width + tileX] >= nearestDepth) {
+					isOccluded = false;
+					break;
+				}
+			}
+		}
+
+		if (isOccluded) {
+			return true;
+		}
+	}
+
+	return false;
+}
@@ -0,0 +1,93 @@
+﻿#pragma once
+#include <vector>
+#include "MyMath.h"
+#include "ScreenLine.h"
+
+/// <summary>
+/// 粗い階層深度バッファ
+/// 不透明な球を画面上の円として書き込み、線がその奥に完全に隠れるかを調べる
+/// 各タイルには「タイル全体を覆う遮蔽物のうち最も手前のものの深度」を入れ、上の階層は子の最大値(最も奥)を持つ
+/// </summary>
+class HiZBuffer {
+public:
+	/// <summary>
+	/// 型定義
+	/// </summary>
+
+	// 画面に投影した球
+	struct Disc {
+
+		Vec2f center;    // 中心のスクリーン座標
+		float radius;    // 投影した球に内接する半径(ピクセル)
+		float nearDepth; // 一番手前の深度
+		float farDepth;  // 一番奥の深度
+	};
+
+	// 画面上の矩形(ピクセル)、分割表示の1つの視点の範囲
+	struct Rect {
+
+		float left;
+		float top;
+		float width;
+		float height;
+	};
+
+private:
+	// 1階層分のタイル
+	struct Level {
+
+		uint32_t width;
+		uint32_t height;
+		std::vector<float> depth;
+	};
+
+	/// <summary>
+	/// メンバ変数
+	/// </summary>
+
+	// 一番細かい階層のタイルの一辺のピクセル数
+	static const uint32_t kTileSize = 8;
+	// 1回の判定で調べるタイル数の上限
+	static const uint32_t kMaxTestTileCount = 256;
+
+	uint32_t width_ = 0;
+	uint32_t height_ = 0;
+
+	// 0が一番細かい階層
+	std::vector<Level> levels_;
+
+	uint32_t occluderCount_ = 0;
+
+public:
+	/// <summary>
+	/// メンバ関数
+	/// </summary>
+
+	// コンストラクタ
+	HiZBuffer() {}
+	// デストラクタ
+	~HiZBuffer() {}
+
+	// 球を画面に投影する、カメラが球の中にある時はfalse
+	static bool ProjectSphere(const SphereShape& sphere, const Vec3f& cameraPosition, const Matrix4x4& viewProjectionViewportMatrix, Disc& outDisc);
+
+	// 初期化
+	void Init(uint32_t width, uint32_t height);
+	// 遮蔽物を全て消す
+	void Clear();
+	// 画面上の円を遮蔽物として書き込む
+	void AddDisc(const Disc& disc);
+	// 画面上の円を、矩形の中のタイルにだけ遮蔽物として書き込む
+	void AddDisc(const Disc& disc, const Rect& rect);
+	// 上の階層を作る
+	void Build();
+	// 線が遮蔽物に完全に隠れるか
+	bool IsOccluded(const ScreenLine& line) const;
+
+	/// <summary>
+	/// ゲッター
+	/// </summary>
+	/// <returns></returns>
+	uint32_t GetOccluderCount() const { return occluderCount_; }
+	Rect GetScreenRect() const { return { 0.0f, 0.0f, static_cast<float>(width_), static_cast<float>(height_) }; }
+};
@@ -0,0 +1,396 @@
+﻿#include "LineBatcher.h"
+#include "Counters.h"
+#include <algorithm>
+#include <array>
+
+namespace {
+
+	// 結合する時の誤差(ピクセル)
+	const float kJoinTolerance = 0.5f;
+	// 一直線とみなす角度の誤差(sin)
+	const float kCollinearTolerance = 1.0e-3f;
+
+	/// <summary>
+	/// 2本目の線が1本目の終点から同じ向きに続いているか
+	/// </summary>
+	bool CanMerge(const ScreenLine& a, const ScreenLine& b) {
+
+		if (a.color != b.color) {
+			return false;
+		}
+
+		// 終点と始点が繋がっているか
+		float gapX = b.start.x - a.end.x;
+		float gapY = b.start.y - a.end.y;
+		if (gapX * gapX + gapY * gapY > kJoinTolerance * kJoinTolerance) {
+			return false;
+		}
+
+		float ax = a.end.x - a.start.x;
+		float ay = a.end.y - a.start.y;
+		float bx = b.end.x - b.start.x;
+		float by = b.end.y - b.start.y;
+
+		// 同じ向きで、外積が長さに対して十分小さいか
+		float dot = ax * bx + ay * by;
+		if (dot <= 0.0f) {
+			return false;
+		}
+
+		float cross = ax * by - ay * bx;
+		float lengthProduct = std::sqrt((ax * ax + ay * ay) * (bx * bx + by * by));
+		return std::abs(cross) <= kCollinearTolerance * lengthProduct;
+	}
+
+	/// <summary>
+	/// 線の一番手前の深度
+	/// </summary>
+	float NearestDepth(const ScreenLine& line) {
+
+		return (std::min)(line.start.z, line.end.z);
+	}
+
+	/// <summary>
+	/// 矩形で切り取った円を三角形で塗る
+	/// 円を多角形にして矩形の4辺で順に切り取り、残った凸多角形を扇形に分ける
+	/// </summary>
+	void DrawClippedDisc(const HiZBuffer::Disc& disc, const HiZBuffer::Rect& rect, uint32_t color) {
+
+		const uint32_t kSegmentCount = 32;
+		const float kPi = 3.14159265f;
+
+		std::vector<Vec2f> polygon;
+		for (uint32_t i = 0; i < kSegmentCount; ++i) {
+			float angle = 2.0f * kPi * static_cast<float>(i) / static_cast<float>(kSegmentCount);
+			polygon.push_back({ disc.center.x + disc.radius * std::cos(angle), disc.center.y + disc.radius * std::sin(angle) });
+		}
+
+		// 辺ごとに、内側の点を残し、辺をまたぐ所に交点を入れる
+		const float kBounds[4] = { rect.left, rect.left + rect.width, rect.top, rect.top + rect.height };
+		std::vector<Vec2f> clipped;
+		for (int edge = 0; edge < 4; ++edge) {
+
+			const bool kIsX = edge < 2;
+			const bool kIsMin = edge % 2 == 0;
+			auto inside = [&](const Vec2f& p) {
+				float value = kIsX ? p.x : p.y;
+				return kIsMin ? value >= kBounds[edge] : value <= kBounds[edge];
+				};
+
+			clipped.clear();
+			for (size_t i = 0; i < polygon.size(); ++i) {
+
+				const Vec2f& current = polygon[i];
+				const Vec2f& next = polygon[(i + 1) % polygon.size()];
+				if (inside(current)) {
+					clipped.push_back(current);
+				}
+				if (inside(current) != inside(next)) {
+					float a = kIsX ? current.x : current.y;
+					float b = kIsX ? next.x : next.y;
+					float t = (kBounds[edge] - a) / (b - a);
+					clipped.push_back(current + (next - current) * t);
+				}
+			}
+			polygon.swap(clipped);
+		}
+
+		for (size_t i = 2; i < polygon.size(); ++i) {
+			Novice::DrawTriangle(
+				static_cast<int>(polygon[0].x), static_cast<int>(polygon[0].y),
+				static_cast<int>(polygon[i - 1].x), static_cast<int>(polygon[i - 1].y),
+				static_cast<int>(polygon[i].x), static_cast<int>(polygon[i].y),
+				color, kFillModeSolid
+			);
+		}
+	}
+
+	/// <summary>
+	/// 遮蔽物の描画順を決める深度
+	/// </summary>
+	float CenterDepth(const HiZBuffer::Disc& disc) {
+
+		return (disc.nearDepth + disc.farDepth) * 0.5f;
+	}
+}
+
+/// <summary>
+/// 初期化
+/// </summary>
+/// <param name="width"></param>
+/// <param name="height"></param>
+void LineBatcher::Init(uint32_t width, uint32_t height) {
+
+	width_ = width;
+	height_ = height;
+
+	hiZBuffer_.Init(width, height);
+}
+
+/// <summary>
+/// 線の追加
+/// </summary>
+/// <param name="start"></param>
+/// <param name="end"></param>
+/// <param name="color"></param>
+void LineBatcher::AddLine(const Vec3f& start, const Vec3f& end, uint32_t color) {
+
+	GetTargetLines().push_back({ start, end, color });
+}
+
+/// <summary>
+/// スクリーン座標の線をまとめて追加
+/// </summary>
+/// <param name="lines"></param>
+void LineBatcher::AddLines(const std::vector<ScreenLine>& lines) {
+
+	std::vector<ScreenLine>& targetLines = GetTargetLines();
+	targetLines.insert(targetLines.end(), lines.begin(), lines.end());
+}
+
+/// <summary>
+/// 詰めた線を戻してまとめて追加
+/// </summary>
+/// <param name="lines"></param>
+/// <param name="palette"></param>
+void LineBatcher::AddPackedLines(const std::vector<PackedLine>& lines, const LinePalette& palette) {
+
+	std::vector<ScreenLine>& targetLines = GetTargetLines();
+	size_t offset = targetLines.size();
+	targetLines.resize(offset + lines.size());
+	UnpackLines(lines.data(), lines.size(), palette, targetLines.data() + offset);
+}
+
+/// <summary>
+/// 不透明な球の追加
+/// </summary>
+/// <param name="sphere"></param>
+/// <param name="color"></param>
+/// <param name="cameraPosition"></param>
+/// <param name="viewProjectionViewportMatrix"></param>
+void LineBatcher::AddOccluder(const SphereShape& sphere, uint32_t color, const Vec3f& cameraPosition, const Matrix4x4& viewProjectionViewportMatrix) {
+
+	AddOccluder(sphere, color, cameraPosition, viewProjectionViewportMatrix, hiZBuffer_.GetScreenRect());
+}
+
+/// <summary>
+/// 不透明な球を分割表示の1つの視点に追加
+/// 遮蔽の判定も描画も矩形の中だけにして、隣の視点の線をこの視点の深度で隠さないようにする
+/// </summary>
+/// <param name="sphere"></param>
+/// <param name="color"></param>
+/// <param name="cameraPosition">その視点のカメラの位置</param>
+/// <param name="viewProjectionViewportMatrix">その視点のビュー射影ビューポート行列</param>
+/// <param name="rect">その視点の矩形</param>
+void LineBatcher::AddOccluder(const SphereShape& sphere, uint32_t color, const Vec3f& cameraPosition, const Matrix4x4& viewProjectionViewportMatrix,
+	const HiZBuffer::Rect& rect) {
+
+	Occluder occluder;
+	if (!HiZBuffer::ProjectSphere(sphere, cameraPosition, viewProjectionViewportMatrix, occluder.disc)) {
+		return;
+	}
+
+	occluder.rect = rect;
+	occluder.color = color;
+	occluders_.push_back(occluder);
+	hiZBuffer_.AddDisc(occluder.disc, rect);
+}
+
+/// <summary>
+/// 並べ替え、破棄、結合
+/// 渡された順を保つ時は色と深度で並べ直さず、続けて渡された線だけを結合する
+/// 描画した線が何番目に渡された線かはデバッグビルドでだけ記録する
+/// </summary>
+void LineBatcher::Resolve() {
+
+	stats_ = {};
+	stats_.submittedCount = static_cast<uint32_t>(lines_.size());
+	AddCounter(Counter::kLinesSubmitted, lines_.size());
+
+	const bool kIsSubmitOrderKept = order_ != Order::kSorted;
+
+	emittedLines_.clear();
+#ifdef _DEBUG
+	emittedSourceIndices_.clear();
+#endif
+
+	if (isOcclusionCulled_) {
+		hiZBuffer_.Build();
+	}
+
+	// 1ピクセル未満の線と、遮蔽物に隠れる線を捨てる
+	for (uint32_t lineIndex = 0; lineIndex < lines_.size(); ++lineIndex) {
+
+		const ScreenLine& line = lines_[lineIndex];
+
+		if (isOptimized_) {
+			float dx = line.end.x - line.start.x;
+			float dy = line.end.y - line.start.y;
+			if (dx * dx + dy * dy < 1.0f) {
+				++stats_.culledCount;
+				continue;
+			}
+		}
+
+		if (isOcclusionCulled_ && hiZBuffer_.IsOccluded(line)) {
+			++stats_.occludedCount;
+			continue;
+		}
+
+		emittedLines_.push_back(line);
+#ifdef _DEBUG
+		if (kIsSubmitOrderKept) {
+			emittedSourceIndices_.push_back(lineIndex);
+		}
+#endif
+	}
+
+	if (isOptimized_) {
+
+		// 色ごとにまとめる、同じ色の中では投入順を保つ
+		if (!kIsSubmitOrderKept) {
+			std::stable_sort(emittedLines_.begin(), emittedLines_.end(),
+				[](const ScreenLine& a, const ScreenLine& b) { return a.color < b.color; });
+		}
+
+		// 続いている線を前の線に吸収する
+		size_t writeIndex = 0;
+		for (size_t readIndex = 0; readIndex < emittedLines_.size(); ++readIndex) {
+
+			if (writeIndex > 0 && CanMerge(emittedLines_[writeIndex - 1], emittedLines_[readIndex])) {
+				emittedLines_[writeIndex - 1].end = emittedLines_[readIndex].end;
+				++stats_.mergedCount;
+				continue;
+			}
+
+#ifdef _DEBUG
+			if (kIsSubmitOrderKept) {
+				emittedSourceIndices_[writeIndex] = emittedSourceIndices_[readIndex];
+			}
+#endif
+			emittedLines_[writeIndex++] = emittedLines_[readIndex];
+		}
+		emittedLines_.resize(writeIndex);
+#ifdef _DEBUG
+		if (kIsSubmitOrderKept) {
+			emittedSourceIndices_.resize(writeIndex);
+		}
+#endif
+	}
+
+	if (!kIsSubmitOrderKept && isDepthSorted_) {
+		SortByDepth();
+	}
+
+	stats_.emittedCount = static_cast<uint32_t>(emittedLines_.size());
+}
+
+/// <summary>
+/// 手前から奥の順に並べる
+/// 深度を段階に分けて振り分けるので、同じ段階の中では色順(結合済みの順)を保つ
+/// </summary>
+void LineBatcher::SortByDepth() {
+
+	// 範囲外(クリップされる線)は両端の段階に入れる
+	auto bucketOf = [](const ScreenLine& line) {
+		float depth = NearestDepth(line);
+		if (!(depth > 0.0f)) {
+			return 0u;
+		}
+		return static_cast<uint32_t>((std::min)(depth, 1.0f) * static_cast<float>(kDepthBucketCount - 1));
+		};
+
+	std::array<uint32_t, kDepthBucketCount + 1> offsets{};
+	for (const ScreenLine& line : emittedLines_) {
+		++offsets[bucketOf(line) + 1];
+	}
+	for (uint32_t i = 0; i < kDepthBucketCount; ++i) {
+		offsets[i + 1] += offsets[i];
+	}
+
+	sortBuffer_.resize(emittedLines_.size());
+	for (const ScreenLine& line : emittedLines_) {
+		sortBuffer_[offsets[bucketOf(line)]++] = line;
+	}
+
+	emittedLines_.swap(sortBuffer_);
+}
+
+/// <summary>
+/// 溜めた線を描画して空にする
+/// </summary>
+void LineBatcher::Flush() {
+
+	Resolve();
+
+	// 遮蔽物は奥から描く
+	std::sort(occluders_.begin(), occluders_.end(),
+		[](const Occluder& a, const Occluder& b) { return CenterDepth(a.disc) > CenterDepth(b.disc); });
+
+	// 矩形からはみ出す円は切り取って三角形で塗る
+	auto drawOccluder = [](const Occluder& occluder) {
+		const HiZBuffer::Disc& disc = occluder.disc;
+		const HiZBuffer::Rect& rect = occluder.rect;
+		if (disc.center.x - disc.radius < rect.left || disc.center.x + disc.radius > rect.left + rect.width ||
+			disc.center.y - disc.radius < rect.top || disc.center.y + disc.radius > rect.top + rect.height) {
+			DrawClippedDisc(disc, rect, occluder.color);
+			return;
+		}
+		int radius = static_cast<int>(disc.radius);
+		Novice::DrawEllipse(
+			static_cast<int>(disc.center.x), static_cast<int>(disc.center.y),
+			radius, radius, 0.0f, occluder.color, kFillModeSolid
+		);
+		};
+
+	// Noviceは深度を見ないので、奥から描いて手前の線で上書きする
+	// 手前から奥の順に並んでいない時は遮蔽物を先に全部描く
+	const bool kIsBackToFront = order_ == Order::kSorted ? isDepthSorted_ : order_ == Order::kFrontToBack;
+
+	size_t occluderIndex = 0;
+	const size_t lineCount = emittedLines_.size();
+	for (size_t i = 0; i < lineCount; ++i) {
+
+		const ScreenLine& line = kIsBackToFront ? emittedLines_[lineCount - 1 - i] : emittedLines_[i];
+
+		while (occluderIndex < occluders_.size() &&
+			(!kIsBackToFront || NearestDepth(line) < CenterDepth(occluders_[occluderIndex].disc))) {
+			drawOccluder(occluders_[occluderIndex++]);
+		}
+
+		Novice::DrawLine(
+			static_cast<int>(line.start.x), static_cast<int>(line.start.y),
+			static_cast<int>(line.end.x), static_cast<int>(line.end.y),
+			line.color
+		);
+	}
+
+	for (; occluderIndex < occluders_.size(); ++occluderIndex) {
+		drawOccluder(occluders_[occluderIndex]);
+	}
+
+	lines_.clear();
+	occluders_.clear();
+	hiZBuffer_.Clear();
+}
+
+/// <summary>
+/// 統計をImGuiで描画
+/// </summary>
+void LineBatcher::DrawImGui() {
+
+	ImGui::Begin("LineBatcher");
+
+	const char* kOrderNames[] = { "sorted", "submitted (front to back)", "submitted" };
+	ImGui::Text("order %s", kOrderNames[static_cast<uint32_t>(order_)]);
+	ImGui::Checkbox("optimize", &isOptimized_);
+	ImGui::Checkbox("depthSort", &isDepthSorted_);
+	ImGui::Checkbox("occlusion", &isOcclusionCulled_);
+	ImGui::Text("submitted %u", stats_.submittedCount);
+	ImGui::Text("culled    %u", stats_.culledCount);
+	ImGui::Text("occluded  %u", stats_.occludedCount);
+	ImGui::Text("merged    %u", stats_.mergedCount);
+	ImGui::Text("emitted   %u", stats_.emittedCount);
+
+	ImGui::End();
+}
@@ -0,0 +1,147 @@
+﻿#pragma once
+#include <vector>
+#include "MyMath.h"
+#include "ScreenLine.h"
+#include "PackedLine.h"
+#include "HiZBuffer.h"
+
+/// <summary>
+/// 線の一括描画クラス
+/// 1フレーム分の線を溜めておき、色ごとに並べ替えて短い線の破棄と一直線に繋がる線の結合をしてから描画する
+/// 線は深度を持ち、手前から奥の順に並べる(Noviceには奥から描く)
+/// RenderQueueで並べた順に線を渡す時は、色と深度で並べ直さずに渡された順を保つ(SetOrder)
+/// 不透明な球を遮蔽物として登録すると、その奥に完全に隠れる線は描かない
+/// </summary>
+class LineBatcher {
+public:
+	/// <summary>
+	/// 型定義
+	/// </summary>
+
+	// 線の並べ方
+	enum class Order : uint32_t {
+
+		kSorted,      // 色ごとにまとめてから深度で並べ直す
+		kFrontToBack, // 渡された順を保つ、渡す順は手前から奥(奥から描く)
+		kSubmitted,   // 渡された順を保ち、その順に描く
+	};
+
+	/// <summary>
+	/// 1フレームの統計
+	/// </summary>
+	struct Stats {
+
+		uint32_t submittedCount; // 投入された線の数
+		uint32_t culledCount;    // 1ピクセル未満で破棄した数
+		uint32_t occludedCount;  // 遮蔽物に隠れて破棄した数
+		uint32_t mergedCount;    // 結合で減った数
+		uint32_t emittedCount;   // 実際に描画した数
+	};
+
+private:
+	/// <summary>
+	/// 型定義
+	/// </summary>
+
+	// 遮蔽物として描く球
+	struct Occluder {
+
+		HiZBuffer::Disc disc;
+		HiZBuffer::Rect rect; // 描く範囲(分割表示の視点の矩形)
+		uint32_t color;
+	};
+
+	/// <summary>
+	/// メンバ変数
+	/// </summary>
+
+	// 深度で振り分ける段階の数
+	static const uint32_t kDepthBucketCount = 256;
+
+	std::vector<ScreenLine> lines_;
+	// BeginCaptureの間は追加した線をここに溜める
+	std::vector<ScreenLine>* captureLines_ = nullptr;
+	std::vector<ScreenLine> emittedLines_;
+#ifdef _DEBUG
+	// 渡された順を保つ時の、emittedLines_のそれぞれが何番目に渡された線か(RenderQueueの順番の確認用)
+	std::vector<uint32_t> emittedSourceIndices_;
+#endif
+	std::vector<ScreenLine> sortBuffer_;
+
+	uint32_t width_ = 0;
+	uint32_t height_ = 0;
+
+	std::vector<Occluder> occluders_;
+	HiZBuffer hiZBuffer_;
+
+	Stats stats_{};
+
+	// 破棄と結合を有効にするか
+	bool isOptimized_ = true;
+	// 線の並べ方
+	Order order_ = Order::kSorted;
+	// 手前から奥へ並べるか(kSortedの時だけ)
+	bool isDepthSorted_ = true;
+	// 遮蔽物に隠れる線を捨てるか
+	bool isOcclusionCulled_ = true;
+
+	// 並べ替え、破棄、結合をしてemittedLines_を作る
+	void Resolve();
+	// emittedLines_を手前から奥の順に並べる
+	void SortByDepth();
+	// 線を溜める先
+	std::vector<ScreenLine>& GetTargetLines() { return captureLines_ ? *captureLines_ : lines_; }
+
+public:
+	/// <summary>
+	/// メンバ関数
+	/// </summary>
+
+	// コンストラクタ
+	LineBatcher() {}
+	// デストラクタ
+	~LineBatcher() {}
+
+	// 初期化
+	void Init(uint32_t width, uint32_t height);
+	// 線の追加
+	void AddLine(const Vec3f& start, const Vec3f& end, uint32_t color);
+	// スクリーン座標の線をまとめて追加
+	void AddLines(const std::vector<ScreenLine>& lines);
+	// 詰めた線を戻してまとめて追加
+	void AddPackedLines(const std::vector<PackedLine>& lines, const LinePalette& palette);
+	// 追加する線をoutLinesに溜めるようにする(描画せずに線を受け取る、ScreenLineCache用)
+	void BeginCapture(std::vector<ScreenLine>& outLines) { captureLines_ = &outLines; }
+	// 追加する線をこのフレームの線に戻す
+	void EndCapture() { captureLines_ = nullptr; }
+	// 不透明な球の追加
+	void AddOccluder(const SphereShape& sphere, uint32_t color, const Vec3f& cameraPosition, const Matrix4x4& viewProjectionViewportMatrix);
+	// 不透明な球を分割表示の1つの視点に追加、その視点のカメラで投影し、矩形の外は隠さず描かない
+	void AddOccluder(const SphereShape& sphere, uint32_t color, const Vec3f& cameraPosition, const Matrix4x4& viewProjectionViewportMatrix,
+		const HiZBuffer::Rect& rect);
+	// 溜めた線を描画して空にする
+	void Flush();
+	// 統計をImGuiで描画
+	void DrawImGui();
+
+	/// <summary>
+	/// ゲッター
+	/// </summary>
+	/// <returns></returns>
+	const Stats& GetStats() const { return stats_; }
+	uint32_t GetWidth() const { return width_; }
+	uint32_t GetHeight() const { return height_; }
+	const std::vector<ScreenLine>& GetEmittedLines() const { return emittedLines_; }
+	// このフレームに渡された線の数
+	uint32_t GetSubmittedCount() const { return static_cast<uint32_t>(lines_.size()); }
+#ifdef _DEBUG
+	// 描画した線がそれぞれ何番目に渡された線か(kSortedの時は空)
+	const std::vector<uint32_t>& GetEmittedSourceIndices() const { return emittedSourceIndices_; }
+#endif
+	Order GetOrder() const { return order_; }
+
+	/// <summary>
+	/// セッター
+	/// </summary>
+	void SetOrder(Order order) { order_ = order; }
+};
@@ -0,0 +1,213 @@
+﻿#include "MultiViewRenderer.h"
+#include <ImGui.h>
+#include <algorithm>
+#include <chrono>
+
+/// <summary>
+/// 線を矩形で切り取る(Liang-Barsky)
+/// 深度はスクリーン上の位置に合わせて線形に補間する
+/// </summary>
+/// <param name="line"></param>
+/// <param name="rect"></param>
+/// <returns>矩形の中に残る部分があるか</returns>
+bool MultiViewRenderer::ClipLine(ScreenLine& line, const ViewRect& rect) {
+
+	const float dx = line.end.x - line.start.x;
+	const float dy = line.end.y - line.start.y;
+
+	// 矩形の4辺について、線が内側へ入る側と出る側の媒介変数を絞り込む
+	const float p[4] = { -dx, dx, -dy, dy };
+	const float q[4] = {
+		line.start.x - rect.left, rect.left + rect.width - line.start.x,
+		line.start.y - rect.top, rect.top + rect.height - line.start.y };
+
+	float tEnter = 0.0f;
+	float tExit = 1.0f;
+	for (int i = 0; i < 4; ++i) {
+
+		if (p[i] == 0.0f) {
+			// 辺と平行で外側にある
+			if (q[i] < 0.0f) {
+				return false;
+			}
+			continue;
+		}
+
+		float t = q[i] / p[i];
+		if (p[i] < 0.0f) {
+			tEnter = (std::max)(tEnter, t);
+		} else {
+			tExit = (std::min)(tExit, t);
+		}
+	}
+
+	// NaNもここで捨てる
+	if (!(tEnter <= tExit)) {
+		return false;
+	}
+
+	Vec3f start = line.start;
+	Vec3f diff = line.end - line.start;
+	line.start = start + diff * tEnter;
+	line.end = start + diff * tExit;
+
+	return true;
+}
+
+/// <summary>
+/// 視点を全て消して統計を空にする
+/// </summary>
+void MultiViewRenderer::Clear() {
+
+	matrices_.clear();
+	rects_.clear();
+	stats_ = {};
+}
+
+/// <summary>
+/// 視点の追加
+/// </summary>
+/// <param name="viewProjectionViewportMatrix">ビューポートを矩形に合わせたビュー x 射影 x ビューポート行列</param>
+/// <param name="rect"></param>
+void MultiViewRenderer::AddView(const Matrix4x4& viewProjectionViewportMatrix, const ViewRect& rect) {
+
+	matrices_.push_back(viewProjectionViewportMatrix);
+	rects_.push_back(rect);
+	stats_.viewCount = static_cast<uint32_t>(matrices_.size());
+}
+
+/// <summary>
+/// 線を矩形で切り取ってLineBatcherに渡す
+/// </summary>
+/// <param name="line"></param>
+/// <param name="rect"></param>
+/// <param name="lineBatcher"></param>
+void MultiViewRenderer::EmitLine(ScreenLine line, const ViewRect& rect, LineBatcher& lineBatcher) {
+
+	const float right = rect.left + rect.width;
+	const float bottom = rect.top + rect.height;
+
+	// 両端が中にある線はそのまま渡す
+	bool isInside =
+		line.start.x >= rect.left && line.start.x <= right && line.start.y >= rect.top && line.start.y <= bottom &&
+		line.end.x >= rect.left && line.end.x <= right && line.end.y >= rect.top && line.end.y <= bottom;
+
+	if (!isInside) {
+
+		// 両端が同じ辺の外側にある線は割り算をせずに捨てる
+		bool isOutside =
+			(line.start.x < rect.left && line.end.x < rect.left) || (line.start.x > right && line.end.x > right) ||
+			(line.start.y < rect.top && line.end.y < rect.top) || (line.start.y > bottom && line.end.y > bottom);
+
+		if (isOutside || !ClipLine(line, rect)) {
+			++stats_.culledCount;
+			return;
+		}
+		++stats_.clippedCount;
+	}
+
+	lineBatcher.AddLine(line.start, line.end, line.color);
+	++stats_.emittedCount;
+}
+
+/// <summary>
+/// ワールド座標の線を全ての視点で描く
+/// 視点ごとに全ての端点を変換してから切り取ると、変換した座標を視点の数だけメモリに書いて読み直すので、
+/// 端点をkBlockVertexCountずつに分け、塊ごとに全ての視点で変換し、L1にあるうちに切り取る
+/// 線は塊ごとに視点を順に回って渡すので、視点をまたいだ渡す順は塊単位になる(視点の矩形は重ならない)
+/// </summary>
+/// <param name="lines"></param>
+/// <param name="lineBatcher"></param>
+void MultiViewRenderer::Draw(const WorldLines& lines, LineBatcher& lineBatcher) {
+
+	if (lines.Size() == 0 || matrices_.empty()) {
+		return;
+	}
+
+	auto start = std::chrono::steady_clock::now();
+
+	const size_t vertexCount = lines.positions.Size();
+	for (size_t begin = 0; begin < vertexCount; begin += kBlockVertexCount) {
+
+		const size_t end = (std::min)(begin + kBlockVertexCount, vertexCount);
+		const size_t firstLine = begin / 2;
+		const size_t blockLineCount = (end - begin) / 2;
+
+		for (size_t viewIndex = 0; viewIndex < matrices_.size(); ++viewIndex) {
+
+			TransformBatchRange(lines.positions, begin, end, matrices_[viewIndex], blockPositions_);
+
+			const ViewRect& rect = rects_[viewIndex];
+			for (size_t i = 0; i < blockLineCount; ++i) {
+				EmitLine({
+					{ blockPositions_.x[i * 2], blockPositions_.y[i * 2], blockPositions_.z[i * 2] },
+					{ blockPositions_.x[i * 2 + 1], blockPositions_.y[i * 2 + 1], blockPositions_.z[i * 2 + 1] },
+					lines.colors[firstLine + i] }, rect, lineBatcher);
+			}
+		}
+	}
+
+	stats_.worldLineCount += static_cast<uint32_t>(lines.Size());
+	stats_.milliseconds += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+/// <summary>
+/// スクリーン座標の線を1つの視点の矩形で切り取って描く
+/// </summary>
+/// <param name="lines"></param>
+/// <param name="viewIndex"></param>
+/// <param name="lineBatcher"></param>
+void MultiViewRenderer::DrawScreenLines(const std::vector<ScreenLine>& lines, size_t viewIndex, LineBatcher& lineBatcher) {
+
+	const ViewRect& rect = rects_[viewIndex];
+	for (const ScreenLine& line : lines) {
+		EmitLine(line, rect, lineBatcher);
+	}
+}
+
+/// <summary>
+/// 詰めた線を戻して1つの視点の矩形で切り取って描く
+/// </summary>
+/// <param name="lines"></param>
+/// <param name="palette"></param>
+/// <param name="viewIndex"></param>
+/// <param name="lineBatcher"></param>
+void MultiViewRenderer::DrawPackedLines(const std::vector<PackedLine>& lines, const LinePalette& palette, size_t viewIndex, LineBatcher& lineBatcher) {
+
+	const ViewRect& rect = rects_[viewIndex];
+	for (const PackedLine& line : lines) {
+		EmitLine(UnpackLine(line, palette), rect, lineBatcher);
+	}
+}
+
+/// <summary>
+/// 視点の枠を描く(一番手前の深度)
+/// </summary>
+/// <param name="lineBatcher"></param>
+void MultiViewRenderer::DrawBorders(LineBatcher& lineBatcher) {
+
+	for (const ViewRect& rect : rects_) {
+
+		Vec3f corners[4] = {
+			{ rect.left, rect.top, 0.0f }, { rect.left + rect.width, rect.top, 0.0f },
+			{ rect.left + rect.width, rect.top + rect.height, 0.0f }, { rect.left, rect.top + rect.height, 0.0f } };
+
+		for (int i = 0; i < 4; ++i) {
+			lineBatcher.AddLine(corners[i], corners[(i + 1) % 4], kBorderColor);
+		}
+	}
+}
+
+/// <summary>
+/// 統計をImGuiで描画
+/// </summary>
+void MultiViewRenderer::DrawImGui() {
+
+	ImGui::Begin("MultiView");
+
+	ImGui::Text("views %u  world lines %u", stats_.viewCount, stats_.worldLineCount);
+	ImGui::Text("emitted %u  clipped %u  culled %u", stats_.emittedCount, stats_.clippedCount, stats_.culledCount);
+	ImGui::Text("transform + clip %.3f ms", stats_.milliseconds);
+
+	ImGui::End();
+}
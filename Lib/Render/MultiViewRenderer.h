@@ -0,0 +1,98 @@
+﻿#pragma once
+#include <stdint.h>
+#include <vector>
+#include "MyMath.h"
+#include "MyMathBatch.h"
+#include "ScreenLine.h"
+#include "PackedLine.h"
+#include "WorldLines.h"
+#include "LineBatcher.h"
+
+/// <summary>
+/// 複数の視点で同じワールド座標の線を描くクラス
+/// 形は1フレームに1回だけワールド座標で作り、端点をL1に収まる塊に分けて、塊ごとに全ての視点で
+/// 座標変換(TransformBatchRange)とビューポートの矩形での切り取りを行ってからLineBatcherに渡す
+/// 視点ごとに掛かるのは座標変換と切り取りだけで、形は作り直さず、変換した座標もメモリに書き出さない
+/// </summary>
+class MultiViewRenderer {
+public:
+	/// <summary>
+	/// 型定義
+	/// </summary>
+
+	// 画面上の描画先の矩形(ピクセル)
+	struct ViewRect {
+
+		float left;
+		float top;
+		float width;
+		float height;
+	};
+
+	// 1フレームの統計
+	struct Stats {
+
+		uint32_t viewCount;
+		uint32_t worldLineCount;      // ワールド座標の線の数(視点の数に関わらず1回だけ作る)
+		uint32_t emittedCount;        // 全ての視点でLineBatcherに渡した数
+		uint32_t clippedCount;        // 矩形の端で切った数
+		uint32_t culledCount;         // 矩形の外で捨てた数
+		double milliseconds;          // 全ての視点の座標変換と切り取りに掛かった時間
+	};
+
+private:
+	/// <summary>
+	/// メンバ変数
+	/// </summary>
+
+	// 視点の枠の色
+	static const uint32_t kBorderColor = 0x808080ff;
+	// 1度に変換する端点の数(x、y、zの3配列分の12KBがL1に収まる数、線が塊をまたがないように偶数)
+	static const size_t kBlockVertexCount = 1024;
+
+	std::vector<Matrix4x4> matrices_;
+	std::vector<ViewRect> rects_;
+
+	// 1つの塊の端点のスクリーン座標(フレームをまたいで使い回す)
+	Vec3fSoA blockPositions_;
+
+	Stats stats_{};
+
+	// 線を矩形で切り取ってLineBatcherに渡す
+	void EmitLine(ScreenLine line, const ViewRect& rect, LineBatcher& lineBatcher);
+
+public:
+	/// <summary>
+	/// メンバ関数
+	/// </summary>
+
+	// コンストラクタ
+	MultiViewRenderer() {}
+	// デストラクタ
+	~MultiViewRenderer() {}
+
+	// 線を矩形で切り取る、全て外ならfalse
+	static bool ClipLine(ScreenLine& line, const ViewRect& rect);
+
+	// 視点を全て消して統計を空にする(フレームの開始)
+	void Clear();
+	// 視点の追加
+	void AddView(const Matrix4x4& viewProjectionViewportMatrix, const ViewRect& rect);
+	// ワールド座標の線を全ての視点で描く
+	void Draw(const WorldLines& lines, LineBatcher& lineBatcher);
+	// スクリーン座標の線を1つの視点の矩形で切り取って描く(その視点だけで作った線用)
+	void DrawScreenLines(const std::vector<ScreenLine>& lines, size_t viewIndex, LineBatcher& lineBatcher);
+	// 詰めた線を戻して1つの視点の矩形で切り取って描く
+	void DrawPackedLines(const std::vector<PackedLine>& lines, const LinePalette& palette, size_t viewIndex, LineBatcher& lineBatcher);
+	// 視点の枠を描く
+	void DrawBorders(LineBatcher& lineBatcher);
+	// 統計をImGuiで描画
+	void DrawImGui();
+
+	/// <summary>
+	/// ゲッター
+	/// </summary>
+	/// <returns></returns>
+	size_t GetViewCount() const { return matrices_.size(); }
+	const Stats& GetStats() const { return stats_; }
+};
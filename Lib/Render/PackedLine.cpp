@@ -0,0 +1,305 @@
+﻿#include "PackedLine.h"
+#include "MyMathSSE.h"
+#include "Counters.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+	using namespace MathSSE;
+
+	// UnpackLinesは1本を12バイト目から重ねて2回書く
+	static_assert(sizeof(ScreenLine) == 28, "ScreenLine must be 28 bytes");
+
+	// 深度を符号付きの16ビットに詰めるためにずらす量
+	const float kDepthBias = 32768.0f;
+
+	// 最も近い整数へ丸める(_mm_cvtps_epi32と同じ丸め)
+	int32_t RoundToInt(float value) {
+		return _mm_cvtss_si32(_mm_set_ss(value));
+	}
+
+	int16_t QuantizeCoord(float value) {
+		float clamped = std::clamp(value, PackedLine::kMinCoord, PackedLine::kMaxCoord);
+		return static_cast<int16_t>(RoundToInt(clamped * PackedLine::kCoordScale));
+	}
+
+	uint16_t QuantizeDepth(float value) {
+		float clamped = std::clamp(value, 0.0f, 1.0f);
+		return static_cast<uint16_t>(RoundToInt(clamped * PackedLine::kDepthScale - kDepthBias) + 32768);
+	}
+
+	/// <summary>
+	/// 線分のうち、境界の内側に残る範囲を狭める(Liang-Barsky)
+	/// </summary>
+	/// <param name="p">境界の法線方向の変化量(符号を反転したもの)</param>
+	/// <param name="q">始点から境界までの距離</param>
+	/// <returns>全て外側ならfalse</returns>
+	bool ClipEdge(float p, float q, float& t0, float& t1) {
+
+		if (p == 0.0f) {
+			return q >= 0.0f;
+		}
+
+		float r = q / p;
+		if (p < 0.0f) {
+			if (r > t1) {
+				return false;
+			}
+			t0 = (std::max)(t0, r);
+		} else {
+			if (r < t0) {
+				return false;
+			}
+			t1 = (std::min)(t1, r);
+		}
+		return true;
+	}
+
+	// 4要素の座標が表せる範囲内か(NaNは範囲外)
+	__m128 IsCoordInRange(__m128 v) {
+		return _mm_and_ps(
+			_mm_cmpge_ps(v, _mm_set1_ps(PackedLine::kMinCoord)),
+			_mm_cmple_ps(v, _mm_set1_ps(PackedLine::kMaxCoord)));
+	}
+
+	// 4要素が有限か(∞とNaNは差が0にならない)
+	__m128 IsFinite(__m128 v) {
+		return _mm_cmpeq_ps(_mm_sub_ps(v, v), _mm_setzero_ps());
+	}
+}
+
+/// <summary>
+/// 色の登録
+/// 色の数は少ないので線形に探す
+/// </summary>
+/// <param name="color"></param>
+/// <returns>登録済みならその番号、一杯の時は0番</returns>
+uint16_t LinePalette::Register(uint32_t color) {
+
+	for (size_t i = 0; i < colors_.size(); ++i) {
+		if (colors_[i] == color) {
+			return static_cast<uint16_t>(i);
+		}
+	}
+
+	if (colors_.size() >= kMaxColorCount) {
+		return 0;
+	}
+
+	colors_.push_back(color);
+	return static_cast<uint16_t>(colors_.size() - 1);
+}
+
+/// <summary>
+/// スクリーン座標の線を1本詰める
+/// 座標の範囲をはみ出す線は範囲の矩形で切り取る、深度は画面上で線形に補間する
+/// </summary>
+/// <param name="start"></param>
+/// <param name="end"></param>
+/// <param name="paletteIndex"></param>
+/// <param name="outLine"></param>
+/// <returns>座標が有限でないか、範囲の外にある線ならfalse</returns>
+bool PackLine(const Vec3f& start, const Vec3f& end, uint16_t paletteIndex, PackedLine& outLine) {
+
+	if (!std::isfinite(start.x) || !std::isfinite(start.y) || !std::isfinite(start.z) ||
+		!std::isfinite(end.x) || !std::isfinite(end.y) || !std::isfinite(end.z)) {
+		return false;
+	}
+
+	Vec3f diff = end - start;
+	float t0 = 0.0f;
+	float t1 = 1.0f;
+	if (!ClipEdge(-diff.x, start.x - PackedLine::kMinCoord, t0, t1) ||
+		!ClipEdge(diff.x, PackedLine::kMaxCoord - start.x, t0, t1) ||
+		!ClipEdge(-diff.y, start.y - PackedLine::kMinCoord, t0, t1) ||
+		!ClipEdge(diff.y, PackedLine::kMaxCoord - start.y, t0, t1)) {
+		return false;
+	}
+
+	// 切り取らなかった端点はそのまま使う
+	Vec3f clippedStart = t0 > 0.0f ? start + diff * t0 : start;
+	Vec3f clippedEnd = t1 < 1.0f ? start + diff * t1 : end;
+
+	outLine.startX = QuantizeCoord(clippedStart.x);
+	outLine.startY = QuantizeCoord(clippedStart.y);
+	outLine.endX = QuantizeCoord(clippedEnd.x);
+	outLine.endY = QuantizeCoord(clippedEnd.y);
+	outLine.startDepth = QuantizeDepth(clippedStart.z);
+	outLine.endDepth = QuantizeDepth(clippedEnd.z);
+	outLine.paletteIndex = paletteIndex;
+	outLine.padding = 0;
+
+	return true;
+}
+
+/// <summary>
+/// 線の始点と終点をまとめて座標変換し、詰めた線にする(SSE2)
+/// 4本ずつ座標変換と量子化をして、16ビットに詰め直した4本分を続けて書き込む
+/// 4本の中に範囲をはみ出す線があれば、その4本はPackLineで1本ずつ切り取る
+/// </summary>
+/// <param name="starts"></param>
+/// <param name="ends"></param>
+/// <param name="matrix"></param>
+/// <param name="paletteIndex"></param>
+/// <param name="outLines"></param>
+void PackLinesBatch(const Vec3fSoA& starts, const Vec3fSoA& ends, const Matrix4x4& matrix, uint16_t paletteIndex, std::vector<PackedLine>& outLines) {
+
+	const size_t count = (std::min)(starts.Size(), ends.Size());
+
+	AddCounter(Counter::kVerticesTransformed, count * 2);
+
+	size_t writeIndex = outLines.size();
+	outLines.resize(writeIndex + count);
+	PackedLine* out = outLines.data();
+
+	// 行列の各要素を4要素に広げておく
+	__m128 m[4][4];
+	for (int i = 0; i < 4; i++) {
+		for (int j = 0; j < 4; j++) {
+			m[i][j] = _mm_set1_ps(matrix.m[i][j]);
+		}
+	}
+
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 one = _mm_set1_ps(1.0f);
+	const __m128 coordScale = _mm_set1_ps(PackedLine::kCoordScale);
+	const __m128 depthScale = _mm_set1_ps(PackedLine::kDepthScale);
+	const __m128 depthBias = _mm_set1_ps(kDepthBias);
+	const __m128i depthFlip = _mm_set1_epi16(static_cast<short>(0x8000));
+	const __m128i palette = _mm_set1_epi32(paletteIndex);
+
+	// TransformBatchSSE2と同じ計算
+	auto transform = [&](const Vec3x4& v) {
+		__m128 result[4];
+		for (int j = 0; j < 4; j++) {
+			result[j] = _mm_add_ps(
+				_mm_add_ps(_mm_mul_ps(v.x, m[0][j]), _mm_mul_ps(v.y, m[1][j])),
+				_mm_add_ps(_mm_mul_ps(v.z, m[2][j]), m[3][j]));
+		}
+
+		// wが0の要素は割らない
+		__m128 w = result[3];
+		__m128 invW = Select(_mm_cmpneq_ps(w, zero), _mm_div_ps(one, w), one);
+		return Vec3x4{ _mm_mul_ps(result[0], invW), _mm_mul_ps(result[1], invW), _mm_mul_ps(result[2], invW) };
+		};
+
+	size_t i = 0;
+	for (; i + 4 <= count; i += 4) {
+
+		Vec3x4 start = transform(Load(starts, i));
+		Vec3x4 end = transform(Load(ends, i));
+
+		__m128 isValid = _mm_and_ps(
+			_mm_and_ps(_mm_and_ps(IsCoordInRange(start.x), IsCoordInRange(start.y)), IsFinite(start.z)),
+			_mm_and_ps(_mm_and_ps(IsCoordInRange(end.x), IsCoordInRange(end.y)), IsFinite(end.z)));
+
+		if (_mm_movemask_ps(isValid) != 0xf) {
+
+			alignas(16) float values[6][4];
+			_mm_store_ps(values[0], start.x);
+			_mm_store_ps(values[1], start.y);
+			_mm_store_ps(values[2], start.z);
+			_mm_store_ps(values[3], end.x);
+			_mm_store_ps(values[4], end.y);
+			_mm_store_ps(values[5], end.z);
+
+			for (size_t lane = 0; lane < 4; ++lane) {
+				Vec3f laneStart = { values[0][lane], values[1][lane], values[2][lane] };
+				Vec3f laneEnd = { values[3][lane], values[4][lane], values[5][lane] };
+				if (PackLine(laneStart, laneEnd, paletteIndex, out[writeIndex])) {
+					++writeIndex;
+				}
+			}
+			continue;
+		}
+
+		__m128i startX = _mm_cvtps_epi32(_mm_mul_ps(start.x, coordScale));
+		__m128i startY = _mm_cvtps_epi32(_mm_mul_ps(start.y, coordScale));
+		__m128i endX = _mm_cvtps_epi32(_mm_mul_ps(end.x, coordScale));
+		__m128i endY = _mm_cvtps_epi32(_mm_mul_ps(end.y, coordScale));
+		__m128i startDepth = _mm_cvtps_epi32(_mm_sub_ps(_mm_mul_ps(Clamp01(start.z), depthScale), depthBias));
+		__m128i endDepth = _mm_cvtps_epi32(_mm_sub_ps(_mm_mul_ps(Clamp01(end.z), depthScale), depthBias));
+
+		// 32ビットごとに[始点0 始点1 終点0 終点1]と詰めてから、[始点0 終点0 始点1 終点1]に並べ替える
+		__m128i xy01 = _mm_shuffle_epi32(_mm_packs_epi32(
+			_mm_unpacklo_epi32(startX, startY), _mm_unpacklo_epi32(endX, endY)), _MM_SHUFFLE(3, 1, 2, 0));
+		__m128i xy23 = _mm_shuffle_epi32(_mm_packs_epi32(
+			_mm_unpackhi_epi32(startX, startY), _mm_unpackhi_epi32(endX, endY)), _MM_SHUFFLE(3, 1, 2, 0));
+
+		// 深度は符号付きで詰めてから符号ビットを戻し、線ごとに[始点 終点 色 0]にする
+		__m128i depth = _mm_xor_si128(_mm_packs_epi32(startDepth, endDepth), depthFlip);
+		__m128i depthPairs = _mm_unpacklo_epi16(depth, _mm_srli_si128(depth, 8));
+		__m128i depthPalette01 = _mm_unpacklo_epi32(depthPairs, palette);
+		__m128i depthPalette23 = _mm_unpackhi_epi32(depthPairs, palette);
+
+		__m128i* destination = reinterpret_cast<__m128i*>(out + writeIndex);
+		_mm_storeu_si128(destination + 0, _mm_unpacklo_epi64(xy01, depthPalette01));
+		_mm_storeu_si128(destination + 1, _mm_unpackhi_epi64(xy01, depthPalette01));
+		_mm_storeu_si128(destination + 2, _mm_unpacklo_epi64(xy23, depthPalette23));
+		_mm_storeu_si128(destination + 3, _mm_unpackhi_epi64(xy23, depthPalette23));
+		writeIndex += 4;
+	}
+
+	// 端数
+	for (; i < count; ++i) {
+		Vec3f start = MathT::Transform(starts.Get(i), matrix);
+		Vec3f end = MathT::Transform(ends.Get(i), matrix);
+		if (PackLine(start, end, paletteIndex, out[writeIndex])) {
+			++writeIndex;
+		}
+	}
+
+	outLines.resize(writeIndex);
+}
+
+/// <summary>
+/// 詰めた線をまとめてスクリーン座標の線に戻す(SSE2)
+/// 1本(16バイト)を1回で読み、座標4つと深度2つをそれぞれ4要素でまとめて浮動小数点にする
+/// 28バイトのScreenLineは、12バイト目から重ねた16バイトの書き込み2回で書く
+/// </summary>
+/// <param name="lines"></param>
+/// <param name="count"></param>
+/// <param name="palette"></param>
+/// <param name="outLines">count本分の領域</param>
+void UnpackLines(const PackedLine* lines, size_t count, const LinePalette& palette, ScreenLine* outLines) {
+
+	const __m128 inverseCoordScale = _mm_set1_ps(1.0f / PackedLine::kCoordScale);
+	const __m128 inverseDepthScale = _mm_set1_ps(1.0f / PackedLine::kDepthScale);
+	const __m128i zero = _mm_setzero_si128();
+
+	for (size_t i = 0; i < count; ++i) {
+
+		// [始点x 始点y 終点x 終点y 始点の深度 終点の深度 色の番号 0]
+		__m128i packed = _mm_loadu_si128(reinterpret_cast<const __m128i*>(lines + i));
+
+		// 座標は符号付き、深度は符号無しで32ビットに広げる
+		__m128 coord = _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(packed, packed), 16)), inverseCoordScale);
+		__m128 depth = _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(packed, zero)), inverseDepthScale);
+		uint32_t color = palette.GetColor(static_cast<uint16_t>(_mm_extract_epi16(packed, 6)));
+		__m128 colors = _mm_castsi128_ps(_mm_set1_epi32(static_cast<int>(color)));
+
+		// [始点の深度 終点x 終点の深度 終点y]
+		__m128 mixed = _mm_unpacklo_ps(depth, _mm_movehl_ps(coord, coord));
+		// [始点x 始点y 始点の深度 終点x]
+		__m128 first = _mm_shuffle_ps(coord, mixed, _MM_SHUFFLE(1, 0, 1, 0));
+		// [終点x 終点y 終点の深度 色]
+		__m128 second = _mm_shuffle_ps(mixed, _mm_shuffle_ps(mixed, colors, _MM_SHUFFLE(0, 0, 2, 2)), _MM_SHUFFLE(2, 0, 3, 1));
+
+		float* destination = &outLines[i].start.x;
+		_mm_storeu_ps(destination, first);
+		_mm_storeu_ps(destination + 3, second);
+	}
+}
+
+/// <summary>
+/// 詰めた線をまとめてスクリーン座標の線に戻す
+/// </summary>
+/// <param name="lines"></param>
+/// <param name="palette"></param>
+/// <param name="outLines">中身は置き換える</param>
+void UnpackLines(const std::vector<PackedLine>& lines, const LinePalette& palette, std::vector<ScreenLine>& outLines) {
+
+	outLines.resize(lines.size());
+	UnpackLines(lines.data(), lines.size(), palette, outLines.data());
+}
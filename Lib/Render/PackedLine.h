@@ -0,0 +1,129 @@
+﻿#pragma once
+#include <stdint.h>
+#include <vector>
+#include "MyMath.h"
+#include "MyMathBatch.h"
+#include "ScreenLine.h"
+
+/// <summary>
+/// 詰めたスクリーン座標の線(16バイト、ScreenLineは28バイト)
+/// 座標は小数部3ビットの16ビット固定小数点(-4096から4095.875ピクセル)、深度は0から1を16ビットに割り当てる
+/// 色はLinePaletteの番号で持つ
+/// </summary>
+struct PackedLine {
+
+	// 座標に掛ける倍率(小数部3ビット)と、表せる範囲
+	static constexpr float kCoordScale = 8.0f;
+	static constexpr float kMinCoord = -4096.0f;
+	static constexpr float kMaxCoord = 32767.0f / kCoordScale;
+	// 深度に掛ける倍率
+	static constexpr float kDepthScale = 65535.0f;
+
+	int16_t startX;
+	int16_t startY;
+	int16_t endX;
+	int16_t endY;
+	uint16_t startDepth;
+	uint16_t endDepth;
+	uint16_t paletteIndex;
+	uint16_t padding;
+};
+
+static_assert(sizeof(PackedLine) == 16, "PackedLine must be 16 bytes");
+
+/// <summary>
+/// 線の色の一覧
+/// 描画側とシミュレーション側で共有するので、線を作り始める前に全ての色を登録しておく
+/// </summary>
+class LinePalette {
+public:
+	/// <summary>
+	/// メンバ変数
+	/// </summary>
+
+	// 登録できる色の数(番号が16ビット)
+	static const uint32_t kMaxColorCount = 65536;
+
+private:
+	std::vector<uint32_t> colors_;
+
+public:
+	/// <summary>
+	/// メンバ関数
+	/// </summary>
+
+	// コンストラクタ
+	LinePalette() {}
+	// デストラクタ
+	~LinePalette() {}
+
+	// 色の登録、登録済みならその番号を返す(一杯の時は0番)
+	uint16_t Register(uint32_t color);
+
+	/// <summary>
+	/// ゲッター
+	/// </summary>
+	/// <returns></returns>
+	uint32_t GetColor(uint16_t index) const { return colors_[index]; }
+	size_t GetColorCount() const { return colors_.size(); }
+};
+
+/// <summary>
+/// 線の始点と終点をまとめて座標変換し、詰めた線にしてoutLinesの末尾に足す
+/// 座標の範囲をはみ出す線は範囲の矩形で切り取り、全て外の線と座標が有限でない線は足さない
+/// </summary>
+/// <param name="starts"></param>
+/// <param name="ends"></param>
+/// <param name="matrix">ビュー射影ビューポート行列</param>
+/// <param name="paletteIndex"></param>
+/// <param name="outLines"></param>
+void PackLinesBatch(const Vec3fSoA& starts, const Vec3fSoA& ends, const Matrix4x4& matrix, uint16_t paletteIndex, std::vector<PackedLine>& outLines);
+
+/// <summary>
+/// スクリーン座標の線を1本詰める、足さない線ならfalse
+/// </summary>
+/// <param name="start"></param>
+/// <param name="end"></param>
+/// <param name="paletteIndex"></param>
+/// <param name="outLine"></param>
+/// <returns></returns>
+bool PackLine(const Vec3f& start, const Vec3f& end, uint16_t paletteIndex, PackedLine& outLine);
+
+/// <summary>
+/// 詰めた線をスクリーン座標の線に戻す
+/// 描画側で1本ずつ呼ぶので、ヘッダーに置いて展開させる
+/// </summary>
+/// <param name="line"></param>
+/// <param name="palette"></param>
+/// <returns></returns>
+inline ScreenLine UnpackLine(const PackedLine& line, const LinePalette& palette) {
+
+	const float kInverseCoordScale = 1.0f / PackedLine::kCoordScale;
+	const float kInverseDepthScale = 1.0f / PackedLine::kDepthScale;
+
+	return {
+		{ static_cast<float>(line.startX) * kInverseCoordScale, static_cast<float>(line.startY) * kInverseCoordScale,
+		  static_cast<float>(line.startDepth) * kInverseDepthScale },
+		{ static_cast<float>(line.endX) * kInverseCoordScale, static_cast<float>(line.endY) * kInverseCoordScale,
+		  static_cast<float>(line.endDepth) * kInverseDepthScale },
+		palette.GetColor(line.paletteIndex) };
+}
+
+/// <summary>
+/// 詰めた線をまとめてスクリーン座標の線に戻す(SSE2)
+/// UnpackLineと同じ値になる
+/// </summary>
+/// <param name="lines"></param>
+/// <param name="count"></param>
+/// <param name="palette"></param>
+/// <param name="outLines">count本分の領域</param>
+void UnpackLines(const PackedLine* lines, size_t count, const LinePalette& palette, ScreenLine* outLines);
+
+/// <summary>
+/// 詰めた線をまとめてスクリーン座標の線に戻す
+/// SoftRasterizerはScreenLineしか受け取らないので、詰めた線を描く時はここで戻してから渡す
+/// </summary>
+/// <param name="lines"></param>
+/// <param name="palette"></param>
+/// <param name="outLines">中身は置き換える</param>
+void UnpackLines(const std::vector<PackedLine>& lines, const LinePalette& palette, std::vector<ScreenLine>& outLines);
\ No newline at end of file
@@ -0,0 +1,237 @@
+﻿#include "RenderQueue.h"
+#include <ImGui.h>
+#include <algorithm>
+#include <array>
+#include <chrono>
+
+/// <summary>
+/// フレームの開始
+/// </summary>
+/// <param name="viewMatrix">カメラが持っているビュー行列</param>
+/// <param name="nearClip"></param>
+/// <param name="farClip"></param>
+void RenderQueue::Begin(const Matrix4x4& viewMatrix, float nearClip, float farClip) {
+
+	viewMatrix_ = viewMatrix;
+	nearClip_ = nearClip;
+	farClip_ = farClip;
+
+	centers_.Resize(0);
+	materials_.clear();
+	types_.clear();
+	payloads_.clear();
+	items_.clear();
+#ifdef _DEBUG
+	lineStarts_.clear();
+#endif
+}
+
+/// <summary>
+/// 描画する物を積む
+/// </summary>
+/// <param name="center">深度を測る代表点(ワールド座標)</param>
+/// <param name="material">色の番号</param>
+/// <param name="type"></param>
+/// <param name="payload"></param>
+/// <returns>積めたか(一杯の時はfalse)</returns>
+bool RenderQueue::Add(const Vec3f& center, uint16_t material, PrimitiveType type, uint32_t payload) {
+
+	uint32_t index = static_cast<uint32_t>(items_.size());
+	if (index >= kMaxItemCount) {
+		return false;
+	}
+
+	centers_.x.push_back(center.x);
+	centers_.y.push_back(center.y);
+	centers_.z.push_back(center.z);
+	materials_.push_back(material);
+	types_.push_back(type);
+	payloads_.push_back(payload);
+	items_.push_back(index);
+
+	return true;
+}
+
+/// <summary>
+/// 深度を求めてキーを作る
+/// ビュー空間のzだけを求めればよいので、ビュー行列の3列目との内積にする
+/// 深度はnearからfarを16ビットに量子化し、手前側(カメラの後ろを含む)は0、奥側は最大にまとめる
+/// </summary>
+void RenderQueue::BuildKeys() {
+
+	const size_t count = items_.size();
+	depths_.resize(count);
+
+	const float m0 = viewMatrix_.m[0][2];
+	const float m1 = viewMatrix_.m[1][2];
+	const float m2 = viewMatrix_.m[2][2];
+	const float m3 = viewMatrix_.m[3][2];
+
+	const float* x = centers_.x.data();
+	const float* y = centers_.y.data();
+	const float* z = centers_.z.data();
+	float* depth = depths_.data();
+
+	// ベクトル化しやすいように深度だけを先にまとめて求める
+	for (size_t i = 0; i < count; ++i) {
+		depth[i] = x[i] * m0 + y[i] * m1 + z[i] * m2 + m3;
+	}
+
+	const float scale = static_cast<float>(kDepthLevelCount - 1) / (farClip_ - nearClip_);
+	const float maxLevel = static_cast<float>(kDepthLevelCount - 1);
+
+	for (size_t i = 0; i < count; ++i) {
+
+		// NaNは0にする
+		float level = (depth[i] - nearClip_) * scale;
+		level = level > 0.0f ? (std::min)(level, maxLevel) : 0.0f;
+
+		uint64_t quantizedDepth = static_cast<uint64_t>(level);
+		uint64_t material = materials_[i];
+		uint64_t type = static_cast<uint64_t>(types_[i]);
+
+		uint64_t key = 0;
+		if (sortMode_ == SortMode::kFrontToBack) {
+			key = (quantizedDepth << 48) | (material << 32) | (type << 24);
+		} else {
+			key = (type << 56) | (material << 40) | (quantizedDepth << 24);
+		}
+
+		items_[i] = key | static_cast<uint64_t>(i);
+	}
+}
+
+/// <summary>
+/// キーの上位40ビットで基数ソートする(LSD、1桁8ビット)
+/// 全ての桁の数を1回で数え、全て同じ値の桁は並べ替えを飛ばす
+/// 積んだ順番は下位にあるが並べ替えないので、キーが同じ物は積んだ順のまま(安定)
+/// </summary>
+void RenderQueue::RadixSort() {
+
+	const size_t count = items_.size();
+	constexpr uint32_t kBucketCount = 1u << kRadixBits;
+
+	std::array<std::array<uint32_t, kBucketCount>, kRadixDigitCount> histograms{};
+	for (uint64_t item : items_) {
+		for (uint32_t digit = 0; digit < kRadixDigitCount; ++digit) {
+			++histograms[digit][(item >> ((kFirstRadixDigit + digit) * kRadixBits)) & (kBucketCount - 1)];
+		}
+	}
+
+	sortBuffer_.resize(count);
+	stats_.radixPassCount = 0;
+
+	for (uint32_t digit = 0; digit < kRadixDigitCount; ++digit) {
+
+		const uint32_t shift = (kFirstRadixDigit + digit) * kRadixBits;
+		std::array<uint32_t, kBucketCount>& histogram = histograms[digit];
+
+		// 全て同じ桁の値なら並びは変わらない
+		if (histogram[(items_[0] >> shift) & (kBucketCount - 1)] == count) {
+			continue;
+		}
+
+		uint32_t offset = 0;
+		for (uint32_t& bucket : histogram) {
+			uint32_t bucketCount = bucket;
+			bucket = offset;
+			offset += bucketCount;
+		}
+
+		for (uint64_t item : items_) {
+			sortBuffer_[histogram[(item >> shift) & (kBucketCount - 1)]++] = item;
+		}
+
+		items_.swap(sortBuffer_);
+		++stats_.radixPassCount;
+	}
+}
+
+/// <summary>
+/// 深度を求めて並べ替える
+/// </summary>
+void RenderQueue::Sort() {
+
+	auto start = std::chrono::steady_clock::now();
+
+	stats_.itemCount = static_cast<uint32_t>(items_.size());
+	stats_.radixPassCount = 0;
+	stats_.isLineOrderChecked = false;
+
+	if (!items_.empty()) {
+		BuildKeys();
+		RadixSort();
+	}
+
+	stats_.milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+#ifdef _DEBUG
+/// <summary>
+/// 次の物の線を渡す前に、それまでに渡した線の数を記録する
+/// </summary>
+/// <param name="submittedLineCount">LineBatcherに渡した線の数</param>
+void RenderQueue::MarkLineStart(uint32_t submittedLineCount) {
+
+	lineStarts_.push_back(submittedLineCount);
+}
+
+/// <summary>
+/// 描画した線が並べ替えた物の順になっているか調べる
+/// 線ごとに何番目の物から来たかを求め、前の線より前の物から来た線を数える
+/// LineBatcherが色や深度で並べ直していれば、ここで順番が崩れる
+/// </summary>
+/// <param name="emittedSourceIndices">描画した線がそれぞれ何番目に渡された線か</param>
+void RenderQueue::CheckLineOrder(const std::vector<uint32_t>& emittedSourceIndices) {
+
+	stats_.isLineOrderChecked = !lineStarts_.empty();
+	stats_.checkedLineCount = 0;
+	stats_.outOfOrderLineCount = 0;
+	if (!stats_.isLineOrderChecked) {
+		return;
+	}
+
+	size_t previousOrder = 0;
+	for (uint32_t sourceIndex : emittedSourceIndices) {
+
+		// sourceIndex以下で最後に始まった物
+		size_t order = static_cast<size_t>(std::upper_bound(lineStarts_.begin(), lineStarts_.end(), sourceIndex) - lineStarts_.begin());
+		order = order > 0 ? order - 1 : 0;
+
+		if (order < previousOrder) {
+			++stats_.outOfOrderLineCount;
+		}
+		previousOrder = (std::max)(previousOrder, order);
+		++stats_.checkedLineCount;
+	}
+}
+#endif
+
+/// <summary>
+/// 並べ方と統計をImGuiで描画
+/// </summary>
+void RenderQueue::DrawImGui() {
+
+	ImGui::Begin("RenderQueue");
+
+	int sortMode = static_cast<int>(sortMode_);
+	ImGui::RadioButton("front to back", &sortMode, static_cast<int>(SortMode::kFrontToBack));
+	ImGui::SameLine();
+	ImGui::RadioButton("by material", &sortMode, static_cast<int>(SortMode::kByMaterial));
+	sortMode_ = static_cast<SortMode>(sortMode);
+
+	ImGui::Text("items %u  radix passes %u", stats_.itemCount, stats_.radixPassCount);
+	ImGui::Text("sort %.4f ms", stats_.milliseconds);
+	if (stats_.isLineOrderChecked) {
+		ImGui::Text("line order %s (%u / %u lines out of order)", stats_.outOfOrderLineCount == 0 ? "kept" : "broken",
+			stats_.outOfOrderLineCount, stats_.checkedLineCount);
+	} else {
+		ImGui::Text("line order not checked");
+	}
+
+	for (size_t i = 0; i < items_.size() && i < 16; ++i) {
+		ImGui::Text("%2zu: payload %u  type %u  depth %.2f", i, GetPayload(i), static_cast<uint32_t>(GetType(i)), GetDepth(i));
+	}
+
+	ImGui::End();
+}
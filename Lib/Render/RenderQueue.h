@@ -0,0 +1,133 @@
+﻿#pragma once
+#include <stdint.h>
+#include <vector>
+#include "MyMath.h"
+#include "MyMathBatch.h"
+
+/// <summary>
+/// 1フレーム分の描画する物を並べ替えるキュー
+/// 物ごとに代表点、材質(色の番号)、形の種類を積み、ビュー行列からビュー空間の深度をまとめて求め、
+/// 深度と材質と種類を詰めたキーで基数ソートする
+/// 手前から奥の順(遮蔽の早期判定向け)と、材質ごとの順(同じ色を続けて出す)を選べる
+/// </summary>
+class RenderQueue {
+public:
+	/// <summary>
+	/// 型定義
+	/// </summary>
+
+	// 形の種類
+	enum class PrimitiveType : uint8_t {
+
+		kGrid,
+		kSphere,
+		kSegment,
+		kCurve,
+		kShape,
+		kPackedLines,
+	};
+
+	// 並べ方
+	enum class SortMode : uint32_t {
+
+		kFrontToBack, // 深度 > 材質 > 種類
+		kByMaterial,  // 種類 > 材質 > 深度
+	};
+
+	// 1フレームの統計
+	struct Stats {
+
+		uint32_t itemCount;
+		uint32_t radixPassCount; // 実際に並べ替えた桁の数(全て同じ値の桁は飛ばす)
+		double milliseconds;     // 深度を求めて並べ替えるのに掛かった時間
+		bool isLineOrderChecked;      // このフレームで描画した線の順を調べたか
+		uint32_t checkedLineCount;    // 調べた線の数
+		uint32_t outOfOrderLineCount; // 前の線より前の順番の物から来た線の数
+	};
+
+	/// <summary>
+	/// メンバ変数
+	/// </summary>
+
+	// 1フレームに積める最大の数(キーの下位24ビットに積んだ順番を入れる)
+	static const uint32_t kMaxItemCount = 1u << 24;
+
+private:
+	// 深度を量子化する段階の数
+	static const uint32_t kDepthLevelCount = 65536;
+	// 基数ソートの1桁のビット数と、キーのうち並べ替える桁
+	static const uint32_t kRadixBits = 8;
+	static const uint32_t kFirstRadixDigit = 3;
+	static const uint32_t kRadixDigitCount = 5;
+
+	Matrix4x4 viewMatrix_{};
+	float nearClip_ = 0.1f;
+	float farClip_ = 100.0f;
+
+	// 積んだ順に持つ
+	Vec3fSoA centers_;
+	std::vector<uint16_t> materials_;
+	std::vector<PrimitiveType> types_;
+	std::vector<uint32_t> payloads_;
+	std::vector<float> depths_;
+
+	// 上位40ビットがキー、下位24ビットが積んだ順番
+	std::vector<uint64_t> items_;
+	std::vector<uint64_t> sortBuffer_;
+
+#ifdef _DEBUG
+	// 並べ替えた順番ごとの、その物の線が何本目から渡されたか
+	std::vector<uint32_t> lineStarts_;
+#endif
+
+	SortMode sortMode_ = SortMode::kFrontToBack;
+
+	Stats stats_{};
+
+	// 深度を求めてキーを作る
+	void BuildKeys();
+	// キーの上位40ビットで基数ソートする
+	void RadixSort();
+
+public:
+	/// <summary>
+	/// メンバ関数
+	/// </summary>
+
+	// コンストラクタ
+	RenderQueue() {}
+	// デストラクタ
+	~RenderQueue() {}
+
+	// フレームの開始、積んだ物を空にする
+	void Begin(const Matrix4x4& viewMatrix, float nearClip, float farClip);
+	// 描画する物を積む、payloadは並べ替えた後に描画側が使う番号
+	bool Add(const Vec3f& center, uint16_t material, PrimitiveType type, uint32_t payload);
+	// 深度を求めて並べ替える
+	void Sort();
+#ifdef _DEBUG
+	// 並べ替えた順に線を渡す時、次の物の線を渡す前に呼び、それまでに渡した線の数を記録する
+	void MarkLineStart(uint32_t submittedLineCount);
+	// 描画した線(渡された順番)が並べ替えた物の順になっているか調べる(デバッグビルドだけ)
+	void CheckLineOrder(const std::vector<uint32_t>& emittedSourceIndices);
+#endif
+	// 並べ方と統計をImGuiで描画
+	void DrawImGui();
+
+	/// <summary>
+	/// ゲッター
+	/// </summary>
+	/// <returns></returns>
+	size_t GetCount() const { return items_.size(); }
+	// 並べ替えた後のorder番目の物
+	uint32_t GetPayload(size_t order) const { return payloads_[items_[order] & (kMaxItemCount - 1)]; }
+	PrimitiveType GetType(size_t order) const { return types_[items_[order] & (kMaxItemCount - 1)]; }
+	float GetDepth(size_t order) const { return depths_[items_[order] & (kMaxItemCount - 1)]; }
+	const Stats& GetStats() const { return stats_; }
+	SortMode GetSortMode() const { return sortMode_; }
+
+	/// <summary>
+	/// セッター
+	/// </summary>
+	void SetSortMode(SortMode sortMode) { sortMode_ = sortMode; }
+};
@@ -0,0 +1,130 @@
+﻿#include "RenderResolution.h"
+#include "MyMath.h"
+#include <algorithm>
+#include <cmath>
+
+/// <summary>
+/// 初期化
+/// </summary>
+/// <param name="outputWidth"></param>
+/// <param name="outputHeight"></param>
+void RenderResolution::Init(uint32_t outputWidth, uint32_t outputHeight) {
+
+	renderScale_ = 1.0f;
+	smoothedMilliseconds_ = 0.0f;
+	settleFrameCount_ = 0;
+
+	SetOutputSize(outputWidth, outputHeight);
+}
+
+/// <summary>
+/// 出力の大きさを変える
+/// </summary>
+/// <param name="outputWidth"></param>
+/// <param name="outputHeight"></param>
+void RenderResolution::SetOutputSize(uint32_t outputWidth, uint32_t outputHeight) {
+
+	if (outputWidth == outputWidth_ && outputHeight == outputHeight_) {
+		return;
+	}
+
+	outputWidth_ = (std::max)(outputWidth, 1u);
+	outputHeight_ = (std::max)(outputHeight, 1u);
+	++version_;
+}
+
+/// <summary>
+/// 内部解像度の幅
+/// </summary>
+/// <returns></returns>
+uint32_t RenderResolution::GetRenderWidth() const {
+
+	return (std::max)(static_cast<uint32_t>(std::lround(static_cast<float>(outputWidth_) * renderScale_)), 1u);
+}
+
+/// <summary>
+/// 内部解像度の高さ
+/// </summary>
+/// <returns></returns>
+uint32_t RenderResolution::GetRenderHeight() const {
+
+	return (std::max)(static_cast<uint32_t>(std::lround(static_cast<float>(outputHeight_) * renderScale_)), 1u);
+}
+
+/// <summary>
+/// 倍率を刻みに丸めて設定する
+/// </summary>
+/// <param name="scale"></param>
+void RenderResolution::ApplyScale(float scale) {
+
+	float steppedScale = std::round(scale / kScaleStep) * kScaleStep;
+	steppedScale = std::clamp(steppedScale, minScale_, 1.0f);
+
+	if (steppedScale == renderScale_) {
+		return;
+	}
+
+	renderScale_ = steppedScale;
+	++version_;
+
+	// 新しい倍率で測り直す
+	smoothedMilliseconds_ = 0.0f;
+	settleFrameCount_ = kSettleFrameCount;
+}
+
+/// <summary>
+/// 計測したフレーム時間を渡して、動的解像度なら倍率を調整する
+/// 描画するピクセル数は倍率の2乗に比例するとみなし、予算を超えた分だけ一度に下げる
+/// 上げる時は少しずつにして、上げ下げを繰り返さないようにする
+/// </summary>
+/// <param name="frameMilliseconds"></param>
+void RenderResolution::Update(float frameMilliseconds) {
+
+	if (smoothedMilliseconds_ == 0.0f) {
+		smoothedMilliseconds_ = frameMilliseconds;
+	} else {
+		smoothedMilliseconds_ += (frameMilliseconds - smoothedMilliseconds_) * kSmoothing;
+	}
+
+	if (!isDynamic_ || frameBudgetMilliseconds_ <= 0.0f) {
+		return;
+	}
+
+	if (settleFrameCount_ > 0) {
+		--settleFrameCount_;
+		return;
+	}
+
+	if (smoothedMilliseconds_ > frameBudgetMilliseconds_) {
+
+		// 下げる時は必ず1刻み以上下げる
+		float scale = renderScale_ * std::sqrt(frameBudgetMilliseconds_ / smoothedMilliseconds_);
+		ApplyScale((std::min)(scale, renderScale_ - kScaleStep));
+	} else if (smoothedMilliseconds_ < frameBudgetMilliseconds_ * kRaiseThreshold && renderScale_ < 1.0f) {
+
+		ApplyScale((std::max)(renderScale_ * kRaiseRate, renderScale_ + kScaleStep));
+	}
+}
+
+/// <summary>
+/// 設定をImGuiで描画
+/// </summary>
+/// <param name="name">ウィンドウ名</param>
+void RenderResolution::DrawImGui(const char* name) {
+
+	ImGui::Begin(name);
+
+	float scale = renderScale_;
+	if (ImGui::SliderFloat("renderScale", &scale, minScale_, 1.0f)) {
+		ApplyScale(scale);
+	}
+
+	ImGui::Checkbox("dynamic", &isDynamic_);
+	ImGui::SliderFloat("budget (ms)", &frameBudgetMilliseconds_, 0.5f, 33.0f);
+	ImGui::SliderFloat("minScale", &minScale_, kScaleStep, 1.0f);
+
+	ImGui::Text("output %u x %u  render %u x %u", outputWidth_, outputHeight_, GetRenderWidth(), GetRenderHeight());
+	ImGui::Text("frame %.3f ms (smoothed)", smoothedMilliseconds_);
+
+	ImGui::End();
+}
@@ -0,0 +1,80 @@
+﻿#pragma once
+#include <stdint.h>
+#include "Derived.h"
+
+/// <summary>
+/// 描画解像度の設定
+/// 出力(ウィンドウ)の大きさと描画倍率から内部解像度を決める
+/// 動的解像度を有効にすると、フレーム時間が予算を超えた時に倍率を下げ、余裕がある時に少しずつ戻す
+/// 内部解像度が変わった時だけバージョンが進むので、依存する行列やバッファはその時だけ作り直せばよい
+/// </summary>
+class RenderResolution : public VersionSource {
+private:
+	/// <summary>
+	/// メンバ変数
+	/// </summary>
+
+	// 倍率を変える刻み、細かく変えてバッファを作り直し続けないようにする
+	static constexpr float kScaleStep = 1.0f / 16.0f;
+	// 予算に対してこの割合より速ければ倍率を上げる
+	static constexpr float kRaiseThreshold = 0.75f;
+	// 倍率を上げる時の割合
+	static constexpr float kRaiseRate = 1.1f;
+	// 倍率を変えた後、次に変えるまでに待つフレーム数
+	static const uint32_t kSettleFrameCount = 10;
+	// フレーム時間の平滑化の係数
+	static constexpr float kSmoothing = 0.1f;
+
+	uint32_t outputWidth_ = 0;
+	uint32_t outputHeight_ = 0;
+
+	float renderScale_ = 1.0f;
+	float minScale_ = 0.25f;
+
+	// 動的解像度
+	bool isDynamic_ = false;
+	float frameBudgetMilliseconds_ = 8.0f;
+	float smoothedMilliseconds_ = 0.0f;
+	uint32_t settleFrameCount_ = 0;
+
+	uint64_t version_ = 0;
+
+	// 倍率を刻みに丸めて設定する、変わればバージョンを進める
+	void ApplyScale(float scale);
+
+public:
+	/// <summary>
+	/// メンバ関数
+	/// </summary>
+
+	// コンストラクタ
+	RenderResolution() {}
+	// デストラクタ
+	~RenderResolution() override {}
+
+	// 初期化
+	void Init(uint32_t outputWidth, uint32_t outputHeight);
+	// 計測したフレーム時間を渡して、動的解像度なら倍率を調整する
+	void Update(float frameMilliseconds);
+	// 設定をImGuiで描画
+	void DrawImGui(const char* name);
+
+	/// <summary>
+	/// ゲッター
+	/// </summary>
+	/// <returns></returns>
+	uint32_t GetOutputWidth() const { return outputWidth_; }
+	uint32_t GetOutputHeight() const { return outputHeight_; }
+	uint32_t GetRenderWidth() const;
+	uint32_t GetRenderHeight() const;
+	float GetRenderScale() const { return renderScale_; }
+	uint64_t GetVersion() const override { return version_; }
+
+	/// <summary>
+	/// セッター
+	/// </summary>
+	void SetOutputSize(uint32_t outputWidth, uint32_t outputHeight);
+	void SetRenderScale(float renderScale) { ApplyScale(renderScale); }
+	void SetDynamic(bool isDynamic) { isDynamic_ = isDynamic; }
+	void SetFrameBudget(float frameBudgetMilliseconds) { frameBudgetMilliseconds_ = frameBudgetMilliseconds; }
+};
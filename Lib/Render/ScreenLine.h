@@ -0,0 +1,14 @@
+﻿#pragma once
+#include <stdint.h>
+#include "Vector.h"
+
+/// <summary>
+/// スクリーン座標の線
+/// Novice.hに依存しないので、ヘッドレスのラスタライザからも使える
+/// </summary>
+struct ScreenLine {
+
+	Vec3f start; // 始点(zはビューポート変換後の深度)
+	Vec3f end;   // 終点
+	uint32_t color;
+};
@@ -0,0 +1,123 @@
+﻿#include "ScreenLineCache.h"
+#include "Counters.h"
+#include <ImGui.h>
+#include <chrono>
+
+/// <summary>
+/// 物の登録
+/// </summary>
+/// <param name="name">ImGuiに出す名前</param>
+/// <param name="sources">線が依存する値、カメラも含める</param>
+/// <returns>Submitに渡す番号</returns>
+uint32_t ScreenLineCache::Register(const char* name, std::initializer_list<const VersionSource*> sources) {
+
+	Entry entry{};
+	entry.name = name;
+	entry.sources = sources;
+	entry.seenVersions.assign(sources.size(), 0);
+	entries_.push_back(std::move(entry));
+
+	return static_cast<uint32_t>(entries_.size() - 1);
+}
+
+/// <summary>
+/// フレームの開始
+/// </summary>
+void ScreenLineCache::BeginFrame() {
+
+	stats_ = {};
+	for (Entry& entry : entries_) {
+		entry.isSubmitted = false;
+		entry.isHit = false;
+	}
+}
+
+/// <summary>
+/// 依存先が変わっていればdrawで線を作り直し、線をLineBatcherに渡す
+/// 作り直す時はLineBatcherに追加される線をキャッシュ側で受け取ってから、まとめて渡す
+/// </summary>
+/// <param name="index">Registerの戻り値</param>
+/// <param name="lineBatcher"></param>
+/// <param name="draw"></param>
+void ScreenLineCache::Submit(uint32_t index, LineBatcher& lineBatcher, const DrawFunction& draw) {
+
+	auto start = std::chrono::steady_clock::now();
+
+	Entry& entry = entries_[index];
+	entry.isSubmitted = true;
+
+	// 全ての依存先のバージョンを見て、見た値を覚えておく
+	bool isDirty = !entry.isValid || !isEnabled_;
+	for (size_t i = 0; i < entry.sources.size(); ++i) {
+
+		uint64_t version = entry.sources[i]->GetVersion();
+		if (version != entry.seenVersions[i]) {
+			entry.seenVersions[i] = version;
+			isDirty = true;
+		}
+	}
+
+	if (isDirty) {
+
+		entry.lines.clear();
+		lineBatcher.BeginCapture(entry.lines);
+		draw(lineBatcher);
+		lineBatcher.EndCapture();
+		entry.isValid = true;
+		entry.isHit = false;
+
+		++stats_.missCount;
+		stats_.rebuiltLineCount += static_cast<uint32_t>(entry.lines.size());
+		++totalStats_.missCount;
+		AddCounter(Counter::kLineCacheMisses);
+	} else {
+
+		entry.isHit = true;
+
+		++stats_.hitCount;
+		stats_.reusedLineCount += static_cast<uint32_t>(entry.lines.size());
+		++totalStats_.hitCount;
+		AddCounter(Counter::kLineCacheHits);
+	}
+
+	auto built = std::chrono::steady_clock::now();
+
+	lineBatcher.AddLines(entry.lines);
+
+	auto end = std::chrono::steady_clock::now();
+
+	stats_.buildMilliseconds += std::chrono::duration<double, std::milli>(built - start).count();
+	stats_.submitMilliseconds += std::chrono::duration<double, std::milli>(end - built).count();
+}
+
+/// <summary>
+/// 全ての物を次のSubmitで作り直させる
+/// </summary>
+void ScreenLineCache::Invalidate() {
+
+	for (Entry& entry : entries_) {
+		entry.isValid = false;
+	}
+}
+
+/// <summary>
+/// 統計をImGuiで描画
+/// </summary>
+void ScreenLineCache::DrawImGui() {
+
+	ImGui::Begin("ScreenLineCache");
+
+	ImGui::Checkbox("enabled", &isEnabled_);
+
+	ImGui::Text("hit %u  miss %u", stats_.hitCount, stats_.missCount);
+	ImGui::Text("lines reused %u  rebuilt %u", stats_.reusedLineCount, stats_.rebuiltLineCount);
+	ImGui::Text("build %.4f ms  submit %.4f ms", stats_.buildMilliseconds, stats_.submitMilliseconds);
+	ImGui::Text("total hit rate %.1f%%", totalStats_.GetHitRate() * 100.0f);
+
+	for (const Entry& entry : entries_) {
+		const char* state = !entry.isSubmitted ? "-" : entry.isHit ? "hit" : "miss";
+		ImGui::Text("%-20s %-4s %zu lines", entry.name, state, entry.lines.size());
+	}
+
+	ImGui::End();
+}
@@ -0,0 +1,96 @@
+﻿#pragma once
+#include <stdint.h>
+#include <functional>
+#include <initializer_list>
+#include <vector>
+#include "ScreenLine.h"
+#include "LineBatcher.h"
+#include "Derived.h"
+
+/// <summary>
+/// 物ごとにスクリーン座標の線を前のフレームから使い回すキャッシュ
+/// 物の登録時に依存する値(物自身の形や位置と、カメラ)を渡しておき、どれのバージョンも変わっていなければ
+/// 座標変換をせずに前回作った線をそのままLineBatcherに渡す
+/// 何も動かないフレームでは、線をLineBatcherに渡すだけになる
+/// </summary>
+class ScreenLineCache {
+public:
+	/// <summary>
+	/// 型定義
+	/// </summary>
+
+	// 1フレームの統計
+	struct Stats {
+
+		uint32_t hitCount;         // 線を使い回した物の数
+		uint32_t missCount;        // 線を作り直した物の数
+		uint32_t reusedLineCount;  // 使い回した線の数
+		uint32_t rebuiltLineCount; // 作り直した線の数
+		double buildMilliseconds;  // 作り直すのに掛かった時間
+		double submitMilliseconds; // 使い回した線をLineBatcherに渡すのに掛かった時間
+	};
+
+	// 線を作る関数、渡したLineBatcherに線を追加する
+	using DrawFunction = std::function<void(LineBatcher&)>;
+
+private:
+	// 1つの物のキャッシュ
+	struct Entry {
+
+		const char* name;
+		std::vector<const VersionSource*> sources;
+		// 最後に線を作った時の依存先のバージョン
+		std::vector<uint64_t> seenVersions;
+		std::vector<ScreenLine> lines;
+		bool isValid;
+		bool isSubmitted; // このフレームで渡したか
+		bool isHit;       // このフレームで使い回したか
+	};
+
+	/// <summary>
+	/// メンバ変数
+	/// </summary>
+
+	std::vector<Entry> entries_;
+
+	Stats stats_{};
+	// 起動からの累計
+	DerivedStats totalStats_;
+
+	// 無効にすると毎フレーム作り直す(比較用)
+	bool isEnabled_ = true;
+
+public:
+	/// <summary>
+	/// メンバ関数
+	/// </summary>
+
+	// コンストラクタ
+	ScreenLineCache() {}
+	// デストラクタ
+	~ScreenLineCache() {}
+
+	// 物の登録、戻り値はSubmitに渡す番号
+	uint32_t Register(const char* name, std::initializer_list<const VersionSource*> sources);
+	// フレームの開始、1フレームの統計を空にする
+	void BeginFrame();
+	// 依存先が変わっていればdrawで線を作り直し、線をLineBatcherに渡す
+	void Submit(uint32_t index, LineBatcher& lineBatcher, const DrawFunction& draw);
+	// 全ての物を次のSubmitで作り直させる
+	void Invalidate();
+	// 統計をImGuiで描画
+	void DrawImGui();
+
+	/// <summary>
+	/// ゲッター
+	/// </summary>
+	/// <returns></returns>
+	const Stats& GetStats() const { return stats_; }
+	const DerivedStats& GetTotalStats() const { return totalStats_; }
+	bool IsEnabled() const { return isEnabled_; }
+
+	/// <summary>
+	/// セッター
+	/// </summary>
+	void SetEnabled(bool isEnabled) { isEnabled_ = isEnabled; }
+};
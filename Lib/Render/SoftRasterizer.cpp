@@ -0,0 +1,406 @@
+﻿#include "SoftRasterizer.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <functional>
+#include <thread>
+#include <immintrin.h>
+
+namespace {
+
+	// 画面外へ大きく飛び出した座標を丸める範囲
+	const float kCoordLimit = 1048576.0f;
+
+	/// <summary>
+	/// ピクセル座標へ変換(Novice::DrawLineへ渡す時と同じく切り捨て)
+	/// </summary>
+	int32_t ToPixel(float v) {
+
+		return static_cast<int32_t>(std::clamp(v, -kCoordLimit, kCoordLimit));
+	}
+
+	bool IsFinite(const ScreenLine& line) {
+
+		return std::isfinite(line.start.x) && std::isfinite(line.start.y) && std::isfinite(line.start.z) &&
+			std::isfinite(line.end.x) && std::isfinite(line.end.y) && std::isfinite(line.end.z);
+	}
+
+	/// <summary>
+	/// 0xRRGGBBAAの色の線形補間
+	/// </summary>
+	uint32_t BlendColor(uint32_t dst, uint32_t src, float coverage) {
+
+		uint32_t result = 0;
+		for (uint32_t shift = 0; shift < 32; shift += 8) {
+
+			float d = static_cast<float>((dst >> shift) & 0xff);
+			float s = static_cast<float>((src >> shift) & 0xff);
+			uint32_t c = static_cast<uint32_t>(d + (s - d) * coverage + 0.5f);
+			result |= (std::min)(c, 255u) << shift;
+		}
+
+		return result;
+	}
+
+	/// <summary>
+	/// 主軸方向の連続した4ピクセル分の副軸座標と深度をまとめて求める
+	/// </summary>
+	void ComputeSpan4(int32_t u, int32_t u0, float v0, float slope, float z0, float zSlope, int32_t outV[4], float outZ[4]) {
+
+		__m128 offsets = _mm_add_ps(
+			_mm_set1_ps(static_cast<float>(u - u0)), _mm_set_ps(3.0f, 2.0f, 1.0f, 0.0f));
+
+		// 副軸は最も近い整数へ丸める
+		__m128 v = _mm_add_ps(_mm_set1_ps(v0), _mm_mul_ps(offsets, _mm_set1_ps(slope)));
+		__m128 z = _mm_add_ps(_mm_set1_ps(z0), _mm_mul_ps(offsets, _mm_set1_ps(zSlope)));
+
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(outV), _mm_cvtps_epi32(v));
+		_mm_storeu_ps(outZ, z);
+	}
+}
+
+/// <summary>
+/// 初期化
+/// 解像度を変えるたびに呼ばれるので、スレッドは数が変わる時だけ立て直す
+/// </summary>
+/// <param name="width"></param>
+/// <param name="height"></param>
+/// <param name="threadCount">0ならハードウェアのスレッド数</param>
+void SoftRasterizer::Init(uint32_t width, uint32_t height, uint32_t threadCount) {
+
+	width_ = width;
+	height_ = height;
+	tileCountX_ = (width + kTileSize - 1) / kTileSize;
+	tileCountY_ = (height + kTileSize - 1) / kTileSize;
+
+	if (threadCount == 0) {
+		threadCount = (std::max)(1u, std::thread::hardware_concurrency());
+	}
+	if (workerPool_.GetThreadCount() != threadCount) {
+		workerPool_.Init(threadCount);
+	}
+
+	colorBuffer_.assign(static_cast<size_t>(width) * height, 0);
+	depthBuffer_.assign(static_cast<size_t>(width) * height, 1.0f);
+	tileBins_.assign(static_cast<size_t>(tileCountX_) * tileCountY_, {});
+}
+
+/// <summary>
+/// バッファを塗りつぶす
+/// </summary>
+/// <param name="color"></param>
+/// <param name="depth"></param>
+void SoftRasterizer::Clear(uint32_t color, float depth) {
+
+	std::fill(colorBuffer_.begin(), colorBuffer_.end(), color);
+	std::fill(depthBuffer_.begin(), depthBuffer_.end(), depth);
+}
+
+/// <summary>
+/// 線をタイルに振り分ける
+/// 線の外接矩形が掛かるタイルのうち、線が実際に通るものだけに入れる
+/// </summary>
+/// <param name="lines"></param>
+void SoftRasterizer::BinLines(const std::vector<ScreenLine>& lines) {
+
+	for (std::vector<uint32_t>& bin : tileBins_) {
+		bin.clear();
+	}
+
+	stats_.binnedCount = 0;
+
+	const int32_t kTileSizeI = static_cast<int32_t>(kTileSize);
+	const int32_t maxTileX = static_cast<int32_t>(tileCountX_) - 1;
+	const int32_t maxTileY = static_cast<int32_t>(tileCountY_) - 1;
+
+	for (uint32_t lineIndex = 0; lineIndex < lines.size(); ++lineIndex) {
+
+		const ScreenLine& line = lines[lineIndex];
+		if (!IsFinite(line)) {
+			continue;
+		}
+
+		int32_t x0 = ToPixel(line.start.x);
+		int32_t y0 = ToPixel(line.start.y);
+		int32_t x1 = ToPixel(line.end.x);
+		int32_t y1 = ToPixel(line.end.y);
+
+		// 掛かるタイルの範囲
+		int32_t tileMinX = std::clamp((std::min)(x0, x1) / kTileSizeI - 1, 0, maxTileX);
+		int32_t tileMaxX = std::clamp((std::max)(x0, x1) / kTileSizeI + 1, 0, maxTileX);
+		int32_t tileMinY = std::clamp((std::min)(y0, y1) / kTileSizeI - 1, 0, maxTileY);
+		int32_t tileMaxY = std::clamp((std::max)(y0, y1) / kTileSizeI + 1, 0, maxTileY);
+
+		// 直線の式 a*x + b*y + c
+		double a = static_cast<double>(y1 - y0);
+		double b = static_cast<double>(x0 - x1);
+		double c = -(a * x0 + b * y0);
+
+		for (int32_t tileY = tileMinY; tileY <= tileMaxY; ++tileY) {
+			for (int32_t tileX = tileMinX; tileX <= tileMaxX; ++tileX) {
+
+				// タイルを1ピクセル広げた矩形の四隅が全て直線の片側にあれば通らない
+				double left = tileX * kTileSizeI - 1.0;
+				double top = tileY * kTileSizeI - 1.0;
+				double right = left + kTileSizeI + 1.0;
+				double bottom = top + kTileSizeI + 1.0;
+
+				double d0 = a * left + b * top + c;
+				double d1 = a * right + b * top + c;
+				double d2 = a * left + b * bottom + c;
+				double d3 = a * right + b * bottom + c;
+
+				bool isAllPositive = d0 > 0.0 && d1 > 0.0 && d2 > 0.0 && d3 > 0.0;
+				bool isAllNegative = d0 < 0.0 && d1 < 0.0 && d2 < 0.0 && d3 < 0.0;
+				if (isAllPositive || isAllNegative) {
+					continue;
+				}
+
+				tileBins_[static_cast<size_t>(tileY) * tileCountX_ + tileX].push_back(lineIndex);
+				++stats_.binnedCount;
+			}
+		}
+	}
+}
+
+/// <summary>
+/// 線の描画
+/// </summary>
+/// <param name="inputLines">出力解像度のスクリーン座標の線</param>
+void SoftRasterizer::DrawLines(const std::vector<ScreenLine>& inputLines) {
+
+	auto start = std::chrono::steady_clock::now();
+
+	// 内部解像度に合わせて縮める、深度はそのまま
+	const std::vector<ScreenLine>* source = &inputLines;
+	if (inputScale_ != 1.0f) {
+
+		scaledLines_.resize(inputLines.size());
+		for (size_t i = 0; i < inputLines.size(); ++i) {
+
+			const ScreenLine& line = inputLines[i];
+			scaledLines_[i] = {
+				{ line.start.x * inputScale_, line.start.y * inputScale_, line.start.z },
+				{ line.end.x * inputScale_, line.end.y * inputScale_, line.end.z },
+				line.color };
+		}
+		source = &scaledLines_;
+	}
+
+	RasterizeLines(*source, start);
+}
+
+/// <summary>
+/// 線を振り分けてタイルごとに描画する
+/// </summary>
+/// <param name="lines">内部解像度のスクリーン座標の線</param>
+/// <param name="start">計測の開始時刻</param>
+void SoftRasterizer::RasterizeLines(const std::vector<ScreenLine>& lines, std::chrono::steady_clock::time_point start) {
+
+	BinLines(lines);
+
+	const uint32_t tileCount = tileCountX_ * tileCountY_;
+
+	// タイルは互いに重ならないので、スレッド間で同じピクセルに書き込むことはない
+	std::function<void(size_t)> rasterizeTile = [this, &lines](size_t tileIndex) {
+		RasterizeTile(static_cast<uint32_t>(tileIndex), lines);
+		};
+	workerPool_.Run(tileCount, rasterizeTile);
+
+	auto end = std::chrono::steady_clock::now();
+
+	stats_.lineCount = static_cast<uint32_t>(lines.size());
+	stats_.milliseconds = std::chrono::duration<double, std::milli>(end - start).count();
+	stats_.linesPerSecond = stats_.milliseconds > 0.0 ? stats_.lineCount / (stats_.milliseconds * 1.0e-3) : 0.0;
+}
+
+/// <summary>
+/// タイル内の線を描画する
+/// </summary>
+/// <param name="tileIndex"></param>
+/// <param name="lines"></param>
+void SoftRasterizer::RasterizeTile(uint32_t tileIndex, const std::vector<ScreenLine>& lines) {
+
+	int32_t minX = static_cast<int32_t>((tileIndex % tileCountX_) * kTileSize);
+	int32_t minY = static_cast<int32_t>((tileIndex / tileCountX_) * kTileSize);
+	int32_t maxX = (std::min)(minX + static_cast<int32_t>(kTileSize), static_cast<int32_t>(width_)) - 1;
+	int32_t maxY = (std::min)(minY + static_cast<int32_t>(kTileSize), static_cast<int32_t>(height_)) - 1;
+
+	// 投入順に描くので、結果はスレッド数に依らない
+	for (uint32_t lineIndex : tileBins_[tileIndex]) {
+		DrawLineInRect(lines[lineIndex], minX, minY, maxX, maxY);
+	}
+}
+
+/// <summary>
+/// 矩形の中だけ線を描画する
+/// 線全体を描いた時と同じピクセルになるように、主軸の位置から副軸の位置を直接求める
+/// </summary>
+/// <param name="line"></param>
+/// <param name="minX"></param>
+/// <param name="minY"></param>
+/// <param name="maxX"></param>
+/// <param name="maxY"></param>
+void SoftRasterizer::DrawLineInRect(const ScreenLine& line, int32_t minX, int32_t minY, int32_t maxX, int32_t maxY) {
+
+	int32_t x0 = ToPixel(line.start.x);
+	int32_t y0 = ToPixel(line.start.y);
+	int32_t x1 = ToPixel(line.end.x);
+	int32_t y1 = ToPixel(line.end.y);
+	float z0 = line.start.z;
+	float z1 = line.end.z;
+
+	// 長さ0の線は1点
+	if (x0 == x1 && y0 == y1) {
+		if (x0 >= minX && x0 <= maxX && y0 >= minY && y0 <= maxY) {
+			PlotPixel(x0, y0, z0, line.color, 1.0f);
+		}
+		return;
+	}
+
+	// 長い方の軸を主軸(u)、もう一方を副軸(v)とする
+	bool isXMajor = std::abs(x1 - x0) >= std::abs(y1 - y0);
+	int32_t u0 = isXMajor ? x0 : y0;
+	int32_t u1 = isXMajor ? x1 : y1;
+	int32_t v0 = isXMajor ? y0 : x0;
+	int32_t v1 = isXMajor ? y1 : x1;
+	int32_t minU = isXMajor ? minX : minY;
+	int32_t maxU = isXMajor ? maxX : maxY;
+	int32_t minV = isXMajor ? minY : minX;
+	int32_t maxV = isXMajor ? maxY : maxX;
+
+	if (u0 > u1) {
+		std::swap(u0, u1);
+		std::swap(v0, v1);
+		std::swap(z0, z1);
+	}
+
+	float length = static_cast<float>(u1 - u0);
+	float slope = static_cast<float>(v1 - v0) / length;
+	float zSlope = (z1 - z0) / length;
+
+	int32_t spanBegin = (std::max)(u0, minU);
+	int32_t spanEnd = (std::min)(u1, maxU);
+
+	if (lineMode_ == LineMode::kWu) {
+
+		// 副軸の小数部で隣り合う2ピクセルに振り分ける
+		for (int32_t u = spanBegin; u <= spanEnd; ++u) {
+
+			float t = static_cast<float>(u - u0);
+			float v = static_cast<float>(v0) + t * slope;
+			float z = z0 + t * zSlope;
+			float vFloor = std::floor(v);
+			float fraction = v - vFloor;
+			int32_t vi = static_cast<int32_t>(vFloor);
+
+			for (int32_t k = 0; k < 2; ++k) {
+
+				int32_t vk = vi + k;
+				float coverage = k == 0 ? 1.0f - fraction : fraction;
+				if (vk < minV || vk > maxV || coverage <= 0.0f) {
+					continue;
+				}
+
+				if (isXMajor) {
+					PlotPixel(u, vk, z, line.color, coverage);
+				} else {
+					PlotPixel(vk, u, z, line.color, coverage);
+				}
+			}
+		}
+		return;
+	}
+
+	// 4ピクセルずつ座標を求めて、範囲内のものを書き込む
+	int32_t spanV[4];
+	float spanZ[4];
+	for (int32_t u = spanBegin; u <= spanEnd; u += 4) {
+
+		ComputeSpan4(u, u0, static_cast<float>(v0), slope, z0, zSlope, spanV, spanZ);
+
+		int32_t count = (std::min)(4, spanEnd - u + 1);
+		for (int32_t k = 0; k < count; ++k) {
+
+			if (spanV[k] < minV || spanV[k] > maxV) {
+				continue;
+			}
+
+			if (isXMajor) {
+				PlotPixel(u + k, spanV[k], spanZ[k], line.color, 1.0f);
+			} else {
+				PlotPixel(spanV[k], u + k, spanZ[k], line.color, 1.0f);
+			}
+		}
+	}
+}
+
+/// <summary>
+/// 深度テストをしてピクセルを書き込む
+/// </summary>
+/// <param name="x"></param>
+/// <param name="y"></param>
+/// <param name="z"></param>
+/// <param name="color"></param>
+/// <param name="coverage">ピクセルを覆う割合 0 ~ 1</param>
+void SoftRasterizer::PlotPixel(int32_t x, int32_t y, float z, uint32_t color, float coverage) {
+
+	size_t index = static_cast<size_t>(y) * width_ + static_cast<size_t>(x);
+
+	// 手前(深度が小さい)か同じなら描く
+	if (isDepthTest_ && z > depthBuffer_[index]) {
+		return;
+	}
+
+	if (coverage >= 1.0f) {
+		colorBuffer_[index] = color;
+		depthBuffer_[index] = z;
+		return;
+	}
+
+	colorBuffer_[index] = BlendColor(colorBuffer_[index], color, coverage);
+
+	// 半分以上覆っている時だけ深度を書く
+	if (coverage >= 0.5f) {
+		depthBuffer_[index] = z;
+	}
+}
+
+/// <summary>
+/// カラーバッファをTGAで保存する
+/// </summary>
+/// <param name="filePath"></param>
+/// <returns>保存できたか</returns>
+bool SoftRasterizer::SaveTGA(const std::string& filePath) const {
+
+	std::ofstream file(filePath, std::ios::binary);
+	if (!file) {
+		return false;
+	}
+
+	// 無圧縮32bit、左上原点
+	uint8_t header[18] = {};
+	header[2] = 2;
+	header[12] = static_cast<uint8_t>(width_ & 0xff);
+	header[13] = static_cast<uint8_t>(width_ >> 8);
+	header[14] = static_cast<uint8_t>(height_ & 0xff);
+	header[15] = static_cast<uint8_t>(height_ >> 8);
+	header[16] = 32;
+	header[17] = 0x28;
+	file.write(reinterpret_cast<const char*>(header), sizeof(header));
+
+	// 0xRRGGBBAA を B, G, R, A の順に並べる
+	std::vector<uint8_t> pixels(colorBuffer_.size() * 4);
+	for (size_t i = 0; i < colorBuffer_.size(); ++i) {
+
+		uint32_t color = colorBuffer_[i];
+		pixels[i * 4 + 0] = static_cast<uint8_t>((color >> 8) & 0xff);
+		pixels[i * 4 + 1] = static_cast<uint8_t>((color >> 16) & 0xff);
+		pixels[i * 4 + 2] = static_cast<uint8_t>((color >> 24) & 0xff);
+		pixels[i * 4 + 3] = static_cast<uint8_t>(color & 0xff);
+	}
+	file.write(reinterpret_cast<const char*>(pixels.data()), static_cast<std::streamsize>(pixels.size()));
+
+	return static_cast<bool>(file);
+}
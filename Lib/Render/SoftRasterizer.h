@@ -0,0 +1,115 @@
+﻿#pragma once
+#include <stdint.h>
+#include <chrono>
+#include <string>
+#include <vector>
+#include "ScreenLine.h"
+#include "WorkerPool.h"
+
+/// <summary>
+/// CPUで線を描くラスタライザ
+/// Novice(Windows)無しで参照画像を作ったり、線の描画速度を測ったりするために使う
+/// 画面をタイルに分けて線を振り分け、タイル単位で複数スレッドで描画する(スレッドはInitで一度だけ立てて使い回す)
+/// 入力はScreenLineだけにして、MyMathやNoviceには依存しない(詰めた線はUnpackLinesで戻してから渡す)
+/// </summary>
+class SoftRasterizer {
+public:
+	/// <summary>
+	/// 型定義
+	/// </summary>
+
+	// 線の描き方
+	enum class LineMode {
+
+		kBresenham, // 1ピクセル幅
+		kWu,        // アンチエイリアス
+	};
+
+	/// <summary>
+	/// 直前のDrawLinesの統計
+	/// </summary>
+	struct Stats {
+
+		uint32_t lineCount;    // 描画した線の数
+		uint64_t binnedCount;  // タイルに振り分けた数(線 x タイル)
+		double milliseconds;   // 掛かった時間
+		double linesPerSecond; // 1秒あたりの線の数
+	};
+
+private:
+	/// <summary>
+	/// メンバ変数
+	/// </summary>
+
+	// タイルの一辺のピクセル数
+	static const uint32_t kTileSize = 64;
+
+	uint32_t width_ = 0;
+	uint32_t height_ = 0;
+	uint32_t tileCountX_ = 0;
+	uint32_t tileCountY_ = 0;
+	WorkerPool workerPool_;
+
+	// 0xRRGGBBAAの色と、ビューポート変換後の深度
+	std::vector<uint32_t> colorBuffer_;
+	std::vector<float> depthBuffer_;
+
+	// タイルごとの線の番号
+	std::vector<std::vector<uint32_t>> tileBins_;
+
+	LineMode lineMode_ = LineMode::kBresenham;
+	bool isDepthTest_ = true;
+
+	// 入力の線のスクリーン座標に掛ける倍率(内部解像度を出力より下げた時に使う)
+	float inputScale_ = 1.0f;
+	std::vector<ScreenLine> scaledLines_;
+
+	Stats stats_{};
+
+	// 線を振り分けてタイルごとに描画し、startからの時間を統計に書く
+	void RasterizeLines(const std::vector<ScreenLine>& lines, std::chrono::steady_clock::time_point start);
+	// 線をタイルに振り分ける
+	void BinLines(const std::vector<ScreenLine>& lines);
+	// タイル内の線を描画する
+	void RasterizeTile(uint32_t tileIndex, const std::vector<ScreenLine>& lines);
+	// 矩形の中だけ線を描画する
+	void DrawLineInRect(const ScreenLine& line, int32_t minX, int32_t minY, int32_t maxX, int32_t maxY);
+	// 深度テストをしてピクセルを書き込む
+	void PlotPixel(int32_t x, int32_t y, float z, uint32_t color, float coverage);
+
+public:
+	/// <summary>
+	/// メンバ関数
+	/// </summary>
+
+	// コンストラクタ
+	SoftRasterizer() {}
+	// デストラクタ
+	~SoftRasterizer() {}
+
+	// 初期化、threadCountが0ならハードウェアのスレッド数を使う
+	void Init(uint32_t width, uint32_t height, uint32_t threadCount = 0);
+	// バッファを塗りつぶす
+	void Clear(uint32_t color, float depth = 1.0f);
+	// 線の描画
+	void DrawLines(const std::vector<ScreenLine>& lines);
+	// カラーバッファをTGAで保存する
+	bool SaveTGA(const std::string& filePath) const;
+
+	/// <summary>
+	/// ゲッター
+	/// </summary>
+	/// <returns></returns>
+	uint32_t GetWidth() const { return width_; }
+	uint32_t GetHeight() const { return height_; }
+	const std::vector<uint32_t>& GetColorBuffer() const { return colorBuffer_; }
+	const std::vector<float>& GetDepthBuffer() const { return depthBuffer_; }
+	const Stats& GetStats() const { return stats_; }
+
+	/// <summary>
+	/// セッター
+	/// </summary>
+	void SetLineMode(LineMode lineMode) { lineMode_ = lineMode; }
+	void SetDepthTest(bool isDepthTest) { isDepthTest_ = isDepthTest; }
+	void SetInputScale(float inputScale) { inputScale_ = inputScale; }
+};
@@ -0,0 +1,32 @@
+﻿#pragma once
+#include <stdint.h>
+#include <vector>
+#include "MyMath.h"
+#include "MyMathBatch.h"
+
+/// <summary>
+/// ワールド座標の線の並び
+/// 端点は2つで1本(始点、終点の順)、視点ごとに座標変換する前の1フレーム分の形を持つ
+/// </summary>
+struct WorldLines {
+
+	Vec3fSoA positions;
+	std::vector<uint32_t> colors;
+
+	void Clear() {
+		positions.Resize(0);
+		colors.clear();
+	}
+
+	void Add(const Vec3f& start, const Vec3f& end, uint32_t color) {
+		positions.x.push_back(start.x);
+		positions.y.push_back(start.y);
+		positions.z.push_back(start.z);
+		positions.x.push_back(end.x);
+		positions.y.push_back(end.y);
+		positions.z.push_back(end.z);
+		colors.push_back(color);
+	}
+
+	size_t Size() const { return colors.size(); }
+};
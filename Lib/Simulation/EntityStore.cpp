@@ -0,0 +1,269 @@
+﻿#include "EntityStore.h"
+#include <algorithm>
+#include <chrono>
+#include <random>
+
+namespace {
+
+	/// <summary>
+	/// 1軸分の位置を速度で進め、範囲の外に出たら跳ね返す
+	/// </summary>
+	void IntegrateAxis(std::vector<float>& positions, std::vector<float>& velocities, float deltaTime, float halfExtent) {
+
+		const size_t count = positions.size();
+		float* position = positions.data();
+		float* velocity = velocities.data();
+
+		for (size_t i = 0; i < count; ++i) {
+
+			float p = position[i] + velocity[i] * deltaTime;
+			float v = velocity[i];
+
+			// 範囲の端に戻して、内側へ向かう速度にする
+			if (p > halfExtent) {
+				p = halfExtent;
+				v = -std::abs(v);
+			} else if (p < -halfExtent) {
+				p = -halfExtent;
+				v = std::abs(v);
+			}
+
+			position[i] = p;
+			velocity[i] = v;
+		}
+	}
+
+	/// <summary>
+	/// 配列の一部を後ろに足す
+	/// </summary>
+	void Append(std::vector<float>& out, const std::vector<float>& source, size_t begin, size_t count) {
+
+		out.insert(out.end(), source.begin() + begin, source.begin() + begin + count);
+	}
+
+	void Append(Vec3fSoA& out, const Vec3fSoA& source, size_t begin, size_t count) {
+
+		Append(out.x, source.x, begin, count);
+		Append(out.y, source.y, begin, count);
+		Append(out.z, source.z, begin, count);
+	}
+
+	/// <summary>
+	/// 番号の並びに従って要素を集める
+	/// </summary>
+	void Gather(const std::vector<float>& source, const std::vector<uint32_t>& indices, std::vector<float>& out) {
+
+		out.resize(indices.size());
+		for (size_t i = 0; i < indices.size(); ++i) {
+			out[i] = source[indices[i]];
+		}
+	}
+}
+
+/// <summary>
+/// 全て消す
+/// </summary>
+void EntityStore::Clear() {
+
+	state_.pointPositions.Resize(0);
+	state_.segments.Resize(0);
+	state_.closestPoints.Resize(0);
+	pointVelocities_.Resize(0);
+	segmentVelocities_.Resize(0);
+	pointTargets_.clear();
+	targetSegments_.Resize(0);
+	accumulator_ = 0.0f;
+}
+
+/// <summary>
+/// 点の追加
+/// </summary>
+/// <param name="position"></param>
+/// <param name="velocity"></param>
+/// <returns>点の番号</returns>
+uint32_t EntityStore::AddPoint(const Vec3f& position, const Vec3f& velocity) {
+
+	uint32_t index = GetPointCount();
+
+	state_.pointPositions.Resize(index + 1);
+	state_.pointPositions.Set(index, position);
+	pointVelocities_.Resize(index + 1);
+	pointVelocities_.Set(index, velocity);
+	pointTargets_.push_back(0);
+
+	return index;
+}
+
+/// <summary>
+/// 線分の追加
+/// </summary>
+/// <param name="segment"></param>
+/// <param name="velocity"></param>
+/// <returns>線分の番号</returns>
+uint32_t EntityStore::AddSegment(const Segement& segment, const Vec3f& velocity) {
+
+	uint32_t index = GetSegmentCount();
+
+	state_.segments.Resize(index + 1);
+	state_.segments.Set(index, segment);
+	segmentVelocities_.Resize(index + 1);
+	segmentVelocities_.Set(index, velocity);
+
+	return index;
+}
+
+/// <summary>
+/// 点が追跡する線分の設定
+/// </summary>
+/// <param name="pointIndex"></param>
+/// <param name="segmentIndex"></param>
+void EntityStore::SetPointTarget(uint32_t pointIndex, uint32_t segmentIndex) {
+
+	pointTargets_[pointIndex] = segmentIndex;
+}
+
+/// <summary>
+/// 線分をまとめて追加
+/// </summary>
+/// <param name="segments"></param>
+/// <param name="velocities"></param>
+/// <param name="begin"></param>
+/// <param name="count"></param>
+/// <returns>最初の線分の番号</returns>
+uint32_t EntityStore::AddSegments(const SegmentSoA& segments, const Vec3fSoA& velocities, size_t begin, size_t count) {
+
+	uint32_t index = GetSegmentCount();
+
+	Append(state_.segments.origin, segments.origin, begin, count);
+	Append(state_.segments.diff, segments.diff, begin, count);
+	Append(segmentVelocities_, velocities, begin, count);
+
+	return index;
+}
+
+/// <summary>
+/// 点をまとめて追加
+/// 最近接点は次のティックまで点の位置にしておく(止めている間も描画で使うため)
+/// </summary>
+/// <param name="positions"></param>
+/// <param name="velocities"></param>
+/// <param name="targets">追跡する線分の番号</param>
+/// <param name="begin"></param>
+/// <param name="count"></param>
+/// <returns>最初の点の番号</returns>
+uint32_t EntityStore::AddPoints(const Vec3fSoA& positions, const Vec3fSoA& velocities, const std::vector<uint32_t>& targets, size_t begin, size_t count) {
+
+	uint32_t index = GetPointCount();
+
+	Append(state_.pointPositions, positions, begin, count);
+	Append(state_.closestPoints, positions, begin, count);
+	Append(pointVelocities_, velocities, begin, count);
+	pointTargets_.insert(pointTargets_.end(), targets.begin() + begin, targets.begin() + begin + count);
+
+	return index;
+}
+
+/// <summary>
+/// ランダムに生成し直す
+/// 点は番号順に線分へ割り当てる
+/// </summary>
+/// <param name="pointCount"></param>
+/// <param name="segmentCount"></param>
+/// <param name="seed"></param>
+void EntityStore::Spawn(uint32_t pointCount, uint32_t segmentCount, uint32_t seed) {
+
+	Clear();
+
+	std::mt19937 random(seed);
+	std::uniform_real_distribution<float> position(-halfExtent_, halfExtent_);
+	std::uniform_real_distribution<float> velocity(-0.5f, 0.5f);
+	std::uniform_real_distribution<float> diff(-0.3f, 0.3f);
+
+	for (uint32_t i = 0; i < segmentCount; ++i) {
+		AddSegment(
+			{ { position(random), position(random), position(random) }, { diff(random), diff(random), diff(random) } },
+			{ velocity(random), velocity(random), velocity(random) });
+	}
+
+	for (uint32_t i = 0; i < pointCount; ++i) {
+		uint32_t pointIndex = AddPoint(
+			{ position(random), position(random), position(random) }, { velocity(random), velocity(random), velocity(random) });
+
+		if (segmentCount > 0) {
+			SetPointTarget(pointIndex, pointIndex % segmentCount);
+		}
+	}
+
+	// 最初の状態でも最近接点を持っておく
+	Tick(0.0f);
+}
+
+/// <summary>
+/// 経過時間分だけ固定の時間刻みで進める
+/// </summary>
+/// <param name="deltaTime">前回からの経過時間(秒)</param>
+void EntityStore::Update(float deltaTime) {
+
+	stats_.stepsLastUpdate = 0;
+
+	if (isPaused_) {
+		return;
+	}
+
+	accumulator_ += deltaTime;
+
+	while (accumulator_ >= kFixedDeltaTime) {
+
+		// 処理が追いつかない時は溜まった時間を捨てる
+		if (stats_.stepsLastUpdate >= kMaxStepsPerUpdate) {
+			accumulator_ = 0.0f;
+			break;
+		}
+
+		Tick(kFixedDeltaTime);
+		accumulator_ -= kFixedDeltaTime;
+		++stats_.stepsLastUpdate;
+	}
+}
+
+/// <summary>
+/// 1ティック進める
+/// 速度の積分と、点ごとの最近接点の更新
+/// </summary>
+/// <param name="deltaTime"></param>
+void EntityStore::Tick(float deltaTime) {
+
+	auto start = std::chrono::steady_clock::now();
+
+	// 速度の積分
+	IntegrateAxis(state_.pointPositions.x, pointVelocities_.x, deltaTime, halfExtent_);
+	IntegrateAxis(state_.pointPositions.y, pointVelocities_.y, deltaTime, halfExtent_);
+	IntegrateAxis(state_.pointPositions.z, pointVelocities_.z, deltaTime, halfExtent_);
+	IntegrateAxis(state_.segments.origin.x, segmentVelocities_.x, deltaTime, halfExtent_);
+	IntegrateAxis(state_.segments.origin.y, segmentVelocities_.y, deltaTime, halfExtent_);
+	IntegrateAxis(state_.segments.origin.z, segmentVelocities_.z, deltaTime, halfExtent_);
+
+	// 追跡する線分を点と同じ並びに集めて、最近接点をまとめて求める
+	if (GetSegmentCount() > 0) {
+
+		Gather(state_.segments.origin.x, pointTargets_, targetSegments_.origin.x);
+		Gather(state_.segments.origin.y, pointTargets_, targetSegments_.origin.y);
+		Gather(state_.segments.origin.z, pointTargets_, targetSegments_.origin.z);
+		Gather(state_.segments.diff.x, pointTargets_, targetSegments_.diff.x);
+		Gather(state_.segments.diff.y, pointTargets_, targetSegments_.diff.y);
+		Gather(state_.segments.diff.z, pointTargets_, targetSegments_.diff.z);
+
+		ClosestPointBatch(state_.pointPositions, targetSegments_, state_.closestPoints);
+	} else {
+		state_.closestPoints = state_.pointPositions;
+	}
+
+	auto end = std::chrono::steady_clock::now();
+
+	++stats_.tickCount;
+	stats_.tickMilliseconds = std::chrono::duration<double, std::milli>(end - start).count();
+
+	double entityCount = static_cast<double>(GetPointCount()) + static_cast<double>(GetSegmentCount());
+	stats_.entitiesPerSecond = stats_.tickMilliseconds > 0.0 ? entityCount / (stats_.tickMilliseconds * 1.0e-3) : 0.0;
+}
+
@@ -0,0 +1,106 @@
+﻿#pragma once
+#include <vector>
+#include "MyMath.h"
+#include "MyMathBatch.h"
+
+/// <summary>
+/// 描画に必要なエンティティの状態
+/// </summary>
+struct EntityState {
+
+	Vec3fSoA pointPositions; // 点の位置
+	SegmentSoA segments;     // 線分
+	Vec3fSoA closestPoints;  // 点ごとの、追跡している線分上の最近接点
+};
+
+/// <summary>
+/// 点と線分をSoAで持つエンティティの入れ物
+/// 固定の時間刻みで速度を積分し、毎ティック点と線分の最近接点をまとめて更新する
+/// </summary>
+class EntityStore {
+public:
+	/// <summary>
+	/// 更新処理の統計
+	/// </summary>
+	struct Stats {
+
+		uint64_t tickCount;          // 累計のティック数
+		uint32_t stepsLastUpdate;    // 直前のUpdateで進めたティック数
+		double tickMilliseconds;     // 1ティックに掛かった時間
+		double entitiesPerSecond;    // 1秒あたりに更新できるエンティティ数
+	};
+
+private:
+	/// <summary>
+	/// メンバ変数
+	/// </summary>
+
+	// 1ティックの時間(秒)
+	static constexpr float kFixedDeltaTime = 1.0f / 60.0f;
+	// 1回のUpdateで進める最大のティック数、超えた分は捨てる
+	static const uint32_t kMaxStepsPerUpdate = 5;
+
+	EntityState state_;
+
+	Vec3fSoA pointVelocities_;
+	Vec3fSoA segmentVelocities_;
+
+	// 点ごとに追跡する線分の番号
+	std::vector<uint32_t> pointTargets_;
+	// 追跡する線分を点と同じ並びに集めたもの
+	SegmentSoA targetSegments_;
+
+	// この範囲(各軸 ±halfExtent_)の中で跳ね返る
+	float halfExtent_ = 2.0f;
+
+	float accumulator_ = 0.0f;
+	bool isPaused_ = false;
+
+	Stats stats_{};
+
+public:
+	/// <summary>
+	/// メンバ関数
+	/// </summary>
+
+	// コンストラクタ
+	EntityStore() {}
+	// デストラクタ
+	~EntityStore() {}
+
+	// 全て消す
+	void Clear();
+	// 点の追加、点の番号を返す
+	uint32_t AddPoint(const Vec3f& position, const Vec3f& velocity);
+	// 線分の追加、線分の番号を返す
+	uint32_t AddSegment(const Segement& segment, const Vec3f& velocity);
+	// 点が追跡する線分の設定
+	void SetPointTarget(uint32_t pointIndex, uint32_t segmentIndex);
+	// 線分をまとめて追加(segmentsのbeginからcount個)、最初の線分の番号を返す
+	uint32_t AddSegments(const SegmentSoA& segments, const Vec3fSoA& velocities, size_t begin, size_t count);
+	// 点をまとめて追加(追跡する線分は既にあること、線分が無い時は番号を使わない)、最初の点の番号を返す
+	uint32_t AddPoints(const Vec3fSoA& positions, const Vec3fSoA& velocities, const std::vector<uint32_t>& targets, size_t begin, size_t count);
+	// ランダムに生成し直す
+	void Spawn(uint32_t pointCount, uint32_t segmentCount, uint32_t seed);
+
+	// 経過時間分だけ固定の時間刻みで進める
+	void Update(float deltaTime);
+	// 1ティック進める
+	void Tick(float deltaTime);
+
+	/// <summary>
+	/// ゲッター
+	/// </summary>
+	/// <returns></returns>
+	const EntityState& GetState() const { return state_; }
+	const Stats& GetStats() const { return stats_; }
+	uint32_t GetPointCount() const { return static_cast<uint32_t>(state_.pointPositions.Size()); }
+	uint32_t GetSegmentCount() const { return static_cast<uint32_t>(state_.segments.Size()); }
+	float GetHalfExtent() const { return halfExtent_; }
+
+	/// <summary>
+	/// セッター
+	/// </summary>
+	void SetHalfExtent(float halfExtent) { halfExtent_ = halfExtent; }
+	void SetPaused(bool isPaused) { isPaused_ = isPaused; }
+};
@@ -0,0 +1,422 @@
+﻿#include "SceneStreamer.h"
+#include <algorithm>
+#include <chrono>
+#include <random>
+
+namespace {
+
+	/*========================================================================================================================*/
+	// シーンのファイル
+	// [magic "SCNE"][version][線分の数][点の数]
+	// の後にチャンクが続き、線分のチャンクを全て書いてから点のチャンクを書く
+	// 線分: [kind 1][数][始点x...][y...][z...][差分x...][y...][z...][速度x...][y...][z...]
+	// 点:   [kind 2][数][位置x...][y...][z...][速度x...][y...][z...][追跡する線分の番号...]
+	// 終わり: [kind 0][0]
+	// 線分が無いシーンの点は、追跡する線分の番号をkNoTargetにする
+
+	const char kSceneMagic[4] = { 'S', 'C', 'N', 'E' };
+	const uint32_t kSceneVersion = 2;
+
+	// 追跡する線分が無い点の番号
+	const uint32_t kNoTarget = 0xffffffff;
+
+	const uint32_t kChunkKindEnd = 0;
+	const uint32_t kChunkKindSegment = 1;
+	const uint32_t kChunkKindPoint = 2;
+
+	// 1チャンクの最大の要素数、書く時はこの数ずつに分ける
+	const uint32_t kMaxChunkCount = 16384;
+
+	template<typename T>
+	void WriteValue(std::ofstream& file, const T& value) {
+		file.write(reinterpret_cast<const char*>(&value), sizeof(T));
+	}
+
+	template<typename T>
+	bool ReadValue(std::ifstream& file, T& value) {
+		return static_cast<bool>(file.read(reinterpret_cast<char*>(&value), sizeof(T)));
+	}
+
+	template<typename T>
+	void WriteArray(std::ofstream& file, const std::vector<T>& values) {
+		file.write(reinterpret_cast<const char*>(values.data()), static_cast<std::streamsize>(values.size() * sizeof(T)));
+	}
+
+	template<typename T>
+	bool ReadArray(std::ifstream& file, std::vector<T>& values, size_t count) {
+		values.resize(count);
+		return static_cast<bool>(file.read(reinterpret_cast<char*>(values.data()), static_cast<std::streamsize>(count * sizeof(T))));
+	}
+
+	void WriteSoA(std::ofstream& file, const Vec3fSoA& vectors) {
+		WriteArray(file, vectors.x);
+		WriteArray(file, vectors.y);
+		WriteArray(file, vectors.z);
+	}
+
+	bool ReadSoA(std::ifstream& file, Vec3fSoA& vectors, size_t count) {
+		return ReadArray(file, vectors.x, count) && ReadArray(file, vectors.y, count) && ReadArray(file, vectors.z, count);
+	}
+}
+
+/// <summary>
+/// 状態の名前
+/// </summary>
+/// <param name="state"></param>
+/// <returns></returns>
+const char* GetSceneStreamerStateName(SceneStreamer::State state) {
+
+	switch (state) {
+	case SceneStreamer::State::kIdle:
+		return "idle";
+	case SceneStreamer::State::kWriting:
+		return "writing";
+	case SceneStreamer::State::kWritten:
+		return "written";
+	case SceneStreamer::State::kLoading:
+		return "loading";
+	case SceneStreamer::State::kLoaded:
+		return "loaded";
+	case SceneStreamer::State::kFailed:
+		return "failed";
+	case SceneStreamer::State::kCancelled:
+		return "cancelled";
+	}
+
+	return "unknown";
+}
+
+/// <summary>
+/// コンストラクタ
+/// 読み込み用のスレッドは積まれたコルーチンを順に再開し続ける
+/// </summary>
+SceneStreamer::SceneStreamer() {
+
+	ioThread_ = std::thread([this]() {
+		while (ioQueue_.RunOne()) {
+		}
+	});
+}
+
+/// <summary>
+/// デストラクタ
+/// 途中の処理を止めてから読み込み用のスレッドを終える
+/// </summary>
+SceneStreamer::~SceneStreamer() {
+
+	Cancel();
+
+	ioQueue_.Close();
+	if (ioThread_.joinable()) {
+		ioThread_.join();
+	}
+}
+
+/// <summary>
+/// シーンの読み込みを始める
+/// </summary>
+/// <param name="filePath"></param>
+void SceneStreamer::BeginLoad(const std::string& filePath) {
+
+	Cancel();
+
+	progress_ = {};
+	progress_.state = State::kLoading;
+
+	task_ = Load(filePath);
+	task_.Start();
+}
+
+/// <summary>
+/// ランダムなシーンの書き出しを始める
+/// </summary>
+/// <param name="filePath"></param>
+/// <param name="pointCount"></param>
+/// <param name="segmentCount"></param>
+/// <param name="seed"></param>
+/// <param name="halfExtent"></param>
+void SceneStreamer::BeginWrite(const std::string& filePath, uint32_t pointCount, uint32_t segmentCount, uint32_t seed, float halfExtent) {
+
+	Cancel();
+
+	progress_ = {};
+	progress_.state = State::kWriting;
+	progress_.totalPointCount = pointCount;
+	progress_.totalSegmentCount = segmentCount;
+
+	task_ = Write(filePath, pointCount, segmentCount, seed, halfExtent);
+	task_.Start();
+}
+
+/// <summary>
+/// 今の処理を止めて終わるまで待つ
+/// コルーチンはフレーム側に戻った所で止める指示を見て終わるので、フレーム側に積まれた分はここで再開する
+/// (終わるのを常にフレーム側にして、IsDoneを見るスレッドと揃える)
+/// 読み込み用のスレッドで1チャンク読み書きしている途中なら、その分だけ待つ
+/// </summary>
+void SceneStreamer::Cancel() {
+
+	if (!task_.IsValid()) {
+		return;
+	}
+
+	if (!task_.IsDone()) {
+
+		isCancelled_ = true;
+
+		while (!task_.IsDone()) {
+			frameQueue_.RunPending();
+			std::this_thread::yield();
+		}
+
+		isCancelled_ = false;
+
+		if (progress_.state == State::kLoading || progress_.state == State::kWriting) {
+			progress_.state = State::kCancelled;
+		}
+	}
+
+	task_.Reset();
+}
+
+/// <summary>
+/// フレームの区切り: 読めているチャンクをbudget個までEntityStoreに入れる
+/// </summary>
+/// <param name="entityStore"></param>
+/// <param name="budget">このフレームで入れる最大の点と線分の数</param>
+void SceneStreamer::IngestFrame(EntityStore& entityStore, uint32_t budget) {
+
+	auto start = std::chrono::steady_clock::now();
+
+	entityStore_ = &entityStore;
+	budgetRemaining_ = budget;
+
+	frameQueue_.RunPending();
+
+	entityStore_ = nullptr;
+
+	progress_.ingestedLastFrame = budget - budgetRemaining_;
+	progress_.ingestMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+/// <summary>
+/// ファイルから1チャンク読む
+/// </summary>
+/// <param name="file"></param>
+/// <param name="chunk"></param>
+/// <returns>読めたか</returns>
+bool SceneStreamer::ReadChunk(std::ifstream& file, Chunk& chunk) {
+
+	if (!ReadValue(file, chunk.kind) || !ReadValue(file, chunk.count) || chunk.count > kMaxChunkCount) {
+		return false;
+	}
+
+	switch (chunk.kind) {
+	case kChunkKindEnd:
+		return chunk.count == 0;
+	case kChunkKindSegment:
+		return ReadSoA(file, chunk.segments.origin, chunk.count) && ReadSoA(file, chunk.segments.diff, chunk.count) &&
+			ReadSoA(file, chunk.velocities, chunk.count);
+	case kChunkKindPoint:
+		return ReadSoA(file, chunk.positions, chunk.count) && ReadSoA(file, chunk.velocities, chunk.count) &&
+			ReadArray(file, chunk.targets, chunk.count);
+	}
+
+	return false;
+}
+
+/// <summary>
+/// チャンクの一部をEntityStoreに入れる
+/// </summary>
+/// <param name="chunk"></param>
+/// <param name="begin"></param>
+/// <param name="count"></param>
+void SceneStreamer::IngestChunk(const Chunk& chunk, uint32_t begin, uint32_t count) {
+
+	if (chunk.kind == kChunkKindSegment) {
+		entityStore_->AddSegments(chunk.segments, chunk.velocities, begin, count);
+		progress_.loadedSegmentCount += count;
+	} else {
+		entityStore_->AddPoints(chunk.positions, chunk.velocities, chunk.targets, begin, count);
+		progress_.loadedPointCount += count;
+	}
+
+	budgetRemaining_ -= count;
+}
+
+/// <summary>
+/// シーンを読んで入れるコルーチン
+/// 読み込み用のスレッドでヘッダーとチャンクを読み、フレーム側に移ってEntityStoreに入れる、を繰り返す
+/// 予算を使い切ったら次のフレームまで待つので、読めたチャンクは何フレームかに分けて入る
+/// </summary>
+/// <param name="filePath"></param>
+/// <returns></returns>
+Task SceneStreamer::Load(std::string filePath) {
+
+	co_await ioQueue_.Schedule();
+
+	std::ifstream file(filePath, std::ios::binary);
+
+	char magic[4] = {};
+	uint32_t version = 0;
+	uint32_t segmentCount = 0;
+	uint32_t pointCount = 0;
+	bool isValid = file && file.read(magic, sizeof(magic)) && std::equal(magic, magic + 4, kSceneMagic) &&
+		ReadValue(file, version) && version == kSceneVersion && ReadValue(file, segmentCount) && ReadValue(file, pointCount);
+
+	co_await frameQueue_.Schedule();
+	if (isCancelled_) {
+		co_return;
+	}
+
+	if (!isValid) {
+		progress_.state = State::kFailed;
+		co_return;
+	}
+
+	// 前のシーンを消して、ここから入れた分が表示される
+	entityStore_->Clear();
+	progress_.totalSegmentCount = segmentCount;
+	progress_.totalPointCount = pointCount;
+
+	// 読んだ数(ファイルの中身の確認用)
+	uint32_t readSegmentCount = 0;
+	uint32_t readPointCount = 0;
+
+	Chunk chunk{};
+
+	while (true) {
+
+		co_await ioQueue_.Schedule();
+
+		bool isChunkValid = ReadChunk(file, chunk);
+
+		// 線分を全て読んでから点が来る、点の追跡する線分はあるものだけ
+		// 線分が無いシーンでは、点は全て追跡する線分が無い(kNoTarget)
+		if (isChunkValid && chunk.kind == kChunkKindSegment) {
+			isChunkValid = chunk.count <= segmentCount - readSegmentCount;
+			readSegmentCount += isChunkValid ? chunk.count : 0;
+		} else if (isChunkValid && chunk.kind == kChunkKindPoint) {
+			isChunkValid = readSegmentCount == segmentCount && chunk.count <= pointCount - readPointCount &&
+				std::all_of(chunk.targets.begin(), chunk.targets.end(), [&](uint32_t target) {
+					return segmentCount > 0 ? target < segmentCount : target == kNoTarget;
+					});
+			readPointCount += isChunkValid ? chunk.count : 0;
+		} else if (isChunkValid) {
+			isChunkValid = readSegmentCount == segmentCount && readPointCount == pointCount;
+		}
+
+		co_await frameQueue_.Schedule();
+		if (isCancelled_) {
+			co_return;
+		}
+
+		if (!isChunkValid) {
+			progress_.state = State::kFailed;
+			co_return;
+		}
+
+		if (chunk.kind == kChunkKindEnd) {
+			break;
+		}
+
+		++progress_.chunkCount;
+
+		// 予算の分だけ入れて、残りは次のフレームに回す
+		uint32_t offset = 0;
+		while (offset < chunk.count) {
+
+			if (budgetRemaining_ == 0) {
+				co_await frameQueue_.Schedule();
+				if (isCancelled_) {
+					co_return;
+				}
+				continue;
+			}
+
+			uint32_t count = (std::min)(budgetRemaining_, chunk.count - offset);
+			IngestChunk(chunk, offset, count);
+			offset += count;
+		}
+	}
+
+	progress_.state = State::kLoaded;
+}
+
+/// <summary>
+/// ランダムなシーンを書くコルーチン
+/// EntityStore::Spawnと同じ分布で、読み込み用のスレッドでチャンクごとに書く
+/// </summary>
+/// <param name="filePath"></param>
+/// <param name="pointCount"></param>
+/// <param name="segmentCount"></param>
+/// <param name="seed"></param>
+/// <param name="halfExtent"></param>
+/// <returns></returns>
+Task SceneStreamer::Write(std::string filePath, uint32_t pointCount, uint32_t segmentCount, uint32_t seed, float halfExtent) {
+
+	co_await ioQueue_.Schedule();
+
+	std::ofstream file(filePath, std::ios::binary);
+
+	std::mt19937 random(seed);
+	std::uniform_real_distribution<float> position(-halfExtent, halfExtent);
+	std::uniform_real_distribution<float> velocity(-0.5f, 0.5f);
+	std::uniform_real_distribution<float> diff(-0.3f, 0.3f);
+
+	file.write(kSceneMagic, sizeof(kSceneMagic));
+	WriteValue(file, kSceneVersion);
+	WriteValue(file, segmentCount);
+	WriteValue(file, pointCount);
+
+	Chunk chunk{};
+
+	for (uint32_t begin = 0; begin < segmentCount && file && !isCancelled_; begin += kMaxChunkCount) {
+
+		uint32_t count = (std::min)(kMaxChunkCount, segmentCount - begin);
+		chunk.segments.Resize(count);
+		chunk.velocities.Resize(count);
+		for (uint32_t i = 0; i < count; ++i) {
+			chunk.segments.Set(i, { { position(random), position(random), position(random) }, { diff(random), diff(random), diff(random) } });
+			chunk.velocities.Set(i, { velocity(random), velocity(random), velocity(random) });
+		}
+
+		WriteValue(file, kChunkKindSegment);
+		WriteValue(file, count);
+		WriteSoA(file, chunk.segments.origin);
+		WriteSoA(file, chunk.segments.diff);
+		WriteSoA(file, chunk.velocities);
+	}
+
+	for (uint32_t begin = 0; begin < pointCount && file && !isCancelled_; begin += kMaxChunkCount) {
+
+		uint32_t count = (std::min)(kMaxChunkCount, pointCount - begin);
+		chunk.positions.Resize(count);
+		chunk.velocities.Resize(count);
+		chunk.targets.resize(count);
+		for (uint32_t i = 0; i < count; ++i) {
+			chunk.positions.Set(i, { position(random), position(random), position(random) });
+			chunk.velocities.Set(i, { velocity(random), velocity(random), velocity(random) });
+			chunk.targets[i] = segmentCount > 0 ? (begin + i) % segmentCount : kNoTarget;
+		}
+
+		WriteValue(file, kChunkKindPoint);
+		WriteValue(file, count);
+		WriteSoA(file, chunk.positions);
+		WriteSoA(file, chunk.velocities);
+		WriteArray(file, chunk.targets);
+	}
+
+	WriteValue(file, kChunkKindEnd);
+	WriteValue(file, static_cast<uint32_t>(0));
+	file.close();
+
+	bool isWritten = static_cast<bool>(file);
+
+	co_await frameQueue_.Schedule();
+	if (isCancelled_) {
+		co_return;
+	}
+
+	progress_.state = isWritten ? State::kWritten : State::kFailed;
+}
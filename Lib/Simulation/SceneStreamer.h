@@ -0,0 +1,123 @@
+﻿#pragma once
+#include <atomic>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "MyMath.h"
+#include "MyMathBatch.h"
+#include "Task.h"
+#include "EntityStore.h"
+
+/// <summary>
+/// シーンのファイルから線分と点をチャンクごとに読み、フレームの区切りで少しずつEntityStoreに入れるクラス
+/// 読み込みは1本のコルーチンで書き、ファイルを読む所は読み込み用のスレッド、EntityStoreに入れる所はIngestFrameを呼ぶスレッドで再開する
+/// 1フレームに入れる数に上限があるので大きなシーンでもフレームが止まらず、入れた分から表示される
+/// IngestFrame、Begin系、Cancelは同じスレッド(シミュレーション側)から呼ぶこと
+/// </summary>
+class SceneStreamer {
+public:
+	/// <summary>
+	/// 型定義
+	/// </summary>
+
+	// 処理の状態
+	enum class State : uint32_t {
+
+		kIdle,
+		kWriting,   // ファイルを書いている
+		kWritten,
+		kLoading,   // ファイルを読んで入れている
+		kLoaded,
+		kFailed,
+		kCancelled,
+	};
+
+	// 進み具合
+	struct Progress {
+
+		State state;
+		uint32_t totalSegmentCount;
+		uint32_t totalPointCount;
+		uint32_t loadedSegmentCount; // EntityStoreに入れた数
+		uint32_t loadedPointCount;
+		uint32_t chunkCount;         // 読んだチャンクの数
+		uint32_t ingestedLastFrame;  // 直前のフレームで入れた数
+		double ingestMilliseconds;   // 直前のフレームで入れるのに掛かった時間
+	};
+
+private:
+	// ファイルの1チャンク分
+	struct Chunk {
+
+		uint32_t kind;
+		uint32_t count;
+		SegmentSoA segments;
+		Vec3fSoA positions;
+		Vec3fSoA velocities;
+		std::vector<uint32_t> targets;
+	};
+
+	/// <summary>
+	/// メンバ変数
+	/// </summary>
+
+	// ファイルを読む所を再開するキューとスレッド
+	TaskQueue ioQueue_;
+	std::thread ioThread_;
+	// EntityStoreに入れる所を再開するキュー(IngestFrameで回す)
+	TaskQueue frameQueue_;
+
+	Task task_;
+	std::atomic<bool> isCancelled_ = false;
+
+	// IngestFrameの間だけ有効
+	EntityStore* entityStore_ = nullptr;
+	uint32_t budgetRemaining_ = 0;
+
+	Progress progress_{};
+
+	// シーンを読んで入れるコルーチン
+	Task Load(std::string filePath);
+	// ランダムなシーンを書くコルーチン
+	Task Write(std::string filePath, uint32_t pointCount, uint32_t segmentCount, uint32_t seed, float halfExtent);
+
+	// ファイルから1チャンク読む(読み込み用のスレッド)
+	static bool ReadChunk(std::ifstream& file, Chunk& chunk);
+	// チャンクの一部をEntityStoreに入れる
+	void IngestChunk(const Chunk& chunk, uint32_t begin, uint32_t count);
+
+public:
+	/// <summary>
+	/// メンバ関数
+	/// </summary>
+
+	// コンストラクタ(読み込み用のスレッドを立てる)
+	SceneStreamer();
+	// デストラクタ
+	~SceneStreamer();
+
+	// シーンの読み込みを始める、今の処理は止める
+	void BeginLoad(const std::string& filePath);
+	// ランダムなシーンの書き出しを始める、今の処理は止める
+	void BeginWrite(const std::string& filePath, uint32_t pointCount, uint32_t segmentCount, uint32_t seed, float halfExtent);
+	// 今の処理を止めて終わるまで待つ(入れた分はEntityStoreに残る)
+	void Cancel();
+
+	// フレームの区切り: 読めているチャンクをbudget個までEntityStoreに入れる
+	void IngestFrame(EntityStore& entityStore, uint32_t budget);
+
+	/// <summary>
+	/// ゲッター
+	/// </summary>
+	/// <returns></returns>
+	const Progress& GetProgress() const { return progress_; }
+	bool IsBusy() const { return !task_.IsDone(); }
+};
+
+/// <summary>
+/// 状態の名前
+/// </summary>
+/// <param name="state"></param>
+/// <returns></returns>
+const char* GetSceneStreamerStateName(SceneStreamer::State state);
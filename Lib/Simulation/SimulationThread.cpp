@@ -0,0 +1,189 @@
+﻿#include "SimulationThread.h"
+#include <chrono>
+
+/// <summary>
+/// スレッドの開始
+/// </summary>
+/// <param name="pointCount"></param>
+/// <param name="segmentCount"></param>
+void SimulationThread::Start(uint32_t pointCount, uint32_t segmentCount) {
+
+	Stop();
+
+	spawnPointCount_ = static_cast<int>(pointCount);
+	spawnSegmentCount_ = static_cast<int>(segmentCount);
+
+	// 最初の生成はスレッドを立てる前に済ませる
+	entityStore_.Spawn(pointCount, segmentCount, 0);
+
+	isRunning_ = true;
+	thread_ = std::thread(&SimulationThread::Run, this);
+}
+
+/// <summary>
+/// スレッドの終了
+/// </summary>
+void SimulationThread::Stop() {
+
+	isRunning_ = false;
+	if (thread_.joinable()) {
+		thread_.join();
+	}
+}
+
+/// <summary>
+/// シミュレーション側のスレッドの処理
+/// 入力を受け取り、エンティティを進め、スナップショットを書いて渡す
+/// </summary>
+void SimulationThread::Run() {
+
+	using Clock = std::chrono::steady_clock;
+
+	const auto kFrameDuration = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(kFrameInterval));
+
+	uint64_t frameIndex = 0;
+	auto previousTime = Clock::now();
+	auto nextFrameTime = previousTime;
+
+	while (isRunning_) {
+
+		inputs_.Update();
+		const Input& input = inputs_.GetReadBuffer();
+
+		if (input.spawnRequest != handledSpawnRequest_) {
+			// 読み込み中のシーンに混ざらないように止めてから生成する
+			sceneStreamer_.Cancel();
+			entityStore_.Spawn(input.spawnPointCount, input.spawnSegmentCount, 0);
+			handledSpawnRequest_ = input.spawnRequest;
+		}
+
+		if (input.writeSceneRequest != handledWriteSceneRequest_) {
+			sceneStreamer_.BeginWrite(kScenePath, input.sceneWritePointCount, input.sceneWriteSegmentCount, 0, entityStore_.GetHalfExtent());
+			handledWriteSceneRequest_ = input.writeSceneRequest;
+		}
+
+		if (input.loadSceneRequest != handledLoadSceneRequest_) {
+			sceneStreamer_.BeginLoad(kScenePath);
+			handledLoadSceneRequest_ = input.loadSceneRequest;
+		}
+
+		auto frameStart = Clock::now();
+		float deltaTime = std::chrono::duration<float>(frameStart - previousTime).count();
+		previousTime = frameStart;
+
+		// フレームの区切りで、読めているシーンを予算の分だけ入れる
+		sceneStreamer_.IngestFrame(entityStore_, input.ingestBudget);
+
+		entityStore_.SetPaused(input.isPaused);
+		entityStore_.Update(deltaTime);
+
+		// カメラが来るまでは線を作れない
+		if (input.hasCamera) {
+
+			FrameSnapshot& snapshot = snapshots_.GetWriteBuffer();
+
+			snapshot.frameIndex = ++frameIndex;
+			snapshot.viewProjectionViewportMatrix = input.viewProjectionViewportMatrix;
+			entityDrawer_.BuildLines(
+				entityStore_.GetState(), input.maxDrawCount, input.viewProjectionViewportMatrix, snapshot.lines);
+			snapshot.pointCount = entityStore_.GetPointCount();
+			snapshot.segmentCount = entityStore_.GetSegmentCount();
+			snapshot.entityStats = entityStore_.GetStats();
+			snapshot.sceneProgress = sceneStreamer_.GetProgress();
+			snapshot.frameMilliseconds = std::chrono::duration<double, std::milli>(Clock::now() - frameStart).count();
+
+			snapshots_.Publish();
+		}
+
+		// 次のフレームまで待つ、遅れている時は待たずに進める
+		nextFrameTime += kFrameDuration;
+		auto now = Clock::now();
+		if (nextFrameTime < now) {
+			nextFrameTime = now;
+		}
+		std::this_thread::sleep_until(nextFrameTime);
+	}
+
+	// 途中のシーンの処理はこのスレッドで終わらせる
+	sceneStreamer_.Cancel();
+}
+
+/// <summary>
+/// 描画側: カメラ行列と操作を渡す
+/// </summary>
+/// <param name="viewProjectionViewportMatrix"></param>
+void SimulationThread::SubmitInput(const Matrix4x4& viewProjectionViewportMatrix) {
+
+	input_.hasCamera = true;
+	input_.viewProjectionViewportMatrix = viewProjectionViewportMatrix;
+	input_.maxDrawCount = static_cast<uint32_t>(drawCount_);
+	input_.spawnPointCount = static_cast<uint32_t>(spawnPointCount_);
+	input_.spawnSegmentCount = static_cast<uint32_t>(spawnSegmentCount_);
+	input_.sceneWritePointCount = static_cast<uint32_t>(sceneWritePointCount_);
+	input_.sceneWriteSegmentCount = static_cast<uint32_t>(sceneWriteSegmentCount_);
+	input_.ingestBudget = static_cast<uint32_t>(ingestBudget_);
+
+	inputs_.GetWriteBuffer() = input_;
+	inputs_.Publish();
+}
+
+/// <summary>
+/// 描画側: 最新のスナップショットを受け取る
+/// 新しいものが無ければ前回と同じものを返す
+/// </summary>
+/// <returns></returns>
+const SimulationThread::FrameSnapshot& SimulationThread::AcquireSnapshot() {
+
+	snapshots_.Update();
+	return snapshots_.GetReadBuffer();
+}
+
+/// <summary>
+/// 描画側: 操作と統計をImGuiで描画
+/// </summary>
+void SimulationThread::DrawImGui() {
+
+	const FrameSnapshot& snapshot = snapshots_.GetReadBuffer();
+
+	ImGui::Begin("EntityStore");
+
+	ImGui::SliderInt("points", &spawnPointCount_, 0, 100000);
+	ImGui::SliderInt("segments", &spawnSegmentCount_, 0, 20000);
+	if (ImGui::Button("spawn")) {
+		++input_.spawnRequest;
+	}
+
+	ImGui::Checkbox("pause", &input_.isPaused);
+	ImGui::SliderInt("drawCount", &drawCount_, 0, 20000);
+
+	ImGui::Text("points %u  segments %u", snapshot.pointCount, snapshot.segmentCount);
+	ImGui::Text("frame %llu  ticks %llu", static_cast<unsigned long long>(snapshot.frameIndex),
+		static_cast<unsigned long long>(snapshot.entityStats.tickCount));
+	ImGui::Text("tick %.3f ms  %.2f M entities/s", snapshot.entityStats.tickMilliseconds, snapshot.entityStats.entitiesPerSecond * 1.0e-6);
+	ImGui::Text("simulation frame %.3f ms", snapshot.frameMilliseconds);
+
+	// シーンのファイル
+	const SceneStreamer::Progress& progress = snapshot.sceneProgress;
+
+	ImGui::Separator();
+	ImGui::Text("scene %s", kScenePath);
+	ImGui::SliderInt("scenePoints", &sceneWritePointCount_, 0, 2000000);
+	ImGui::SliderInt("sceneSegments", &sceneWriteSegmentCount_, 0, 200000);
+	if (ImGui::Button("write scene")) {
+		++input_.writeSceneRequest;
+	}
+	ImGui::SameLine();
+	if (ImGui::Button("load scene")) {
+		++input_.loadSceneRequest;
+	}
+	ImGui::SliderInt("ingestBudget", &ingestBudget_, 256, 65536);
+
+	uint32_t total = progress.totalPointCount + progress.totalSegmentCount;
+	uint32_t loaded = progress.loadedPointCount + progress.loadedSegmentCount;
+	ImGui::Text("%s  segments %u/%u  points %u/%u", GetSceneStreamerStateName(progress.state),
+		progress.loadedSegmentCount, progress.totalSegmentCount, progress.loadedPointCount, progress.totalPointCount);
+	ImGui::ProgressBar(total > 0 ? static_cast<float>(loaded) / static_cast<float>(total) : 0.0f);
+	ImGui::Text("chunks %u  ingested %u  %.3f ms", progress.chunkCount, progress.ingestedLastFrame, progress.ingestMilliseconds);
+
+	ImGui::End();
+}
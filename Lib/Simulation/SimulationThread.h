@@ -0,0 +1,121 @@
+﻿#pragma once
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "MyMath.h"
+#include "PackedLine.h"
+#include "TripleBuffer.h"
+#include "EntityStore.h"
+#include "SceneStreamer.h"
+#include "EntityDrawer.h"
+
+/// <summary>
+/// シミュレーションを別スレッドで進めるクラス
+/// メインスレッド(描画側)からはカメラ行列と操作をトリプルバッファで渡し、
+/// シミュレーション側はエンティティを進めてスクリーン座標の線まで作ったフレームのスナップショットを返す
+/// Novice(Direct3D)とImGuiはメインスレッドでしか呼べないので、描画はメインスレッドで最新のスナップショットを使う
+/// </summary>
+class SimulationThread {
+public:
+	/// <summary>
+	/// 型定義
+	/// </summary>
+
+	/// <summary>
+	/// 描画側からシミュレーション側へ渡す入力
+	/// </summary>
+	struct Input {
+
+		bool hasCamera;                      // カメラ行列が設定されたか
+		Matrix4x4 viewProjectionViewportMatrix;
+		uint32_t maxDrawCount;               // 線にするエンティティの数
+		bool isPaused;
+		uint32_t spawnRequest;               // 増えたら生成し直す
+		uint32_t spawnPointCount;
+		uint32_t spawnSegmentCount;
+		uint32_t writeSceneRequest;          // 増えたらランダムなシーンをファイルに書く
+		uint32_t loadSceneRequest;           // 増えたらシーンをファイルから読む
+		uint32_t sceneWritePointCount;
+		uint32_t sceneWriteSegmentCount;
+		uint32_t ingestBudget;               // 1フレームにEntityStoreに入れる最大の数
+	};
+
+	/// <summary>
+	/// シミュレーション側が作る1フレーム分の変更されない結果
+	/// </summary>
+	struct FrameSnapshot {
+
+		uint64_t frameIndex;
+		Matrix4x4 viewProjectionViewportMatrix; // 線を作った時のカメラ
+		std::vector<PackedLine> lines;          // 色はGetPaletteの番号
+		uint32_t pointCount;
+		uint32_t segmentCount;
+		EntityStore::Stats entityStats;
+		SceneStreamer::Progress sceneProgress;
+		double frameMilliseconds;               // 更新と線の生成に掛かった時間
+	};
+
+private:
+	/// <summary>
+	/// メンバ変数
+	/// </summary>
+
+	// シミュレーション側の1フレームの間隔(秒)
+	static constexpr double kFrameInterval = 1.0 / 60.0;
+	// シーンのファイル
+	static constexpr const char* kScenePath = "scene.bin";
+
+	TripleBuffer<Input> inputs_;
+	TripleBuffer<FrameSnapshot> snapshots_;
+
+	std::thread thread_;
+	std::atomic<bool> isRunning_ = false;
+
+	// シミュレーション側のスレッドだけが触る
+	EntityStore entityStore_;
+	EntityDrawer entityDrawer_;
+	uint32_t handledSpawnRequest_ = 0;
+	SceneStreamer sceneStreamer_;
+	uint32_t handledWriteSceneRequest_ = 0;
+	uint32_t handledLoadSceneRequest_ = 0;
+
+	// 描画側のスレッドだけが触る
+	Input input_{};
+	int spawnPointCount_ = 20000;
+	int spawnSegmentCount_ = 2000;
+	int drawCount_ = 1000;
+	int sceneWritePointCount_ = 500000;
+	int sceneWriteSegmentCount_ = 50000;
+	int ingestBudget_ = 8192;
+
+	// シミュレーション側のスレッドの処理
+	void Run();
+
+public:
+	/// <summary>
+	/// メンバ関数
+	/// </summary>
+
+	// コンストラクタ
+	SimulationThread() {}
+	// デストラクタ
+	~SimulationThread() { Stop(); }
+
+	// スレッドの開始
+	void Start(uint32_t pointCount, uint32_t segmentCount);
+	// スレッドの終了
+	void Stop();
+
+	// 描画側: カメラ行列と操作を渡す
+	void SubmitInput(const Matrix4x4& viewProjectionViewportMatrix);
+	// 描画側: 最新のスナップショットを受け取る
+	const FrameSnapshot& AcquireSnapshot();
+	// 描画側: 操作と統計をImGuiで描画
+	void DrawImGui();
+
+	/// <summary>
+	/// ゲッター
+	/// </summary>
+	/// <returns></returns>
+	const LinePalette& GetPalette() const { return entityDrawer_.GetPalette(); }
+};
@@ -0,0 +1,241 @@
+﻿#include "Counters.h"
+#include <ImGui.h>
+#include <array>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace {
+
+	const size_t kCounterCount = static_cast<size_t>(Counter::kCount);
+	// 記録するフレーム数
+	const size_t kHistoryCount = 600;
+
+	using CounterValues = std::array<uint64_t, kCounterCount>;
+
+	/// <summary>
+	/// 1フレーム分の記録
+	/// </summary>
+	struct FrameRecord {
+
+		uint64_t frameIndex;
+		CounterValues values;
+	};
+
+	/// <summary>
+	/// 全スレッドのカウンタと集計結果
+	/// </summary>
+	struct Registry {
+
+		std::mutex mutex;
+
+		// 終了したスレッドのカウンタも累計を残したまま次のスレッドに使い回す
+		std::vector<std::unique_ptr<CounterDetail::ThreadCounters>> threadCounters;
+		std::vector<CounterDetail::ThreadCounters*> freeCounters;
+
+		// 前回の集計時の累計
+		CounterValues lastTotals{};
+
+		// 直近のフレーム(リングバッファ)
+		std::vector<FrameRecord> history;
+		size_t historyHead = 0;
+		uint64_t frameIndex = 0;
+	};
+
+	Registry& GetRegistry() {
+		static Registry registry;
+		return registry;
+	}
+
+	/// <summary>
+	/// スレッドの終了時にカウンタを返す
+	/// </summary>
+	struct ThreadReleaser {
+
+		CounterDetail::ThreadCounters* counters = nullptr;
+
+		~ThreadReleaser() {
+			if (!counters) {
+				return;
+			}
+
+			Registry& registry = GetRegistry();
+			std::lock_guard<std::mutex> lock(registry.mutex);
+			registry.freeCounters.push_back(counters);
+			CounterDetail::threadCounters = nullptr;
+		}
+	};
+
+	// 直前のフレームの値
+	CounterValues frameValues{};
+
+	// ImGuiの表示用
+	std::string dumpMessage;
+}
+
+/// <summary>
+/// 今のスレッドのカウンタを登録する
+/// </summary>
+/// <returns></returns>
+CounterDetail::ThreadCounters* CounterDetail::RegisterThread() {
+
+	Registry& registry = GetRegistry();
+
+	ThreadCounters* counters = nullptr;
+	{
+		std::lock_guard<std::mutex> lock(registry.mutex);
+
+		if (!registry.freeCounters.empty()) {
+			counters = registry.freeCounters.back();
+			registry.freeCounters.pop_back();
+		} else {
+
+			registry.threadCounters.push_back(std::make_unique<ThreadCounters>());
+			counters = registry.threadCounters.back().get();
+			for (std::atomic<uint64_t>& value : counters->values) {
+				value.store(0, std::memory_order_relaxed);
+			}
+		}
+	}
+
+	static thread_local ThreadReleaser releaser;
+	releaser.counters = counters;
+	threadCounters = counters;
+
+	return counters;
+}
+
+/// <summary>
+/// 全スレッドのカウンタを集計して1フレーム分の値にする
+/// 各スレッドの累計の合計から前回の合計を引くので、スレッド側の値は書き換えない
+/// </summary>
+void EndCounterFrame() {
+
+	Registry& registry = GetRegistry();
+	std::lock_guard<std::mutex> lock(registry.mutex);
+
+	CounterValues totals{};
+	for (const std::unique_ptr<CounterDetail::ThreadCounters>& counters : registry.threadCounters) {
+		for (size_t i = 0; i < kCounterCount; ++i) {
+			totals[i] += counters->values[i].load(std::memory_order_relaxed);
+		}
+	}
+
+	for (size_t i = 0; i < kCounterCount; ++i) {
+		frameValues[i] = totals[i] - registry.lastTotals[i];
+	}
+	registry.lastTotals = totals;
+
+	FrameRecord record = { registry.frameIndex++, frameValues };
+	if (registry.history.size() < kHistoryCount) {
+		registry.history.push_back(record);
+	} else {
+		registry.history[registry.historyHead] = record;
+		registry.historyHead = (registry.historyHead + 1) % kHistoryCount;
+	}
+}
+
+/// <summary>
+/// 直前のフレームの値
+/// </summary>
+/// <param name="counter"></param>
+/// <returns></returns>
+uint64_t GetCounterFrameValue(Counter counter) {
+
+	return frameValues[static_cast<size_t>(counter)];
+}
+
+/// <summary>
+/// カウンタの名前
+/// </summary>
+/// <param name="counter"></param>
+/// <returns></returns>
+const char* ToString(Counter counter) {
+
+	switch (counter) {
+	case Counter::kLinesSubmitted:
+		return "linesSubmitted";
+	case Counter::kVerticesTransformed:
+		return "verticesTransformed";
+	case Counter::kMultiplyCalls:
+		return "multiplyCalls";
+	case Counter::kInverseCalls:
+		return "inverseCalls";
+	case Counter::kSpheresCulled:
+		return "spheresCulled";
+	case Counter::kCacheHits:
+		return "cacheHits";
+	case Counter::kCacheMisses:
+		return "cacheMisses";
+	case Counter::kLineCacheHits:
+		return "lineCacheHits";
+	case Counter::kLineCacheMisses:
+		return "lineCacheMisses";
+	default:
+		return "unknown";
+	}
+}
+
+/// <summary>
+/// 記録している直近のフレームの値をCSVで保存する
+/// 1行が1フレームで、古いフレームから順に書く
+/// </summary>
+/// <param name="filePath"></param>
+/// <returns></returns>
+bool DumpCountersCSV(const std::string& filePath) {
+
+	std::ofstream file(filePath);
+	if (!file) {
+		return false;
+	}
+
+	file << "frame";
+	for (size_t i = 0; i < kCounterCount; ++i) {
+		file << ',' << ToString(static_cast<Counter>(i));
+	}
+	file << '\n';
+
+	Registry& registry = GetRegistry();
+	std::lock_guard<std::mutex> lock(registry.mutex);
+
+	const size_t count = registry.history.size();
+	for (size_t n = 0; n < count; ++n) {
+
+		const FrameRecord& record = registry.history[(registry.historyHead + n) % count];
+		file << record.frameIndex;
+		for (uint64_t value : record.values) {
+			file << ',' << value;
+		}
+		file << '\n';
+	}
+
+	return static_cast<bool>(file);
+}
+
+/// <summary>
+/// カウンタをImGuiで描画
+/// </summary>
+void DrawCountersImGui() {
+
+	ImGui::Begin("Counters");
+
+	for (size_t i = 0; i < kCounterCount; ++i) {
+		ImGui::Text("%-20s %llu", ToString(static_cast<Counter>(i)), static_cast<unsigned long long>(frameValues[i]));
+	}
+
+	uint64_t hitCount = frameValues[static_cast<size_t>(Counter::kCacheHits)];
+	uint64_t missCount = frameValues[static_cast<size_t>(Counter::kCacheMisses)];
+	if (hitCount + missCount > 0) {
+		ImGui::Text("cache hit rate %.1f%%", static_cast<double>(hitCount) * 100.0 / static_cast<double>(hitCount + missCount));
+	}
+
+	if (ImGui::Button("dump CSV")) {
+		dumpMessage = DumpCountersCSV("counters.csv") ? "saved counters.csv" : "failed to save counters.csv";
+	}
+	if (!dumpMessage.empty()) {
+		ImGui::Text("%s", dumpMessage.c_str());
+	}
+
+	ImGui::End();
+}
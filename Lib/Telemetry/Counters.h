@@ -0,0 +1,92 @@
+﻿#pragma once
+#include <stdint.h>
+#include <atomic>
+#include <string>
+
+/// <summary>
+/// 1フレームの処理量を数えるカウンタの種類
+/// </summary>
+enum class Counter : uint32_t {
+
+	kLinesSubmitted,      // LineBatcherに投入された線
+	kVerticesTransformed, // 座標変換した頂点(バッチ処理の関数で数える)
+	kMultiplyCalls,       // 4x4行列の積(カメラが行列を作り直す時に数える)
+	kInverseCalls,        // 逆行列(同上)
+	kSpheresCulled,       // 画面外で描かなかった球
+	kCacheHits,           // 派生値のキャッシュを使った回数
+	kCacheMisses,         // 派生値を再計算した回数
+	kLineCacheHits,       // スクリーン座標の線のキャッシュを使った物の数
+	kLineCacheMisses,     // スクリーン座標の線を作り直した物の数
+
+	kCount,
+};
+
+/*
+* カウンタはスレッドごとに持ち、EndCounterFrameでまとめて1フレーム分の値にする
+* スレッドごとの値は書くのが持ち主のスレッドだけなので、加算にlock付きの命令を使わない
+* Multiply、Transformなどの1回が数nsの関数の中では数えず、バッチ処理や呼び出し側でまとめて数える
+*/
+
+namespace CounterDetail {
+
+	/// <summary>
+	/// 1スレッド分のカウンタ(起動からの累計)
+	/// </summary>
+	struct ThreadCounters {
+
+		std::atomic<uint64_t> values[static_cast<size_t>(Counter::kCount)];
+	};
+
+	// 今のスレッドのカウンタ、まだ登録していなければnullptr
+	inline thread_local ThreadCounters* threadCounters = nullptr;
+
+	// 今のスレッドのカウンタを登録する
+	ThreadCounters* RegisterThread();
+}
+
+/// <summary>
+/// カウンタを増やす
+/// </summary>
+/// <param name="counter"></param>
+/// <param name="value"></param>
+inline void AddCounter(Counter counter, uint64_t value = 1) {
+
+	CounterDetail::ThreadCounters* counters = CounterDetail::threadCounters;
+	if (!counters) {
+		counters = CounterDetail::RegisterThread();
+	}
+
+	std::atomic<uint64_t>& slot = counters->values[static_cast<size_t>(counter)];
+	slot.store(slot.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+}
+
+/// <summary>
+/// 全スレッドのカウンタを集計して1フレーム分の値にする、Novice::EndFrameの直前に呼ぶ
+/// </summary>
+void EndCounterFrame();
+
+/// <summary>
+/// 直前のフレームの値
+/// </summary>
+/// <param name="counter"></param>
+/// <returns></returns>
+uint64_t GetCounterFrameValue(Counter counter);
+
+/// <summary>
+/// カウンタの名前(CSVの列名にも使う)
+/// </summary>
+/// <param name="counter"></param>
+/// <returns></returns>
+const char* ToString(Counter counter);
+
+/// <summary>
+/// 記録している直近のフレームの値をCSVで保存する
+/// </summary>
+/// <param name="filePath"></param>
+/// <returns>保存できたか</returns>
+bool DumpCountersCSV(const std::string& filePath);
+
+/// <summary>
+/// カウンタをImGuiで描画
+/// </summary>
+void DrawCountersImGui();
@@ -0,0 +1,94 @@
+﻿#include "StartupProfiler.h"
+#include <ImGui.h>
+#include <fstream>
+
+/// <summary>
+/// 計測開始からの時間
+/// </summary>
+/// <param name="time"></param>
+/// <returns></returns>
+double StartupProfiler::ToMilliseconds(Clock::time_point time) const {
+
+	return std::chrono::duration<double, std::milli>(time - origin_).count();
+}
+
+/// <summary>
+/// 段階の開始
+/// </summary>
+/// <param name="name"></param>
+void StartupProfiler::Begin(const std::string& name) {
+
+	End();
+
+	phaseName_ = name;
+	phaseBegin_ = Clock::now();
+	isInPhase_ = true;
+}
+
+/// <summary>
+/// 段階の終了
+/// </summary>
+void StartupProfiler::End() {
+
+	if (!isInPhase_) {
+		return;
+	}
+
+	Clock::time_point now = Clock::now();
+	phases_.push_back({ phaseName_, ToMilliseconds(phaseBegin_), std::chrono::duration<double, std::milli>(now - phaseBegin_).count() });
+	isInPhase_ = false;
+}
+
+/// <summary>
+/// 全ての段階の終了
+/// 合計には段階の間(記録していない処理)も含む
+/// </summary>
+void StartupProfiler::Finish() {
+
+	End();
+
+	totalMilliseconds_ = ToMilliseconds(Clock::now());
+}
+
+/// <summary>
+/// 記録をCSVで保存する
+/// </summary>
+/// <param name="filePath"></param>
+/// <returns>保存できたか</returns>
+bool StartupProfiler::SaveCSV(const std::string& filePath) const {
+
+	std::ofstream file(filePath);
+	if (!file) {
+		return false;
+	}
+
+	file << "phase,beginMs,ms\n";
+	for (const Phase& phase : phases_) {
+		file << phase.name << ',' << phase.beginMilliseconds << ',' << phase.milliseconds << '\n';
+	}
+	file << "total,0," << totalMilliseconds_ << '\n';
+
+	return static_cast<bool>(file);
+}
+
+/// <summary>
+/// 記録をImGuiで描画
+/// </summary>
+void StartupProfiler::DrawImGui() {
+
+	ImGui::Begin("Startup");
+
+	for (const Phase& phase : phases_) {
+		ImGui::Text("%-24s %8.3f ms", phase.name.c_str(), phase.milliseconds);
+	}
+	ImGui::Text("%-24s %8.3f ms", "total", totalMilliseconds_);
+
+	if (ImGui::Button("save CSV")) {
+		saveMessage_ = SaveCSV("startup_profile.csv") ? "saved startup_profile.csv" : "failed to save startup_profile.csv";
+	}
+	if (!saveMessage_.empty()) {
+		ImGui::Text("%s", saveMessage_.c_str());
+	}
+
+	ImGui::End();
+}
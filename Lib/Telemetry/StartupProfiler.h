@@ -0,0 +1,83 @@
+﻿#pragma once
+#include <stdint.h>
+#include <chrono>
+#include <string>
+#include <vector>
+
+/// <summary>
+/// 起動時の初期化の段階ごとの時間を測るクラス
+/// 段階は常に記録し(1段階につき時刻を2回取るだけ)、起動時の計測モードではコンソールとCSVに書き出す
+/// </summary>
+class StartupProfiler {
+public:
+	/// <summary>
+	/// 型定義
+	/// </summary>
+
+	// 1段階分の記録
+	struct Phase {
+
+		std::string name;
+		double beginMilliseconds; // 計測開始からの時刻
+		double milliseconds;      // 掛かった時間
+	};
+
+private:
+	using Clock = std::chrono::steady_clock;
+
+	/// <summary>
+	/// メンバ変数
+	/// </summary>
+
+	Clock::time_point origin_;
+	Clock::time_point phaseBegin_;
+	std::string phaseName_;
+	bool isInPhase_ = false;
+
+	std::vector<Phase> phases_;
+	double totalMilliseconds_ = 0.0;
+
+	// 計測モードか
+	bool isProfileMode_ = false;
+
+	// ImGuiの表示用
+	std::string saveMessage_;
+
+	// 計測開始からの時間(ミリ秒)
+	double ToMilliseconds(Clock::time_point time) const;
+
+public:
+	/// <summary>
+	/// メンバ関数
+	/// </summary>
+
+	// コンストラクタ(計測を始める)
+	StartupProfiler() { origin_ = Clock::now(); }
+	// デストラクタ
+	~StartupProfiler() {}
+
+	// 段階の開始、前の段階が終わっていなければ終える
+	void Begin(const std::string& name);
+	// 段階の終了
+	void End();
+	// 全ての段階の終了、計測開始からの合計を確定する
+	void Finish();
+
+	// 記録をCSVで保存する
+	bool SaveCSV(const std::string& filePath) const;
+	// 記録をImGuiで描画
+	void DrawImGui();
+
+	/// <summary>
+	/// ゲッター
+	/// </summary>
+	/// <returns></returns>
+	const std::vector<Phase>& GetPhases() const { return phases_; }
+	double GetTotalMilliseconds() const { return totalMilliseconds_; }
+	bool IsProfileMode() const { return isProfileMode_; }
+
+	/// <summary>
+	/// セッター
+	/// </summary>
+	void SetProfileMode(bool isProfileMode) { isProfileMode_ = isProfileMode; }
+};
@@ -0,0 +1,93 @@
+﻿#ifdef MT3_FUZZ
+
+#include "MathValidator.h"
+#include "MathDispatch.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+/*
+* libFuzzerの入口
+* clang -fsanitize=fuzzer,address -DMT3_FUZZ でこのファイルとLib/MyMath、Lib/Validationをビルドする
+* 入力のバイト列をfloatとして読み、MathValidatorと同じ比較をする
+*/
+
+namespace {
+
+	// 1つの入力に使うfloatの数(行列2つ、点、線分2つ、角度、拡縮、回転)
+	const size_t kFloatsPerCase = 16 + 16 + 3 + 6 + 6 + 1 + 3 + 3;
+	// 1回に使う入力の数の上限
+	const size_t kMaxCaseCount = 64;
+
+	/// <summary>
+	/// 有限でない値を0にし、大きすぎる値を丸める
+	/// 大きすぎる値は積の途中でオーバーフローし、誤差の比較に意味が無くなる
+	/// </summary>
+	/// <param name="value"></param>
+	/// <returns></returns>
+	float Sanitize(float value) {
+
+		const float kMaxValue = 1.0e4f;
+
+		if (!std::isfinite(value)) {
+			return 0.0f;
+		}
+		return (std::min)((std::max)(value, -kMaxValue), kMaxValue);
+	}
+
+	/// <summary>
+	/// floatの並びを入力にする
+	/// </summary>
+	/// <param name="values"></param>
+	/// <returns></returns>
+	MathValidator::Case ToCase(const float* values) {
+
+		MathValidator::Case testCase;
+		memcpy(&testCase.matrix1, values, sizeof(float) * 16);
+		memcpy(&testCase.matrix2, values + 16, sizeof(float) * 16);
+		testCase.point = { values[32], values[33], values[34] };
+		testCase.segment1 = { { values[35], values[36], values[37] }, { values[38], values[39], values[40] } };
+		testCase.segment2 = { { values[41], values[42], values[43] }, { values[44], values[45], values[46] } };
+		testCase.angle = values[47];
+		testCase.scale = { values[48], values[49], values[50] };
+		testCase.rotate = { values[51], values[52], values[53] };
+
+		return testCase;
+	}
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+
+	static bool isInitialized = false;
+	if (!isInitialized) {
+		InitMathDispatch();
+		isInitialized = true;
+	}
+
+	size_t floatCount = (std::min)(size / sizeof(float), kFloatsPerCase * kMaxCaseCount);
+	size_t caseCount = floatCount / kFloatsPerCase;
+	if (caseCount == 0) {
+		return 0;
+	}
+
+	std::vector<float> values(floatCount);
+	memcpy(values.data(), data, floatCount * sizeof(float));
+	for (float& value : values) {
+		value = Sanitize(value);
+	}
+
+	std::vector<MathValidator::Case> cases(caseCount);
+	for (size_t i = 0; i < caseCount; ++i) {
+		cases[i] = ToCase(values.data() + i * kFloatsPerCase);
+	}
+
+	MathValidator validator;
+	if (!validator.ValidateCases(cases)) {
+		abort();
+	}
+
+	return 0;
+}
+
+#endif // MT3_FUZZ
@@ -0,0 +1,647 @@
+﻿#include "MathValidator.h"
+#include "MathDispatch.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdio>
+#include <utility>
+#include <limits>
+
+namespace {
+
+	/// <summary>
+	/// 4x4行列の無限大ノルム(行の絶対値の和の最大)、有限でない要素があれば無限大
+	/// </summary>
+	double NormInf(const Matrix4x4d& m) {
+
+		double norm = 0.0;
+		for (int i = 0; i < 4; ++i) {
+			double sum = 0.0;
+			for (int j = 0; j < 4; ++j) {
+				sum += std::abs(m.m[i][j]);
+			}
+			if (!std::isfinite(sum)) {
+				return std::numeric_limits<double>::infinity();
+			}
+			norm = (std::max)(norm, sum);
+		}
+		return norm;
+	}
+
+	/// <summary>
+	/// 4x4行列の行列式(部分ピボット付きのガウスの消去法)
+	/// </summary>
+	double Determinant(Matrix4x4d m) {
+
+		double det = 1.0;
+		for (int column = 0; column < 4; ++column) {
+
+			int pivot = column;
+			for (int row = column + 1; row < 4; ++row) {
+				if (std::abs(m.m[row][column]) > std::abs(m.m[pivot][column])) {
+					pivot = row;
+				}
+			}
+
+			if (m.m[pivot][column] == 0.0) {
+				return 0.0;
+			}
+
+			if (pivot != column) {
+				std::swap(m.m[pivot], m.m[column]);
+				det = -det;
+			}
+
+			det *= m.m[column][column];
+			for (int row = column + 1; row < 4; ++row) {
+				double factor = m.m[row][column] / m.m[column][column];
+				for (int j = column; j < 4; ++j) {
+					m.m[row][j] -= factor * m.m[column][j];
+				}
+			}
+		}
+
+		return det;
+	}
+
+	/// <summary>
+	/// 行列式の展開の各項の絶対値の和(|M|のパーマネント)
+	/// 行列式をこれで割ると、展開の打ち消しで失う桁数の目安になる
+	/// </summary>
+	double DeterminantTermScale(const Matrix4x4d& m) {
+
+		int columns[4] = { 0, 1, 2, 3 };
+		double sum = 0.0;
+		do {
+			sum += std::abs(m.m[0][columns[0]] * m.m[1][columns[1]] * m.m[2][columns[2]] * m.m[3][columns[3]]);
+		} while (std::next_permutation(columns, columns + 4));
+
+		return sum;
+	}
+
+	/// <summary>
+	/// CPUが対応している全ての段階で処理する
+	/// </summary>
+	template<typename Function>
+	void ForEachSimdLevel(Function function) {
+
+		for (int level = 0; level <= static_cast<int>(GetDetectedSimdLevel()); ++level) {
+			const MathKernels& kernels = GetMathKernels(static_cast<SimdLevel>(level));
+			function(kernels, ToString(kernels.level));
+		}
+	}
+}
+
+/// <summary>
+/// 許容誤差の中に入っているか
+/// 誤差は基準の大きさ(scale)と参照値の大きい方の1ULPを単位として測る
+/// 打ち消しで参照値が小さくなっても、途中の値の大きさに見合った誤差を許す
+/// </summary>
+/// <param name="name"></param>
+/// <param name="level"></param>
+/// <param name="reference"></param>
+/// <param name="value"></param>
+/// <param name="scale"></param>
+/// <param name="maxUlp"></param>
+void MathValidator::Check(const char* name, const char* level, float reference, float value, float scale, float maxUlp) {
+
+	++report_.checkCount;
+
+	float ulp = 0.0f;
+	if (!std::isfinite(reference) || !std::isfinite(value)) {
+
+		// 有限でない値は同じ種類(NaN同士、同じ符号の無限大)なら一致とみなす
+		bool isSame = (std::isnan(reference) && std::isnan(value)) || reference == value;
+		ulp = isSame ? 0.0f : std::numeric_limits<float>::infinity();
+	} else {
+
+		// 非正規化数の範囲は精度が無いので、FLT_MINより小さい差は無視する
+		float unit = (std::max)(FLT_EPSILON * (std::max)(std::abs(reference), scale), FLT_MIN);
+		ulp = std::abs(reference - value) / unit;
+	}
+
+	if (std::isfinite(ulp)) {
+		report_.maxUlp = (std::max)(report_.maxUlp, ulp);
+	}
+
+	if (ulp <= maxUlp) {
+		return;
+	}
+
+	++report_.failureCount;
+	if (report_.failures.size() < kMaxRecordedFailures) {
+
+		char message[256];
+		snprintf(message, sizeof(message), "%s [%s] reference %.9g value %.9g (%.1f ulp > %.1f)",
+			name, level, reference, value, ulp, maxUlp);
+		report_.failures.push_back(message);
+	}
+}
+
+float MathValidator::RandomFloat(float min, float max) {
+
+	return std::uniform_real_distribution<float>(min, max)(random_);
+}
+
+/// <summary>
+/// ランダムな行列
+/// 一般の行列、アフィン変換、特異に近い行列、射影を含む行列、単位行列、零行列
+/// </summary>
+/// <returns></returns>
+Matrix4x4 MathValidator::RandomMatrix() {
+
+	Matrix4x4 matrix = {};
+
+	switch (random_() % 7) {
+	case 0:
+		for (int i = 0; i < 16; ++i) {
+			matrix.m[i / 4][i % 4] = RandomFloat(-10.0f, 10.0f);
+		}
+		break;
+	case 1:
+		matrix = MakeAffineMatrix(
+			{ RandomFloat(0.1f, 10.0f), RandomFloat(0.1f, 10.0f), RandomFloat(0.1f, 10.0f) },
+			{ RandomFloat(-Pi(), Pi()), RandomFloat(-Pi(), Pi()), RandomFloat(-Pi(), Pi()) },
+			RandomVector());
+		break;
+	case 2:
+		// 4行目を他の行の組み合わせにわずかなずれを足したものにする
+		for (int i = 0; i < 12; ++i) {
+			matrix.m[i / 4][i % 4] = RandomFloat(-10.0f, 10.0f);
+		}
+		{
+			float a = RandomFloat(-2.0f, 2.0f);
+			float b = RandomFloat(-2.0f, 2.0f);
+			for (int j = 0; j < 4; ++j) {
+				matrix.m[3][j] = matrix.m[0][j] * a + matrix.m[1][j] * b + RandomFloat(-1.0e-6f, 1.0e-6f);
+			}
+		}
+		break;
+	case 3:
+		for (int i = 0; i < 16; ++i) {
+			matrix.m[i / 4][i % 4] = RandomFloat(-1.0f, 1.0f);
+		}
+		matrix.m[3][3] = RandomFloat(-1.0f, 1.0f);
+		break;
+	case 4:
+		matrix = MakeIdentity4x4();
+		break;
+	case 5:
+		matrix = MakeAffineMatrix(
+			{ 1.0e-3f, 1.0e-3f, 1.0e-3f }, { RandomFloat(-Pi(), Pi()), 0.0f, 0.0f }, RandomVector());
+		break;
+	default:
+		break;
+	}
+
+	return matrix;
+}
+
+/// <summary>
+/// ランダムなベクトル(普通、大きい、小さい、0)
+/// </summary>
+/// <returns></returns>
+Vec3f MathValidator::RandomVector() {
+
+	float range = 0.0f;
+	switch (random_() % 4) {
+	case 0:
+		range = 10.0f;
+		break;
+	case 1:
+		range = 1.0e4f;
+		break;
+	case 2:
+		range = 1.0e-4f;
+		break;
+	default:
+		return { 0.0f, 0.0f, 0.0f };
+	}
+
+	return { RandomFloat(-range, range), RandomFloat(-range, range), RandomFloat(-range, range) };
+}
+
+/// <summary>
+/// ランダムな線分(長さ0、極端に短い線分を含む)
+/// </summary>
+/// <returns></returns>
+Segement MathValidator::RandomSegment() {
+
+	Segement segment = { RandomVector(), RandomVector() };
+
+	switch (random_() % 5) {
+	case 0:
+		segment.diff = { 0.0f, 0.0f, 0.0f };
+		break;
+	case 1:
+		segment.diff = { RandomFloat(-1.0e-20f, 1.0e-20f), 0.0f, 0.0f };
+		break;
+	default:
+		break;
+	}
+
+	return segment;
+}
+
+/// <summary>
+/// ランダムな角度(広い範囲、π/2の倍数、象限の境目の近く)
+/// </summary>
+/// <returns></returns>
+float MathValidator::RandomAngle() {
+
+	switch (random_() % 4) {
+	case 0:
+		return RandomFloat(-1.0e4f, 1.0e4f);
+	case 1:
+		return RandomFloat(-Pi(), Pi());
+	case 2:
+		return static_cast<float>(static_cast<int>(random_() % 64) - 32) * (Pi() / 2.0f);
+	default:
+		return static_cast<float>(static_cast<int>(random_() % 64) - 32) * (Pi() / 4.0f) + RandomFloat(-1.0e-6f, 1.0e-6f);
+	}
+}
+
+/// <summary>
+/// ランダムな拡縮(負、0、極端に小さい値を含む)
+/// </summary>
+/// <returns></returns>
+Vec3f MathValidator::RandomScale() {
+
+	switch (random_() % 4) {
+	case 0:
+		return { RandomFloat(-10.0f, 10.0f), RandomFloat(-10.0f, 10.0f), RandomFloat(-10.0f, 10.0f) };
+	case 1:
+		return { RandomFloat(1.0e-4f, 1.0e-3f), RandomFloat(1.0e-4f, 1.0e-3f), RandomFloat(1.0e-4f, 1.0e-3f) };
+	case 2:
+		return { 0.0f, RandomFloat(0.1f, 10.0f), 0.0f };
+	default:
+		return { 1.0f, 1.0f, 1.0f };
+	}
+}
+
+MathValidator::Case MathValidator::RandomCase() {
+
+	Case testCase;
+	testCase.matrix1 = RandomMatrix();
+	testCase.matrix2 = RandomMatrix();
+	testCase.point = RandomVector();
+	testCase.segment1 = RandomSegment();
+	testCase.segment2 = RandomSegment();
+	testCase.angle = RandomAngle();
+	testCase.scale = RandomScale();
+	testCase.rotate = { RandomAngle(), RandomAngle(), RandomAngle() };
+
+	return testCase;
+}
+
+/// <summary>
+/// 行列の積、参照はテンプレートのMathT::Multiply
+/// </summary>
+/// <param name="cases"></param>
+void MathValidator::ValidateMultiply(const std::vector<Case>& cases) {
+
+	ForEachSimdLevel([&](const MathKernels& kernels, const char* level) {
+		for (const Case& testCase : cases) {
+
+			const Matrix4x4& m1 = testCase.matrix1;
+			const Matrix4x4& m2 = testCase.matrix2;
+			Matrix4x4 reference = MathT::Multiply(m1, m2);
+			Matrix4x4 value = kernels.multiply(m1, m2);
+
+			for (int i = 0; i < 4; ++i) {
+				for (int j = 0; j < 4; ++j) {
+
+					float scale = 0.0f;
+					for (int k = 0; k < 4; ++k) {
+						scale += std::abs(m1.m[i][k] * m2.m[k][j]);
+					}
+
+					Check("Multiply", level, reference.m[i][j], value.m[i][j], scale, 4.0f);
+				}
+			}
+		}
+		});
+}
+
+/// <summary>
+/// 逆行列、参照は倍精度で求めた逆行列
+/// 誤差は条件数に比例するので、条件数が大きい(特異に近い)行列は比べない
+/// 余因子を使う実装なので、行列式がfloatの正規化数に収まらない行列や、展開の打ち消しが大きい(要素の大きさが極端に違う)行列も比べない
+/// </summary>
+/// <param name="cases"></param>
+void MathValidator::ValidateInverse(const std::vector<Case>& cases) {
+
+	const double kMaxCondition = 1.0e5;
+	const double kMinDeterminant = 1.0e-30;
+	const double kMaxDeterminant = 1.0e30;
+	// 行列式の展開で打ち消し合って失う桁の上限
+	const double kMinRelativeDeterminant = 1.0e-3;
+
+	for (const Case& testCase : cases) {
+
+		Matrix4x4d matrix = MathT::ConvertMatrix<Matrix4x4d>(testCase.matrix1);
+
+		double det = std::abs(Determinant(matrix));
+		if (!(det >= kMinDeterminant && det <= kMaxDeterminant && det >= kMinRelativeDeterminant * DeterminantTermScale(matrix))) {
+			Skip();
+			continue;
+		}
+
+		Matrix4x4d reference = MathT::Inverse(matrix);
+
+		double inverseNorm = NormInf(reference);
+		double condition = NormInf(matrix) * inverseNorm;
+		if (!std::isfinite(condition) || condition > kMaxCondition) {
+			Skip();
+			continue;
+		}
+
+		Matrix4x4 value = Inverse(testCase.matrix1);
+		float scale = static_cast<float>(condition * inverseNorm);
+
+		for (int i = 0; i < 4; ++i) {
+			for (int j = 0; j < 4; ++j) {
+				Check("Inverse", "float", static_cast<float>(reference.m[i][j]), value.m[i][j], scale, 64.0f);
+			}
+		}
+	}
+}
+
+/// <summary>
+/// 座標変換のバッチ処理、参照はスカラーのMathT::Transform
+/// wで割るのでwが打ち消しで小さく(0に)なる入力は比べない
+/// </summary>
+/// <param name="cases"></param>
+void MathValidator::ValidateTransform(const std::vector<Case>& cases) {
+
+	Vec3fSoA points;
+	points.Resize(cases.size());
+	for (size_t i = 0; i < cases.size(); ++i) {
+		points.Set(i, cases[i].point);
+	}
+
+	// 行列は全ての入力で1つ目のものを使う
+	const Matrix4x4& matrix = cases.front().matrix1;
+
+	ForEachSimdLevel([&](const MathKernels& kernels, const char* level) {
+
+		Vec3fSoA values;
+		kernels.transformBatch(points, matrix, values);
+
+		for (size_t i = 0; i < cases.size(); ++i) {
+
+			Vec3f point = points.Get(i);
+			Vec3f reference = MathT::Transform(point, matrix);
+			Vec3f value = values.Get(i);
+
+			// 各成分の項の絶対値の和
+			float termScales[4];
+			for (int j = 0; j < 4; ++j) {
+				termScales[j] = std::abs(point.x * matrix.m[0][j]) + std::abs(point.y * matrix.m[1][j]) +
+					std::abs(point.z * matrix.m[2][j]) + std::abs(matrix.m[3][j]);
+			}
+
+			float w = point.x * matrix.m[0][3] + point.y * matrix.m[1][3] + point.z * matrix.m[2][3] + matrix.m[3][3];
+			float absW = std::abs(w);
+			// wの項が全て0なら割らないので比べられる、打ち消しで0になったwは実装ごとに0になるかが変わる
+			// バッチ版はwの逆数を掛けるので、逆数がオーバーフローする非正規化数のwも比べない
+			if (termScales[3] > 0.0f && (absW < 1.0e-3f * termScales[3] || absW < FLT_MIN)) {
+				Skip();
+				continue;
+			}
+
+			const float* referenceValues = &reference.x;
+			const float* valueValues = &value.x;
+			for (int j = 0; j < 3; ++j) {
+
+				float scale = termScales[j];
+				if (w != 0.0f) {
+					scale = termScales[j] / absW + std::abs(referenceValues[j]) * termScales[3] / absW;
+				}
+
+				Check("TransformBatch", level, referenceValues[j], valueValues[j], scale, 8.0f);
+			}
+		}
+		});
+}
+
+/// <summary>
+/// 点と線分の最近接点のバッチ処理、参照はスカラーのClosestPoint
+/// </summary>
+/// <param name="cases"></param>
+void MathValidator::ValidateClosestPoint(const std::vector<Case>& cases) {
+
+	Vec3fSoA points;
+	SegmentSoA segments;
+	points.Resize(cases.size());
+	segments.Resize(cases.size());
+	for (size_t i = 0; i < cases.size(); ++i) {
+		points.Set(i, cases[i].point);
+		segments.Set(i, cases[i].segment1);
+	}
+
+	ForEachSimdLevel([&](const MathKernels& kernels, const char* level) {
+
+		Vec3fSoA values;
+		kernels.closestPointBatch(points, segments, values);
+
+		for (size_t i = 0; i < cases.size(); ++i) {
+
+			const Segement& segment = cases[i].segment1;
+			Vec3f value = values.Get(i);
+
+			// 長さ0の線分はスカラー版では0除算になるので、バッチ版の決まり(始点を返す)と比べる
+			Vec3f reference = segment.origin;
+			if (Dot(segment.diff, segment.diff) != 0.0f) {
+
+				reference = ClosestPoint(cases[i].point, segment);
+
+				// 長さが非正規化数の線分も、スカラー版では有限の値にならない
+				if (!std::isfinite(reference.x) || !std::isfinite(reference.y) || !std::isfinite(reference.z)) {
+					Skip();
+					continue;
+				}
+			}
+
+			float scale = Length(segment.origin) + Length(cases[i].point - segment.origin) + Length(segment.diff);
+
+			Check("ClosestPointBatch.x", level, reference.x, value.x, scale, 32.0f);
+			Check("ClosestPointBatch.y", level, reference.y, value.y, scale, 32.0f);
+			Check("ClosestPointBatch.z", level, reference.z, value.z, scale, 32.0f);
+		}
+		});
+}
+
+/// <summary>
+/// 2線分間の最近接点のバッチ処理、参照はスカラーのClosestPoints
+/// 平行に近い線分では最近接点は一意に決まらないので、2点間の距離で比べる
+/// </summary>
+/// <param name="cases"></param>
+void MathValidator::ValidateClosestPoints(const std::vector<Case>& cases) {
+
+	SegmentSoA segments1;
+	SegmentSoA segments2;
+	segments1.Resize(cases.size());
+	segments2.Resize(cases.size());
+	for (size_t i = 0; i < cases.size(); ++i) {
+		segments1.Set(i, cases[i].segment1);
+		segments2.Set(i, cases[i].segment2);
+	}
+
+	Vec3fSoA points1;
+	Vec3fSoA points2;
+	ClosestPointsBatch(segments1, segments2, points1, points2);
+
+	for (size_t i = 0; i < cases.size(); ++i) {
+
+		const Segement& segment1 = cases[i].segment1;
+		const Segement& segment2 = cases[i].segment2;
+
+		ClosestPointPair reference = ClosestPoints(segment1, segment2);
+		float referenceDistance = Length(reference.point2 - reference.point1);
+		float valueDistance = Length(points2.Get(i) - points1.Get(i));
+
+		float scale = Length(segment1.origin) + Length(segment1.diff) + Length(segment2.origin) + Length(segment2.diff);
+
+		Check("ClosestPointsBatch", "SSE2", referenceDistance, valueDistance, scale, 64.0f);
+	}
+}
+
+/// <summary>
+/// sinとcosのバッチ処理、参照は倍精度のstd::sin、std::cos
+/// 値は-1 ~ 1なので、1のULPを単位に比べる
+/// </summary>
+/// <param name="cases"></param>
+void MathValidator::ValidateSinCos(const std::vector<Case>& cases) {
+
+	std::vector<float> angles(cases.size());
+	for (size_t i = 0; i < cases.size(); ++i) {
+		angles[i] = cases[i].angle;
+	}
+
+	ForEachSimdLevel([&](const MathKernels& kernels, const char* level) {
+
+		std::vector<float> sinValues;
+		std::vector<float> cosValues;
+		kernels.sinCosBatch(angles, sinValues, cosValues);
+
+		for (size_t i = 0; i < angles.size(); ++i) {
+
+			double angle = static_cast<double>(angles[i]);
+			Check("SinCosBatch.sin", level, static_cast<float>(std::sin(angle)), sinValues[i], 1.0f, 4.0f);
+			Check("SinCosBatch.cos", level, static_cast<float>(std::cos(angle)), cosValues[i], 1.0f, 4.0f);
+		}
+		});
+}
+
+/// <summary>
+/// アフィン変換行列の閉じた式とバッチ処理、参照は行列の積で作るMathT::MakeAffineMatrix
+/// 各行の要素は拡縮の2倍より小さいので、それを基準の大きさにする
+/// </summary>
+/// <param name="cases"></param>
+void MathValidator::ValidateAffineMatrix(const std::vector<Case>& cases) {
+
+	Vec3fSoA scales;
+	Vec3fSoA rotates;
+	Vec3fSoA translates;
+	scales.Resize(cases.size());
+	rotates.Resize(cases.size());
+	translates.Resize(cases.size());
+	for (size_t i = 0; i < cases.size(); ++i) {
+		scales.Set(i, cases[i].scale);
+		rotates.Set(i, cases[i].rotate);
+		translates.Set(i, cases[i].point);
+	}
+
+	std::vector<Matrix4x4> batchMatrices;
+	MakeAffineMatrixBatch(scales, rotates, translates, batchMatrices);
+
+	for (size_t i = 0; i < cases.size(); ++i) {
+
+		const Case& testCase = cases[i];
+		Matrix4x4 reference = MathT::MakeAffineMatrix<Matrix4x4>(testCase.scale, testCase.rotate, testCase.point);
+		Matrix4x4 value = MakeAffineMatrix(testCase.scale, testCase.rotate, testCase.point);
+
+		const float rowScales[4] = {
+			std::abs(testCase.scale.x) * 2.0f, std::abs(testCase.scale.y) * 2.0f, std::abs(testCase.scale.z) * 2.0f, 0.0f };
+
+		for (int row = 0; row < 4; ++row) {
+			for (int column = 0; column < 4; ++column) {
+
+				// sinとcosは同じ関数なので、違いは積の丸め(FMA)だけ
+				Check("MakeAffineMatrix", "float", reference.m[row][column], value.m[row][column], rowScales[row], 4.0f);
+				// sinとcosの近似の誤差が3つの積で重なる
+				Check("MakeAffineMatrixBatch", ToString(GetSimdLevel()), reference.m[row][column], batchMatrices[i].m[row][column], rowScales[row], 16.0f);
+			}
+		}
+	}
+}
+
+/// <summary>
+/// ランダムな入力で検証する
+/// </summary>
+/// <param name="seed"></param>
+/// <param name="iterations">kBatchSize個ずつの入力を作る回数</param>
+/// <returns></returns>
+const MathValidator::Report& MathValidator::Run(uint32_t seed, uint32_t iterations) {
+
+	report_ = {};
+	random_.seed(seed);
+
+	std::vector<Case> cases(kBatchSize);
+	for (uint32_t iteration = 0; iteration < iterations; ++iteration) {
+
+		for (Case& testCase : cases) {
+			testCase = RandomCase();
+		}
+
+		ValidateCases(cases);
+	}
+
+	return report_;
+}
+
+/// <summary>
+/// 与えた入力で検証する
+/// </summary>
+/// <param name="cases"></param>
+/// <returns>これまでに失敗が無ければtrue</returns>
+bool MathValidator::ValidateCases(const std::vector<Case>& cases) {
+
+	if (cases.empty()) {
+		return report_.failureCount == 0;
+	}
+
+	ValidateMultiply(cases);
+	ValidateInverse(cases);
+	ValidateTransform(cases);
+	ValidateClosestPoint(cases);
+	ValidateClosestPoints(cases);
+	ValidateSinCos(cases);
+	ValidateAffineMatrix(cases);
+
+	return report_.failureCount == 0;
+}
+
+/// <summary>
+/// 検証の実行と結果をImGuiで描画
+/// </summary>
+void MathValidator::DrawImGui() {
+
+	ImGui::Begin("Validation");
+
+	ImGui::SliderInt("seed", &seed_, 0, 1000);
+	ImGui::SliderInt("iterations", &iterations_, 1, 10000);
+	if (ImGui::Button("run")) {
+		Run(static_cast<uint32_t>(seed_), static_cast<uint32_t>(iterations_));
+	}
+
+	ImGui::Text("checks %llu  skipped %llu", static_cast<unsigned long long>(report_.checkCount),
+		static_cast<unsigned long long>(report_.skippedCount));
+	ImGui::Text("failures %u  max %.2f ulp", report_.failureCount, report_.maxUlp);
+	for (const std::string& failure : report_.failures) {
+		ImGui::Text("%s", failure.c_str());
+	}
+
+	ImGui::End();
+}
@@ -0,0 +1,104 @@
+﻿#pragma once
+#include <random>
+#include <string>
+#include <vector>
+#include "MyMath.h"
+#include "MyMathBatch.h"
+
+/// <summary>
+/// 高速化した数学関数を元のスカラー実装と比べる検証クラス
+/// ランダムな入力(特異に近い行列や長さ0の線分なども含む)を作り、全ての命令セットの実装を誤差(ULP)の範囲で比べる
+/// 同じ検証をlibFuzzerの入口(MathFuzz.cpp)からも使う
+/// </summary>
+class MathValidator {
+public:
+	/// <summary>
+	/// 1つの入力
+	/// </summary>
+	struct Case {
+
+		Matrix4x4 matrix1;
+		Matrix4x4 matrix2;
+		Vec3f point;
+		Segement segment1;
+		Segement segment2;
+		float angle;
+		Vec3f scale;
+		Vec3f rotate;
+	};
+
+	/// <summary>
+	/// 検証結果
+	/// </summary>
+	struct Report {
+
+		uint64_t checkCount;               // 比べた値の数
+		uint64_t skippedCount;             // 条件が悪く比べなかった数
+		uint32_t failureCount;             // 誤差を超えた数
+		float maxUlp;                      // 一番大きかった誤差(許容値の基準に対するULP)
+		std::vector<std::string> failures; // 最初のいくつかの失敗の内容
+	};
+
+private:
+	/// <summary>
+	/// メンバ変数
+	/// </summary>
+
+	// 1回にまとめて調べる数、SIMDの幅で割り切れない数にして端数の処理も通す
+	static const uint32_t kBatchSize = 37;
+	// 記録する失敗の数
+	static const uint32_t kMaxRecordedFailures = 16;
+
+	Report report_{};
+	std::mt19937 random_;
+
+	// ImGuiで変更する値
+	int seed_ = 1;
+	int iterations_ = 200;
+
+	// 許容誤差の中に入っているか、基準の大きさ(scale)に対するULPで比べる
+	void Check(const char* name, const char* level, float reference, float value, float scale, float maxUlp);
+	// 条件が悪く比べなかった
+	void Skip() { ++report_.skippedCount; }
+
+	// ランダムな入力
+	float RandomFloat(float min, float max);
+	Matrix4x4 RandomMatrix();
+	Vec3f RandomVector();
+	Segement RandomSegment();
+	float RandomAngle();
+	Vec3f RandomScale();
+	Case RandomCase();
+
+	// 項目ごとの検証
+	void ValidateMultiply(const std::vector<Case>& cases);
+	void ValidateInverse(const std::vector<Case>& cases);
+	void ValidateTransform(const std::vector<Case>& cases);
+	void ValidateClosestPoint(const std::vector<Case>& cases);
+	void ValidateClosestPoints(const std::vector<Case>& cases);
+	void ValidateSinCos(const std::vector<Case>& cases);
+	void ValidateAffineMatrix(const std::vector<Case>& cases);
+
+public:
+	/// <summary>
+	/// メンバ関数
+	/// </summary>
+
+	// コンストラクタ
+	MathValidator() {}
+	// デストラクタ
+	~MathValidator() {}
+
+	// ランダムな入力で検証する
+	const Report& Run(uint32_t seed, uint32_t iterations);
+	// 与えた入力で検証する、失敗が無ければtrue
+	bool ValidateCases(const std::vector<Case>& cases);
+	// 検証の実行と結果をImGuiで描画
+	void DrawImGui();
+
+	/// <summary>
+	/// ゲッター
+	/// </summary>
+	/// <returns></returns>
+	const Report& GetReport() const { return report_; }
+};
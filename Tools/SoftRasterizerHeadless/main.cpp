@@ -0,0 +1,201 @@
+﻿#include "SoftRasterizer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+/// <summary>
+/// Novice(Windows)無しでSoftRasterizerを動かすドライバ
+/// 参照画像をTGAで書き出し、線の描画速度(1秒あたりの線の数)を表示する
+/// 使い方: SoftRasterizerHeadless [出力先のフォルダ] [スレッド数(0ならハードウェアのスレッド数)]
+/// </summary>
+
+namespace {
+
+	// 出力の大きさ(ゲーム側のウィンドウと同じ)
+	const uint32_t kWidth = 1280;
+	const uint32_t kHeight = 720;
+
+	// 速度を測る線の数と回数
+	const uint32_t kBenchmarkLineCount = 100000;
+	const uint32_t kBenchmarkIterations = 20;
+
+	/// <summary>
+	/// 簡単な透視投影のカメラ
+	/// MyMathはNoviceに依存するので、参照画像に要る分だけここで計算する
+	/// </summary>
+	struct ReferenceCamera {
+
+		Vec3f position;
+		float pitch;       // x軸回りの回転(下向きが正)
+		float focalLength; // 画面の高さの半分に対する焦点距離
+		float nearZ;
+		float farZ;
+
+		// ワールド座標をスクリーン座標へ(zは0から1の深度)
+		Vec3f Project(const Vec3f& world) const {
+
+			Vec3f local = { world.x - position.x, world.y - position.y, world.z - position.z };
+			float cosPitch = std::cos(pitch);
+			float sinPitch = std::sin(pitch);
+			float y = local.y * cosPitch + local.z * sinPitch;
+			float z = -local.y * sinPitch + local.z * cosPitch;
+
+			float scale = focalLength * static_cast<float>(kHeight) * 0.5f / z;
+			return {
+				static_cast<float>(kWidth) * 0.5f + local.x * scale,
+				static_cast<float>(kHeight) * 0.5f - y * scale,
+				(z - nearZ) / (farZ - nearZ) };
+		}
+	};
+
+	/// <summary>
+	/// ゲーム側の初期画面に近い、格子と球の線を作る
+	/// </summary>
+	/// <returns></returns>
+	std::vector<ScreenLine> MakeReferenceScene() {
+
+		const ReferenceCamera kCamera = { { 0.0f, 1.9f, -6.49f }, 0.26f, 1.73f, 0.1f, 100.0f };
+
+		std::vector<ScreenLine> lines;
+
+		// xz平面の格子
+		const int32_t kGridDivision = 10;
+		const float kGridHalfWidth = 2.0f;
+		const float kGridStep = kGridHalfWidth * 2.0f / static_cast<float>(kGridDivision);
+		for (int32_t i = 0; i <= kGridDivision; ++i) {
+
+			float offset = -kGridHalfWidth + kGridStep * static_cast<float>(i);
+			uint32_t color = i == kGridDivision / 2 ? 0x000000ff : 0xaaaaaaff;
+			lines.push_back({ kCamera.Project({ offset, 0.0f, -kGridHalfWidth }), kCamera.Project({ offset, 0.0f, kGridHalfWidth }), color });
+			lines.push_back({ kCamera.Project({ -kGridHalfWidth, 0.0f, offset }), kCamera.Project({ kGridHalfWidth, 0.0f, offset }), color });
+		}
+
+		// 緯度と経度で分けた球
+		const uint32_t kSubdivision = 16;
+		const float kRadius = 0.5f;
+		const float kPi = 3.14159265f;
+		auto spherePoint = [kRadius](float lat, float lon) -> Vec3f {
+			return { kRadius * std::cos(lat) * std::cos(lon), kRadius * std::sin(lat), kRadius * std::cos(lat) * std::sin(lon) };
+			};
+		for (uint32_t latIndex = 0; latIndex < kSubdivision; ++latIndex) {
+
+			float lat = -kPi / 2.0f + kPi / static_cast<float>(kSubdivision) * static_cast<float>(latIndex);
+			float nextLat = lat + kPi / static_cast<float>(kSubdivision);
+
+			for (uint32_t lonIndex = 0; lonIndex < kSubdivision; ++lonIndex) {
+
+				float lon = 2.0f * kPi / static_cast<float>(kSubdivision) * static_cast<float>(lonIndex);
+				float nextLon = lon + 2.0f * kPi / static_cast<float>(kSubdivision);
+
+				Vec3f a = kCamera.Project(spherePoint(lat, lon));
+				lines.push_back({ a, kCamera.Project(spherePoint(nextLat, lon)), 0x000000ff });
+				lines.push_back({ a, kCamera.Project(spherePoint(lat, nextLon)), 0x000000ff });
+			}
+		}
+
+		return lines;
+	}
+
+	/// <summary>
+	/// グリッドや球の線に近い、短めの線をランダムに作る(ベンチマークのSoftRasterizer 100k linesと同じ分布)
+	/// </summary>
+	/// <returns></returns>
+	std::vector<ScreenLine> MakeBenchmarkLines() {
+
+		std::mt19937 random(0);
+		std::uniform_real_distribution<float> x(0.0f, static_cast<float>(kWidth));
+		std::uniform_real_distribution<float> y(0.0f, static_cast<float>(kHeight));
+		std::uniform_real_distribution<float> depth(0.0f, 1.0f);
+		std::uniform_real_distribution<float> length(-32.0f, 32.0f);
+
+		std::vector<ScreenLine> lines;
+		lines.reserve(kBenchmarkLineCount);
+		for (uint32_t i = 0; i < kBenchmarkLineCount; ++i) {
+			Vec3f start = { x(random), y(random), depth(random) };
+			Vec3f end = { start.x + length(random), start.y + length(random), depth(random) };
+			lines.push_back({ start, end, 0xffffffff });
+		}
+
+		return lines;
+	}
+
+	/// <summary>
+	/// 同じ線を何度か描いて、最も速かった回と平均の1秒あたりの線の数を表示する
+	/// </summary>
+	/// <param name="rasterizer"></param>
+	/// <param name="lines"></param>
+	/// <param name="name"></param>
+	void MeasureThroughput(SoftRasterizer& rasterizer, const std::vector<ScreenLine>& lines, const char* name) {
+
+		double bestLinesPerSecond = 0.0;
+		double totalMilliseconds = 0.0;
+
+		for (uint32_t i = 0; i < kBenchmarkIterations; ++i) {
+
+			rasterizer.Clear(0x000000ff);
+			rasterizer.DrawLines(lines);
+
+			const SoftRasterizer::Stats& stats = rasterizer.GetStats();
+			bestLinesPerSecond = (std::max)(bestLinesPerSecond, stats.linesPerSecond);
+			totalMilliseconds += stats.milliseconds;
+		}
+
+		double averageLinesPerSecond = static_cast<double>(lines.size()) * kBenchmarkIterations / (totalMilliseconds * 1.0e-3);
+		std::printf("%-24s %8.3f ms/frame  %8.2f Mlines/s (best %8.2f)\n", name,
+			totalMilliseconds / kBenchmarkIterations, averageLinesPerSecond * 1.0e-6, bestLinesPerSecond * 1.0e-6);
+	}
+}
+
+int main(int argc, char* argv[]) {
+
+	std::string outputDirectory = argc > 1 ? argv[1] : ".";
+	uint32_t threadCount = argc > 2 ? static_cast<uint32_t>(std::strtoul(argv[2], nullptr, 10)) : 0;
+
+	SoftRasterizer rasterizer;
+	rasterizer.Init(kWidth, kHeight, threadCount);
+
+	/****************************************************************************************************************************/
+	// 参照画像
+
+	const std::vector<ScreenLine> kReferenceLines = MakeReferenceScene();
+
+	const SoftRasterizer::LineMode kLineModes[] = { SoftRasterizer::LineMode::kBresenham, SoftRasterizer::LineMode::kWu };
+	const char* kImageNames[] = { "softRasterizer_bresenham.tga", "softRasterizer_wu.tga" };
+
+	for (uint32_t i = 0; i < 2; ++i) {
+
+		rasterizer.SetLineMode(kLineModes[i]);
+		rasterizer.Clear(0x1a1a1aff);
+		rasterizer.DrawLines(kReferenceLines);
+
+		std::string filePath = outputDirectory + "/" + kImageNames[i];
+		if (!rasterizer.SaveTGA(filePath)) {
+			std::fprintf(stderr, "failed to write %s\n", filePath.c_str());
+			return 1;
+		}
+		std::printf("wrote %s (%zu lines)\n", filePath.c_str(), kReferenceLines.size());
+	}
+
+	/****************************************************************************************************************************/
+	// 線の描画速度
+
+	const std::vector<ScreenLine> kBenchmarkLines = MakeBenchmarkLines();
+
+	std::printf("%ux%u, %zu lines, %u iterations\n", kWidth, kHeight, kBenchmarkLines.size(), kBenchmarkIterations);
+
+	rasterizer.SetDepthTest(true);
+	rasterizer.SetLineMode(SoftRasterizer::LineMode::kBresenham);
+	MeasureThroughput(rasterizer, kBenchmarkLines, "bresenham");
+	rasterizer.SetLineMode(SoftRasterizer::LineMode::kWu);
+	MeasureThroughput(rasterizer, kBenchmarkLines, "wu");
+	rasterizer.SetDepthTest(false);
+	rasterizer.SetLineMode(SoftRasterizer::LineMode::kBresenham);
+	MeasureThroughput(rasterizer, kBenchmarkLines, "bresenham (no depth)");
+
+	return 0;
+}
@@ -1,39 +1,261 @@
 #include "MyMath.h"
+#include "MathDispatch.h"
 #include "Camera.h"
 #include "Grid.h"
 #include "Sphere.h"
+#include "Picker.h"
+#include "Derived.h"
+#include "LineBatcher.h"
+#include "SoftRasterizer.h"
+#include "RenderResolution.h"
+#include "SimulationThread.h"
+#include "BenchmarkCases.h"
+#include "MathValidator.h"
+#include "Counters.h"
+#include "StartupProfiler.h"
+#include "MeshTables.h"
+#include "Spline.h"
+#include "ShapeDrawer.h"
+#include "RenderQueue.h"
+#include "MultiViewRenderer.h"
+#include "ScreenLineCache.h"
 
+#include <cmath>
+#include <cstring>
 #include <memory>
 
 const char kWindowTitle[] = "LC1B_28_ムラタ_サクヤ_MT3_02_00";
 
+// ウィンドウの大きさ
+const uint32_t kWindowWidth = 1280;
+const uint32_t kWindowHeight = 720;
+
+// 実行時に作った球と格子の表のキャッシュ
+const char kMeshTableCachePath[] = "mesh_tables.bin";
+
+// 描画キューに積む物
+enum class Drawable : uint32_t {
+
+	kGrid,
+	kPointSphere,
+	kClosestPointSphere,
+	kSegment,
+	kSpline,
+	kShapes,
+	kEntities,
+};
+
+// 箱と平面の描画に使う値、変わった時だけ線を作り直す
+struct CollisionShapeState {
+
+	AABB aabb;
+	OBB obb;
+	Plane plane;
+	uint32_t aabbColor;
+	uint32_t obbColor;
+	uint32_t planeColor;
+};
+
+// 視点の配置
+const int kViewLayoutSingle = 0; // 1画面
+const int kViewLayoutSplit = 1;  // 左右に2分割(右は上から見た正射影)
+const int kViewLayoutQuad = 2;   // 4分割(右上、左下、右下は上、前、横から見た正射影)
+
 // Windowsアプリでのエントリーポイント(main関数)
-int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int) {
+int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR commandLine, int) {
+
+	// 初期化の段階ごとの時間を測る
+	// "--startup-profile"を付けて起動すると、最初のフレームまでの結果を書き出して終了する
+	StartupProfiler startupProfiler;
+	startupProfiler.SetProfileMode(commandLine && std::strstr(commandLine, "--startup-profile") != nullptr);
 
 	// ライブラリの初期化
-	Novice::Initialize(kWindowTitle, 1280, 720);
+	startupProfiler.Begin("Novice::Initialize");
+	Novice::Initialize(kWindowTitle, static_cast<int>(kWindowWidth), static_cast<int>(kWindowHeight));
+
+	// CPUに合わせて数学関数の実装を選ぶ
+	startupProfiler.Begin("InitMathDispatch");
+	InitMathDispatch();
+
+	// 高速化した数学関数を元の実装と比べる
+	MathValidator mathValidator;
+#ifdef _DEBUG
+	{
+		startupProfiler.Begin("MathValidator");
+		const MathValidator::Report& report = mathValidator.Run(1, 200);
+		Novice::ConsolePrintf("MathValidator: %llu checks, %u failures, max %.2f ulp\n",
+			static_cast<unsigned long long>(report.checkCount), report.failureCount, report.maxUlp);
+	}
+	{
+		// シーンを原点から遠くに置いた時の、単精度のワールド座標とカメラ相対描画の誤差
+		startupProfiler.Begin("Camera::MeasurePrecision");
+		const Vec3d kFarOrigin = { 1000000.0,0.0,1000000.0 };
+		Camera::PrecisionReport report = Camera::MeasurePrecision(kFarOrigin);
+		Novice::ConsolePrintf("Camera precision at %.0f: world %.3f px, camera relative %.4f px\n",
+			kFarOrigin.x, report.worldMaxError, report.relativeMaxError);
+	}
+#endif
 
 	// キー入力結果を受け取る箱
 	char keys[256] = { 0 };
 	char preKeys[256] = { 0 };
 
-	Segement segment = {
+	Tracked<Segement> segment({
 		{-2.0f,-1.0f,0.0f},
 		{3.0f,2.0f,2.0f},
-	};
+		});
 
-	Vec3f point = { -1.5f,0.6f,0.6f };
-	Vec3f project = Project(point - segment.origin, segment.diff);
-	Vec3f closestPoint = ClosestPoint(point, segment);
+	Tracked<Vec3f> point({ -1.5f,0.6f,0.6f });
 
+	startupProfiler.Begin("Camera::Init");
 	Camera camera;
-	camera.Init();
+	camera.Init(kWindowWidth, kWindowHeight);
+
+	// 分割表示で使う、上、前、横から見た正射影の視点
+	Camera topCamera;
+	topCamera.Init(kWindowWidth, kWindowHeight);
+	topCamera.SetProjection(Camera::Projection::kOrthographic);
+	topCamera.SetTransform({ 1.0f,1.0f,1.0f }, { Pi() / 2.0f,0.0f,0.0f }, { 0.0f,20.0f,0.0f });
+
+	Camera frontCamera;
+	frontCamera.Init(kWindowWidth, kWindowHeight);
+	frontCamera.SetProjection(Camera::Projection::kOrthographic);
+	frontCamera.SetTransform({ 1.0f,1.0f,1.0f }, { 0.0f,0.0f,0.0f }, { 0.0f,0.0f,-20.0f });
+
+	Camera sideCamera;
+	sideCamera.Init(kWindowWidth, kWindowHeight);
+	sideCamera.SetProjection(Camera::Projection::kOrthographic);
+	sideCamera.SetTransform({ 1.0f,1.0f,1.0f }, { 0.0f,Pi() / 2.0f,0.0f }, { -20.0f,0.0f,0.0f });
+
+	int viewLayout = kViewLayoutSingle;
+
+	// 入力(点、線分、カメラ)が変わった時だけ再計算する値
+	DerivedStats derivedStats;
+
+	Derived<Vec3f> project(
+		[&]() { return Project(point.Get() - segment.Get().origin, segment.Get().diff); },
+		{ &point, &segment }, &derivedStats);
+	Derived<Vec3f> closestPoint(
+		[&]() { return ClosestPoint(point.Get(), segment.Get()); },
+		{ &point, &segment }, &derivedStats);
+
+	// 線分の始点と終点のスクリーン座標
+	Derived<Vec3f> segmentScreenStart(
+		[&]() { return Transform(segment.Get().origin, camera.GetViewProjectionViewportMatrix()); },
+		{ &segment, &camera }, &derivedStats);
+	Derived<Vec3f> segmentScreenEnd(
+		[&]() { return Transform(segment.Get().origin + segment.Get().diff, camera.GetViewProjectionViewportMatrix()); },
+		{ &segment, &camera }, &derivedStats);
+
+	// 球と格子の表、既定の分割数はコンパイル時に作ってあり、それ以外は前回のキャッシュから読む
+	startupProfiler.Begin("mesh tables");
+	LoadMeshTableCache(kMeshTableCachePath);
+	GetGridTable(kDefaultGridSubdivision, kDefaultGridHalfWidth);
+	GetSphereTable(kDefaultSphereSubdivision);
+	int sphereSubdivision = static_cast<int>(kDefaultSphereSubdivision);
+	std::string meshTableMessage;
 
 	Grid grid;
 
+	// 1フレーム分の線をまとめて描画する
+	startupProfiler.Begin("render targets");
+	LineBatcher lineBatcher;
+	lineBatcher.Init(kWindowWidth, kWindowHeight);
+
+	// 奥の線を隠す不透明な球
+	SphereShape occluder = { { 0.0f,0.0f,1.0f }, 0.5f };
+
+	// 線をCPUで描いて参照画像を作る
+	SoftRasterizer softRasterizer;
+	softRasterizer.Init(kWindowWidth, kWindowHeight);
+	bool isSoftRasterizerWu = false;
+	bool isSoftRasterizerDepthTest = true;
+	bool isSoftRasterizerEveryFrame = false;
+
+	// CPUラスタライザの内部解像度、毎フレーム描く時は描画時間が予算を超えると下げる
+	RenderResolution rasterResolution;
+	rasterResolution.Init(kWindowWidth, kWindowHeight);
+	uint64_t rasterResolutionVersion = rasterResolution.GetVersion();
+
+	// 動き回る点と線分は別スレッドで更新する
+	startupProfiler.Begin("SimulationThread::Start");
+	SimulationThread simulation;
+	simulation.Start(20000, 2000);
+
 	Sphere pointSphere;
 	Sphere closestPointSphere;
 
+	// 制御点を通る曲線、最近接点はワールド空間で分割した折れ線で求める
+	startupProfiler.Begin("Spline");
+	Spline spline;
+	spline.SetControlPoints(Spline::Type::kCatmullRom, {
+		{ -3.0f,0.0f,-1.0f }, { -2.0f,1.0f,1.0f }, { -0.5f,0.0f,2.0f }, { 0.5f,1.5f,0.5f },
+		{ 1.5f,0.0f,-1.0f }, { 2.5f,1.0f,0.0f }, { 3.0f,0.5f,2.0f } });
+	Polyline splinePolyline;
+	spline.Flatten(0.001f, splinePolyline);
+	Tracked<float> splinePixelTolerance(0.5f);
+
+	// 描画キューで深度を測る曲線の代表点(制御点の平均)
+	Vec3f splineCenter = { 0.0f,0.0f,0.0f };
+	for (const Vec3f& controlPoint : spline.GetControlPoints()) {
+		splineCenter += controlPoint * (1.0f / static_cast<float>(spline.GetControlPoints().size()));
+	}
+
+	// 衝突判定を確かめる箱と平面、線分や互いに交差すると赤くなる
+	ShapeDrawer shapeDrawer;
+	AABB aabb = { { -0.5f,-0.5f,-0.5f }, { 0.0f,0.0f,0.0f } };
+	Vec3f obbCenter = { 0.5f,0.3f,0.0f };
+	Vec3f obbRotate = { 0.0f,0.4f,0.2f };
+	Vec3f obbSize = { 0.4f,0.3f,0.2f };
+	Plane plane = { { 0.0f,1.0f,0.0f }, -0.8f };
+	Tracked<CollisionShapeState> collisionShapes;
+
+	// マウスで選択できる太さ
+	const float kPickRadius = 0.05f;
+
+	Picker picker;
+	Picker::Result pickResult;
+
+	// 分割表示では形をワールド座標で1回だけ作り、全ての視点でまとめて座標変換する
+	MultiViewRenderer multiViewRenderer;
+	WorldLines worldLines;
+
+	// 1画面の時は、物とカメラが変わらなければスクリーン座標の線を前のフレームから使い回す
+	ScreenLineCache screenLineCache;
+	const uint32_t gridLines = screenLineCache.Register("grid", { &grid, &camera });
+	const uint32_t pointSphereLines = screenLineCache.Register("point sphere", { &pointSphere, &point, &camera });
+	const uint32_t closestPointSphereLines = screenLineCache.Register("closest point sphere", { &pointSphere, &closestPoint, &camera });
+	const uint32_t splineLines = screenLineCache.Register("spline", { &spline, &splinePixelTolerance, &point, &camera });
+	const uint32_t shapeLines = screenLineCache.Register("shapes", { &collisionShapes, &camera });
+
+	// 描画する物を1フレームごとに深度と色で並べ替える、材質の番号は色の番号
+	RenderQueue renderQueue;
+	LinePalette drawableMaterials;
+	const uint16_t gridMaterial = drawableMaterials.Register(0xaaaaaaff);
+	const uint16_t pointMaterial = drawableMaterials.Register(0xff0000ff);
+	const uint16_t closestPointMaterial = drawableMaterials.Register(0x000000ff);
+	const uint16_t whiteMaterial = drawableMaterials.Register(0xffffffff);
+	const uint16_t splineMaterial = drawableMaterials.Register(0x00ffffff);
+
+	// ベンチマークの入力データもここで作る
+	startupProfiler.Begin("benchmark setup");
+	Benchmark benchmark;
+	AddMathBenchmarks(benchmark);
+	AddPickingBenchmarks(benchmark);
+	AddRasterizerBenchmarks(benchmark);
+	AddSimulationBenchmarks(benchmark);
+	AddDispatchBenchmarks(benchmark);
+	AddCurveBenchmarks(benchmark);
+	AddCollisionBenchmarks(benchmark);
+	AddBroadphaseBenchmarks(benchmark);
+	AddLineFormatBenchmarks(benchmark);
+	AddRenderQueueBenchmarks(benchmark);
+	AddMultiViewBenchmarks(benchmark);
+
+	// 最初のフレームを描き終えるまでを起動時間とする
+	startupProfiler.Begin("first frame");
+	bool isFirstFrame = true;
+
 	// ウィンドウの×ボタンが押されるまでループ
 	while (Novice::ProcessMessage() == 0) {
 		// フレームの開始
@@ -46,47 +268,397 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int) {
 		// 計算結果をImGuiで描画
 		ImGui::Begin("Result");
 
-		ImGui::SliderFloat3("point", &point.x, -10.0f, 10.0f);
-		ImGui::SliderFloat3("project", &project.x, -10.0f, 10.0f);
-		ImGui::SliderFloat3("closestPoint", &closestPoint.x, -10.0f, 10.0f);
+		Vec3f pointValue = point.Get();
+		if (ImGui::SliderFloat3("point", &pointValue.x, -10.0f, 10.0f)) {
+			point.Set(pointValue);
+		}
+
+		// 計算結果は表示のみ
+		Vec3f projectValue = project.Get();
+		Vec3f closestPointValue = closestPoint.Get();
+		ImGui::SliderFloat3("project", &projectValue.x, -10.0f, 10.0f);
+		ImGui::SliderFloat3("closestPoint", &closestPointValue.x, -10.0f, 10.0f);
+
+		ImGui::SliderFloat3("occluderCenter", &occluder.center.x, -10.0f, 10.0f);
+		ImGui::SliderFloat("occluderRadius", &occluder.radius, 0.0f, 5.0f);
 
+		ImGui::Text("derived hit %llu / miss %llu (%.1f%%)",
+			static_cast<unsigned long long>(derivedStats.hitCount), static_cast<unsigned long long>(derivedStats.missCount),
+			derivedStats.GetHitRate() * 100.0f);
+
+		ImGui::End();
+
+		// 前のフレームのカウンタ
+		DrawCountersImGui();
+		startupProfiler.DrawImGui();
+
+		// 球の分割数と表のキャッシュ
+		ImGui::Begin("MeshTables");
+		if (ImGui::SliderInt("sphere subdivision", &sphereSubdivision, 3, 64)) {
+			pointSphere.SetSubdivision(static_cast<uint32_t>(sphereSubdivision));
+			closestPointSphere.SetSubdivision(static_cast<uint32_t>(sphereSubdivision));
+		}
+		MeshTableStats meshTableStats = GetMeshTableStats();
+		ImGui::Text("builtIn %u  generated %u  loaded %u",
+			meshTableStats.builtInCount, meshTableStats.generatedCount, meshTableStats.loadedCount);
+		if (ImGui::Button("save cache")) {
+			meshTableMessage = SaveMeshTableCache(kMeshTableCachePath) ? "saved mesh_tables.bin" : "failed to save mesh_tables.bin";
+		}
+		if (!meshTableMessage.empty()) {
+			ImGui::Text("%s", meshTableMessage.c_str());
+		}
 		ImGui::End();
 
-		// 値の更新
-		project = Project(point - segment.origin, segment.diff);
-		closestPoint = ClosestPoint(point, segment);
+		benchmark.DrawImGui();
+		DrawMathDispatchImGui();
+		mathValidator.DrawImGui();
+
+		simulation.DrawImGui();
+
+		// 視点の配置、メインのカメラは左上に置く
+		ImGui::Begin("Views");
+		ImGui::RadioButton("single", &viewLayout, kViewLayoutSingle);
+		ImGui::SameLine();
+		ImGui::RadioButton("split", &viewLayout, kViewLayoutSplit);
+		ImGui::SameLine();
+		ImGui::RadioButton("quad", &viewLayout, kViewLayoutQuad);
+		ImGui::End();
+
+		const uint32_t kHalfWidth = kWindowWidth / 2;
+		const uint32_t kHalfHeight = kWindowHeight / 2;
+		if (viewLayout == kViewLayoutSingle) {
+			camera.SetViewport(0, 0, kWindowWidth, kWindowHeight);
+		} else if (viewLayout == kViewLayoutSplit) {
+			camera.SetViewport(0, 0, kHalfWidth, kWindowHeight);
+			topCamera.SetViewport(kHalfWidth, 0, kHalfWidth, kWindowHeight);
+		} else {
+			camera.SetViewport(0, 0, kHalfWidth, kHalfHeight);
+			topCamera.SetViewport(kHalfWidth, 0, kHalfWidth, kHalfHeight);
+			frontCamera.SetViewport(0, kHalfHeight, kHalfWidth, kHalfHeight);
+			sideCamera.SetViewport(kHalfWidth, kHalfHeight, kHalfWidth, kHalfHeight);
+		}
 
 		// カメラの更新処理
 		camera.Update();
 
-		// グリッド線の描画
-		grid.DrawGrid(camera.GetViewMatrix(), camera.GetProjectionMatrix(), camera.GetViewportMatrix());
+		// シミュレーション側へ今のカメラを渡す、結果は次以降のフレームで受け取る
+		simulation.SubmitInput(camera.GetViewProjectionViewportMatrix());
 
-		// 点の描画 1
-		pointSphere.DrawSphere(point, 0xff0000ff, camera.GetViewMatrix(), camera.GetProjectionMatrix(), camera.GetViewportMatrix());
+		// マウスの位置からワールド空間の半直線を求める
+		int mouseX = 0;
+		int mouseY = 0;
+		Novice::GetMousePosition(&mouseX, &mouseY);
+		Ray mouseRay = ScreenToWorldRay(
+			{ static_cast<float>(mouseX), static_cast<float>(mouseY) }, camera.GetInverseViewProjectionViewportMatrix());
 
-		// 点の描画 2
-		pointSphere.DrawSphere(closestPoint, 0x000000ff, camera.GetViewMatrix(), camera.GetProjectionMatrix(), camera.GetViewportMatrix());
+		// クリックした物を選択する
+		if (!ImGui::GetIO().WantCaptureMouse && Novice::IsTriggerMouse(0)) {
 
-		// 線分の描画
-		Vec3f start = Transform(Transform(segment.origin, Multiply(camera.GetViewMatrix(), camera.GetProjectionMatrix())), camera.GetViewportMatrix());
-		Vec3f end = Transform(Transform(segment.origin + segment.diff, Multiply(camera.GetViewMatrix(), camera.GetProjectionMatrix())), camera.GetViewportMatrix());
+			picker.Clear();
+			picker.AddSphere({ point.Get(), (std::max)(pointSphere.GetRadius(), kPickRadius) });
+			picker.AddSegment(segment.Get(), kPickRadius);
+			picker.Build();
 
-		Novice::DrawLine(
-			static_cast<int>(start.x), static_cast<int>(start.y),
-			static_cast<int>(end.x), static_cast<int>(end.y),
-			0xffffffff
-		);
+			pickResult = picker.Pick(mouseRay);
+		}
+
+		if (!Novice::IsPressMouse(0)) {
+			pickResult.type = Picker::Type::kNone;
+		}
+
+		// 選択中はカメラに正対する平面上で動かす
+		if (pickResult.type != Picker::Type::kNone) {
+
+			Matrix4x4 cameraMatrix = camera.GetCameraMatrix();
+			Vec3f forward = { cameraMatrix.m[2][0], cameraMatrix.m[2][1], cameraMatrix.m[2][2] };
+
+			float denom = Dot(mouseRay.diff, forward);
+			if (denom != 0.0f) {
+
+				Vec3f dragPos = mouseRay.origin + mouseRay.diff * (Dot(pickResult.position - mouseRay.origin, forward) / denom);
+				Vec3f delta = dragPos - pickResult.position;
+				pickResult.position = dragPos;
+
+				if (pickResult.type == Picker::Type::kSphere) {
+					point.Set(point.Get() + delta);
+				} else {
+					Segement movedSegment = segment.Get();
+					movedSegment.origin += delta;
+					segment.Set(movedSegment);
+				}
+			}
+		}
+
+		// 点から曲線への最近接点
+		Polyline::ClosestResult splineClosest = splinePolyline.ClosestPoint(point.Get());
+
+		// 箱と平面
+		ImGui::Begin("Collision");
+		ImGui::DragFloat3("aabbMin", &aabb.min.x, 0.01f);
+		ImGui::DragFloat3("aabbMax", &aabb.max.x, 0.01f);
+		ImGui::DragFloat3("obbCenter", &obbCenter.x, 0.01f);
+		ImGui::SliderFloat3("obbRotate", &obbRotate.x, -Pi(), Pi());
+		ImGui::DragFloat3("obbSize", &obbSize.x, 0.01f, 0.0f, 5.0f);
+		if (ImGui::SliderFloat3("planeNormal", &plane.normal.x, -1.0f, 1.0f)) {
+			plane.normal = Normalize(plane.normal);
+		}
+		ImGui::DragFloat("planeDistance", &plane.distance, 0.01f);
+		ImGui::End();
+
+		// minとmaxが入れ替わらないようにする
+		aabb = {
+			{ (std::min)(aabb.min.x, aabb.max.x), (std::min)(aabb.min.y, aabb.max.y), (std::min)(aabb.min.z, aabb.max.z) },
+			{ (std::max)(aabb.min.x, aabb.max.x), (std::max)(aabb.min.y, aabb.max.y), (std::max)(aabb.min.z, aabb.max.z) } };
+
+		OBB obb = MakeOBB(obbCenter, obbRotate, obbSize);
+		float hitT = 0.0f;
+		bool isBoxHit = OBBIntersection(ToOBB(aabb), obb);
+		bool isAABBHit = isBoxHit || SegmentAABBIntersection(segment.Get(), aabb, hitT);
+		bool isPlaneHit = SegmentPlaneIntersection(segment.Get(), plane, hitT);
+		collisionShapes.Set({ aabb, obb, plane,
+			isAABBHit ? 0xff0000ffu : 0xffffffffu, isBoxHit ? 0xff0000ffu : 0xffffffffu, isPlaneHit ? 0xff0000ffu : 0xffffffffu });
+
+		// 球の半径の操作
+		pointSphere.DrawImGui();
+
+		// 描画する物をカメラからの深度と色で並べ替えてから、その順に線を作る
+		renderQueue.Begin(camera.GetViewMatrix(), camera.GetNearClip(), camera.GetFarClip());
+		renderQueue.Add({ 0.0f,0.0f,0.0f }, gridMaterial, RenderQueue::PrimitiveType::kGrid, static_cast<uint32_t>(Drawable::kGrid));
+		renderQueue.Add(point.Get(), pointMaterial, RenderQueue::PrimitiveType::kSphere, static_cast<uint32_t>(Drawable::kPointSphere));
+		renderQueue.Add(closestPoint.Get(), closestPointMaterial, RenderQueue::PrimitiveType::kSphere,
+			static_cast<uint32_t>(Drawable::kClosestPointSphere));
+		renderQueue.Add(segment.Get().origin + segment.Get().diff * 0.5f, whiteMaterial, RenderQueue::PrimitiveType::kSegment,
+			static_cast<uint32_t>(Drawable::kSegment));
+		renderQueue.Add(splineCenter, splineMaterial, RenderQueue::PrimitiveType::kCurve, static_cast<uint32_t>(Drawable::kSpline));
+		renderQueue.Add((aabb.min + aabb.max) * 0.5f, whiteMaterial, RenderQueue::PrimitiveType::kShape, static_cast<uint32_t>(Drawable::kShapes));
+		renderQueue.Add({ 0.0f,0.0f,0.0f }, whiteMaterial, RenderQueue::PrimitiveType::kPackedLines, static_cast<uint32_t>(Drawable::kEntities));
+		renderQueue.Sort();
+
+		// 分割表示の視点、0番はメインのカメラ
+		bool isMultiView = viewLayout != kViewLayoutSingle;
+		multiViewRenderer.Clear();
+		worldLines.Clear();
+		const Camera* viewCameras[] = { &camera, &topCamera, &frontCamera, &sideCamera };
+		const size_t kViewCount = !isMultiView ? 0 : viewLayout == kViewLayoutQuad ? 4 : 2;
+		auto getViewRect = [](const Camera& view) -> MultiViewRenderer::ViewRect {
+			return {
+				static_cast<float>(view.GetLeft()), static_cast<float>(view.GetTop()),
+				static_cast<float>(view.GetWidth()), static_cast<float>(view.GetHeight()) };
+			};
+		for (size_t i = 0; i < kViewCount; ++i) {
+			multiViewRenderer.AddView(viewCameras[i]->GetViewProjectionViewportMatrix(), getViewRect(*viewCameras[i]));
+		}
+
+		// LineBatcherは色と深度で並べ直さず、キューの順のまま描く
+		lineBatcher.SetOrder(renderQueue.GetSortMode() == RenderQueue::SortMode::kFrontToBack ?
+			LineBatcher::Order::kFrontToBack : LineBatcher::Order::kSubmitted);
+
+		// 分割表示ではワールド座標の線を溜め、最後に全ての視点でまとめて描く
+		// 1画面では線をキャッシュから渡し、物かカメラが変わった物だけ作り直す
+		screenLineCache.BeginFrame();
+		for (size_t i = 0; i < renderQueue.GetCount(); ++i) {
+
+#ifdef _DEBUG
+			// 1画面では物ごとに線の始まりを記録し、描画した線がキューの順になっているか後で調べる
+			if (!isMultiView) {
+				renderQueue.MarkLineStart(lineBatcher.GetSubmittedCount());
+			}
+#endif
+
+			switch (static_cast<Drawable>(renderQueue.GetPayload(i))) {
+			case Drawable::kGrid:
+				// グリッド線の描画
+				if (isMultiView) {
+					grid.AddWorldLines(worldLines);
+				} else {
+					screenLineCache.Submit(gridLines, lineBatcher, [&](LineBatcher& target) {
+						grid.DrawGrid(camera.GetViewProjectionViewportMatrix(), target);
+						});
+				}
+				break;
+			case Drawable::kPointSphere:
+				// 点の描画 1
+				if (isMultiView) {
+					pointSphere.AddWorldLines(point.Get(), 0xff0000ff, worldLines);
+				} else {
+					screenLineCache.Submit(pointSphereLines, lineBatcher, [&](LineBatcher& target) {
+						pointSphere.DrawSphere(point.Get(), 0xff0000ff, camera.GetViewProjectionViewportMatrix(), target);
+						});
+				}
+				break;
+			case Drawable::kClosestPointSphere:
+				// 点の描画 2
+				if (isMultiView) {
+					pointSphere.AddWorldLines(closestPoint.Get(), 0x000000ff, worldLines);
+				} else {
+					screenLineCache.Submit(closestPointSphereLines, lineBatcher, [&](LineBatcher& target) {
+						pointSphere.DrawSphere(closestPoint.Get(), 0x000000ff, camera.GetViewProjectionViewportMatrix(), target);
+						});
+				}
+				break;
+			case Drawable::kSegment:
+				// 線分の描画
+				if (isMultiView) {
+					worldLines.Add(segment.Get().origin, segment.Get().origin + segment.Get().diff, 0xffffffff);
+				} else {
+					lineBatcher.AddLine(segmentScreenStart.Get(), segmentScreenEnd.Get(), 0xffffffff);
+				}
+				break;
+			case Drawable::kSpline:
+				// 曲線と、点から曲線への最近接点の描画
+				// 分割表示では画面上の許容誤差で分割できないので、ワールド空間で分割した折れ線を使う
+				if (isMultiView) {
+					splinePolyline.AddWorldLines(0x00ffffff, worldLines);
+					worldLines.Add(point.Get(), splineClosest.point, 0x00ffffff);
+				} else {
+					screenLineCache.Submit(splineLines, lineBatcher, [&](LineBatcher& target) {
+						spline.Draw(0x00ffffff, splinePixelTolerance.Get(), camera.GetViewProjectionViewportMatrix(), target);
+						target.AddLine(Transform(point.Get(), camera.GetViewProjectionViewportMatrix()),
+							Transform(splineClosest.point, camera.GetViewProjectionViewportMatrix()), 0x00ffffff);
+						});
+				}
+				break;
+			case Drawable::kShapes:
+				// 箱と平面の描画、線分や互いに交差すると赤くなる
+				if (isMultiView) {
+					shapeDrawer.AddAABB(aabb, isAABBHit ? 0xff0000ff : 0xffffffff);
+					shapeDrawer.AddOBB(obb, isBoxHit ? 0xff0000ff : 0xffffffff);
+					shapeDrawer.AddPlane(plane, 2.0f, isPlaneHit ? 0xff0000ff : 0xffffffff);
+					shapeDrawer.MoveWorldLines(worldLines);
+				} else {
+					screenLineCache.Submit(shapeLines, lineBatcher, [&](LineBatcher& target) {
+						const CollisionShapeState& shapes = collisionShapes.Get();
+						shapeDrawer.AddAABB(shapes.aabb, shapes.aabbColor);
+						shapeDrawer.AddOBB(shapes.obb, shapes.obbColor);
+						shapeDrawer.AddPlane(shapes.plane, 2.0f, shapes.planeColor);
+						shapeDrawer.Draw(camera.GetViewProjectionViewportMatrix(), target);
+						});
+				}
+				break;
+			case Drawable::kEntities:
+				// エンティティの描画、シミュレーション側が作った最新のスナップショットを使う
+				// スナップショットはメインのカメラで作った線なので、分割表示ではメインの視点にだけ描く
+				if (isMultiView) {
+					multiViewRenderer.DrawPackedLines(simulation.AcquireSnapshot().lines, simulation.GetPalette(), 0, lineBatcher);
+				} else {
+					lineBatcher.AddPackedLines(simulation.AcquireSnapshot().lines, simulation.GetPalette());
+				}
+				break;
+			}
+		}
+
+		if (isMultiView) {
+			multiViewRenderer.Draw(worldLines, lineBatcher);
+			multiViewRenderer.DrawBorders(lineBatcher);
+		}
+		multiViewRenderer.DrawImGui();
+		screenLineCache.DrawImGui();
+
+		ImGui::Begin("Curve");
+		float pixelTolerance = splinePixelTolerance.Get();
+		if (ImGui::SliderFloat("pixelTolerance", &pixelTolerance, 0.05f, 8.0f)) {
+			splinePixelTolerance.Set(pixelTolerance);
+		}
+		ImGui::Text("lines %u  culled %u", spline.GetStats().lineCount, spline.GetStats().culledCount);
+		ImGui::Text("closest segment %zu / %zu  distance %.3f", splineClosest.segmentIndex, splinePolyline.GetSegmentCount(),
+			std::sqrt(splineClosest.distanceSquared));
+		ImGui::End();
+
+		// 不透明な球
+		// 分割表示では視点ごとにその視点のカメラで投影し、遮蔽の判定も描画もその視点の矩形の中だけにする
+		if (isMultiView) {
+			for (size_t i = 0; i < kViewCount; ++i) {
+				MultiViewRenderer::ViewRect rect = getViewRect(*viewCameras[i]);
+				lineBatcher.AddOccluder(occluder, 0x404040ff,
+					viewCameras[i]->GetPosition(), viewCameras[i]->GetViewProjectionViewportMatrix(),
+					{ rect.left, rect.top, rect.width, rect.height });
+			}
+		} else {
+			lineBatcher.AddOccluder(occluder, 0x404040ff,
+				camera.GetPosition(), camera.GetViewProjectionViewportMatrix());
+		}
+
+		// 溜めた線をまとめて描画
+		lineBatcher.Flush();
+		lineBatcher.DrawImGui();
+
+#ifdef _DEBUG
+		renderQueue.CheckLineOrder(lineBatcher.GetEmittedSourceIndices());
+#endif
+		renderQueue.DrawImGui();
+
+		// このフレームの線をCPUで描いて画像に保存する
+		ImGui::Begin("SoftRasterizer");
+
+		ImGui::Checkbox("antialias (Wu)", &isSoftRasterizerWu);
+		ImGui::Checkbox("depthTest", &isSoftRasterizerDepthTest);
+		ImGui::Checkbox("everyFrame", &isSoftRasterizerEveryFrame);
+
+		bool isCapture = ImGui::Button("capture");
+		if (isCapture || isSoftRasterizerEveryFrame) {
+
+			// 内部解像度が変わった時だけバッファを作り直す
+			if (rasterResolutionVersion != rasterResolution.GetVersion()) {
+				rasterResolutionVersion = rasterResolution.GetVersion();
+				softRasterizer.Init(rasterResolution.GetRenderWidth(), rasterResolution.GetRenderHeight());
+				softRasterizer.SetInputScale(rasterResolution.GetRenderScale());
+			}
+
+			softRasterizer.SetLineMode(isSoftRasterizerWu ? SoftRasterizer::LineMode::kWu : SoftRasterizer::LineMode::kBresenham);
+			softRasterizer.SetDepthTest(isSoftRasterizerDepthTest);
+			softRasterizer.Clear(0x1a1a1aff);
+			softRasterizer.DrawLines(lineBatcher.GetEmittedLines());
+
+			// 描画時間が予算を超えていれば次のフレームから内部解像度を下げる
+			rasterResolution.Update(static_cast<float>(softRasterizer.GetStats().milliseconds));
+
+			if (isCapture) {
+				softRasterizer.SaveTGA("softRasterizer.tga");
+			}
+		}
+
+		const SoftRasterizer::Stats& rasterizerStats = softRasterizer.GetStats();
+		ImGui::Text("lines %u  binned %llu", rasterizerStats.lineCount, static_cast<unsigned long long>(rasterizerStats.binnedCount));
+		ImGui::Text("%.3f ms  %.0f lines/s", rasterizerStats.milliseconds, rasterizerStats.linesPerSecond);
+
+		ImGui::End();
+
+		rasterResolution.DrawImGui("SoftRasterizer Resolution");
+
+		// カウンタをこのフレームの値として集計する
+		EndCounterFrame();
 
 		// フレームの終了
 		Novice::EndFrame();
 
+		if (isFirstFrame) {
+			isFirstFrame = false;
+			startupProfiler.Finish();
+
+			// 計測モードでは結果を書き出して終了する
+			if (startupProfiler.IsProfileMode()) {
+				for (const StartupProfiler::Phase& phase : startupProfiler.GetPhases()) {
+					Novice::ConsolePrintf("startup %-24s %8.3f ms\n", phase.name.c_str(), phase.milliseconds);
+				}
+				Novice::ConsolePrintf("startup %-24s %8.3f ms\n", "total", startupProfiler.GetTotalMilliseconds());
+				startupProfiler.SaveCSV("startup_profile.csv");
+				break;
+			}
+		}
+
 		// ESCキーが押されたらループを抜ける
 		if (preKeys[DIK_ESCAPE] == 0 && keys[DIK_ESCAPE] != 0) {
 			break;
 		}
 	}
 
+	simulation.Stop();
+
+	// 実行中に作った表は次の起動で読めるように残す
+	if (GetMeshTableStats().generatedCount > 0) {
+		SaveMeshTableCache(kMeshTableCachePath);
+	}
+
 	// ライブラリの終了
 	Novice::Finalize();
 